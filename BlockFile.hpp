@@ -0,0 +1,79 @@
+#ifndef GRAPHWORKS_BLOCKFILE_HPP_
+#define GRAPHWORKS_BLOCKFILE_HPP_
+
+#include <mpi.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * Binary file of fixed size records, stored in blocks which are compressed
+ * independently with zlib.
+ *
+ * The file starts with a header of 64-bit little endian words: the magic
+ * "GWBLOCK2", the size of a record, the number of records, the number of
+ * records per block and the size of the metadata. The metadata of the
+ * writer follows, padded to whole words, and then the index of the file
+ * offsets of the blocks, with one more offset for the end of the last
+ * block. Files with the magic "GWBLOCK1" have neither the size of the
+ * metadata nor the metadata. Every block but the last holds the same
+ * number of records. A processor therefore locates the blocks of any range
+ * of records from the header alone, reads only their bytes, and
+ * decompresses them with its own threads.
+ */
+class BlockFile {
+public:
+  BlockFile();
+
+  bool
+  open(MPI_File);
+
+  unsigned int
+  recordSize() const;
+
+  unsigned long long
+  numRecords() const;
+
+  unsigned long long
+  numBlocks() const;
+
+  unsigned long long
+  blockBegin(const unsigned long long) const;
+
+  const std::vector<char>&
+  metadata() const;
+
+  bool
+  read(
+    MPI_File,
+    const unsigned long long,
+    const unsigned long long,
+    char* const
+  ) const;
+
+  static
+  bool
+  isBlockFile(const std::string&);
+
+  static
+  bool
+  write(
+    const std::string&,
+    const char* const,
+    const unsigned int,
+    const unsigned long long,
+    const unsigned long long = 0,
+    const std::vector<char>& = std::vector<char>()
+  );
+
+  ~BlockFile();
+
+private:
+  unsigned long long m_recordSize;
+  unsigned long long m_numRecords;
+  unsigned long long m_recordsPerBlock;
+  unsigned long long m_indexOffset;
+  std::vector<char> m_metadata;
+}; // class BlockFile
+
+#endif // GRAPHWORKS_BLOCKFILE_HPP_
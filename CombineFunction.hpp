@@ -4,8 +4,17 @@
 #include "Graph.hpp"
 
 class DataPoint;
+class Reduction;
 
 class CombineFunction {
+public:
+  /** Granularity at which the combine function is invoked **/
+  enum Batching {
+    Pairwise,   // once per (node, interaction set node) pair
+    Nodes,      // once per node, with all its interaction set nodes
+    Payloads    // once per node, with the payloads of all its interaction set nodes
+  };
+
 public:
   /**Implement one of these**/
 
@@ -29,6 +38,43 @@ public:
     return false;
   }
 
+  /** Or implement one of these, along with batching() **/
+
+  virtual
+  bool
+  operator()(
+    Graph::Node&,
+    const Graph::Node* const,
+    const unsigned int
+  ) const
+  {
+    return false;
+  }
+
+  virtual
+  bool
+  operator()(
+    Graph::Node&,
+    const Graph::Node::PayloadType* const,
+    const unsigned int
+  ) const
+  {
+    return false;
+  }
+
+  virtual
+  Batching
+  batching() const { return Pairwise; }
+
+  /**
+   * Combine functions which only reduce the payloads of the interaction set
+   * into the payload of the node return their reduction, which can then be
+   * applied by multiple threads.
+   **/
+  virtual
+  const Reduction*
+  reduction() const { return 0; }
+
   virtual
   ~CombineFunction() = 0;
 }; // class CombineFunction
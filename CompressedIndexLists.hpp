@@ -0,0 +1,239 @@
+#ifndef GRAPHWORKS_COMPRESSEDINDEXLISTS_HPP_
+#define GRAPHWORKS_COMPRESSEDINDEXLISTS_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Sorted lists of node indices, stored one after the other in a compressed
+ * byte stream.
+ *
+ * A list is stored as its length and its first index in variable bytes,
+ * followed by the differences of the consecutive indices in blocks of
+ * s_blockSize. Every block packs its differences with the number of bits
+ * of the largest one, so that the lists of nearby indices take a few bits
+ * per entry, whatever the width of the index type. Unpacking a block has no
+ * branches except at its end, so that the compiler can vectorize it.
+ * The packed bits are read as little endian words.
+ */
+template <typename IndexType>
+class CompressedIndexLists {
+public:
+  CompressedIndexLists()
+    : m_data(),
+      m_offsets(1, 0)
+  { }
+
+  void
+  clear()
+  {
+    m_data.clear();
+    m_offsets.assign(1, 0);
+  }
+
+  /**
+   * @brief Appends a list, which has to be sorted.
+   */
+  void
+  append(
+    const IndexType* const indices,
+    const unsigned int count
+  )
+  {
+    encode(indices, count, m_data);
+    m_offsets.push_back(m_data.size());
+  }
+
+  unsigned int
+  numLists() const { return static_cast<unsigned int>(m_offsets.size() - 1); }
+
+  /**
+   * @brief Length of a list, without decoding it.
+   */
+  unsigned int
+  size(const unsigned int list) const
+  {
+    const unsigned char* p = &m_data[0] + m_offsets[list];
+    return static_cast<unsigned int>(readVarint(p));
+  }
+
+  /**
+   * @brief Decodes a list into the given indices, replacing them.
+   */
+  void
+  decode(
+    const unsigned int list,
+    std::vector<IndexType>& indices
+  ) const
+  {
+    indices.clear();
+    if (m_offsets[list + 1] > m_offsets[list]) {
+      decode(&m_data[0] + m_offsets[list], indices);
+    }
+  }
+
+  /**
+   * @brief Memory taken by the lists, in bytes.
+   */
+  std::size_t
+  bytes() const
+  {
+    return m_data.capacity() + m_offsets.capacity() * sizeof(std::size_t);
+  }
+
+  /**
+   * @brief Encodes a sorted list, appending it to the given bytes.
+   */
+  static void
+  encode(
+    const IndexType* const indices,
+    const unsigned int count,
+    std::vector<unsigned char>& data
+  )
+  {
+    writeVarint(count, data);
+    if (count == 0) {
+      return;
+    }
+    writeVarint(static_cast<uint64_t>(indices[0]), data);
+    for (unsigned int begin = 1; begin < count; begin += s_blockSize) {
+      const unsigned int end = (count - begin < s_blockSize) ? count : begin + s_blockSize;
+      uint64_t largest = 0;
+      for (unsigned int k = begin; k < end; ++k) {
+        if (indices[k] < indices[k - 1]) {
+          throw std::runtime_error("Compressed index lists have to be sorted!");
+        }
+        largest |= static_cast<uint64_t>(indices[k] - indices[k - 1]);
+      }
+      unsigned int width = 0;
+      while ((width < 64) && ((largest >> width) != 0)) {
+        ++width;
+      }
+      // Wide differences are stored whole, since a word read at any bit
+      // offset only holds s_maxPackedWidth bits.
+      if (width > s_maxPackedWidth) {
+        width = 64;
+      }
+      data.push_back(static_cast<unsigned char>(width));
+
+      const std::size_t start = data.size();
+      data.resize(start + ((end - begin) * width + 7) / 8, 0);
+      for (unsigned int k = begin; k < end; ++k) {
+        const uint64_t delta = static_cast<uint64_t>(indices[k] - indices[k - 1]);
+        const std::size_t bit = static_cast<std::size_t>(k - begin) * width;
+        for (unsigned int b = 0; b < width; b += 8) {
+          const std::size_t position = bit + b;
+          const uint64_t bits = (delta >> b) << (position & 7);
+          data[start + position / 8] |= static_cast<unsigned char>(bits);
+          if (((position & 7) != 0) && (start + position / 8 + 1 < data.size())) {
+            data[start + position / 8 + 1] |= static_cast<unsigned char>(bits >> 8);
+          }
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Decodes a list encoded at the given bytes, replacing the indices.
+   *
+   * @return Position after the list.
+   */
+  static const unsigned char*
+  decode(
+    const unsigned char* data,
+    std::vector<IndexType>& indices
+  )
+  {
+    const unsigned int count = static_cast<unsigned int>(readVarint(data));
+    indices.resize(count);
+    if (count == 0) {
+      return data;
+    }
+    IndexType* const out = &indices[0];
+    out[0] = static_cast<IndexType>(readVarint(data));
+    for (unsigned int begin = 1; begin < count; begin += s_blockSize) {
+      const unsigned int n = (count - begin < s_blockSize) ? count - begin : s_blockSize;
+      const unsigned int width = *data++;
+      const std::size_t numBytes = (static_cast<std::size_t>(n) * width + 7) / 8;
+      IndexType* const deltas = out + begin;
+      if (width == 64) {
+        for (unsigned int k = 0; k < n; ++k) {
+          uint64_t delta;
+          std::memcpy(&delta, data + 8 * k, 8);
+          deltas[k] = static_cast<IndexType>(delta);
+        }
+      }
+      else if (width > 0) {
+        // Whole words can be read up to the last 8 bytes of the block.
+        const uint64_t mask = (static_cast<uint64_t>(1) << width) - 1;
+        const unsigned int numWords = (numBytes < 8) ? 0 : std::min(n, static_cast<unsigned int>(((numBytes - 8) * 8) / width + 1));
+        for (unsigned int k = 0; k < numWords; ++k) {
+          const std::size_t bit = static_cast<std::size_t>(k) * width;
+          uint64_t word;
+          std::memcpy(&word, data + bit / 8, 8);
+          deltas[k] = static_cast<IndexType>((word >> (bit & 7)) & mask);
+        }
+        for (unsigned int k = numWords; k < n; ++k) {
+          const std::size_t bit = static_cast<std::size_t>(k) * width;
+          uint64_t word = 0;
+          std::memcpy(&word, data + bit / 8, numBytes - bit / 8);
+          deltas[k] = static_cast<IndexType>((word >> (bit & 7)) & mask);
+        }
+      }
+      else {
+        std::fill(deltas, deltas + n, IndexType());
+      }
+      data += numBytes;
+
+      // Turn the differences into indices.
+      for (unsigned int k = 0; k < n; ++k) {
+        deltas[k] += deltas[static_cast<int>(k) - 1];
+      }
+    }
+    return data;
+  }
+
+public:
+  /** Number of differences packed with the same width **/
+  static const unsigned int s_blockSize = 128;
+
+  /** Widest differences which are packed **/
+  static const unsigned int s_maxPackedWidth = 56;
+
+private:
+  static void
+  writeVarint(
+    uint64_t value,
+    std::vector<unsigned char>& data
+  )
+  {
+    while (value >= 0x80) {
+      data.push_back(static_cast<unsigned char>(value | 0x80));
+      value >>= 7;
+    }
+    data.push_back(static_cast<unsigned char>(value));
+  }
+
+  static uint64_t
+  readVarint(const unsigned char*& data)
+  {
+    uint64_t value = 0;
+    for (unsigned int shift = 0; ; shift += 7) {
+      const unsigned char byte = *data++;
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (byte < 0x80) {
+        return value;
+      }
+    }
+  }
+
+private:
+  std::vector<unsigned char> m_data;
+  std::vector<std::size_t> m_offsets;
+}; // class CompressedIndexLists
+
+#endif // GRAPHWORKS_COMPRESSEDINDEXLISTS_HPP_
@@ -0,0 +1,98 @@
+#ifndef GRAPHWORKS_DISTRIBUTEDKDTREE_HPP_
+#define GRAPHWORKS_DISTRIBUTEDKDTREE_HPP_
+
+#include "Graph.hpp"
+#include "KdTree.hpp"
+
+#include <utility>
+#include <vector>
+
+class MPICommunicator;
+
+class DistributedKdTree {
+public:
+  typedef std::pair<double, Graph::Node::IndexType> Neighbor;
+
+public:
+  DistributedKdTree(const MPICommunicator&);
+
+  void
+  build(const Graph&);
+
+  void
+  nearest(
+    const unsigned int,
+    const bool,
+    std::vector<std::vector<Graph::Node::IndexType> >&
+  ) const;
+
+  void
+  nearest(
+    const unsigned int,
+    const bool,
+    const std::vector<unsigned int>* const,
+    std::vector<std::vector<Graph::Node::IndexType> >&
+  ) const;
+
+  void
+  withinRadius(
+    const double,
+    const bool,
+    std::vector<std::vector<Graph::Node::IndexType> >&
+  ) const;
+
+  void
+  withinRadius(
+    const double,
+    const bool,
+    const std::vector<unsigned int>* const,
+    std::vector<std::vector<Graph::Node::IndexType> >&
+  ) const;
+
+  ~DistributedKdTree();
+
+private:
+  class Query {
+    public:
+      double m_coords[3];
+      double m_bound;
+  }; // class Query
+
+  void
+  query(
+    const unsigned int,
+    const double,
+    const bool,
+    const std::vector<unsigned int>* const,
+    std::vector<std::vector<Graph::Node::IndexType> >&
+  ) const;
+
+  void
+  localQuery(
+    const KdTree&,
+    const double* const,
+    const unsigned int,
+    const double,
+    std::vector<KdTree::Neighbor>&
+  ) const;
+
+  const KdTree&
+  peerTree(const unsigned int) const;
+
+  double
+  boxDistance(
+    const double* const,
+    const unsigned int
+  ) const;
+
+private:
+  const MPICommunicator& m_mpiCommunicator;
+  const Graph* m_graph;
+  KdTree m_localTree;
+  std::vector<double> m_boxes;
+  std::vector<const InputData::Point*> m_peerPoints;
+  mutable std::vector<KdTree> m_peerTrees;
+  mutable std::vector<char> m_peerBuilt;
+}; // class DistributedKdTree
+
+#endif // GRAPHWORKS_DISTRIBUTEDKDTREE_HPP_
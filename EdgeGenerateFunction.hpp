@@ -0,0 +1,46 @@
+#ifndef GRAPHWORKS_EDGEGENERATEFUNCTION_HPP_
+#define GRAPHWORKS_EDGEGENERATEFUNCTION_HPP_
+
+#include "GenerateFunction.hpp"
+#include "Graph.hpp"
+
+#include <iterator>
+#include <vector>
+
+/**
+ * Generate function which uses the targets of the edges of a node,
+ * as stored in the graph, for its interaction set.
+ */
+class EdgeGenerateFunction : public GenerateFunction {
+public:
+  EdgeGenerateFunction()
+    : m_neighbors()
+  { }
+
+  bool
+  operator()(
+    const Graph& g,
+    const Graph::Node& node,
+    std::back_insert_iterator<std::vector<Graph::Node> >& iteratorList,
+    bool& dependencyFlag
+  ) const
+  {
+    g.neighbors(g.localIndex(node.index()), m_neighbors);
+    for (std::vector<Graph::Node::IndexType>::const_iterator n = m_neighbors.begin(); n != m_neighbors.end(); ++n) {
+      // Local neighbors are emitted along with their payloads.
+      if (g.isLocal(*n)) {
+        iteratorList = *(g.begin() + g.localIndex(*n));
+      }
+      else {
+        iteratorList = Graph::Node(*n);
+      }
+    }
+    dependencyFlag = false;
+    return true;
+  }
+
+private:
+  mutable std::vector<Graph::Node::IndexType> m_neighbors;
+}; // class EdgeGenerateFunction
+
+#endif // GRAPHWORKS_EDGEGENERATEFUNCTION_HPP_
@@ -0,0 +1,110 @@
+#ifndef GRAPHWORKS_EDGELIST_HPP_
+#define GRAPHWORKS_EDGELIST_HPP_
+
+#include "Graph.hpp"
+
+#include <mpi.h>
+
+#include <string>
+#include <vector>
+
+class MPICommunicator;
+
+/**
+ * Edges of a graph read in parallel from an edge list file, and then
+ * distributed by their sources into a compressed sparse row layout.
+ *
+ * The nodes are numbered as in the file, and every processor ends up with
+ * a contiguous range of sources along with all their edges, so that the
+ * ranges follow the numbering of the graph built over the edges.
+ */
+class EdgeList {
+public:
+  typedef Graph::Node::IndexType IndexType;
+
+  enum Format {
+    Text,
+    Binary,
+    WeightedBinary,
+    Compressed
+  };
+
+  class Edge {
+    public:
+      IndexType m_source;
+      IndexType m_target;
+      double m_weight;
+  }; // class Edge
+
+public:
+  EdgeList();
+
+  bool
+  read(
+    const std::string&,
+    const Format,
+    const MPICommunicator&
+  );
+
+  bool
+  write(
+    const std::string&,
+    const MPICommunicator&
+  ) const;
+
+  void
+  build(const MPICommunicator&);
+
+  IndexType
+  numGlobalNodes() const;
+
+  unsigned long long
+  numGlobalEdges() const;
+
+  IndexType
+  firstNode() const;
+
+  unsigned int
+  numLocalNodes() const;
+
+  std::size_t
+  numEdges(const unsigned int) const;
+
+  const Edge*
+  edges(const unsigned int) const;
+
+  ~EdgeList();
+
+private:
+  bool
+  readText(
+    MPI_File,
+    const MPICommunicator&
+  );
+
+  bool
+  readBinary(
+    MPI_File,
+    const bool,
+    const MPICommunicator&
+  );
+
+  bool
+  readCompressed(
+    MPI_File,
+    const MPICommunicator&
+  );
+
+  void
+  mergeRuns(const std::vector<std::size_t>&);
+
+private:
+  std::vector<Edge> m_edges;
+  std::vector<std::size_t> m_offsets;
+  IndexType m_numGlobalNodes;
+  unsigned long long m_numGlobalEdges;
+  IndexType m_firstNode;
+  unsigned int m_numLocalNodes;
+}; // class EdgeList
+
+#endif // GRAPHWORKS_EDGELIST_HPP_
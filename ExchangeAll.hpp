@@ -0,0 +1,243 @@
+#ifndef GRAPHWORKS_EXCHANGEALL_HPP_
+#define GRAPHWORKS_EXCHANGEALL_HPP_
+
+#include "MPICommunicator.hpp"
+
+#include <mpi.h>
+
+#include <climits>
+#include <vector>
+
+/**
+ * @brief Datatype of a block of elements at an absolute address, for blocks
+ *        of more elements than an int counts.
+ *
+ * @param address       Address of the first element.
+ * @param count         Number of elements.
+ * @param elementType   Datatype of the elements.
+ * @param maxCount      Largest number of elements given as one count.
+ *
+ * The block is made of whole chunks of maxCount elements, followed by the
+ * remaining elements.
+ */
+inline MPI_Datatype
+largeBlockType(
+  const void* const address,
+  const unsigned long long count,
+  const MPI_Datatype elementType,
+  const unsigned long long maxCount
+)
+{
+  MPI_Aint lowerBound, extent;
+  MPI_Type_get_extent(elementType, &lowerBound, &extent);
+  MPI_Datatype chunkType;
+  MPI_Type_contiguous(static_cast<int>(maxCount), elementType, &chunkType);
+
+  const unsigned long long numChunks = count / maxCount;
+  int blockLengths[2] = {static_cast<int>(numChunks), static_cast<int>(count % maxCount)};
+  MPI_Aint displacements[2];
+  MPI_Get_address(const_cast<void*>(address), &displacements[0]);
+  displacements[1] = displacements[0] + static_cast<MPI_Aint>(numChunks * maxCount) * extent;
+  MPI_Datatype types[2] = {chunkType, elementType};
+  MPI_Datatype blockType;
+  MPI_Type_create_struct(2, blockLengths, displacements, types, &blockType);
+  MPI_Type_commit(&blockType);
+  MPI_Type_free(&chunkType);
+  return blockType;
+}
+
+/**
+ * @brief MPI_Alltoallv for counts and displacements of any size.
+ *
+ * @param sendBuffer        Elements for all the processors.
+ * @param sendCounts        Number of the elements for every processor.
+ * @param sendDispls        Position of the elements for every processor.
+ * @param receiveBuffer     Elements from all the processors.
+ * @param receiveCounts     Number of the elements from every processor.
+ * @param receiveDispls     Position of the elements from every processor.
+ * @param elementType       Datatype of the elements, in which the counts and
+ *                          the positions are given.
+ * @param mpiCommunicator   Communicator of the processors.
+ * @param maxCount          Largest count or position which is passed to MPI
+ *                          as an int.
+ *
+ * If all the counts and positions of all the processors fit in an int,
+ * which is agreed on in one reduction, the elements are exchanged with one
+ * MPI_Alltoallv. Otherwise, the elements of every processor are described
+ * by a datatype at their absolute address, and are exchanged in place with
+ * one MPI_Alltoallw. This is a collective call.
+ */
+inline void
+exchangeAllv(
+  const void* const sendBuffer,
+  const std::vector<unsigned long long>& sendCounts,
+  const std::vector<unsigned long long>& sendDispls,
+  void* const receiveBuffer,
+  const std::vector<unsigned long long>& receiveCounts,
+  const std::vector<unsigned long long>& receiveDispls,
+  const MPI_Datatype elementType,
+  const MPICommunicator& mpiCommunicator,
+  const unsigned long long maxCount = INT_MAX
+)
+{
+  const unsigned int numProcs = mpiCommunicator.size();
+  int localFits = 1;
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    if ((sendCounts[p] > maxCount) || (sendDispls[p] > maxCount) ||
+        (receiveCounts[p] > maxCount) || (receiveDispls[p] > maxCount)) {
+      localFits = 0;
+    }
+  }
+  int globalFits = 0;
+  MPI_Allreduce(&localFits, &globalFits, 1, MPI_INT, MPI_LAND, *mpiCommunicator);
+
+  if (globalFits) {
+    std::vector<int> counts[2] = {std::vector<int>(sendCounts.begin(), sendCounts.end()), std::vector<int>(receiveCounts.begin(), receiveCounts.end())};
+    std::vector<int> displs[2] = {std::vector<int>(sendDispls.begin(), sendDispls.end()), std::vector<int>(receiveDispls.begin(), receiveDispls.end())};
+    MPI_Alltoallv(const_cast<void*>(sendBuffer), &counts[0][0], &displs[0][0], elementType,
+                  receiveBuffer, &counts[1][0], &displs[1][0], elementType, *mpiCommunicator);
+    return;
+  }
+
+  MPI_Aint lowerBound, extent;
+  MPI_Type_get_extent(elementType, &lowerBound, &extent);
+  std::vector<int> counts[2] = {std::vector<int>(numProcs, 0), std::vector<int>(numProcs, 0)};
+  std::vector<int> displs(numProcs, 0);
+  std::vector<MPI_Datatype> types[2] = {std::vector<MPI_Datatype>(numProcs, elementType), std::vector<MPI_Datatype>(numProcs, elementType)};
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    if (sendCounts[p] > 0) {
+      counts[0][p] = 1;
+      types[0][p] = largeBlockType(static_cast<const char*>(sendBuffer) + sendDispls[p] * extent, sendCounts[p], elementType, maxCount);
+    }
+    if (receiveCounts[p] > 0) {
+      counts[1][p] = 1;
+      types[1][p] = largeBlockType(static_cast<char*>(receiveBuffer) + receiveDispls[p] * extent, receiveCounts[p], elementType, maxCount);
+    }
+  }
+  MPI_Alltoallw(MPI_BOTTOM, &counts[0][0], &displs[0], &types[0][0],
+                MPI_BOTTOM, &counts[1][0], &displs[0], &types[1][0], *mpiCommunicator);
+  for (unsigned int d = 0; d < 2; ++d) {
+    for (unsigned int p = 0; p < numProcs; ++p) {
+      if (counts[d][p] > 0) {
+        MPI_Type_free(&types[d][p]);
+      }
+    }
+  }
+}
+
+/**
+ * @brief MPI_Gatherv to processor 0 for counts of any size.
+ *
+ * @param sendBuffer        Elements of this processor.
+ * @param sendCount         Number of the elements of this processor.
+ * @param receiveBuffer     Elements of all the processors, in the order of
+ *                          the processors, on processor 0.
+ * @param receiveCounts     Number of the elements of every processor, which
+ *                          is only used on processor 0.
+ * @param elementType       Datatype of the elements.
+ * @param mpiCommunicator   Communicator of the processors.
+ * @param maxCount          Largest count or position which is passed to MPI
+ *                          as an int.
+ *
+ * The elements are exchanged with exchangeAllv, with nothing sent to the
+ * other processors, so that the counts and the positions aren't limited by
+ * an int. This is a collective call.
+ */
+inline void
+gatherv(
+  const void* const sendBuffer,
+  const unsigned long long sendCount,
+  void* const receiveBuffer,
+  const std::vector<unsigned long long>& receiveCounts,
+  const MPI_Datatype elementType,
+  const MPICommunicator& mpiCommunicator,
+  const unsigned long long maxCount = INT_MAX
+)
+{
+  const unsigned int numProcs = mpiCommunicator.size();
+  std::vector<unsigned long long> sendCounts(numProcs, 0);
+  std::vector<unsigned long long> sendDispls(numProcs, 0);
+  sendCounts[0] = sendCount;
+  std::vector<unsigned long long> counts(numProcs, 0);
+  std::vector<unsigned long long> displs(numProcs, 0);
+  if (mpiCommunicator.rank() == 0) {
+    for (unsigned int p = 0; p < numProcs; ++p) {
+      counts[p] = receiveCounts[p];
+      displs[p] = (p > 0) ? displs[p - 1] + counts[p - 1] : 0;
+    }
+  }
+  exchangeAllv(sendBuffer, sendCounts, sendDispls, receiveBuffer, counts, displs, elementType, mpiCommunicator, maxCount);
+}
+
+/**
+ * @brief Sends a list of plain objects to every processor.
+ *
+ * @param outgoing          Objects for each processor.
+ * @param incoming          Objects received, in the order of the sending ranks.
+ * @param offsets           Position in incoming of the objects from every
+ *                          processor, followed by the number of objects.
+ * @param mpiCommunicator   Communicator of the processors.
+ *
+ * The objects are counted as such rather than as bytes, and are exchanged
+ * with exchangeAllv, so their number is only limited by the offsets.
+ */
+template <typename T>
+void
+exchangeAll(
+  const std::vector<std::vector<T> >& outgoing,
+  std::vector<T>& incoming,
+  std::vector<unsigned int>& offsets,
+  const MPICommunicator& mpiCommunicator
+)
+{
+  const unsigned int numProcs = mpiCommunicator.size();
+  std::vector<T> sendBuffer;
+  std::vector<unsigned long long> sendCounts(numProcs, 0);
+  std::vector<unsigned long long> sendDispls(numProcs, 0);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    sendDispls[p] = sendBuffer.size();
+    sendCounts[p] = outgoing[p].size();
+    sendBuffer.insert(sendBuffer.end(), outgoing[p].begin(), outgoing[p].end());
+  }
+  std::vector<unsigned long long> receiveCounts(numProcs, 0);
+  MPI_Alltoall(&sendCounts[0], 1, MPI_UNSIGNED_LONG_LONG, &receiveCounts[0], 1, MPI_UNSIGNED_LONG_LONG, *mpiCommunicator);
+  std::vector<unsigned long long> receiveDispls(numProcs, 0);
+  for (unsigned int p = 1; p < numProcs; ++p) {
+    receiveDispls[p] = receiveDispls[p - 1] + receiveCounts[p - 1];
+  }
+  incoming.resize(receiveDispls[numProcs - 1] + receiveCounts[numProcs - 1]);
+
+  MPI_Datatype objectType;
+  MPI_Type_contiguous(sizeof(T), MPI_BYTE, &objectType);
+  MPI_Type_commit(&objectType);
+  exchangeAllv(sendBuffer.empty() ? 0 : &sendBuffer[0], sendCounts, sendDispls,
+               incoming.empty() ? 0 : &incoming[0], receiveCounts, receiveDispls, objectType, mpiCommunicator);
+  MPI_Type_free(&objectType);
+
+  offsets.resize(numProcs + 1);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    offsets[p] = static_cast<unsigned int>(receiveDispls[p]);
+  }
+  offsets[numProcs] = static_cast<unsigned int>(incoming.size());
+}
+
+/**
+ * @brief Sends a list of plain objects to every processor.
+ *
+ * @param outgoing          Objects for each processor.
+ * @param incoming          Objects received, in the order of the sending ranks.
+ * @param mpiCommunicator   Communicator of the processors.
+ */
+template <typename T>
+void
+exchangeAll(
+  const std::vector<std::vector<T> >& outgoing,
+  std::vector<T>& incoming,
+  const MPICommunicator& mpiCommunicator
+)
+{
+  std::vector<unsigned int> offsets;
+  exchangeAll(outgoing, incoming, offsets, mpiCommunicator);
+}
+
+#endif // GRAPHWORKS_EXCHANGEALL_HPP_
@@ -0,0 +1,54 @@
+#ifndef GRAPHWORKS_FRONTIER_HPP_
+#define GRAPHWORKS_FRONTIER_HPP_
+
+#include <vector>
+
+/**
+ * Set of active nodes, kept both as a dense flag array for constant time
+ * lookups, and as a sparse list for visiting only the active nodes.
+ * A full frontier marks all the nodes as active without listing them.
+ */
+class Frontier {
+public:
+  Frontier();
+
+  void
+  reset(
+    const unsigned int,
+    const bool
+  );
+
+  void
+  grow(const unsigned int);
+
+  void
+  activate(const unsigned int);
+
+  bool
+  isActive(const unsigned int) const;
+
+  bool
+  isFull() const;
+
+  unsigned int
+  size() const;
+
+  unsigned int
+  numActive() const;
+
+  double
+  density() const;
+
+  const std::vector<unsigned int>&
+  active() const;
+
+  ~Frontier();
+
+private:
+  std::vector<char> m_flags;
+  std::vector<unsigned int> m_active;
+  unsigned int m_size;
+  bool m_full;
+}; // class Frontier
+
+#endif // GRAPHWORKS_FRONTIER_HPP_
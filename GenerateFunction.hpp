@@ -4,12 +4,17 @@
 #include "Graph.hpp"
 
 #include <iterator>
+#include <vector>
 
 class DataPoint;
 
 class GenerateFunction {
 public:
-  /** Implement One of these **/
+  /**
+   * Implement One of these. They may be called from a worker thread, see
+   * GraphCompute::computeAsync, and so must not call MPI, which belongs in
+   * the collective hooks.
+   **/
   virtual
   bool
   operator()(
@@ -38,6 +43,34 @@ public:
   Graph::AlgorithmChoice
   type() const { return Graph::General; }
 
+  /** Collective hook which is called before generating any interaction set **/
+  virtual
+  void
+  prepare(const Graph&) const { }
+
+  /**
+   * Collective hook which is called before generating the interaction sets
+   * of the listed local nodes again, in incremental computations. By
+   * default, all the nodes are prepared.
+   **/
+  virtual
+  void
+  prepareUpdate(
+    const Graph& g,
+    const std::vector<unsigned int>&
+  ) const
+  {
+    prepare(g);
+  }
+
+  /**
+   * Whether the interaction sets may be sorted by the owners of their nodes,
+   * and stripped of repeated nodes, because the combines depend neither on
+   * the order nor on the repetitions of the nodes.
+   */
+  virtual
+  bool
+  normalize() const { return false; }
 
   virtual
   ~GenerateFunction() = 0;
@@ -1,13 +1,22 @@
 #ifndef GRAPHWORKS_GRAPH_HPP_
 #define GRAPHWORKS_GRAPH_HPP_
 
+#include "CompressedIndexLists.hpp"
+#include "Frontier.hpp"
 #include "InputData.hpp"
+#include "MPICommunicator.hpp"
 
 #include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 class CombineFunction;
-class MPICommunicator;
+class EdgeList;
+class HaloExchange;
+class Reduction;
+class TreeIndex;
 
 class Graph {
 public:
@@ -23,25 +32,73 @@ public:
     DownwardAccumulateReverse
   };
 
+  /** Orders in which the local nodes can be renumbered for locality **/
+  enum Ordering {
+    ReverseCuthillMcKee,
+    DescendingDegree,
+    BreadthFirst
+  };
+
+  /** Version of the payload of a node, which changes along with the payload **/
+  typedef unsigned long long VersionType;
+
 public:
   Graph(
     const InputData::Point* const,
     const unsigned int,
+    const InputData::Bounds&,
+    const MPICommunicator&
+  );
+
+  class Node;
+
+  Graph(
+    const std::vector<Node>&,
+    const MPICommunicator&
+  );
+
+  Graph(
+    const EdgeList&,
+    const MPICommunicator&
+  );
+
+  Graph(
+    const InputData&,
     const MPICommunicator&
   );
 
   class Node {
     public:
+#ifdef GRAPHWORKS_INDEX64
+      typedef unsigned long long IndexType;
+#else
       typedef unsigned int IndexType;
+#endif
+      typedef double PayloadType;
 
     public:
       Node();
 
+      Node(const IndexType);
+
+      Node(
+        const IndexType,
+        const IndexType,
+        const unsigned int,
+        const unsigned int
+      );
+
       Node(const Node&);
 
       IndexType
       index() const;
 
+      IndexType
+      parent() const;
+
+      unsigned int
+      level() const;
+
       bool
       isRoot() const;
 
@@ -57,10 +114,44 @@ public:
       unsigned int 
       numChildren() const;
 
+      PayloadType&
+      payload();
+
+      const PayloadType&
+      payload() const;
+
+    public:
+      static const IndexType s_invalidIndex = static_cast<IndexType>(-1);
+
     private:
       IndexType m_index;
+      IndexType m_parent;
+      unsigned int m_numChildren;
+      unsigned int m_level;
+      PayloadType m_payload;
   }; // class Node
 
+  /** Orders nodes by their owners, and then by their local indices **/
+  class OwnerOrder {
+    public:
+      OwnerOrder(const Graph&);
+
+      bool
+      operator()(
+        const Node::IndexType,
+        const Node::IndexType
+      ) const;
+
+      bool
+      operator()(
+        const Node&,
+        const Node&
+      ) const;
+
+    private:
+      const Graph* m_graph;
+  }; // class OwnerOrder
+
   typedef typename std::vector<Node>::iterator NodeIterator;
 
   typedef typename std::vector<Node>::const_iterator ConstNodeIterator;
@@ -80,6 +171,165 @@ public:
   unsigned int 
   size() const;
 
+  const InputData::Point*
+  points() const;
+
+  const InputData::Bounds&
+  bounds() const;
+
+  bool
+  hasSharedPoints() const;
+
+  const InputData::Point*
+  peerPoints(const unsigned int) const;
+
+  Node::IndexType
+  firstIndex(const unsigned int) const;
+
+  Node::IndexType
+  globalSize() const;
+
+  Node::IndexType
+  globalIndex(const unsigned int) const;
+
+  unsigned int
+  owner(const Node::IndexType) const;
+
+  bool
+  isLocal(const Node::IndexType) const;
+
+  unsigned int
+  localIndex(const Node::IndexType) const;
+
+  const MPICommunicator&
+  communicator() const;
+
+  Node::IndexType
+  addNode(const Node::PayloadType);
+
+  Node::IndexType
+  addNode(
+    const InputData::Point&,
+    const Node::PayloadType
+  );
+
+  void
+  removeNode(const Node::IndexType);
+
+  void
+  addEdge(
+    const Node::IndexType,
+    const Node::IndexType
+  );
+
+  void
+  removeEdge(
+    const Node::IndexType,
+    const Node::IndexType
+  );
+
+  void
+  updatePayload(
+    const Node::IndexType,
+    const Node::PayloadType
+  );
+
+  void
+  applyUpdates();
+
+  bool
+  isRemoved(const Node::IndexType) const;
+
+  const std::vector<Node::IndexType>&
+  removedNodes() const;
+
+  const Frontier&
+  dirty() const;
+
+  VersionType
+  version(const unsigned int) const;
+
+  void
+  markDirty(const unsigned int);
+
+  void
+  neighbors(
+    const unsigned int,
+    std::vector<Node::IndexType>&
+  ) const;
+
+  void
+  compactEdges();
+
+  void
+  transpose(
+    const std::vector<std::vector<Node::IndexType> >&,
+    CompressedIndexLists<Node::IndexType>&
+  ) const;
+
+  void
+  buildTranspose();
+
+  const CompressedIndexLists<Node::IndexType>&
+  transposeInteractionSets(const std::vector<std::vector<Node> >&);
+
+  void
+  interactionSetsChanged();
+
+  bool
+  hasTranspose() const;
+
+  void
+  inNeighbors(
+    const unsigned int,
+    std::vector<Node::IndexType>&
+  ) const;
+
+  double
+  imbalance(const std::vector<double>&) const;
+
+  bool
+  rebalance(const std::vector<double>&);
+
+  bool
+  reorder(const Ordering);
+
+  Node::IndexType
+  originalIndex(const unsigned int) const;
+
+  Frontier&
+  frontier();
+
+  const Frontier&
+  frontier() const;
+
+  const Frontier&
+  changed() const;
+
+  void
+  setHalo(const HaloExchange* const);
+
+  const HaloExchange*
+  halo() const;
+
+  void
+  placeNodes();
+
+  bool
+  isPlaced() const;
+
+  unsigned long long
+  numLocalAccesses() const;
+
+  unsigned long long
+  numRemoteAccesses() const;
+
+  void
+  buildTreeIndex();
+
+  const TreeIndex*
+  treeIndex() const;
+
   template <AlgorithmChoice>
   bool
   compute(
@@ -87,15 +337,230 @@ public:
     const std::vector<std::vector<Node> >&
   );
 
+  bool
+  compute(
+    const AlgorithmChoice,
+    const CombineFunction&,
+    const std::vector<std::vector<Node> >&
+  );
+
+  bool
+  computeFused(
+    const AlgorithmChoice,
+    const std::vector<const CombineFunction*>&,
+    const std::vector<const std::vector<std::vector<Node> >*>&
+  );
+
+  bool
+  computePush(
+    const CombineFunction&,
+    const std::vector<std::vector<Node> >&
+  );
+
+  void
+  beginCombine();
+
+  bool
+  combineLocalNode(
+    const CombineFunction&,
+    const unsigned int,
+    const std::vector<Node>&
+  );
+
+  void
+  combineLocalNodes(
+    const CombineFunction&,
+    const std::vector<unsigned int>&,
+    const std::vector<std::vector<Node> >&
+  );
+
+  bool
+  combineLocalCopy(
+    const CombineFunction&,
+    const unsigned int,
+    const std::vector<Node>&,
+    Node::PayloadType&,
+    std::vector<Node::PayloadType>&
+  ) const;
+
+  void
+  commitPayload(
+    const unsigned int,
+    const Node::PayloadType
+  );
+
+  void
+  endCombine();
+
   std::vector<Node>& getProcessorNodeList(){
 	  return m_nodeList;
   }
 
   ~Graph();
 
+private:
+  bool
+  combineNode(
+    const CombineFunction&,
+    Node&,
+    const std::vector<Node>&,
+    std::vector<Node::PayloadType>&
+  ) const;
+
+  const Frontier&
+  activeNodes();
+
+  void
+  combineLevel(
+    const TreeIndex&,
+    const CombineFunction&,
+    const unsigned int,
+    const std::vector<std::vector<Node> >&,
+    const std::unordered_map<Node::IndexType, Node::PayloadType>&
+  );
+
+  void
+  accumulateUpward(
+    const TreeIndex&,
+    const CombineFunction&,
+    const std::vector<std::vector<Node> >&
+  );
+
+  void
+  accumulateDownward(
+    const TreeIndex&,
+    const CombineFunction&,
+    const std::vector<std::vector<Node> >&
+  );
+
+  bool
+  pullReduction(
+    const Reduction&,
+    const std::vector<std::vector<Node> >&
+  );
+
+  void
+  reduceNodes(
+    const std::vector<const Reduction*>&,
+    const unsigned int* const,
+    const int,
+    const std::vector<const std::vector<std::vector<Node> >*>&,
+    std::vector<char>&
+  );
+
+  bool
+  reduceNode(
+    const std::vector<const Reduction*>&,
+    const unsigned int,
+    const std::vector<const std::vector<std::vector<Node> >*>&,
+    Node::PayloadType* const
+  );
+
+  bool
+  pushReduction(
+    const Reduction&,
+    const std::vector<std::vector<Node> >&
+  );
+
+  Node::IndexType
+  appendNode(const Node::PayloadType);
+
+  void
+  stamp(const unsigned int);
+
+  void
+  localOrder(
+    const Ordering,
+    std::vector<unsigned int>&
+  ) const;
+
+  void
+  insertEdge(
+    const unsigned int,
+    const Node::IndexType
+  );
+
+  void
+  eraseEdge(
+    const unsigned int,
+    const Node::IndexType
+  );
+
+private:
+  /** Mutation of a node, buffered until it is applied by its owner **/
+  class Mutation {
+    public:
+      enum Kind {
+        RemoveNode,
+        AddEdge,
+        RemoveEdge,
+        UpdatePayload
+      };
+
+    public:
+      Kind m_kind;
+      Node::IndexType m_node;
+      Node::IndexType m_other;
+      Node::PayloadType m_payload;
+  }; // class Mutation
+
+  /** Node moving to another processor, followed by its encoded edges **/
+  class Migrant {
+    public:
+      Node m_node;
+      VersionType m_version;
+      Node::IndexType m_originalIndex;
+      char m_removed;
+      char m_dirty;
+  }; // class Migrant
+
 private:
   std::vector<Node> m_nodeList;
-  const MPICommunicator& m_mpiCommunicator;
+  std::vector<InputData::Point> m_points;
+  const InputData::Point* m_sharedPoints;
+  InputData::Bounds m_bounds;
+  std::vector<const InputData::Point*> m_peerPoints;
+  std::vector<Node::IndexType> m_offsets;
+  const MPICommunicator m_mpiCommunicator;
+
+  unsigned int m_numBaseNodes;
+  CompressedIndexLists<Node::IndexType> m_edges;
+  std::unordered_map<unsigned int, std::vector<Node::IndexType> > m_insertedEdges;
+  std::unordered_map<unsigned int, std::vector<Node::IndexType> > m_erasedEdges;
+  CompressedIndexLists<Node::IndexType> m_transpose;
+  bool m_hasTranspose;
+  CompressedIndexLists<Node::IndexType> m_setTranspose;
+  const std::vector<std::vector<Node> >* m_transposedSets;
+  unsigned long long m_setsGeneration;
+  unsigned long long m_transposedGeneration;
+  bool m_setsAreEdges;
+
+  std::vector<Mutation> m_mutations;
+  std::vector<char> m_removed;
+  std::unordered_set<Node::IndexType> m_removedNodes;
+  std::vector<Node::IndexType> m_lastRemovedNodes;
+  Frontier m_dirty;
+  std::vector<VersionType> m_versions;
+  VersionType m_versionClock;
+  std::vector<Node::IndexType> m_originalIndices;
+  bool m_reordered;
+
+  Frontier m_frontier;
+  Frontier m_active;
+  Frontier m_changed;
+  const HaloExchange* m_halo;
+  std::vector<unsigned int> m_slots;
+  std::vector<Node::PayloadType> m_payloads;
+  std::vector<unsigned int> m_deferredNodes;
+  std::vector<Node::PayloadType> m_deferredPayloads;
+
+  std::unique_ptr<TreeIndex> m_treeIndex;
+
+  bool m_numaPlaced;
+  std::vector<int> m_nodeDomains;
+  std::vector<int> m_threadDomains;
+  unsigned long long m_numLocalAccesses;
+  unsigned long long m_numRemoteAccesses;
 }; // class Graph
 
 #endif // GRAPHWORKS_GRAPH_HPP_
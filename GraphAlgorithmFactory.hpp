@@ -14,9 +14,8 @@ class GraphAlgorithmFactory {
 
 public:
   GraphAlgorithmFactory(
-    const MPICommunicator& mpiCommunicator
-  ) : m_mpiCommunicator(mpiCommunicator)
-  { }
+    const MPICommunicator&
+  );
 
   void
   registerAlgorithm(
@@ -30,7 +29,9 @@ public:
 
   GraphAlgorithmFunction*
   getAlgorithm(
-    const Graph&,
+    Graph&,
+    const CombineFunction&,
+    const std::vector<std::vector<Graph::Node> >&,
     const Graph::AlgorithmChoice
   );
 
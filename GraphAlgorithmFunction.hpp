@@ -19,6 +19,7 @@ public:
   float
   getScore(
     Graph&,
+    const CombineFunction&,
   	const std::vector<std::vector<Graph::Node> >&
   ) const = 0;
 
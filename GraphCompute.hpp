@@ -1,13 +1,19 @@
 #ifndef GRAPHWORKS_GRAPHCOMPUTE_HPP_
 #define GRAPHWORKS_GRAPHCOMPUTE_HPP_
 
+#include "Frontier.hpp"
 #include "GenerateFunction.hpp"
 #include "Graph.hpp"
+#include "MPICommunicator.hpp"
 
+#include <memory>
 #include <vector>
 
 class CombineFunction;
-class MPICommunicator;
+class HaloExchange;
+class PerfCounters;
+class RemoteCache;
+class TaskPool;
 
 class GraphCompute {
 public:
@@ -15,6 +21,18 @@ public:
   typedef typename Graph::Node GraphNode;
   typedef typename Graph::ConstNodeIterator GraphNodeIterator;
 
+  /**
+   * Generate and combine functions of one computation in a batch. The
+   * computations of a batch must not read each other's results: all the
+   * interaction sets are generated before any of them is combined, and
+   * fused computations are combined node by node.
+   **/
+  class Computation {
+    public:
+      const GenerateFunction* m_generate;
+      const CombineFunction* m_combine;
+  }; // class Computation
+
 public:
   GraphCompute(const MPICommunicator&);
 
@@ -25,8 +43,74 @@ public:
     const CombineFunction&
   );
 
+  bool
+  computeAsync(
+    Graph&,
+    const GenerateFunction&,
+    const CombineFunction&
+  );
+
+  bool
+  computeBatch(
+    Graph&,
+    const std::vector<Computation>&
+  );
+
+  bool
+  iterate(
+    Graph&,
+    const GenerateFunction&,
+    const CombineFunction&,
+    const unsigned int
+  );
+
+  bool
+  update(
+    Graph&,
+    const GenerateFunction&,
+    const CombineFunction&,
+    const unsigned int
+  );
+
+  bool
+  rebalance(
+    Graph&,
+    const GenerateFunction&,
+    const double
+  );
+
+  bool
+  reorder(
+    Graph&,
+    const GenerateFunction&,
+    const Graph::Ordering
+  );
+
+  void
+  enableNumaPlacement();
+
+  void
+  enablePerfCounters();
+
+  void
+  enableRemoteCache(const unsigned int);
+
+  const RemoteCache*
+  remoteCache() const;
+
   ~GraphCompute();
 
+private:
+  /** Interaction sets generated for a range of the local nodes **/
+  class InteractionSetChunk {
+    public:
+      unsigned int m_begin;
+      unsigned int m_end;
+      std::vector<std::vector<GraphNode> > m_interactionSets;
+      int m_dependencyFlag;   // -1 if no node of the range was generated
+      bool m_localOnly;       // whether every set holds only its node
+  }; // class InteractionSetChunk
+
 private:
   bool
   generateInteractionSetForNode(
@@ -39,15 +123,45 @@ private:
 
   bool
   generateAllInteractionSets(
-    const Graph&,
+    Graph&,
     const GenerateFunction&,
     GraphAlgorithmChoice&,
-    std::vector<std::vector<GraphNode> >&
+    std::vector<std::vector<GraphNode> >&,
+    std::vector<std::vector<GraphNode::IndexType> >&
+  ) const;
+
+  void
+  generateBatchInteractionSets(
+    Graph&,
+    const std::vector<Computation>&,
+    std::vector<GraphAlgorithmChoice>&,
+    std::vector<std::vector<std::vector<GraphNode> > >&,
+    std::vector<int>&
+  ) const;
+
+  InteractionSetChunk
+  generateInteractionSetChunk(
+    const Graph&,
+    const GenerateFunction&,
+    const unsigned int
+  ) const;
+
+  void
+  normalizeInteractionSet(
+    const Graph&,
+    std::vector<GraphNode>&
+  ) const;
+
+  void
+  normalizeInteractionSets(
+    const Graph&,
+    std::vector<std::vector<GraphNode> >&,
+    std::vector<std::vector<GraphNode::IndexType> >&
   ) const;
 
   GraphAlgorithmChoice
   detectCombineCase(
-    const Graph&,
+    Graph&,
     const GraphAlgorithmChoice,
     const std::vector<std::vector<GraphNode> >&,
     const bool
@@ -61,8 +175,79 @@ private:
     const GraphAlgorithmChoice
   ) const;
 
+  void
+  combineAllPipelined(
+    Graph&,
+    const CombineFunction&
+  );
+
+  void
+  activateReferences(const std::vector<unsigned int>&);
+
+  void
+  combineArrived(
+    Graph&,
+    const CombineFunction&,
+    const bool
+  );
+
+  void
+  placeInteractionSets(std::vector<std::vector<GraphNode> >&) const;
+
+  double
+  localAccessRatio(
+    const Graph&,
+    const unsigned long long* const
+  ) const;
+
+  void
+  reportPerfCounters(const unsigned long long* const) const;
+
+  double
+  meanEdgeSpan(const Graph&) const;
+
+  double
+  combineReadTime(const Graph&) const;
+
+  void
+  rebuildHalo(Graph&);
+
+  void
+  fillRemotePayloads(
+    const Graph&,
+    const GraphAlgorithmChoice,
+    std::vector<std::vector<GraphNode> >&,
+    const std::vector<std::vector<GraphNode::IndexType> >&
+  );
+
+  bool
+  runSupersteps(
+    Graph&,
+    const CombineFunction&,
+    const unsigned int,
+    unsigned int&,
+    double&,
+    double&
+  );
+
 private:
-  const MPICommunicator& m_mpiCommunicator;
+  const MPICommunicator m_mpiCommunicator;
+
+  std::vector<std::vector<GraphNode> > m_interactionSets;
+  GraphAlgorithmChoice m_combineCase;
+  std::vector<std::vector<GraphNode::IndexType> > m_requests;
+  std::unique_ptr<HaloExchange> m_halo;
+
+  Frontier m_pipelineActive;
+  std::vector<unsigned int> m_pipelinePending;
+  std::vector<unsigned int> m_pipelineSources;
+  std::vector<unsigned int> m_pipelineRanks;
+  std::vector<unsigned int> m_pipelineReady;
+
+  std::unique_ptr<TaskPool> m_tasks;
+  std::unique_ptr<RemoteCache> m_remoteCache;
+  std::unique_ptr<PerfCounters> m_perfCounters;
+  bool m_numaPlacement;
 }; // class GraphCompute
 
 #endif // GRAPHWORKS_GRAPHCOMPUTE_HPP_
@@ -0,0 +1,206 @@
+#ifndef GRAPHWORKS_HALOEXCHANGE_HPP_
+#define GRAPHWORKS_HALOEXCHANGE_HPP_
+
+#include "Graph.hpp"
+
+#include <mpi.h>
+
+#include <vector>
+
+class Frontier;
+class MPICommunicator;
+
+/**
+ * Ghost copies of the remote nodes which appear in the local interaction
+ * sets, with the subscriptions needed to keep them up to date.
+ *
+ * The local nodes and the ghosts share one extended numbering: the local
+ * node i is i, and ghost g is size() + g, the ghosts being sorted by their
+ * global indices. Every entry of the interaction sets is mapped to the
+ * extended index of its source node, and every extended index lists the
+ * entries it appears in, so that the changes of a node can be pushed to
+ * exactly the interaction sets which depend on it.
+ */
+class HaloExchange {
+public:
+  typedef Graph::Node::IndexType IndexType;
+  typedef Graph::Node::PayloadType PayloadType;
+
+public:
+  HaloExchange(
+    const Graph&,
+    const std::vector<std::vector<Graph::Node> >&
+  );
+
+  HaloExchange(
+    const Graph&,
+    const std::vector<std::vector<Graph::Node> >&,
+    const std::vector<std::vector<IndexType> >&
+  );
+
+  unsigned int
+  numLocal() const;
+
+  unsigned int
+  numGhosts() const;
+
+  unsigned int
+  numExtended() const;
+
+  IndexType
+  ghostIndex(const unsigned int) const;
+
+  unsigned int
+  extendedIndex(
+    const Graph&,
+    const IndexType
+  ) const;
+
+  unsigned int
+  source(
+    const unsigned int,
+    const unsigned int
+  ) const;
+
+  unsigned int
+  numReferences(const unsigned int) const;
+
+  const unsigned int*
+  references(const unsigned int) const;
+
+  unsigned int
+  referenceTarget(const unsigned int) const;
+
+  unsigned int
+  referenceSlot(const unsigned int) const;
+
+  PayloadType
+  payload(
+    const Graph&,
+    const unsigned int
+  ) const;
+
+  void
+  exchange(
+    const Graph&,
+    const Frontier&,
+    Frontier&
+  );
+
+  void
+  load(const std::vector<std::vector<Graph::Node> >&);
+
+  void
+  refresh(
+    const Graph&,
+    const Frontier&,
+    std::vector<std::vector<Graph::Node> >&
+  ) const;
+
+  void
+  refresh(
+    const Graph&,
+    const unsigned int,
+    std::vector<Graph::Node>&
+  ) const;
+
+  void
+  refresh(
+    const Graph&,
+    const std::vector<unsigned int>&,
+    std::vector<std::vector<Graph::Node> >&
+  ) const;
+
+  bool
+  isBoundary(const unsigned int) const;
+
+  unsigned int
+  numSourceRanks(const unsigned int) const;
+
+  unsigned int
+  numDependents(const unsigned int) const;
+
+  const unsigned int*
+  dependents(const unsigned int) const;
+
+  void
+  post(
+    const Graph&,
+    const Frontier&
+  );
+
+  bool
+  isReceiving() const;
+
+  void
+  receiveSome(
+    const bool,
+    Frontier&,
+    std::vector<unsigned int>&,
+    std::vector<unsigned int>&
+  );
+
+  void
+  waitSends();
+
+  void
+  update(
+    const Graph&,
+    const std::vector<std::vector<Graph::Node> >&,
+    const std::vector<unsigned int>&
+  );
+
+  ~HaloExchange();
+
+private:
+  void
+  mapReferences();
+
+  void
+  connect();
+
+  static std::vector<std::vector<IndexType> >
+  collectRequests(
+    const Graph&,
+    const std::vector<std::vector<Graph::Node> >&
+  );
+
+private:
+  class Update {
+    public:
+      unsigned int m_position;
+      PayloadType m_value;
+  }; // class Update
+
+private:
+  const MPICommunicator& m_mpiCommunicator;
+  unsigned int m_numLocal;
+
+  std::vector<IndexType> m_ghostIndices;
+  std::vector<unsigned int> m_ghostOffsets;
+  std::vector<PayloadType> m_ghostPayloads;
+
+  std::vector<unsigned int> m_setOffsets;
+  std::vector<unsigned int> m_setSources;
+  std::vector<unsigned int> m_setTargets;
+
+  std::vector<unsigned int> m_referenceOffsets;
+  std::vector<unsigned int> m_references;
+
+  std::vector<unsigned int> m_sendOffsets;
+  std::vector<unsigned int> m_sendIndices;
+
+  std::vector<unsigned int> m_numSourceRanks;
+  std::vector<unsigned int> m_dependentOffsets;
+  std::vector<unsigned int> m_dependents;
+
+  std::vector<unsigned int> m_receiveRanks;
+  std::vector<MPI_Request> m_receiveRequests;
+  std::vector<std::vector<Update> > m_receiveBuffers;
+  std::vector<unsigned int> m_sendRanks;
+  std::vector<MPI_Request> m_sendRequests;
+  std::vector<std::vector<Update> > m_sendBuffers;
+  unsigned int m_numReceiving;
+}; // class HaloExchange
+
+#endif // GRAPHWORKS_HALOEXCHANGE_HPP_
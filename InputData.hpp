@@ -1,14 +1,60 @@
 #ifndef GRAPHWORKS_INPUTDATA_HPP_
 #define GRAPHWORKS_INPUTDATA_HPP_
 
+#include <fstream>
 #include <string>
 
 class MPICommunicator;
 
+template <typename T>
+class SharedMemoryWindow;
+
 class InputData {
 public:
-  InputData();
+  InputData(const bool = false);
+
+  /**
+   * Bounding box within which the coordinates of the points of one data set
+   * are quantized. It is kept along with the points, rather than in them,
+   * and every point is set and read back through the box of its data set.
+   */
+  class Bounds {
+    public:
+      Bounds();
+
+      Bounds(
+        const double* const,
+        const double* const
+      );
+
+      double
+      lower(const unsigned int) const;
+
+      double
+      upper(const unsigned int) const;
+
+      double
+      step(const unsigned int) const;
 
+    public:
+      static const unsigned int s_bits = 21;
+
+    private:
+      double m_lower[3];
+      double m_upper[3];
+      double m_step[3];
+  }; // class Bounds
+
+  /**
+   * Coordinates of a point, in the representation selected at build time.
+   *
+   * By default, the coordinates are stored as doubles. With
+   * GRAPHWORKS_COORDS_FLOAT, they are stored as floats, and with
+   * GRAPHWORKS_COORDS_QUANTIZED, as 21 bit offsets within the bounds of
+   * the data set, packed into one 64 bit word. The accessors return the
+   * coordinates converted back to doubles, and take the same bounds as the
+   * point was set with, which the other representations ignore.
+   */
   class Point {
     public:
       Point();
@@ -17,22 +63,37 @@ public:
       set(
         const double,
         const double,
-        const double
+        const double,
+        const Bounds&
       );
 
       double
-      x() const;
+      x(const Bounds&) const;
 
       double
-      y() const;
+      y(const Bounds&) const;
 
       double
-      z() const;
+      z(const Bounds&) const;
 
     private:
+#if defined(GRAPHWORKS_COORDS_QUANTIZED)
+      double
+      coordinate(
+        const unsigned int,
+        const Bounds&
+      ) const;
+
+      unsigned long long m_code;
+#elif defined(GRAPHWORKS_COORDS_FLOAT)
+      float m_x;
+      float m_y;
+      float m_z;
+#else
       double m_x;
       double m_y;
       double m_z;
+#endif
   }; // class Point
 
   bool
@@ -41,15 +102,63 @@ public:
     const MPICommunicator&
   );
 
+  bool
+  write(
+    const std::string&,
+    const MPICommunicator&
+  ) const;
+
   const Point*
   points() const;
 
+  const Bounds&
+  bounds() const;
+
   unsigned int
   numLocalPoints() const;
 
+  unsigned int
+  numNodeProcs() const;
+
+  const Point*
+  nodePoints(
+    const unsigned int,
+    unsigned int&
+  ) const;
+
+  const MPICommunicator*
+  nodeCommunicator() const;
+
   ~InputData();
 
 private:
+  bool
+  readBounds(
+    std::ifstream&,
+    double* const,
+    double* const
+  ) const;
+
+  bool
+  readCompressed(
+    const std::string&,
+    const MPICommunicator&
+  );
+
+  void
+  readDistributed(
+    std::ifstream&,
+    const MPICommunicator&,
+    const unsigned int
+  );
+
+  void
+  readShared(
+    std::ifstream&,
+    const MPICommunicator&,
+    const unsigned int
+  );
+
   bool 
   allocate();
 
@@ -58,8 +167,11 @@ private:
 
 private:
   Point* m_points;
+  Bounds m_bounds;
   unsigned int m_numGlobalPoints;
   unsigned int m_numLocalPoints;
+  const bool m_sharedMemory;
+  SharedMemoryWindow<Point>* m_window;
 };
 
 #endif // GRAPHWORKS_INPUTDATA_HPP_
@@ -0,0 +1,104 @@
+#ifndef GRAPHWORKS_KDTREE_HPP_
+#define GRAPHWORKS_KDTREE_HPP_
+
+#include "InputData.hpp"
+
+#include <utility>
+#include <vector>
+
+class KdTree {
+public:
+  typedef std::pair<double, unsigned int> Neighbor;
+
+public:
+  KdTree();
+
+  void
+  build(
+    const InputData::Point* const,
+    const InputData::Bounds&,
+    const unsigned int
+  );
+
+  void
+  nearest(
+    const double* const,
+    const unsigned int,
+    const double,
+    std::vector<Neighbor>&
+  ) const;
+
+  void
+  withinRadius(
+    const double* const,
+    const double,
+    std::vector<Neighbor>&
+  ) const;
+
+  unsigned int
+  size() const;
+
+  ~KdTree();
+
+private:
+  class Cell {
+    public:
+      unsigned int m_begin;
+      unsigned int m_end;
+      unsigned int m_child;
+      double m_min[3];
+      double m_max[3];
+  }; // class Cell
+
+  void
+  buildCell(
+    const unsigned int,
+    const unsigned int,
+    const unsigned int
+  );
+
+  void
+  searchNearest(
+    const unsigned int,
+    const double* const,
+    const unsigned int,
+    const double,
+    std::vector<Neighbor>&
+  ) const;
+
+  void
+  searchRadius(
+    const unsigned int,
+    const double* const,
+    const double,
+    std::vector<Neighbor>&
+  ) const;
+
+  double
+  coordinate(
+    const unsigned int,
+    const unsigned int
+  ) const;
+
+  double
+  distance(
+    const double* const,
+    const unsigned int
+  ) const;
+
+  double
+  cellDistance(
+    const double* const,
+    const unsigned int
+  ) const;
+
+private:
+  static const unsigned int s_leafSize = 16;
+
+  const InputData::Point* m_points;
+  InputData::Bounds m_bounds;
+  std::vector<unsigned int> m_order;
+  std::vector<Cell> m_cells;
+}; // class KdTree
+
+#endif // GRAPHWORKS_KDTREE_HPP_
@@ -3,11 +3,15 @@
 
 #include <mpi.h>
 
+#include <memory>
+#include <stdexcept>
+
 class MPICommunicator {
 public:
   MPICommunicator(MPI_Comm communicator = MPI_COMM_WORLD)
-    : m_communicator(communicator)
-  { 
+    : m_communicator(communicator),
+    m_owner()
+  {
     int size, rank;
     MPI_Comm_size(m_communicator, &size);
     MPI_Comm_rank(m_communicator, &rank);
@@ -19,7 +23,8 @@ public:
   MPICommunicator(const MPICommunicator& mpiCommunicator)
     : m_communicator(*mpiCommunicator),
     m_rank(mpiCommunicator.rank()),
-    m_size(mpiCommunicator.size())
+    m_size(mpiCommunicator.size()),
+    m_owner(mpiCommunicator.m_owner)
   {
   }
 
@@ -29,10 +34,84 @@ public:
 
   size_t rank() const { return m_rank; }
 
+  /**
+   * @brief Creates the communicator of the processors which share memory
+   *        with this processor, i.e. which run on the same host.
+   *
+   * This is a collective call. Processors retain their relative order.
+   */
+  MPICommunicator splitShared() const
+  {
+    MPI_Comm shared;
+    MPI_Comm_split_type(m_communicator, MPI_COMM_TYPE_SHARED, static_cast<int>(m_rank), MPI_INFO_NULL, &shared);
+    return adopt(shared);
+  }
+
+  /**
+   * @brief Creates the communicator of the processors which pass the same
+   *        color, so that disjoint groups can compute independently.
+   *
+   * This is a collective call. Processors are ordered by their keys, and
+   * then by their ranks in this communicator.
+   */
+  MPICommunicator split(const int color, const int key) const
+  {
+    if (color < 0) {
+      throw std::runtime_error("Colors of the processors can't be negative!");
+    }
+    MPI_Comm split;
+    MPI_Comm_split(m_communicator, color, key, &split);
+    return adopt(split);
+  }
+
+  /**
+   * @brief Splits the processors into groups of contiguous ranks, whose
+   *        sizes differ by at most one.
+   *
+   * @param numGroups   Number of the groups, at most the number of processors.
+   * @param group       Index of the group of this processor.
+   *
+   * This is a collective call.
+   */
+  MPICommunicator splitGroups(const size_t numGroups, size_t& group) const
+  {
+    if ((numGroups == 0) || (numGroups > m_size)) {
+      throw std::runtime_error("Processors can't be split into the groups!");
+    }
+    group = (m_rank * numGroups) / m_size;
+    return split(static_cast<int>(group), static_cast<int>(m_rank));
+  }
+
+private:
+  /**
+   * @brief Frees a derived communicator along with its last copy.
+   */
+  class Free {
+    public:
+      void
+      operator()(MPI_Comm* communicator) const
+      {
+        int finalized;
+        MPI_Finalized(&finalized);
+        if (!finalized) {
+          MPI_Comm_free(communicator);
+        }
+        delete communicator;
+      }
+  }; // class Free
+
+  static MPICommunicator adopt(MPI_Comm communicator)
+  {
+    MPICommunicator adopted(communicator);
+    adopted.m_owner.reset(new MPI_Comm(communicator), Free());
+    return adopted;
+  }
+
 private:
   const MPI_Comm m_communicator;	// the MPI communicator
   size_t m_rank;		// rank of the processor
   size_t m_size; 		// size of the communicator
+  std::shared_ptr<MPI_Comm> m_owner;	// set only for derived communicators
 }; // class MPICommunicator
 
 #endif // GRAPHWORKS_MPICOMMUNICATOR_HPP_
@@ -0,0 +1,112 @@
+#ifndef GRAPHWORKS_MESSAGEAGGREGATOR_HPP_
+#define GRAPHWORKS_MESSAGEAGGREGATOR_HPP_
+
+#include "Graph.hpp"
+#include "Reduction.hpp"
+
+#include <mpi.h>
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+class MPICommunicator;
+
+/**
+ * Buffers fine grained updates of remote nodes per destination processor,
+ * and sends them in bulk once a buffer fills up or grows too old.
+ * Optionally, updates of the same node are combined before being sent.
+ */
+class MessageAggregator {
+public:
+  class Update {
+    public:
+      Graph::Node::IndexType m_target;
+      Graph::Node::PayloadType m_value;
+  }; // class Update
+
+  /** Receiver side callback, invoked for every received update **/
+  class UpdateHandler {
+    public:
+      virtual
+      void
+      operator()(
+        const Graph::Node::IndexType,
+        const Graph::Node::PayloadType
+      ) = 0;
+
+      virtual
+      ~UpdateHandler() { }
+  }; // class UpdateHandler
+
+public:
+  MessageAggregator(
+    const MPICommunicator&,
+    UpdateHandler&,
+    const unsigned int = 4096,
+    const double = 1e-3,
+    const Reduction* const = 0
+  );
+
+  void
+  send(
+    const unsigned int,
+    const Graph::Node::IndexType,
+    const Graph::Node::PayloadType
+  );
+
+  void
+  flush();
+
+  void
+  poll();
+
+  void
+  finish();
+
+  unsigned long long
+  numMessages() const;
+
+  unsigned long long
+  numUpdates() const;
+
+  unsigned long long
+  numCombinedUpdates() const;
+
+  ~MessageAggregator();
+
+private:
+  void
+  flush(const unsigned int);
+
+  void
+  completeSends(const bool);
+
+  void
+  receive(
+    const int,
+    const int
+  );
+
+private:
+  const MPICommunicator& m_mpiCommunicator;
+  UpdateHandler& m_handler;
+  const unsigned int m_maxBufferedUpdates;
+  const double m_flushInterval;
+  const Reduction* const m_combiner;
+
+  std::vector<std::vector<Update> > m_buffers;
+  std::vector<std::unordered_map<Graph::Node::IndexType, unsigned int> > m_positions;
+  std::list<std::pair<MPI_Request, std::vector<Update> > > m_inFlight;
+  std::vector<int> m_sentMessages;
+  std::vector<Update> m_receiveBuffer;
+  unsigned int m_epoch;
+  int m_receivedMessages;
+  double m_lastFlush;
+
+  unsigned long long m_numMessages;
+  unsigned long long m_numUpdates;
+  unsigned long long m_numCombinedUpdates;
+}; // class MessageAggregator
+
+#endif // GRAPHWORKS_MESSAGEAGGREGATOR_HPP_
@@ -0,0 +1,60 @@
+#ifndef GRAPHWORKS_NUMAPLACEMENT_HPP_
+#define GRAPHWORKS_NUMAPLACEMENT_HPP_
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Placement of the data of a processor on the NUMA domains of its host, and
+ * pinning of the threads which work on the data.
+ *
+ * The domains are the ones the processor may run on. The threads are pinned
+ * in blocks of consecutive thread numbers per domain. An array is split
+ * into blocks of consecutive pages per domain in the same proportions, so
+ * the static schedule of a loop over the array gives every thread the part
+ * on its own domain. When built with GRAPHWORKS_HAVE_LIBNUMA, the blocks are
+ * bound to their domains explicitly, which also moves the pages which were
+ * touched before, and the domains of the pages can be looked up. Otherwise
+ * the pages are placed by the threads which touch them first, wherever the
+ * threads run, the host is treated as a single domain, and the domains of
+ * the threads and of the pages are unknown.
+ */
+class NumaPlacement {
+public:
+  static
+  unsigned int
+  numDomains();
+
+  static
+  unsigned int
+  threadDomain(
+    const unsigned int,
+    const unsigned int
+  );
+
+  static
+  void
+  pinThreads();
+
+  static
+  int
+  currentDomain();
+
+  static
+  void
+  place(
+    void* const,
+    const std::size_t
+  );
+
+  static
+  void
+  pageDomains(
+    const void* const,
+    const std::size_t,
+    const std::size_t,
+    std::vector<int>&
+  );
+}; // class NumaPlacement
+
+#endif // GRAPHWORKS_NUMAPLACEMENT_HPP_
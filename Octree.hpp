@@ -0,0 +1,142 @@
+#ifndef GRAPHWORKS_OCTREE_HPP_
+#define GRAPHWORKS_OCTREE_HPP_
+
+#include "Graph.hpp"
+#include "InputData.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+class MPICommunicator;
+
+class Octree {
+public:
+  typedef uint64_t KeyType;
+
+public:
+  Octree(
+    const MPICommunicator&,
+    const unsigned int = 1,
+    const unsigned int = s_maxLevel
+  );
+
+  bool
+  build(
+    const InputData::Point* const,
+    const InputData::Bounds&,
+    const unsigned int
+  );
+
+  const std::vector<Graph::Node>&
+  nodes() const;
+
+  const InputData::Point*
+  points() const;
+
+  const InputData::Bounds&
+  bounds() const;
+
+  unsigned int
+  numLocalPoints() const;
+
+  KeyType
+  cellKey(const unsigned int) const;
+
+  unsigned int
+  cellLevel(const unsigned int) const;
+
+  void
+  pointRange(
+    const unsigned int,
+    unsigned int&,
+    unsigned int&
+  ) const;
+
+  ~Octree();
+
+public:
+  static const unsigned int s_maxLevel = 21;
+
+private:
+  class Record {
+    public:
+      KeyType m_key;
+      InputData::Point m_point;
+
+      bool
+      operator<(const Record& other) const { return m_key < other.m_key; }
+  }; // class Record
+
+  class Cell {
+    public:
+      KeyType m_key;
+      unsigned int m_level;
+      unsigned int m_begin;
+      unsigned int m_end;
+  }; // class Cell
+
+  void
+  computeKeys(
+    const InputData::Point* const,
+    const InputData::Bounds&,
+    const unsigned int,
+    std::vector<Record>&
+  ) const;
+
+  void
+  sampleSort(std::vector<Record>&) const;
+
+  void
+  findLocalRoots(
+    const KeyType,
+    const unsigned int,
+    const unsigned int,
+    const unsigned int,
+    const bool,
+    const KeyType,
+    const bool,
+    const KeyType,
+    std::vector<Cell>&
+  ) const;
+
+  void
+  buildSubtree(
+    const Cell&,
+    const unsigned int,
+    std::vector<unsigned int>&,
+    std::vector<unsigned int>&
+  );
+
+  unsigned int
+  findPoint(
+    const unsigned int,
+    const unsigned int,
+    const KeyType
+  ) const;
+
+  static
+  KeyType
+  firstKey(
+    const KeyType,
+    const unsigned int
+  );
+
+  static
+  KeyType
+  lastKey(
+    const KeyType,
+    const unsigned int
+  );
+
+private:
+  const MPICommunicator& m_mpiCommunicator;
+  const unsigned int m_maxPointsPerLeaf;
+  const unsigned int m_maxLevel;
+  std::vector<InputData::Point> m_points;
+  InputData::Bounds m_bounds;
+  std::vector<KeyType> m_keys;
+  std::vector<Cell> m_cells;
+  std::vector<Graph::Node> m_nodes;
+}; // class Octree
+
+#endif // GRAPHWORKS_OCTREE_HPP_
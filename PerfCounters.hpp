@@ -0,0 +1,58 @@
+#ifndef GRAPHWORKS_PERFCOUNTERS_HPP_
+#define GRAPHWORKS_PERFCOUNTERS_HPP_
+
+#include <vector>
+
+/**
+ * Hardware performance counters of this processor, read through the Linux
+ * perf_event_open interface around the phases of a computation.
+ *
+ * Every event is counted in user space by the OpenMP threads, each of which
+ * opens its own counters, and by the threads which the calling thread
+ * starts while the counters are open. The counts are scaled up when the
+ * kernel multiplexes the counters, and summed over the threads. Events
+ * which can't be opened, because the hardware, the kernel or its
+ * perf_event_paranoid setting doesn't allow them, are left out; on other
+ * systems, all of them are.
+ */
+class PerfCounters {
+public:
+  enum Event {
+    Cycles,
+    Instructions,
+    LLCMisses,
+    DTLBMisses,
+    BranchMisses,
+    NumEvents
+  };
+
+public:
+  PerfCounters();
+
+  bool
+  isAvailable(const Event) const;
+
+  void
+  start();
+
+  void
+  stop(unsigned long long* const);
+
+  static
+  const char*
+  name(const Event);
+
+  ~PerfCounters();
+
+private:
+  PerfCounters(const PerfCounters&);
+
+  PerfCounters&
+  operator=(const PerfCounters&);
+
+private:
+  const unsigned int m_numThreads;
+  std::vector<int> m_descriptors;
+}; // class PerfCounters
+
+#endif // GRAPHWORKS_PERFCOUNTERS_HPP_
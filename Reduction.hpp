@@ -0,0 +1,141 @@
+#ifndef GRAPHWORKS_REDUCTION_HPP_
+#define GRAPHWORKS_REDUCTION_HPP_
+
+#include "Graph.hpp"
+
+#include <mpi.h>
+
+#include <cstring>
+#include <limits>
+#include <stdint.h>
+
+/**
+ * Associative and commutative reduction of node payloads.
+ * For BitwiseOr, the bits of the payloads are treated as 64-bit masks.
+ */
+class Reduction {
+public:
+  enum Operator {
+    Sum,
+    Min,
+    Max,
+    BitwiseOr
+  };
+
+  typedef Graph::Node::PayloadType PayloadType;
+
+public:
+  Reduction(const Operator op)
+    : m_op(op)
+  { }
+
+  Operator
+  op() const { return m_op; }
+
+  /**
+   * @brief Reducing a value more than once leaves the same result for Min,
+   *        Max and BitwiseOr, but not for Sum.
+   */
+  bool
+  isIdempotent() const { return m_op != Sum; }
+
+  PayloadType
+  operator()(
+    const PayloadType a,
+    const PayloadType b
+  ) const
+  {
+    switch (m_op) {
+      case Sum:
+        return a + b;
+      case Min:
+        return (b < a) ? b : a;
+      case Max:
+        return (a < b) ? b : a;
+      default:
+        return fromBits(toBits(a) | toBits(b));
+    }
+  }
+
+  /**
+   * @brief Reduces a value into a target.
+   *
+   * @return true if the target changed.
+   */
+  bool
+  update(
+    PayloadType& target,
+    const PayloadType value
+  ) const
+  {
+    const PayloadType reduced = (*this)(target, value);
+    if (toBits(reduced) == toBits(target)) {
+      return false;
+    }
+    target = reduced;
+    return true;
+  }
+
+  /**
+   * @brief Reduces a value into a target which is shared between threads,
+   *        using a lock free compare and swap loop.
+   *
+   * @return true if this call changed the target.
+   */
+  bool
+  atomicUpdate(
+    PayloadType& target,
+    const PayloadType value
+  ) const
+  {
+    PayloadType expected;
+    __atomic_load(&target, &expected, __ATOMIC_RELAXED);
+    while (true) {
+      PayloadType reduced = (*this)(expected, value);
+      if (toBits(reduced) == toBits(expected)) {
+        return false;
+      }
+      if (__atomic_compare_exchange(&target, &expected, &reduced, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        return true;
+      }
+    }
+  }
+
+  PayloadType
+  identity() const
+  {
+    switch (m_op) {
+      case Sum:
+        return 0;
+      case Min:
+        return std::numeric_limits<PayloadType>::max();
+      case Max:
+        return -std::numeric_limits<PayloadType>::max();
+      default:
+        return fromBits(0);
+    }
+  }
+
+  static
+  uint64_t
+  toBits(const PayloadType value)
+  {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+  }
+
+  static
+  PayloadType
+  fromBits(const uint64_t bits)
+  {
+    PayloadType value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+private:
+  Operator m_op;
+}; // class Reduction
+
+#endif // GRAPHWORKS_REDUCTION_HPP_
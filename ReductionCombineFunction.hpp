@@ -0,0 +1,35 @@
+#ifndef GRAPHWORKS_REDUCTIONCOMBINEFUNCTION_HPP_
+#define GRAPHWORKS_REDUCTIONCOMBINEFUNCTION_HPP_
+
+#include "CombineFunction.hpp"
+#include "Graph.hpp"
+#include "Reduction.hpp"
+
+/**
+ * Combine function which reduces the payloads of the interaction set into
+ * the payload of the node. Since the reduction is associative and
+ * commutative, the computations apply it with multiple threads.
+ */
+class ReductionCombineFunction : public CombineFunction {
+public:
+  ReductionCombineFunction(const Reduction::Operator op)
+    : m_reduction(op)
+  { }
+
+  bool
+  operator()(
+    Graph::Node& node,
+    const Graph::Node& other
+  ) const
+  {
+    return m_reduction.update(node.payload(), other.payload());
+  }
+
+  const Reduction*
+  reduction() const { return &m_reduction; }
+
+private:
+  const Reduction m_reduction;
+}; // class ReductionCombineFunction
+
+#endif // GRAPHWORKS_REDUCTIONCOMBINEFUNCTION_HPP_
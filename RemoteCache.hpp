@@ -0,0 +1,90 @@
+#ifndef GRAPHWORKS_REMOTECACHE_HPP_
+#define GRAPHWORKS_REMOTECACHE_HPP_
+
+#include "Graph.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+class MPICommunicator;
+
+/**
+ * Cache of the payloads of the remote nodes which appear in the local
+ * interaction sets, kept across computations.
+ *
+ * The cache holds a fixed number of entries, each of which is the payload of
+ * a remote node. Nodes are mapped to the entries by their global indices,
+ * and a node evicts the node held by its entry. The owners keep the
+ * processors which cache each of their nodes, and push the payloads of the
+ * nodes whose versions moved on to them, so that the cached nodes are served
+ * without asking their owners. Only the uncached nodes are requested, which
+ * subscribes to them, and the evicted nodes are unsubscribed with the next
+ * requests. The owners forget their subscribers when their nodes move, so
+ * the cache has to be cleared by all the processors whenever the graph is
+ * rebalanced or reordered.
+ */
+class RemoteCache {
+public:
+  typedef Graph::Node::IndexType IndexType;
+  typedef Graph::Node::PayloadType PayloadType;
+  typedef Graph::VersionType VersionType;
+
+public:
+  RemoteCache(
+    const unsigned int,
+    const MPICommunicator&
+  );
+
+  void
+  fill(
+    const Graph&,
+    std::vector<std::vector<Graph::Node> >&
+  );
+
+  void
+  clear();
+
+  unsigned int
+  capacity() const;
+
+  unsigned long long
+  numHits() const;
+
+  unsigned long long
+  numMisses() const;
+
+  void
+  resetCounters();
+
+  ~RemoteCache();
+
+private:
+  unsigned int
+  slot(const IndexType) const;
+
+private:
+  /** Cached payload of a remote node **/
+  class Entry {
+    public:
+      IndexType m_index;
+      PayloadType m_payload;
+  }; // class Entry
+
+  /** Processors which cache a local node, and the version they were sent **/
+  class Subscription {
+    public:
+      VersionType m_version;
+      std::vector<unsigned int> m_ranks;
+  }; // class Subscription
+
+private:
+  const MPICommunicator& m_mpiCommunicator;
+  const Graph* m_graph;
+  std::vector<Entry> m_entries;
+  std::unordered_map<IndexType, Subscription> m_subscriptions;
+  std::vector<std::vector<IndexType> > m_cancellations;
+  unsigned long long m_numHits;
+  unsigned long long m_numMisses;
+}; // class RemoteCache
+
+#endif // GRAPHWORKS_REMOTECACHE_HPP_
@@ -0,0 +1,90 @@
+#ifndef GRAPHWORKS_SHAREDMEMORYWINDOW_HPP_
+#define GRAPHWORKS_SHAREDMEMORYWINDOW_HPP_
+
+#include "MPICommunicator.hpp"
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * Array of elements which is allocated in memory shared between the
+ * processors of a node-local communicator. Every processor contributes a
+ * segment to the array, and can access the segments of all the other
+ * processors in the communicator through plain loads and stores.
+ */
+template <typename T>
+class SharedMemoryWindow {
+public:
+  SharedMemoryWindow(
+    const MPICommunicator& nodeCommunicator,
+    const size_t localCount
+  ) : m_nodeCommunicator(nodeCommunicator),
+    m_window(MPI_WIN_NULL),
+    m_segments(nodeCommunicator.size(), 0),
+    m_counts(nodeCommunicator.size(), 0)
+  {
+    T* base = 0;
+    if (MPI_Win_allocate_shared(static_cast<MPI_Aint>(localCount * sizeof(T)), sizeof(T), MPI_INFO_NULL,
+                                *m_nodeCommunicator, &base, &m_window) != MPI_SUCCESS) {
+      throw std::runtime_error("Couldn't allocate the shared memory window!");
+    }
+    for (size_t p = 0; p < m_nodeCommunicator.size(); ++p) {
+      MPI_Aint size;
+      int displacement;
+      MPI_Win_shared_query(m_window, static_cast<int>(p), &size, &displacement, &m_segments[p]);
+      m_counts[p] = static_cast<size_t>(size) / sizeof(T);
+    }
+    // Keep a passive target epoch open for the lifetime of the window,
+    // so that the memory can be synchronized using sync().
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, m_window);
+  }
+
+  /**
+   * @brief Makes the stores of all the processors visible to all of them.
+   *
+   * This is a collective call over the node-local communicator.
+   */
+  void
+  sync()
+  {
+    MPI_Win_sync(m_window);
+    MPI_Barrier(*m_nodeCommunicator);
+    MPI_Win_sync(m_window);
+  }
+
+  T*
+  segment(const size_t p) { return static_cast<T*>(m_segments[p]); }
+
+  const T*
+  segment(const size_t p) const { return static_cast<const T*>(m_segments[p]); }
+
+  size_t
+  count(const size_t p) const { return m_counts[p]; }
+
+  T*
+  local() { return segment(m_nodeCommunicator.rank()); }
+
+  const MPICommunicator&
+  communicator() const { return m_nodeCommunicator; }
+
+  ~SharedMemoryWindow()
+  {
+    MPI_Win_unlock_all(m_window);
+    MPI_Win_free(&m_window);
+  }
+
+private:
+  SharedMemoryWindow(const SharedMemoryWindow&);
+
+  SharedMemoryWindow&
+  operator=(const SharedMemoryWindow&);
+
+private:
+  const MPICommunicator m_nodeCommunicator;
+  MPI_Win m_window;
+  std::vector<void*> m_segments;
+  std::vector<size_t> m_counts;
+}; // class SharedMemoryWindow
+
+#endif // GRAPHWORKS_SHAREDMEMORYWINDOW_HPP_
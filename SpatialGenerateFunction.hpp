@@ -0,0 +1,95 @@
+#ifndef GRAPHWORKS_SPATIALGENERATEFUNCTION_HPP_
+#define GRAPHWORKS_SPATIALGENERATEFUNCTION_HPP_
+
+#include "DistributedKdTree.hpp"
+#include "GenerateFunction.hpp"
+#include "Graph.hpp"
+
+#include <iterator>
+#include <vector>
+
+/**
+ * Base class for generate functions which create the interaction sets
+ * from the spatial neighborhoods of the points of the graph.
+ * The neighborhoods of all the local points are found in one batched,
+ * distributed query when the computation starts.
+ */
+class SpatialGenerateFunction : public GenerateFunction {
+public:
+  SpatialGenerateFunction(const bool);
+
+  bool
+  operator()(
+    const Graph&,
+    const Graph::Node&,
+    std::back_insert_iterator<std::vector<Graph::Node> >&,
+    bool&
+  ) const;
+
+  void
+  prepare(const Graph&) const;
+
+  void
+  prepareUpdate(
+    const Graph&,
+    const std::vector<unsigned int>&
+  ) const;
+
+  virtual
+  ~SpatialGenerateFunction();
+
+protected:
+  virtual
+  void
+  query(
+    const DistributedKdTree&,
+    const std::vector<unsigned int>* const,
+    std::vector<std::vector<Graph::Node::IndexType> >&
+  ) const = 0;
+
+protected:
+  const bool m_includeSelf;
+
+private:
+  mutable std::vector<std::vector<Graph::Node::IndexType> > m_neighbors;
+}; // class SpatialGenerateFunction
+
+class NearestNeighborGenerateFunction : public SpatialGenerateFunction {
+public:
+  NearestNeighborGenerateFunction(
+    const unsigned int,
+    const bool = false
+  );
+
+protected:
+  void
+  query(
+    const DistributedKdTree&,
+    const std::vector<unsigned int>* const,
+    std::vector<std::vector<Graph::Node::IndexType> >&
+  ) const;
+
+private:
+  const unsigned int m_k;
+}; // class NearestNeighborGenerateFunction
+
+class RadiusGenerateFunction : public SpatialGenerateFunction {
+public:
+  RadiusGenerateFunction(
+    const double,
+    const bool = false
+  );
+
+protected:
+  void
+  query(
+    const DistributedKdTree&,
+    const std::vector<unsigned int>* const,
+    std::vector<std::vector<Graph::Node::IndexType> >&
+  ) const;
+
+private:
+  const double m_radius;
+}; // class RadiusGenerateFunction
+
+#endif // GRAPHWORKS_SPATIALGENERATEFUNCTION_HPP_
@@ -0,0 +1,67 @@
+#ifndef GRAPHWORKS_TASKPOOL_HPP_
+#define GRAPHWORKS_TASKPOOL_HPP_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Small pool of worker threads which start the submitted tasks in the order
+ * of their submission, handing their results back through futures.
+ *
+ * The tasks must not call MPI, which is initialized for a single thread:
+ * only the thread which owns the pool may talk to the other processors.
+ * The pool can't check this, so whoever submits user code as tasks passes
+ * the requirement on to that code, as computeAsync does for the generate
+ * functions. A task which has to follow another one is submitted once the
+ * future of the earlier task is ready.
+ */
+class TaskPool {
+public:
+  TaskPool(const unsigned int);
+
+  /**
+   * @brief Queues a task, which takes no arguments.
+   *
+   * @return Future of the result of the task, which also carries the
+   *         exception thrown by the task, if any.
+   */
+  template <typename Task>
+  std::future<typename std::result_of<Task()>::type>
+  submit(Task task)
+  {
+    typedef typename std::result_of<Task()>::type ResultType;
+    std::shared_ptr<std::packaged_task<ResultType()> > packaged(new std::packaged_task<ResultType()>(task));
+    std::future<ResultType> result = packaged->get_future();
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_tasks.push_back([packaged]() { (*packaged)(); });
+    }
+    m_ready.notify_one();
+    return result;
+  }
+
+  unsigned int
+  size() const;
+
+  ~TaskPool();
+
+private:
+  void
+  run();
+
+private:
+  std::vector<std::thread> m_threads;
+  std::deque<std::function<void()> > m_tasks;
+  std::mutex m_mutex;
+  std::condition_variable m_ready;
+  bool m_stopping;
+}; // class TaskPool
+
+#endif // GRAPHWORKS_TASKPOOL_HPP_
@@ -0,0 +1,144 @@
+#ifndef GRAPHWORKS_TREEINDEX_HPP_
+#define GRAPHWORKS_TREEINDEX_HPP_
+
+#include "Graph.hpp"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Structure of the forest formed by the parents of the local nodes of a
+ * graph, or by any other parents given for them, kept in flat arrays so
+ * that the structural queries are lookups.
+ *
+ * Every node gets its level, its parent, the size of its subtree, and its
+ * entry and exit numbers in an Euler tour of the whole forest, which visits
+ * the siblings in the order of their global indices and the roots in the
+ * order of their owners. A node is an ancestor of another node iff its
+ * interval of tour numbers contains the interval of the other one. The local
+ * nodes are also bucketed by their levels, for the computations which
+ * proceed level by level. Removed nodes are left out, and nodes with removed
+ * parents become roots. The levels of given parents are their depths.
+ */
+class TreeIndex {
+public:
+  typedef Graph::Node::IndexType IndexType;
+
+public:
+  TreeIndex(const Graph&);
+
+  TreeIndex(
+    const Graph&,
+    const std::vector<IndexType>&
+  );
+
+  unsigned int
+  level(const unsigned int i) const { return m_levels[i]; }
+
+  IndexType
+  parent(const unsigned int i) const { return m_parents[i]; }
+
+  bool
+  isRoot(const unsigned int i) const { return m_parents[i] == Graph::Node::s_invalidIndex; }
+
+  unsigned long long
+  subtreeSize(const unsigned int i) const { return m_subtreeSizes[i]; }
+
+  unsigned long long
+  entry(const unsigned int i) const { return m_entries[i]; }
+
+  unsigned long long
+  exit(const unsigned int i) const { return m_entries[i] + 2 * m_subtreeSizes[i] - 1; }
+
+  /**
+   * @brief Whether a node is an ancestor of another node, or the node itself,
+   *        given the tour numbers of the other node.
+   */
+  bool
+  isAncestor(
+    const unsigned int i,
+    const unsigned long long entry,
+    const unsigned long long exit
+  ) const
+  {
+    return (m_entries[i] <= entry) && (exit <= this->exit(i));
+  }
+
+  unsigned int
+  numChildren(const unsigned int i) const { return static_cast<unsigned int>(m_childOffsets[i + 1] - m_childOffsets[i]); }
+
+  /**
+   * @brief Global indices of the children of a node, in increasing order.
+   */
+  const IndexType*
+  children(const unsigned int i) const { return m_children.data() + m_childOffsets[i]; }
+
+  /**
+   * @brief Lowest level of all the processors, or 1 more than the highest
+   *        one if no processor has nodes.
+   */
+  unsigned int
+  minLevel() const { return m_minLevel; }
+
+  /**
+   * @brief Highest level of all the processors.
+   */
+  unsigned int
+  maxLevel() const { return m_maxLevel; }
+
+  unsigned int
+  numLevelNodes(const unsigned int level) const
+  {
+    return ((level < m_minLevel) || (level > m_maxLevel)) ? 0 : m_levelOffsets[level - m_minLevel + 1] - m_levelOffsets[level - m_minLevel];
+  }
+
+  /**
+   * @brief Local indices of the nodes of a level, in increasing order.
+   */
+  const unsigned int*
+  levelNodes(const unsigned int level) const { return m_levelNodes.data() + m_levelOffsets[level - m_minLevel]; }
+
+  ~TreeIndex();
+
+private:
+  void
+  build(
+    const Graph&,
+    const bool
+  );
+
+  void
+  listChildren(const Graph&);
+
+  void
+  computeLevels(const Graph&);
+
+  void
+  bucketLevels();
+
+  void
+  accumulateSubtreeSizes(
+    const Graph&,
+    std::vector<unsigned long long>&
+  );
+
+  void
+  numberTour(
+    const Graph&,
+    const std::vector<unsigned long long>&
+  );
+
+private:
+  std::vector<unsigned int> m_levels;
+  std::vector<IndexType> m_parents;
+  std::vector<unsigned long long> m_subtreeSizes;
+  std::vector<unsigned long long> m_entries;
+  std::vector<std::size_t> m_childOffsets;
+  std::vector<IndexType> m_children;
+  std::vector<unsigned int> m_levelOffsets;
+  std::vector<unsigned int> m_levelNodes;
+  unsigned int m_minLevel;
+  unsigned int m_maxLevel;
+}; // class TreeIndex
+
+#endif // GRAPHWORKS_TREEINDEX_HPP_
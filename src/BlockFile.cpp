@@ -0,0 +1,372 @@
+#include "BlockFile.hpp"
+
+#ifdef GRAPHWORKS_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+/** First word of the header **/
+const char s_magic[8] = {'G', 'W', 'B', 'L', 'O', 'C', 'K', '2'};
+
+/** First word of the header of the files without metadata **/
+const char s_oldMagic[8] = {'G', 'W', 'B', 'L', 'O', 'C', 'K', '1'};
+
+/** Words of the header in front of the metadata **/
+const unsigned int s_headerWords = 5;
+
+/** Largest size of the metadata **/
+const unsigned long long s_maxMetadataBytes = 1ULL << 20;
+
+/** Uncompressed bytes per block, when not given **/
+const unsigned long long s_defaultBlockBytes = 1ULL << 20;
+
+/** Largest number of bytes read from the file in one call **/
+const int s_maxReadBytes = 1 << 30;
+
+unsigned long long
+decodeWord(
+  const unsigned char* const bytes
+)
+{
+  unsigned long long word = 0;
+  for (unsigned int b = 0; b < 8; ++b) {
+    word |= static_cast<unsigned long long>(bytes[b]) << (8 * b);
+  }
+  return word;
+}
+
+#ifdef GRAPHWORKS_HAVE_ZLIB
+void
+encodeWord(
+  const unsigned long long word,
+  unsigned char* const bytes
+)
+{
+  for (unsigned int b = 0; b < 8; ++b) {
+    bytes[b] = static_cast<unsigned char>(word >> (8 * b));
+  }
+}
+#endif
+
+/**
+ * @brief Reads a range of bytes of a file, in calls of at most
+ *        s_maxReadBytes each.
+ */
+bool
+readBytes(
+  MPI_File file,
+  const MPI_Offset offset,
+  const MPI_Offset numBytes,
+  char* const buffer
+)
+{
+  for (MPI_Offset done = 0; done < numBytes; ) {
+    const int count = static_cast<int>(std::min(numBytes - done, static_cast<MPI_Offset>(s_maxReadBytes)));
+    MPI_Status status;
+    if (MPI_File_read_at(file, offset + done, buffer + done, count, MPI_BYTE, &status) != MPI_SUCCESS) {
+      return false;
+    }
+    int numRead = 0;
+    MPI_Get_count(&status, MPI_BYTE, &numRead);
+    if (numRead != count) {
+      return false;
+    }
+    done += count;
+  }
+  return true;
+}
+
+} // namespace
+
+BlockFile::BlockFile(
+) : m_recordSize(0),
+  m_numRecords(0),
+  m_recordsPerBlock(0),
+  m_indexOffset(0),
+  m_metadata()
+{
+}
+
+/**
+ * @brief Reads the header of a file, and its metadata.
+ *
+ * @return true if the file has a valid header.
+ */
+bool
+BlockFile::open(
+  MPI_File file
+)
+{
+  unsigned char header[s_headerWords * 8];
+  m_metadata.clear();
+  if (!readBytes(file, 0, (s_headerWords - 1) * 8, reinterpret_cast<char*>(header))) {
+    return false;
+  }
+  const bool old = (std::memcmp(header, s_oldMagic, sizeof(s_oldMagic)) == 0);
+  if (!old && (std::memcmp(header, s_magic, sizeof(s_magic)) != 0)) {
+    return false;
+  }
+  m_recordSize = decodeWord(header + 8);
+  m_numRecords = decodeWord(header + 16);
+  m_recordsPerBlock = decodeWord(header + 24);
+  m_indexOffset = (s_headerWords - 1) * 8;
+  if (!old) {
+    if (!readBytes(file, m_indexOffset, 8, reinterpret_cast<char*>(header + m_indexOffset))) {
+      return false;
+    }
+    const unsigned long long metadataBytes = decodeWord(header + m_indexOffset);
+    if (metadataBytes > s_maxMetadataBytes) {
+      return false;
+    }
+    m_indexOffset = (s_headerWords * 8) + ((metadataBytes + 7) / 8) * 8;
+    m_metadata.resize(metadataBytes);
+    if (!m_metadata.empty() && !readBytes(file, s_headerWords * 8, static_cast<MPI_Offset>(metadataBytes), &m_metadata[0])) {
+      return false;
+    }
+  }
+  return (m_recordSize > 0) && ((m_recordsPerBlock > 0) || (m_numRecords == 0));
+}
+
+unsigned int
+BlockFile::recordSize(
+) const
+{
+  return static_cast<unsigned int>(m_recordSize);
+}
+
+unsigned long long
+BlockFile::numRecords(
+) const
+{
+  return m_numRecords;
+}
+
+unsigned long long
+BlockFile::numBlocks(
+) const
+{
+  return (m_numRecords == 0) ? 0 : ((m_numRecords + m_recordsPerBlock - 1) / m_recordsPerBlock);
+}
+
+/**
+ * @brief First record of a block, or the number of records for the block
+ *        past the last one.
+ */
+unsigned long long
+BlockFile::blockBegin(
+  const unsigned long long block
+) const
+{
+  return std::min(block * m_recordsPerBlock, m_numRecords);
+}
+
+/**
+ * @brief Metadata which the file was written with, which is empty for
+ *        files without metadata.
+ */
+const std::vector<char>&
+BlockFile::metadata(
+) const
+{
+  return m_metadata;
+}
+
+/**
+ * @brief Reads a range of records.
+ *
+ * @param file      File whose header was read.
+ * @param first     First record of the range.
+ * @param count     Number of records of the range.
+ * @param records   Records of the range, in their bytes.
+ *
+ * @return true if the records were read successfully.
+ *
+ * Only the index entries and the compressed bytes of the blocks which
+ * overlap the range are read, in one piece each, and the blocks are then
+ * decompressed in parallel by the threads. The blocks which lie within the
+ * range are decompressed in place.
+ */
+bool
+BlockFile::read(
+  MPI_File file,
+  const unsigned long long first,
+  const unsigned long long count,
+  char* const records
+) const
+{
+  if (count == 0) {
+    return true;
+  }
+  if (first + count > m_numRecords) {
+    return false;
+  }
+#ifdef GRAPHWORKS_HAVE_ZLIB
+  const unsigned long long firstBlock = first / m_recordsPerBlock;
+  const unsigned long long lastBlock = (first + count - 1) / m_recordsPerBlock + 1;
+  const unsigned long long numRead = lastBlock - firstBlock;
+
+  std::vector<unsigned char> index((numRead + 1) * 8);
+  if (!readBytes(file, static_cast<MPI_Offset>(m_indexOffset + firstBlock * 8), static_cast<MPI_Offset>(index.size()), reinterpret_cast<char*>(&index[0]))) {
+    return false;
+  }
+  std::vector<unsigned long long> offsets(numRead + 1);
+  for (unsigned long long b = 0; b <= numRead; ++b) {
+    offsets[b] = decodeWord(&index[b * 8]);
+    if ((b > 0) && (offsets[b] < offsets[b - 1])) {
+      return false;
+    }
+  }
+  std::vector<char> compressed(offsets[numRead] - offsets[0]);
+  if (!compressed.empty() &&
+      !readBytes(file, static_cast<MPI_Offset>(offsets[0]), static_cast<MPI_Offset>(compressed.size()), &compressed[0])) {
+    return false;
+  }
+
+  int valid = 1;
+  #pragma omp parallel for schedule(dynamic) reduction(&:valid)
+  for (long long b = 0; b < static_cast<long long>(numRead); ++b) {
+    const unsigned long long blockFirst = blockBegin(firstBlock + b);
+    const unsigned long long blockEnd = blockBegin(firstBlock + b + 1);
+    const unsigned long long overlapFirst = std::max(blockFirst, first);
+    const unsigned long long overlapEnd = std::min(blockEnd, first + count);
+    const bool inPlace = (overlapFirst == blockFirst) && (overlapEnd == blockEnd);
+
+    std::vector<char> partial;
+    char* output = records + (blockFirst - first) * m_recordSize;
+    if (!inPlace) {
+      partial.resize((blockEnd - blockFirst) * m_recordSize);
+      output = &partial[0];
+    }
+    uLongf size = static_cast<uLongf>((blockEnd - blockFirst) * m_recordSize);
+    const Bytef* source = reinterpret_cast<const Bytef*>(&compressed[0] + (offsets[b] - offsets[0]));
+    if ((uncompress(reinterpret_cast<Bytef*>(output), &size, source, static_cast<uLong>(offsets[b + 1] - offsets[b])) != Z_OK) ||
+        (size != (blockEnd - blockFirst) * m_recordSize)) {
+      valid = 0;
+    }
+    else if (!inPlace) {
+      std::memcpy(records + (overlapFirst - first) * m_recordSize, output + (overlapFirst - blockFirst) * m_recordSize,
+                  (overlapEnd - overlapFirst) * m_recordSize);
+    }
+  }
+  return valid != 0;
+#else
+  (void)file;
+  (void)records;
+  std::cerr << "Block compressed files need zlib!" << std::endl;
+  return false;
+#endif
+}
+
+/**
+ * @brief Whether a file starts with the header of a block compressed file.
+ */
+bool
+BlockFile::isBlockFile(
+  const std::string& fileName
+)
+{
+  std::ifstream file(fileName.c_str(), std::ios::binary);
+  char magic[sizeof(s_magic)];
+  return file.read(magic, sizeof(magic)) &&
+    ((std::memcmp(magic, s_magic, sizeof(s_magic)) == 0) || (std::memcmp(magic, s_oldMagic, sizeof(s_oldMagic)) == 0));
+}
+
+/**
+ * @brief Writes records to a block compressed file.
+ *
+ * @param fileName          Name of the file.
+ * @param records           Records, in their bytes.
+ * @param recordSize        Size of a record.
+ * @param numRecords        Number of records.
+ * @param recordsPerBlock   Number of records per block, or 0 for blocks of
+ *                          about 1MB.
+ * @param metadata          Bytes which are stored uncompressed in the
+ *                          header, and read back by open().
+ *
+ * @return true if the file was written successfully.
+ *
+ * The blocks are compressed in parallel by the threads. The points and the
+ * edge lists are converted from their other formats by reading them, and
+ * writing them through InputData::write and EdgeList::write.
+ */
+bool
+BlockFile::write(
+  const std::string& fileName,
+  const char* const records,
+  const unsigned int recordSize,
+  const unsigned long long numRecords,
+  const unsigned long long recordsPerBlock,
+  const std::vector<char>& metadata
+)
+{
+#ifdef GRAPHWORKS_HAVE_ZLIB
+  if ((recordSize == 0) || (metadata.size() > s_maxMetadataBytes)) {
+    return false;
+  }
+  BlockFile layout;
+  layout.m_recordSize = recordSize;
+  layout.m_numRecords = numRecords;
+  layout.m_recordsPerBlock = (recordsPerBlock > 0) ? recordsPerBlock : std::max(s_defaultBlockBytes / recordSize, 1ULL);
+  const unsigned long long numBlocks = layout.numBlocks();
+
+  std::vector<std::vector<Bytef> > blocks(numBlocks);
+  int valid = 1;
+  #pragma omp parallel for schedule(dynamic) reduction(&:valid)
+  for (long long b = 0; b < static_cast<long long>(numBlocks); ++b) {
+    const unsigned long long blockFirst = layout.blockBegin(b);
+    const uLong size = static_cast<uLong>((layout.blockBegin(b + 1) - blockFirst) * recordSize);
+    uLongf compressedSize = compressBound(size);
+    blocks[b].resize(compressedSize);
+    if (compress(&blocks[b][0], &compressedSize, reinterpret_cast<const Bytef*>(records + blockFirst * recordSize), size) != Z_OK) {
+      valid = 0;
+    }
+    blocks[b].resize(compressedSize);
+  }
+  if (!valid) {
+    return false;
+  }
+
+  const unsigned long long indexOffset = (s_headerWords * 8) + ((metadata.size() + 7) / 8) * 8;
+  std::vector<unsigned char> header(indexOffset + (numBlocks + 1) * 8, 0);
+  std::memcpy(&header[0], s_magic, sizeof(s_magic));
+  encodeWord(layout.m_recordSize, &header[8]);
+  encodeWord(layout.m_numRecords, &header[16]);
+  encodeWord(layout.m_recordsPerBlock, &header[24]);
+  encodeWord(metadata.size(), &header[32]);
+  std::copy(metadata.begin(), metadata.end(), header.begin() + (s_headerWords * 8));
+  unsigned long long offset = header.size();
+  for (unsigned long long b = 0; b <= numBlocks; ++b) {
+    encodeWord(offset, &header[indexOffset + b * 8]);
+    if (b < numBlocks) {
+      offset += blocks[b].size();
+    }
+  }
+
+  std::ofstream file(fileName.c_str(), std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(&header[0]), header.size());
+  for (unsigned long long b = 0; b < numBlocks; ++b) {
+    file.write(reinterpret_cast<const char*>(&blocks[b][0]), blocks[b].size());
+  }
+  return static_cast<bool>(file);
+#else
+  (void)fileName;
+  (void)records;
+  (void)recordSize;
+  (void)numRecords;
+  (void)recordsPerBlock;
+  (void)metadata;
+  std::cerr << "Block compressed files need zlib!" << std::endl;
+  return false;
+#endif
+}
+
+BlockFile::~BlockFile(
+)
+{
+}
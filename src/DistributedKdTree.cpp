@@ -0,0 +1,395 @@
+#include "DistributedKdTree.hpp"
+
+#include "MPICommunicator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+DistributedKdTree::DistributedKdTree(
+  const MPICommunicator& mpiCommunicator
+) : m_mpiCommunicator(mpiCommunicator),
+  m_graph(0),
+  m_localTree(),
+  m_boxes(),
+  m_peerPoints(),
+  m_peerTrees(),
+  m_peerBuilt()
+{
+}
+
+/**
+ * @brief Builds the local tree and the replicated top level.
+ *
+ * @param g   Graph whose points are to be indexed.
+ *
+ * The top level consists of the bounding boxes of all the processors'
+ * points, which are used for routing queries to the processors which may
+ * hold neighbors. Empty processors get an inverted box which is never hit.
+ * The points of the processors on this host which are still read in place
+ * from shared memory are searched directly, with trees which are built on
+ * their first query. This is a collective call.
+ */
+void
+DistributedKdTree::build(
+  const Graph& g
+)
+{
+  m_graph = &g;
+  m_localTree.build(g.points(), g.bounds(), g.size());
+
+  double myBox[6];
+  for (unsigned int d = 0; d < 3; ++d) {
+    myBox[d] = std::numeric_limits<double>::max();
+    myBox[d + 3] = -std::numeric_limits<double>::max();
+  }
+  const InputData::Point* points = g.points();
+  const InputData::Bounds& bounds = g.bounds();
+  for (unsigned int i = 0; i < g.size(); ++i) {
+    double coords[3] = {points[i].x(bounds), points[i].y(bounds), points[i].z(bounds)};
+    for (unsigned int d = 0; d < 3; ++d) {
+      myBox[d] = std::min(myBox[d], coords[d]);
+      myBox[d + 3] = std::max(myBox[d + 3], coords[d]);
+    }
+  }
+
+  m_boxes.resize(m_mpiCommunicator.size() * 6);
+  MPI_Allgather(myBox, 6, MPI_DOUBLE, &m_boxes[0], 6, MPI_DOUBLE, *m_mpiCommunicator);
+
+  // The shared points of a processor only match its nodes until it changes them.
+  const unsigned int numProcs = m_mpiCommunicator.size();
+  int shared = g.hasSharedPoints() ? 1 : 0;
+  std::vector<int> sharedProcs(numProcs, 0);
+  MPI_Allgather(&shared, 1, MPI_INT, &sharedProcs[0], 1, MPI_INT, *m_mpiCommunicator);
+  m_peerPoints.assign(numProcs, 0);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    if (sharedProcs[p]) {
+      m_peerPoints[p] = g.peerPoints(p);
+    }
+  }
+  m_peerTrees.assign(numProcs, KdTree());
+  m_peerBuilt.assign(numProcs, 0);
+}
+
+/**
+ * @brief Finds k nearest neighbors of all the local points.
+ *
+ * @param k             Number of neighbors for every point.
+ * @param includeSelf   Whether a point is reported as its own neighbor.
+ * @param neighbors     Global indices of the neighbors of every local point,
+ *                      sorted by increasing distance.
+ *
+ * This is a collective call.
+ */
+void
+DistributedKdTree::nearest(
+  const unsigned int k,
+  const bool includeSelf,
+  std::vector<std::vector<Graph::Node::IndexType> >& neighbors
+) const
+{
+  query(k, 0.0, includeSelf, 0, neighbors);
+}
+
+/**
+ * @brief Finds k nearest neighbors of some of the local points.
+ *
+ * @param k             Number of neighbors for every point.
+ * @param includeSelf   Whether a point is reported as its own neighbor.
+ * @param nodes         Local indices of the points, or 0 for all of them.
+ * @param neighbors     Global indices of the neighbors of every listed
+ *                      point, sorted by increasing distance.
+ *
+ * This is a collective call.
+ */
+void
+DistributedKdTree::nearest(
+  const unsigned int k,
+  const bool includeSelf,
+  const std::vector<unsigned int>* const nodes,
+  std::vector<std::vector<Graph::Node::IndexType> >& neighbors
+) const
+{
+  query(k, 0.0, includeSelf, nodes, neighbors);
+}
+
+/**
+ * @brief Finds all neighbors within a fixed radius of all the local points.
+ *
+ * @param radius        Search radius.
+ * @param includeSelf   Whether a point is reported as its own neighbor.
+ * @param neighbors     Global indices of the neighbors of every local point,
+ *                      sorted by increasing distance.
+ *
+ * This is a collective call.
+ */
+void
+DistributedKdTree::withinRadius(
+  const double radius,
+  const bool includeSelf,
+  std::vector<std::vector<Graph::Node::IndexType> >& neighbors
+) const
+{
+  query(0, radius, includeSelf, 0, neighbors);
+}
+
+/**
+ * @brief Finds all neighbors within a fixed radius of some of the local
+ *        points.
+ *
+ * @param radius        Search radius.
+ * @param includeSelf   Whether a point is reported as its own neighbor.
+ * @param nodes         Local indices of the points, or 0 for all of them.
+ * @param neighbors     Global indices of the neighbors of every listed
+ *                      point, sorted by increasing distance.
+ *
+ * This is a collective call.
+ */
+void
+DistributedKdTree::withinRadius(
+  const double radius,
+  const bool includeSelf,
+  const std::vector<unsigned int>* const nodes,
+  std::vector<std::vector<Graph::Node::IndexType> >& neighbors
+) const
+{
+  query(0, radius, includeSelf, nodes, neighbors);
+}
+
+/**
+ * @brief Common driver for the k-NN (k > 0) and radius (k == 0) queries.
+ *
+ * Every point is first searched for locally. The local result bounds the
+ * distance within which remote neighbors can exist, and the point is then
+ * forwarded only to the processors whose bounding box is within that
+ * distance. The points of the processors on this host are searched in
+ * place. All the other forwarded queries are exchanged in one batch,
+ * answered using the remote local trees, and the answers are merged with
+ * the local results.
+ */
+void
+DistributedKdTree::query(
+  const unsigned int k,
+  const double radius,
+  const bool includeSelf,
+  const std::vector<unsigned int>* const nodes,
+  std::vector<std::vector<Graph::Node::IndexType> >& neighbors
+) const
+{
+  if (m_graph == 0) {
+    throw std::runtime_error("Spatial index hasn't been built!");
+  }
+
+  const unsigned int numProcs = m_mpiCommunicator.size();
+  const unsigned int myRank = m_mpiCommunicator.rank();
+  const InputData::Point* points = m_graph->points();
+  const InputData::Bounds& bounds = m_graph->bounds();
+  const unsigned int numQueries = (nodes != 0) ? static_cast<unsigned int>(nodes->size()) : m_graph->size();
+  // Radius queries are inclusive, while the search bounds are exclusive.
+  const double radiusBound = std::nextafter(radius * radius, std::numeric_limits<double>::max());
+
+  std::vector<std::vector<Neighbor> > candidates(numQueries);
+  std::vector<std::vector<Query> > outgoing(numProcs);
+  std::vector<std::vector<unsigned int> > outgoingOwners(numProcs);
+
+  std::vector<KdTree::Neighbor> found;
+  for (unsigned int c = 0; c < numQueries; ++c) {
+    const unsigned int i = (nodes != 0) ? (*nodes)[c] : c;
+    Query q;
+    q.m_coords[0] = points[i].x(bounds);
+    q.m_coords[1] = points[i].y(bounds);
+    q.m_coords[2] = points[i].z(bounds);
+
+    // One extra neighbor is searched for, in case the point itself is found.
+    unsigned int localK = ((k > 0) && !includeSelf) ? k + 1 : k;
+    localQuery(m_localTree, q.m_coords, localK, (k > 0) ? std::numeric_limits<double>::max() : radiusBound, found);
+    for (std::vector<KdTree::Neighbor>::const_iterator f = found.begin(); f != found.end(); ++f) {
+      if (includeSelf || (f->second != i)) {
+        candidates[c].push_back(Neighbor(f->first, m_graph->globalIndex(f->second)));
+      }
+    }
+    if ((k > 0) && (candidates[c].size() > k)) {
+      candidates[c].resize(k);
+    }
+
+    if (k > 0) {
+      q.m_bound = (candidates[c].size() == k) ? candidates[c].back().first : std::numeric_limits<double>::max();
+    }
+    else {
+      q.m_bound = radiusBound;
+    }
+
+    for (unsigned int p = 0; p < numProcs; ++p) {
+      if ((p == myRank) || !(boxDistance(q.m_coords, p) < q.m_bound)) {
+        continue;
+      }
+      if (m_peerPoints[p] != 0) {
+        localQuery(peerTree(p), q.m_coords, k, q.m_bound, found);
+        for (std::vector<KdTree::Neighbor>::const_iterator f = found.begin(); f != found.end(); ++f) {
+          candidates[c].push_back(Neighbor(f->first, m_graph->firstIndex(p) + f->second));
+        }
+      }
+      else {
+        outgoing[p].push_back(q);
+        outgoingOwners[p].push_back(c);
+      }
+    }
+  }
+
+  // Exchange the batched queries.
+  std::vector<int> sendCounts(numProcs), sendDispls(numProcs + 1, 0);
+  std::vector<int> recvCounts(numProcs), recvDispls(numProcs + 1, 0);
+  std::vector<Query> sendQueries;
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    sendCounts[p] = static_cast<int>(outgoing[p].size() * sizeof(Query));
+    sendDispls[p + 1] = sendDispls[p] + sendCounts[p];
+    sendQueries.insert(sendQueries.end(), outgoing[p].begin(), outgoing[p].end());
+  }
+  MPI_Alltoall(&sendCounts[0], 1, MPI_INT, &recvCounts[0], 1, MPI_INT, *m_mpiCommunicator);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    recvDispls[p + 1] = recvDispls[p] + recvCounts[p];
+  }
+  std::vector<Query> recvQueries(recvDispls[numProcs] / sizeof(Query));
+  MPI_Alltoallv(sendQueries.empty() ? 0 : &sendQueries[0], &sendCounts[0], &sendDispls[0], MPI_BYTE,
+                recvQueries.empty() ? 0 : &recvQueries[0], &recvCounts[0], &recvDispls[0], MPI_BYTE,
+                *m_mpiCommunicator);
+
+  // Answer the queries received from other processors.
+  std::vector<unsigned int> answerCounts(recvQueries.size());
+  std::vector<Neighbor> answers;
+  std::vector<int> answerSendCounts(numProcs, 0), answerSendDispls(numProcs + 1, 0);
+  for (unsigned int p = 0, j = 0; p < numProcs; ++p) {
+    unsigned int before = static_cast<unsigned int>(answers.size());
+    for (; j < (recvDispls[p + 1] / sizeof(Query)); ++j) {
+      localQuery(m_localTree, recvQueries[j].m_coords, k, recvQueries[j].m_bound, found);
+      answerCounts[j] = static_cast<unsigned int>(found.size());
+      for (std::vector<KdTree::Neighbor>::const_iterator f = found.begin(); f != found.end(); ++f) {
+        answers.push_back(Neighbor(f->first, m_graph->globalIndex(f->second)));
+      }
+    }
+    answerSendCounts[p] = static_cast<int>((answers.size() - before) * sizeof(Neighbor));
+    answerSendDispls[p + 1] = answerSendDispls[p] + answerSendCounts[p];
+  }
+
+  // The per query answer counts travel the reverse route of the queries.
+  std::vector<unsigned int> resultCounts(sendQueries.size());
+  std::vector<int> countSendCounts(numProcs), countSendDispls(numProcs);
+  std::vector<int> countRecvCounts(numProcs), countRecvDispls(numProcs);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    countSendCounts[p] = recvCounts[p] / sizeof(Query);
+    countSendDispls[p] = recvDispls[p] / sizeof(Query);
+    countRecvCounts[p] = sendCounts[p] / sizeof(Query);
+    countRecvDispls[p] = sendDispls[p] / sizeof(Query);
+  }
+  MPI_Alltoallv(answerCounts.empty() ? 0 : &answerCounts[0], &countSendCounts[0], &countSendDispls[0], MPI_UNSIGNED,
+                resultCounts.empty() ? 0 : &resultCounts[0], &countRecvCounts[0], &countRecvDispls[0], MPI_UNSIGNED,
+                *m_mpiCommunicator);
+
+  std::vector<int> answerRecvCounts(numProcs), answerRecvDispls(numProcs + 1, 0);
+  MPI_Alltoall(&answerSendCounts[0], 1, MPI_INT, &answerRecvCounts[0], 1, MPI_INT, *m_mpiCommunicator);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    answerRecvDispls[p + 1] = answerRecvDispls[p] + answerRecvCounts[p];
+  }
+  std::vector<Neighbor> results(answerRecvDispls[numProcs] / sizeof(Neighbor));
+  MPI_Alltoallv(answers.empty() ? 0 : &answers[0], &answerSendCounts[0], &answerSendDispls[0], MPI_BYTE,
+                results.empty() ? 0 : &results[0], &answerRecvCounts[0], &answerRecvDispls[0], MPI_BYTE,
+                *m_mpiCommunicator);
+
+  // Merge the remote answers with the local candidates.
+  std::vector<Neighbor>::const_iterator r = results.begin();
+  for (unsigned int p = 0, j = 0; p < numProcs; ++p) {
+    for (unsigned int q = 0; q < outgoingOwners[p].size(); ++q, ++j) {
+      std::vector<Neighbor>& c = candidates[outgoingOwners[p][q]];
+      c.insert(c.end(), r, r + resultCounts[j]);
+      r += resultCounts[j];
+    }
+  }
+
+  neighbors.resize(numQueries);
+  for (unsigned int i = 0; i < numQueries; ++i) {
+    std::sort(candidates[i].begin(), candidates[i].end());
+    if ((k > 0) && (candidates[i].size() > k)) {
+      candidates[i].resize(k);
+    }
+    neighbors[i].clear();
+    neighbors[i].reserve(candidates[i].size());
+    for (std::vector<Neighbor>::const_iterator c = candidates[i].begin(); c != candidates[i].end(); ++c) {
+      neighbors[i].push_back(c->second);
+    }
+  }
+}
+
+/**
+ * @brief Searches a tree of this host, for k nearest (k > 0) or for all
+ *        points closer than the bound (k == 0).
+ */
+void
+DistributedKdTree::localQuery(
+  const KdTree& tree,
+  const double* const coords,
+  const unsigned int k,
+  const double bound,
+  std::vector<KdTree::Neighbor>& found
+) const
+{
+  if (k > 0) {
+    tree.nearest(coords, k, bound, found);
+  }
+  else {
+    tree.withinRadius(coords, std::sqrt(bound), found);
+    // Drop the points which fall outside the bound due to rounding.
+    while (!found.empty() && (found.back().first >= bound)) {
+      found.pop_back();
+    }
+  }
+}
+
+/**
+ * @brief Tree over the shared points of another processor on this host.
+ */
+const KdTree&
+DistributedKdTree::peerTree(
+  const unsigned int p
+) const
+{
+  if (!m_peerBuilt[p]) {
+    const unsigned int numPoints = static_cast<unsigned int>(m_graph->firstIndex(p + 1) - m_graph->firstIndex(p));
+    // The peers read the same input data, so their points share the bounds.
+    m_peerTrees[p].build(m_peerPoints[p], m_graph->bounds(), numPoints);
+    m_peerBuilt[p] = 1;
+  }
+  return m_peerTrees[p];
+}
+
+/**
+ * @brief Squared distance of a point from the bounding box of a processor.
+ */
+double
+DistributedKdTree::boxDistance(
+  const double* const coords,
+  const unsigned int p
+) const
+{
+  const double* box = &m_boxes[p * 6];
+  if (box[0] > box[3]) {
+    return std::numeric_limits<double>::max();
+  }
+  double d = 0.0;
+  for (unsigned int dim = 0; dim < 3; ++dim) {
+    double delta = 0.0;
+    if (coords[dim] < box[dim]) {
+      delta = box[dim] - coords[dim];
+    }
+    else if (coords[dim] > box[dim + 3]) {
+      delta = coords[dim] - box[dim + 3];
+    }
+    d += delta * delta;
+  }
+  return d;
+}
+
+DistributedKdTree::~DistributedKdTree(
+)
+{
+}
@@ -0,0 +1,619 @@
+#include "EdgeList.hpp"
+
+#include "BlockFile.hpp"
+#include "ExchangeAll.hpp"
+#include "MPICommunicator.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <stdint.h>
+
+namespace {
+
+/** Largest number of bytes read from the file in one call **/
+const int s_maxReadBytes = 1 << 30;
+
+/** Bytes read at a time past the end of a share, to complete its last line **/
+const int s_textOverlap = 4096;
+
+/** Sampled sources per processor, for choosing the splitters **/
+const unsigned int s_samplesPerProc = 64;
+
+/** Orders the edges by their sources, and then by their targets **/
+class SourceOrder {
+public:
+  bool
+  operator()(
+    const EdgeList::Edge& a,
+    const EdgeList::Edge& b
+  ) const
+  {
+    return (a.m_source < b.m_source) || ((a.m_source == b.m_source) && (a.m_target < b.m_target));
+  }
+}; // class SourceOrder
+
+/**
+ * @brief Reads a range of bytes of a file, in calls of at most
+ *        s_maxReadBytes each.
+ */
+bool
+readBytes(
+  MPI_File file,
+  const MPI_Offset offset,
+  const MPI_Offset numBytes,
+  char* const buffer
+)
+{
+  for (MPI_Offset done = 0; done < numBytes; ) {
+    const int count = static_cast<int>(std::min(numBytes - done, static_cast<MPI_Offset>(s_maxReadBytes)));
+    MPI_Status status;
+    if (MPI_File_read_at(file, offset + done, buffer + done, count, MPI_BYTE, &status) != MPI_SUCCESS) {
+      return false;
+    }
+    done += count;
+  }
+  return true;
+}
+
+/**
+ * @brief Decodes a record of a binary file, which is valid if its nodes fit
+ *        the indices.
+ */
+bool
+decodeRecord(
+  const char* const record,
+  const bool weighted,
+  EdgeList::Edge& edge
+)
+{
+  uint64_t source;
+  uint64_t target;
+  std::memcpy(&source, record, sizeof(uint64_t));
+  std::memcpy(&target, record + sizeof(uint64_t), sizeof(uint64_t));
+  edge.m_weight = 1.0;
+  if (weighted) {
+    std::memcpy(&edge.m_weight, record + 2 * sizeof(uint64_t), sizeof(double));
+  }
+  edge.m_source = static_cast<EdgeList::IndexType>(source);
+  edge.m_target = static_cast<EdgeList::IndexType>(target);
+  return (source < std::numeric_limits<EdgeList::IndexType>::max()) && (target < std::numeric_limits<EdgeList::IndexType>::max());
+}
+
+} // namespace
+
+EdgeList::EdgeList(
+) : m_edges(),
+  m_offsets(1, 0),
+  m_numGlobalNodes(0),
+  m_numGlobalEdges(0),
+  m_firstNode(0),
+  m_numLocalNodes(0)
+{
+}
+
+/**
+ * @brief Reads the edges from a file, every processor reading its own share.
+ *
+ * @param fileName          Name of the file with the edges.
+ * @param format            Format of the file.
+ * @param mpiCommunicator   Communicator over which the edges are distributed.
+ *
+ * @return true if the edges were read successfully.
+ *
+ * Text files have one edge per line, as the source and the target, with an
+ * optional weight, and lines starting with '#' or '%' are comments. Binary
+ * files are sequences of records of the 64-bit source and target, followed
+ * by a double weight in the weighted format. Compressed files hold the
+ * records of either binary format in the blocks of a BlockFile, whose
+ * record size tells whether they are weighted. Edges without weights get a
+ * weight of 1. The number of nodes is one more than the largest index.
+ * The edges are not distributed by their sources until build is called.
+ * This is a collective call.
+ */
+bool
+EdgeList::read(
+  const std::string& fileName,
+  const Format format,
+  const MPICommunicator& mpiCommunicator
+)
+{
+  if (mpiCommunicator.rank() == 0) {
+    std::cout << "+ reading edge list ... ";
+  }
+
+  double readTime = MPI_Wtime();
+  m_edges.clear();
+  m_offsets.assign(1, 0);
+  m_firstNode = 0;
+  m_numLocalNodes = 0;
+
+  MPI_File file;
+  char* name = const_cast<char*>(fileName.c_str());
+  if (MPI_File_open(*mpiCommunicator, name, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS) {
+    if (mpiCommunicator.rank() == 0) {
+      std::cout << "failed" << std::endl;
+    }
+    return false;
+  }
+  int success = 0;
+  if (format == Text) {
+    success = readText(file, mpiCommunicator);
+  }
+  else if (format == Compressed) {
+    success = readCompressed(file, mpiCommunicator);
+  }
+  else {
+    success = readBinary(file, format == WeightedBinary, mpiCommunicator);
+  }
+  MPI_File_close(&file);
+
+  int allSucceeded = 0;
+  MPI_Allreduce(&success, &allSucceeded, 1, MPI_INT, MPI_LAND, *mpiCommunicator);
+  if (!allSucceeded) {
+    m_edges.clear();
+    if (mpiCommunicator.rank() == 0) {
+      std::cout << "failed" << std::endl;
+    }
+    return false;
+  }
+
+  unsigned long long counts[2] = {m_edges.size(), 0};
+  for (std::vector<Edge>::const_iterator e = m_edges.begin(); e != m_edges.end(); ++e) {
+    counts[1] = std::max(counts[1], static_cast<unsigned long long>(std::max(e->m_source, e->m_target)) + 1);
+  }
+  unsigned long long numEdges = 0;
+  unsigned long long numNodes = 0;
+  MPI_Allreduce(&counts[0], &numEdges, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, *mpiCommunicator);
+  MPI_Allreduce(&counts[1], &numNodes, 1, MPI_UNSIGNED_LONG_LONG, MPI_MAX, *mpiCommunicator);
+  m_numGlobalEdges = numEdges;
+  m_numGlobalNodes = static_cast<IndexType>(numNodes);
+  readTime = MPI_Wtime() - readTime;
+
+  if (mpiCommunicator.rank() == 0) {
+    std::cout << "done: "
+      << readTime * 1000 << "ms"
+      << " [" << m_numGlobalEdges << " edges"
+      << ", " << m_numGlobalNodes << " nodes]"
+      << std::endl;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Reads the lines which start in this processor's share of the bytes
+ *        of a text file.
+ *
+ * The shares are equal ranges of bytes. A line which crosses the end of a
+ * share belongs to the processor whose share it starts in, which reads on
+ * past its share until the end of the line.
+ */
+bool
+EdgeList::readText(
+  MPI_File file,
+  const MPICommunicator& mpiCommunicator
+)
+{
+  const MPI_Offset myRank = static_cast<MPI_Offset>(mpiCommunicator.rank());
+  const MPI_Offset numProcs = static_cast<MPI_Offset>(mpiCommunicator.size());
+  MPI_Offset fileSize = 0;
+  MPI_File_get_size(file, &fileSize);
+  const MPI_Offset begin = (fileSize / numProcs) * myRank + std::min(myRank, fileSize % numProcs);
+  const MPI_Offset end = begin + (fileSize / numProcs) + ((myRank < fileSize % numProcs) ? 1 : 0);
+
+  // One more byte in front tells whether the share starts a line.
+  const MPI_Offset front = (begin > 0) ? 1 : 0;
+  std::vector<char> buffer(end - begin + front);
+  if (!readBytes(file, begin - front, end - begin + front, buffer.empty() ? 0 : &buffer[0])) {
+    return false;
+  }
+  std::size_t start = 0;
+  if (front == 1) {
+    start = std::find(buffer.begin(), buffer.end(), '\n') - buffer.begin();
+    if (start == buffer.size()) {
+      // Every byte of the share belongs to a line which started before it.
+      return true;
+    }
+    ++start;
+  }
+
+  // Complete the last line, which may end past the share.
+  MPI_Offset next = end;
+  while ((next < fileSize) && (buffer.back() != '\n')) {
+    const MPI_Offset numBytes = std::min(static_cast<MPI_Offset>(s_textOverlap), fileSize - next);
+    const std::size_t size = buffer.size();
+    buffer.resize(size + numBytes);
+    if (!readBytes(file, next, numBytes, &buffer[size])) {
+      return false;
+    }
+    std::vector<char>::iterator newline = std::find(buffer.begin() + size, buffer.end(), '\n');
+    if (newline != buffer.end()) {
+      buffer.erase(newline + 1, buffer.end());
+    }
+    next += numBytes;
+  }
+  buffer.push_back('\0');
+
+  const char* line = &buffer[start];
+  const char* const last = &buffer[buffer.size() - 1];
+  while (line < last) {
+    const char* lineEnd = std::find(line, last, '\n');
+    const char* p = line;
+    while ((p < lineEnd) && ((*p == ' ') || (*p == '\t') || (*p == '\r'))) {
+      ++p;
+    }
+    if ((p < lineEnd) && (*p != '#') && (*p != '%')) {
+      char* parsed;
+      Edge edge;
+      const unsigned long long source = std::strtoull(p, &parsed, 10);
+      if (parsed == p) {
+        return false;
+      }
+      p = parsed;
+      const unsigned long long target = std::strtoull(p, &parsed, 10);
+      if ((parsed == p) || (parsed > lineEnd)) {
+        return false;
+      }
+      p = parsed;
+      edge.m_weight = std::strtod(p, &parsed);
+      if ((parsed == p) || (parsed > lineEnd)) {
+        edge.m_weight = 1.0;
+      }
+      if ((source >= std::numeric_limits<IndexType>::max()) || (target >= std::numeric_limits<IndexType>::max())) {
+        return false;
+      }
+      edge.m_source = static_cast<IndexType>(source);
+      edge.m_target = static_cast<IndexType>(target);
+      m_edges.push_back(edge);
+    }
+    line = lineEnd + 1;
+  }
+  return true;
+}
+
+/**
+ * @brief Reads this processor's share of the records of a binary file,
+ *        with collective reads.
+ */
+bool
+EdgeList::readBinary(
+  MPI_File file,
+  const bool weighted,
+  const MPICommunicator& mpiCommunicator
+)
+{
+  const MPI_Offset myRank = static_cast<MPI_Offset>(mpiCommunicator.rank());
+  const MPI_Offset numProcs = static_cast<MPI_Offset>(mpiCommunicator.size());
+  const MPI_Offset recordSize = 2 * sizeof(uint64_t) + (weighted ? sizeof(double) : 0);
+  MPI_Offset fileSize = 0;
+  MPI_File_get_size(file, &fileSize);
+  if (fileSize % recordSize != 0) {
+    return false;
+  }
+  const MPI_Offset numRecords = fileSize / recordSize;
+  const MPI_Offset first = (numRecords / numProcs) * myRank + std::min(myRank, numRecords % numProcs);
+  const MPI_Offset count = (numRecords / numProcs) + ((myRank < numRecords % numProcs) ? 1 : 0);
+
+  // Every processor takes part in the same number of collective reads.
+  const MPI_Offset recordsPerRead = s_maxReadBytes / recordSize;
+  const MPI_Offset numReads = (numRecords / numProcs + 1 + recordsPerRead - 1) / recordsPerRead;
+  std::vector<char> buffer(std::min(count, recordsPerRead) * recordSize + 1);
+  m_edges.reserve(count);
+  bool valid = true;
+  for (MPI_Offset r = 0; r < numReads; ++r) {
+    const MPI_Offset begin = std::min(count, r * recordsPerRead);
+    const MPI_Offset numRead = std::min(count - begin, recordsPerRead);
+    MPI_Status status;
+    if (MPI_File_read_at_all(file, (first + begin) * recordSize, &buffer[0], static_cast<int>(numRead * recordSize), MPI_BYTE, &status) != MPI_SUCCESS) {
+      valid = false;
+    }
+    for (MPI_Offset k = 0; valid && (k < numRead); ++k) {
+      Edge edge;
+      valid = decodeRecord(&buffer[k * recordSize], weighted, edge);
+      m_edges.push_back(edge);
+    }
+  }
+  return valid;
+}
+
+/**
+ * @brief Reads this processor's share of the blocks of a compressed file.
+ *
+ * The shares are contiguous ranges of whole blocks, which every processor
+ * reads and decompresses independently.
+ */
+bool
+EdgeList::readCompressed(
+  MPI_File file,
+  const MPICommunicator& mpiCommunicator
+)
+{
+  const unsigned long long myRank = mpiCommunicator.rank();
+  const unsigned long long numProcs = mpiCommunicator.size();
+  BlockFile blockFile;
+  if (!blockFile.open(file)) {
+    return false;
+  }
+  const unsigned int recordSize = blockFile.recordSize();
+  if ((recordSize != 2 * sizeof(uint64_t)) && (recordSize != 2 * sizeof(uint64_t) + sizeof(double))) {
+    return false;
+  }
+  const bool weighted = (recordSize != 2 * sizeof(uint64_t));
+  const unsigned long long numBlocks = blockFile.numBlocks();
+  const unsigned long long first = blockFile.blockBegin((numBlocks * myRank) / numProcs);
+  const unsigned long long count = blockFile.blockBegin((numBlocks * (myRank + 1)) / numProcs) - first;
+
+  std::vector<char> buffer(count * recordSize + 1);
+  if (!blockFile.read(file, first, count, &buffer[0])) {
+    return false;
+  }
+  m_edges.resize(count);
+  bool valid = true;
+  for (unsigned long long k = 0; valid && (k < count); ++k) {
+    valid = decodeRecord(&buffer[k * recordSize], weighted, m_edges[k]);
+  }
+  return valid;
+}
+
+/**
+ * @brief Writes the edges to a compressed file, e.g. for converting a text
+ *        file into one which is read without parsing.
+ *
+ * @param fileName          Name of the file.
+ * @param mpiCommunicator   Communicator over which the edges are distributed.
+ *
+ * @return true if the file was written successfully.
+ *
+ * The edges are gathered on processor 0 in the order of the processors,
+ * with gatherv, so their number isn't limited by an int, and are written as the records of the binary format, which carry the
+ * weights only if some edge isn't weighted 1. The edges may be written
+ * before or after build. This is a collective call.
+ */
+bool
+EdgeList::write(
+  const std::string& fileName,
+  const MPICommunicator& mpiCommunicator
+) const
+{
+  const unsigned int myRank = mpiCommunicator.rank();
+  const unsigned int numProcs = mpiCommunicator.size();
+
+  int myWeighted = 0;
+  for (std::vector<Edge>::const_iterator e = m_edges.begin(); e != m_edges.end(); ++e) {
+    myWeighted = myWeighted || (e->m_weight != 1.0);
+  }
+  int weighted = 0;
+  MPI_Allreduce(&myWeighted, &weighted, 1, MPI_INT, MPI_LOR, *mpiCommunicator);
+  const unsigned int recordSize = 2 * sizeof(uint64_t) + (weighted ? sizeof(double) : 0);
+
+  std::vector<char> records(m_edges.size() * recordSize + 1);
+  for (std::size_t k = 0; k < m_edges.size(); ++k) {
+    const uint64_t source = m_edges[k].m_source;
+    const uint64_t target = m_edges[k].m_target;
+    std::memcpy(&records[k * recordSize], &source, sizeof(uint64_t));
+    std::memcpy(&records[k * recordSize + sizeof(uint64_t)], &target, sizeof(uint64_t));
+    if (weighted) {
+      std::memcpy(&records[k * recordSize + 2 * sizeof(uint64_t)], &m_edges[k].m_weight, sizeof(double));
+    }
+  }
+
+  // The records are gathered in counts of any size.
+  unsigned long long myCount = m_edges.size();
+  std::vector<unsigned long long> counts(numProcs, 0);
+  MPI_Gather(&myCount, 1, MPI_UNSIGNED_LONG_LONG, &counts[0], 1, MPI_UNSIGNED_LONG_LONG, 0, *mpiCommunicator);
+  unsigned long long numRecords = 0;
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    numRecords += counts[p];
+  }
+
+  MPI_Datatype recordType;
+  MPI_Type_contiguous(static_cast<int>(recordSize), MPI_BYTE, &recordType);
+  MPI_Type_commit(&recordType);
+  std::vector<char> allRecords;
+  if (myRank == 0) {
+    allRecords.resize(numRecords * recordSize + 1);
+  }
+  gatherv(&records[0], myCount, (myRank == 0) ? &allRecords[0] : 0, counts, recordType, mpiCommunicator);
+  MPI_Type_free(&recordType);
+
+  int written = 0;
+  if (myRank == 0) {
+    written = BlockFile::write(fileName, &allRecords[0], recordSize, numRecords) ? 1 : 0;
+  }
+  MPI_Bcast(&written, 1, MPI_INT, 0, *mpiCommunicator);
+  return written != 0;
+}
+
+/**
+ * @brief Distributes the edges by their sources, with a sample sort.
+ *
+ * @param mpiCommunicator   Communicator over which the edges are distributed.
+ *
+ * Every processor sorts its edges, and contributes regularly spaced sources
+ * as samples. The splitters chosen from the samples cut the sources into
+ * one contiguous range per processor, with about as many edges in each.
+ * Since the edges are sorted, the edges for every processor are contiguous
+ * and are sent in place, and every processor merges the sorted runs it
+ * receives. This is a collective call.
+ */
+void
+EdgeList::build(
+  const MPICommunicator& mpiCommunicator
+)
+{
+  const unsigned int myRank = mpiCommunicator.rank();
+  const unsigned int numProcs = mpiCommunicator.size();
+  if (myRank == 0) {
+    std::cout << "+ building distributed edge lists ... ";
+  }
+
+  double buildTime = MPI_Wtime();
+
+  std::sort(m_edges.begin(), m_edges.end(), SourceOrder());
+
+  const std::size_t numEdges = m_edges.size();
+  const unsigned int numSamples = static_cast<unsigned int>(std::min(static_cast<std::size_t>(s_samplesPerProc), numEdges));
+  std::vector<IndexType> samples(numSamples);
+  for (unsigned int k = 0; k < numSamples; ++k) {
+    samples[k] = m_edges[(k * numEdges) / numSamples].m_source;
+  }
+  int sampleBytes = static_cast<int>(numSamples * sizeof(IndexType));
+  std::vector<int> sampleCounts(numProcs, 0);
+  MPI_Allgather(&sampleBytes, 1, MPI_INT, &sampleCounts[0], 1, MPI_INT, *mpiCommunicator);
+  std::vector<int> sampleDispls(numProcs, 0);
+  for (unsigned int p = 1; p < numProcs; ++p) {
+    sampleDispls[p] = sampleDispls[p - 1] + sampleCounts[p - 1];
+  }
+  std::vector<IndexType> allSamples((sampleDispls[numProcs - 1] + sampleCounts[numProcs - 1]) / sizeof(IndexType));
+  MPI_Allgatherv(samples.empty() ? 0 : &samples[0], sampleBytes, MPI_BYTE,
+                 allSamples.empty() ? 0 : &allSamples[0], &sampleCounts[0], &sampleDispls[0], MPI_BYTE, *mpiCommunicator);
+  std::sort(allSamples.begin(), allSamples.end());
+
+  // Processor p takes the sources in [splitters[p], splitters[p + 1]).
+  std::vector<IndexType> splitters(numProcs + 1, 0);
+  splitters[numProcs] = m_numGlobalNodes;
+  for (unsigned int p = 1; p < numProcs; ++p) {
+    if (allSamples.empty()) {
+      splitters[p] = static_cast<IndexType>((static_cast<unsigned long long>(m_numGlobalNodes) * p) / numProcs);
+    }
+    else {
+      splitters[p] = allSamples[(static_cast<std::size_t>(p) * allSamples.size()) / numProcs];
+    }
+  }
+
+  // The counts of the edges may exceed an int, see exchangeAllv.
+  MPI_Datatype edgeType;
+  MPI_Type_contiguous(sizeof(Edge), MPI_BYTE, &edgeType);
+  MPI_Type_commit(&edgeType);
+
+  std::vector<unsigned long long> sendCounts(numProcs, 0);
+  std::vector<unsigned long long> sendDispls(numProcs, 0);
+  Edge bound;
+  bound.m_target = 0;
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    bound.m_source = splitters[p + 1];
+    const std::size_t upper = (p + 1 < numProcs) ? std::lower_bound(m_edges.begin(), m_edges.end(), bound, SourceOrder()) - m_edges.begin() : numEdges;
+    sendDispls[p] = (p > 0) ? sendDispls[p - 1] + sendCounts[p - 1] : 0;
+    sendCounts[p] = upper - sendDispls[p];
+  }
+  std::vector<unsigned long long> receiveCounts(numProcs, 0);
+  MPI_Alltoall(&sendCounts[0], 1, MPI_UNSIGNED_LONG_LONG, &receiveCounts[0], 1, MPI_UNSIGNED_LONG_LONG, *mpiCommunicator);
+  std::vector<unsigned long long> receiveDispls(numProcs, 0);
+  for (unsigned int p = 1; p < numProcs; ++p) {
+    receiveDispls[p] = receiveDispls[p - 1] + receiveCounts[p - 1];
+  }
+  std::vector<Edge> received(receiveDispls[numProcs - 1] + receiveCounts[numProcs - 1]);
+  exchangeAllv(m_edges.empty() ? 0 : &m_edges[0], sendCounts, sendDispls,
+               received.empty() ? 0 : &received[0], receiveCounts, receiveDispls, edgeType, mpiCommunicator);
+  MPI_Type_free(&edgeType);
+  m_edges.swap(received);
+  std::vector<Edge>().swap(received);
+
+  std::vector<std::size_t> runs(receiveDispls.begin(), receiveDispls.end());
+  runs.push_back(m_edges.size());
+  mergeRuns(runs);
+
+  m_firstNode = splitters[myRank];
+  m_numLocalNodes = static_cast<unsigned int>(splitters[myRank + 1] - splitters[myRank]);
+  m_offsets.assign(m_numLocalNodes + 1, 0);
+  for (std::vector<Edge>::const_iterator e = m_edges.begin(); e != m_edges.end(); ++e) {
+    ++m_offsets[e->m_source - m_firstNode + 1];
+  }
+  for (unsigned int i = 0; i < m_numLocalNodes; ++i) {
+    m_offsets[i + 1] += m_offsets[i];
+  }
+
+  buildTime = MPI_Wtime() - buildTime;
+
+  if (myRank == 0) {
+    std::cout << "done: "
+      << buildTime * 1000 << "ms"
+      << std::endl;
+  }
+}
+
+/**
+ * @brief Merges consecutive sorted runs of edges, pairwise.
+ *
+ * @param runs   Boundaries of the runs, including the end of the edges.
+ */
+void
+EdgeList::mergeRuns(
+  const std::vector<std::size_t>& runs
+)
+{
+  std::vector<std::size_t> bounds(runs);
+  while (bounds.size() > 2) {
+    std::vector<std::size_t> merged;
+    for (std::size_t r = 0; r + 2 < bounds.size(); r += 2) {
+      std::inplace_merge(m_edges.begin() + bounds[r], m_edges.begin() + bounds[r + 1], m_edges.begin() + bounds[r + 2], SourceOrder());
+      merged.push_back(bounds[r]);
+    }
+    if (bounds.size() % 2 == 0) {
+      merged.push_back(bounds[bounds.size() - 2]);
+    }
+    merged.push_back(bounds.back());
+    bounds.swap(merged);
+  }
+}
+
+EdgeList::IndexType
+EdgeList::numGlobalNodes(
+) const
+{
+  return m_numGlobalNodes;
+}
+
+unsigned long long
+EdgeList::numGlobalEdges(
+) const
+{
+  return m_numGlobalEdges;
+}
+
+/**
+ * @brief Global index of the first local source, after build.
+ */
+EdgeList::IndexType
+EdgeList::firstNode(
+) const
+{
+  return m_firstNode;
+}
+
+unsigned int
+EdgeList::numLocalNodes(
+) const
+{
+  return m_numLocalNodes;
+}
+
+/**
+ * @brief Number of edges of a local source, after build.
+ */
+std::size_t
+EdgeList::numEdges(
+  const unsigned int i
+) const
+{
+  return m_offsets[i + 1] - m_offsets[i];
+}
+
+/**
+ * @brief Edges of a local source, sorted by their targets, after build.
+ */
+const EdgeList::Edge*
+EdgeList::edges(
+  const unsigned int i
+) const
+{
+  return m_edges.empty() ? 0 : &m_edges[0] + m_offsets[i];
+}
+
+EdgeList::~EdgeList(
+)
+{
+}
@@ -0,0 +1,122 @@
+#include "Frontier.hpp"
+
+Frontier::Frontier(
+) : m_flags(),
+  m_active(),
+  m_size(0),
+  m_full(true)
+{
+}
+
+/**
+ * @brief Resets the frontier.
+ *
+ * @param size    Number of nodes over which the frontier is defined.
+ * @param full    Whether all the nodes are active.
+ *
+ * Only the flags of the previously active nodes are cleared, so that
+ * resetting a sparse frontier doesn't cost a pass over all the nodes.
+ */
+void
+Frontier::reset(
+  const unsigned int size,
+  const bool full
+)
+{
+  if ((m_flags.size() != size) || m_full) {
+    m_flags.assign(size, 0);
+  }
+  else {
+    for (std::vector<unsigned int>::const_iterator a = m_active.begin(); a != m_active.end(); ++a) {
+      m_flags[*a] = 0;
+    }
+  }
+  m_active.clear();
+  m_size = size;
+  m_full = full;
+}
+
+/**
+ * @brief Extends the frontier to more nodes, keeping the active ones.
+ *
+ * @param size    New number of nodes, which is not smaller than the current.
+ *
+ * The new nodes are active only in a full frontier.
+ */
+void
+Frontier::grow(
+  const unsigned int size
+)
+{
+  if (size > m_size) {
+    m_flags.resize(size, 0);
+    m_size = size;
+  }
+}
+
+void
+Frontier::activate(
+  const unsigned int i
+)
+{
+  if (!m_full && (m_flags[i] == 0)) {
+    m_flags[i] = 1;
+    m_active.push_back(i);
+  }
+}
+
+bool
+Frontier::isActive(
+  const unsigned int i
+) const
+{
+  return m_full || (m_flags[i] != 0);
+}
+
+bool
+Frontier::isFull(
+) const
+{
+  return m_full;
+}
+
+unsigned int
+Frontier::size(
+) const
+{
+  return m_size;
+}
+
+unsigned int
+Frontier::numActive(
+) const
+{
+  return m_full ? m_size : static_cast<unsigned int>(m_active.size());
+}
+
+/**
+ * @brief Fraction of the nodes which are active.
+ */
+double
+Frontier::density(
+) const
+{
+  return (m_size > 0) ? (static_cast<double>(numActive()) / m_size) : 0.0;
+}
+
+/**
+ * @brief Lists the active nodes, in the order of activation.
+ *
+ * The list is empty for a full frontier.
+ */
+const std::vector<unsigned int>&
+Frontier::active(
+) const
+{
+  return m_active;
+}
+
+Frontier::~Frontier(
+)
+{
+}
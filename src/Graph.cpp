@@ -1,50 +1,1917 @@
 #include "Graph.hpp"
 
+#include "CombineFunction.hpp"
+#include "EdgeList.hpp"
+#include "ExchangeAll.hpp"
+#include "HaloExchange.hpp"
 #include "MPICommunicator.hpp"
+#include "MessageAggregator.hpp"
+#include "NumaPlacement.hpp"
+#include "Reduction.hpp"
 #include "SampleLocalCombineFunction.hpp"
+#include "TreeIndex.hpp"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+/** Number of nodes handed to a thread at a time **/
+const int s_chunkSize = 64;
+
+int
+numThreads(
+)
+{
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+int
+threadNumber(
+)
+{
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+/**
+ * @brief MPI type of the global node indices, which are 64-bit wide when
+ *        built with GRAPHWORKS_INDEX64.
+ */
+MPI_Datatype
+indexDatatype(
+)
+{
+  return (sizeof(Graph::Node::IndexType) == sizeof(unsigned long long)) ? MPI_UNSIGNED_LONG_LONG : MPI_UNSIGNED;
+}
+
+/** Reversed edge, sent to the owner of its source **/
+class ReversedEdge {
+public:
+  Graph::Node::IndexType m_source;
+  Graph::Node::IndexType m_target;
+}; // class ReversedEdge
+
+/** Node whose new index is asked from its owner, and then sent back by it **/
+class RelabelMessage {
+public:
+  Graph::Node::IndexType m_node;
+  Graph::Node::IndexType m_newNode;
+  unsigned int m_rank;
+}; // class RelabelMessage
+
+/** New global indices of the nodes, for the renumbering of the local ones **/
+class Relabeling {
+public:
+  Relabeling(
+    const Graph& g,
+    const Graph::Node::IndexType first,
+    const std::vector<unsigned int>& positions,
+    const std::unordered_map<Graph::Node::IndexType, Graph::Node::IndexType>& remote
+  ) : m_graph(&g),
+    m_first(first),
+    m_positions(&positions),
+    m_remote(&remote)
+  {
+  }
+
+  /** Added nodes, and invalid indices, keep their indices **/
+  Graph::Node::IndexType
+  operator()(
+    const Graph::Node::IndexType index
+  ) const
+  {
+    if (index >= m_graph->globalSize()) {
+      return index;
+    }
+    if (m_graph->isLocal(index)) {
+      return m_first + (*m_positions)[m_graph->localIndex(index)];
+    }
+    std::unordered_map<Graph::Node::IndexType, Graph::Node::IndexType>::const_iterator r = m_remote->find(index);
+    return (r != m_remote->end()) ? r->second : index;
+  }
+
+private:
+  const Graph* m_graph;
+  Graph::Node::IndexType m_first;
+  const std::vector<unsigned int>* m_positions;
+  const std::unordered_map<Graph::Node::IndexType, Graph::Node::IndexType>* m_remote;
+}; // class Relabeling
+
+/** Orders local nodes by their degrees, keeping the order of equal degrees **/
+class DegreeOrder {
+public:
+  DegreeOrder(
+    const std::vector<unsigned int>& degrees,
+    const bool descending
+  ) : m_degrees(&degrees),
+    m_descending(descending)
+  {
+  }
+
+  bool
+  operator()(
+    const unsigned int a,
+    const unsigned int b
+  ) const
+  {
+    return m_descending ? ((*m_degrees)[a] > (*m_degrees)[b]) : ((*m_degrees)[a] < (*m_degrees)[b]);
+  }
+
+private:
+  const std::vector<unsigned int>* m_degrees;
+  bool m_descending;
+}; // class DegreeOrder
+
+/** Keeps the accumulated payloads of the remote neighbors in the tree **/
+class AccumulatedPayloads : public MessageAggregator::UpdateHandler {
+public:
+  AccumulatedPayloads(
+    std::unordered_map<Graph::Node::IndexType, Graph::Node::PayloadType>& payloads
+  ) : m_payloads(payloads)
+  { }
+
+  void
+  operator()(
+    const Graph::Node::IndexType node,
+    const Graph::Node::PayloadType payload
+  )
+  {
+    m_payloads[node] = payload;
+  }
+
+private:
+  std::unordered_map<Graph::Node::IndexType, Graph::Node::PayloadType>& m_payloads;
+}; // class AccumulatedPayloads
+
+/**
+ * @brief Interaction sets of the accumulations on a forest, which hold the
+ *        children, or the parent, of every node.
+ *
+ * The interaction sets are only generated for the general generate
+ * functions, so those of the special ones follow from the tree index.
+ */
+void
+forestInteractionSets(
+  const TreeIndex& tree,
+  const unsigned int numNodes,
+  const bool children,
+  std::vector<std::vector<Graph::Node> >& interactionSets
+)
+{
+  interactionSets.assign(numNodes, std::vector<Graph::Node>());
+  for (unsigned int i = 0; i < numNodes; ++i) {
+    if (children) {
+      for (unsigned int c = 0; c < tree.numChildren(i); ++c) {
+        interactionSets[i].push_back(Graph::Node(tree.children(i)[c]));
+      }
+    }
+    else if (!tree.isRoot(i)) {
+      interactionSets[i].push_back(Graph::Node(tree.parent(i)));
+    }
+  }
+}
+
+} // namespace
+
+/**
+ * @brief Constructs the local part of a graph with one node per point.
+ *
+ * @param points            Points local to this processor.
+ * @param numPoints         Number of local points.
+ * @param bounds            Bounds with which the points were set, which are
+ *                          the same on all the processors.
+ * @param mpiCommunicator   Communicator over which the graph is distributed.
+ *
+ * Nodes are numbered globally in the order of the processor ranks, so that
+ * the local nodes of processor p occupy the range [m_offsets[p], m_offsets[p + 1]).
+ * All the communication of the graph stays within the communicator, of which
+ * the graph keeps a copy, so that a group split off for the graph may be
+ * passed as a temporary. The points are read in place, and have to outlive
+ * the graph; they are only copied once the graph adds or moves nodes.
+ */
+Graph::Graph(
+  const InputData::Point* const points,
+  const unsigned int numPoints,
+  const InputData::Bounds& bounds,
+  const MPICommunicator& mpiCommunicator
+) : m_nodeList(),
+  m_points(),
+  m_sharedPoints((numPoints > 0) ? points : 0),
+  m_bounds(bounds),
+  m_peerPoints(),
+  m_offsets(mpiCommunicator.size() + 1, 0),
+  m_mpiCommunicator(mpiCommunicator),
+  m_numBaseNodes(numPoints),
+  m_edges(),
+  m_insertedEdges(),
+  m_erasedEdges(),
+  m_transpose(),
+  m_hasTranspose(false),
+  m_setTranspose(),
+  m_transposedSets(0),
+  m_setsGeneration(0),
+  m_transposedGeneration(0),
+  m_setsAreEdges(false),
+  m_mutations(),
+  m_removed(numPoints, 0),
+  m_removedNodes(),
+  m_lastRemovedNodes(),
+  m_dirty(),
+  m_versions(numPoints, 0),
+  m_versionClock(0),
+  m_originalIndices(),
+  m_reordered(false),
+  m_frontier(),
+  m_active(),
+  m_changed(),
+  m_halo(0),
+  m_slots(),
+  m_payloads(),
+  m_deferredNodes(),
+  m_deferredPayloads(),
+  m_treeIndex(),
+  m_numaPlaced(false),
+  m_nodeDomains(),
+  m_threadDomains(),
+  m_numLocalAccesses(0),
+  m_numRemoteAccesses(0)
+{
+  std::vector<unsigned int> counts(m_mpiCommunicator.size());
+  MPI_Allgather(&numPoints, 1, MPI_UNSIGNED, &counts[0], 1, MPI_UNSIGNED, *m_mpiCommunicator);
+  for (unsigned int p = 0; p < m_mpiCommunicator.size(); ++p) {
+    m_offsets[p + 1] = m_offsets[p] + counts[p];
+  }
+
+  m_nodeList.reserve(numPoints);
+  for (unsigned int i = 0; i < numPoints; ++i) {
+    m_nodeList.push_back(Node(globalIndex(i)));
+  }
+  m_dirty.reset(numPoints, false);
+}
+
+Graph::NodeIterator
+Graph::begin(
+)
+{
+  return m_nodeList.begin();
+}
+
+Graph::ConstNodeIterator
+Graph::begin(
+) const
+{
+  return m_nodeList.begin();
+}
+
+Graph::NodeIterator
+Graph::end(
+)
+{
+  return m_nodeList.end();
+}
+
+Graph::ConstNodeIterator
+Graph::end(
+) const
+{
+  return m_nodeList.end();
+}
+
+unsigned int
+Graph::size(
+) const
+{
+  return static_cast<unsigned int>(m_nodeList.size());
+}
+
+/**
+ * @brief Constructs the local part of a graph from already built nodes.
+ *
+ * @param nodes             Nodes local to this processor.
+ * @param mpiCommunicator   Communicator over which the graph is distributed.
+ *
+ * The nodes are expected to follow the global numbering used by the graph,
+ * as produced by the tree builders.
+ */
+Graph::Graph(
+  const std::vector<Node>& nodes,
+  const MPICommunicator& mpiCommunicator
+) : m_nodeList(nodes),
+  m_points(),
+  m_sharedPoints(0),
+  m_bounds(),
+  m_peerPoints(),
+  m_offsets(mpiCommunicator.size() + 1, 0),
+  m_mpiCommunicator(mpiCommunicator),
+  m_numBaseNodes(static_cast<unsigned int>(nodes.size())),
+  m_edges(),
+  m_insertedEdges(),
+  m_erasedEdges(),
+  m_transpose(),
+  m_hasTranspose(false),
+  m_setTranspose(),
+  m_transposedSets(0),
+  m_setsGeneration(0),
+  m_transposedGeneration(0),
+  m_setsAreEdges(false),
+  m_mutations(),
+  m_removed(nodes.size(), 0),
+  m_removedNodes(),
+  m_lastRemovedNodes(),
+  m_dirty(),
+  m_versions(nodes.size(), 0),
+  m_versionClock(0),
+  m_originalIndices(),
+  m_reordered(false),
+  m_frontier(),
+  m_active(),
+  m_changed(),
+  m_halo(0),
+  m_slots(),
+  m_payloads(),
+  m_deferredNodes(),
+  m_deferredPayloads(),
+  m_treeIndex(),
+  m_numaPlaced(false),
+  m_nodeDomains(),
+  m_threadDomains(),
+  m_numLocalAccesses(0),
+  m_numRemoteAccesses(0)
+{
+  std::vector<unsigned int> counts(m_mpiCommunicator.size());
+  unsigned int numNodes = static_cast<unsigned int>(m_nodeList.size());
+  MPI_Allgather(&numNodes, 1, MPI_UNSIGNED, &counts[0], 1, MPI_UNSIGNED, *m_mpiCommunicator);
+  for (unsigned int p = 0; p < m_mpiCommunicator.size(); ++p) {
+    m_offsets[p + 1] = m_offsets[p] + counts[p];
+  }
+
+  for (unsigned int i = 0; i < numNodes; ++i) {
+    if (m_nodeList[i].index() != globalIndex(i)) {
+      throw std::runtime_error("Node indices don't follow the global numbering!");
+    }
+  }
+  m_dirty.reset(numNodes, false);
+}
+
+/**
+ * @brief Constructs the local part of a graph from distributed edge lists.
+ *
+ * @param edgeList          Edges built over the same communicator, which
+ *                          give every processor a contiguous range of nodes.
+ * @param mpiCommunicator   Communicator over which the graph is distributed.
+ *
+ * The nodes keep the indices of the edge lists, and their edges are stored
+ * compressed, with the weights dropped.
+ */
 Graph::Graph(
-  const InputData::Point* const,
-  const unsigned int,
+  const EdgeList& edgeList,
   const MPICommunicator& mpiCommunicator
 ) : m_nodeList(),
-  m_mpiCommunicator(mpiCommunicator)
+  m_points(),
+  m_sharedPoints(0),
+  m_bounds(),
+  m_peerPoints(),
+  m_offsets(mpiCommunicator.size() + 1, 0),
+  m_mpiCommunicator(mpiCommunicator),
+  m_numBaseNodes(edgeList.numLocalNodes()),
+  m_edges(),
+  m_insertedEdges(),
+  m_erasedEdges(),
+  m_transpose(),
+  m_hasTranspose(false),
+  m_setTranspose(),
+  m_transposedSets(0),
+  m_setsGeneration(0),
+  m_transposedGeneration(0),
+  m_setsAreEdges(false),
+  m_mutations(),
+  m_removed(edgeList.numLocalNodes(), 0),
+  m_removedNodes(),
+  m_lastRemovedNodes(),
+  m_dirty(),
+  m_versions(edgeList.numLocalNodes(), 0),
+  m_versionClock(0),
+  m_originalIndices(),
+  m_reordered(false),
+  m_frontier(),
+  m_active(),
+  m_changed(),
+  m_halo(0),
+  m_slots(),
+  m_payloads(),
+  m_deferredNodes(),
+  m_deferredPayloads(),
+  m_treeIndex(),
+  m_numaPlaced(false),
+  m_nodeDomains(),
+  m_threadDomains(),
+  m_numLocalAccesses(0),
+  m_numRemoteAccesses(0)
+{
+  std::vector<unsigned int> counts(m_mpiCommunicator.size());
+  unsigned int numNodes = edgeList.numLocalNodes();
+  MPI_Allgather(&numNodes, 1, MPI_UNSIGNED, &counts[0], 1, MPI_UNSIGNED, *m_mpiCommunicator);
+  for (unsigned int p = 0; p < m_mpiCommunicator.size(); ++p) {
+    m_offsets[p + 1] = m_offsets[p] + counts[p];
+  }
+  if (m_offsets[m_mpiCommunicator.rank()] != edgeList.firstNode()) {
+    throw std::runtime_error("Edge lists don't follow the global numbering!");
+  }
+
+  m_nodeList.reserve(numNodes);
+  std::vector<Node::IndexType> targets;
+  for (unsigned int i = 0; i < numNodes; ++i) {
+    m_nodeList.push_back(Node(globalIndex(i)));
+    const EdgeList::Edge* edges = edgeList.edges(i);
+    targets.resize(edgeList.numEdges(i));
+    for (unsigned int e = 0; e < targets.size(); ++e) {
+      targets[e] = edges[e].m_target;
+    }
+    m_edges.append(targets.empty() ? 0 : &targets[0], static_cast<unsigned int>(targets.size()));
+  }
+  m_dirty.reset(numNodes, false);
+}
+
+/**
+ * @brief Constructs the local part of a graph with one node per point of
+ *        the input data.
+ *
+ * @param inputData         Points read over the same communicator, which
+ *                          have to outlive the graph.
+ * @param mpiCommunicator   Communicator over which the graph is distributed.
+ *
+ * If the points were read into shared memory, the points of the other
+ * processors on this host are read in place as well, through peerPoints().
+ *
+ * Only the points are shared, since they don't change after the read. The
+ * edges and the payloads stay private to every processor: they change with
+ * every mutation and every superstep of their owner. Reading them in place
+ * would need the co-located processors to synchronize at every change.
+ * The ghosts of co-located nodes are therefore still sent through the halo
+ * exchanges, like the ghosts of the other hosts.
+ */
+Graph::Graph(
+  const InputData& inputData,
+  const MPICommunicator& mpiCommunicator
+) : Graph(inputData.points(), inputData.numLocalPoints(), inputData.bounds(), mpiCommunicator)
+{
+  const MPICommunicator* nodeCommunicator = inputData.nodeCommunicator();
+  if (nodeCommunicator == 0) {
+    return;
+  }
+
+  // The processors of the host are found in the communicator of the graph,
+  // which may be a group of the processors which read the points.
+  const unsigned int numNodeProcs = static_cast<unsigned int>(nodeCommunicator->size());
+  std::vector<int> nodeRanks(numNodeProcs);
+  std::vector<int> ranks(numNodeProcs);
+  for (unsigned int r = 0; r < numNodeProcs; ++r) {
+    nodeRanks[r] = static_cast<int>(r);
+  }
+  MPI_Group nodeGroup, group;
+  MPI_Comm_group(**nodeCommunicator, &nodeGroup);
+  MPI_Comm_group(*m_mpiCommunicator, &group);
+  MPI_Group_translate_ranks(nodeGroup, static_cast<int>(numNodeProcs), &nodeRanks[0], group, &ranks[0]);
+  MPI_Group_free(&nodeGroup);
+  MPI_Group_free(&group);
+
+  m_peerPoints.assign(m_mpiCommunicator.size(), 0);
+  for (unsigned int r = 0; r < numNodeProcs; ++r) {
+    if ((ranks[r] == MPI_UNDEFINED) || (static_cast<unsigned int>(ranks[r]) == m_mpiCommunicator.rank())) {
+      continue;
+    }
+    const unsigned int p = static_cast<unsigned int>(ranks[r]);
+    unsigned int numPoints = 0;
+    const InputData::Point* points = inputData.nodePoints(r, numPoints);
+    if ((numPoints > 0) && (numPoints == m_offsets[p + 1] - m_offsets[p])) {
+      m_peerPoints[p] = points;
+    }
+  }
+}
+
+const InputData::Point*
+Graph::points(
+) const
+{
+  if (m_sharedPoints != 0) {
+    return m_sharedPoints;
+  }
+  return m_points.empty() ? 0 : &m_points[0];
+}
+
+/**
+ * @brief Bounds with which the points are read, and with which the points
+ *        of new nodes have to be set.
+ */
+const InputData::Bounds&
+Graph::bounds(
+) const
+{
+  return m_bounds;
+}
+
+/**
+ * @brief Whether the points are still read in place from the array which
+ *        the graph was constructed from.
+ */
+bool
+Graph::hasSharedPoints(
+) const
+{
+  return m_sharedPoints != 0;
+}
+
+/**
+ * @brief Points of another processor on this host, as read into shared
+ *        memory, in the order of the nodes which it numbered at the
+ *        construction.
+ *
+ * @param p   Rank of the processor.
+ *
+ * @return The points, or 0 if they aren't directly accessible. They only
+ *         match the nodes of the processor as long as its graph still has
+ *         shared points.
+ */
+const InputData::Point*
+Graph::peerPoints(
+  const unsigned int p
+) const
+{
+  return m_peerPoints.empty() ? 0 : m_peerPoints[p];
+}
+
+/**
+ * @brief Global index of the first node which a processor numbered at the
+ *        construction.
+ */
+Graph::Node::IndexType
+Graph::firstIndex(
+  const unsigned int p
+) const
+{
+  return m_offsets[p];
+}
+
+/**
+ * @brief Number of nodes over all the processors at the construction.
+ *
+ * The indices of the nodes added later lie above it.
+ */
+Graph::Node::IndexType
+Graph::globalSize(
+) const
+{
+  return m_offsets.back();
+}
+
+/**
+ * @brief Global index of a local node.
+ *
+ * Nodes added after the construction are numbered above the initial global
+ * size, with a stride of the number of processors, so that every processor
+ * can number its nodes without communication.
+ */
+Graph::Node::IndexType
+Graph::globalIndex(
+  const unsigned int localIndex
+) const
+{
+  if (localIndex < m_numBaseNodes) {
+    return m_offsets[m_mpiCommunicator.rank()] + localIndex;
+  }
+  return globalSize() + static_cast<Node::IndexType>((localIndex - m_numBaseNodes) * m_mpiCommunicator.size() + m_mpiCommunicator.rank());
+}
+
+/**
+ * @brief Finds the processor which owns a node.
+ *
+ * @param index   Global index of the node.
+ *
+ * @return Rank of the owning processor.
+ */
+unsigned int
+Graph::owner(
+  const Node::IndexType index
+) const
+{
+  if (index == Node::s_invalidIndex) {
+    throw std::runtime_error("Node index is out of range!");
+  }
+  if (index >= globalSize()) {
+    return static_cast<unsigned int>((index - globalSize()) % m_mpiCommunicator.size());
+  }
+  // Skip over the leading empty ranges by finding the last offset <= index.
+  std::vector<Node::IndexType>::const_iterator upper = std::upper_bound(m_offsets.begin(), m_offsets.end(), index);
+  return static_cast<unsigned int>((upper - m_offsets.begin()) - 1);
+}
+
+bool
+Graph::isLocal(
+  const Node::IndexType index
+) const
+{
+  size_t myRank = m_mpiCommunicator.rank();
+  if ((index >= globalSize()) && (index != Node::s_invalidIndex)) {
+    return ((index - globalSize()) % m_mpiCommunicator.size() == myRank) &&
+           ((index - globalSize()) / m_mpiCommunicator.size() < size() - m_numBaseNodes);
+  }
+  return (index >= m_offsets[myRank]) && (index < m_offsets[myRank + 1]);
+}
+
+unsigned int
+Graph::localIndex(
+  const Node::IndexType index
+) const
+{
+  if (index >= globalSize()) {
+    return m_numBaseNodes + static_cast<unsigned int>((index - globalSize()) / m_mpiCommunicator.size());
+  }
+  return static_cast<unsigned int>(index - m_offsets[m_mpiCommunicator.rank()]);
+}
+
+Graph::OwnerOrder::OwnerOrder(
+  const Graph& g
+) : m_graph(&g)
+{
+}
+
+/**
+ * @brief Compares two global indices by their owners, and then by their
+ *        local indices at the owners.
+ *
+ * The ranges of the nodes numbered at the construction follow the ranks,
+ * so that only the strided indices of the added nodes need their owners.
+ * Within an owner, the global indices follow the local ones.
+ */
+bool
+Graph::OwnerOrder::operator()(
+  const Node::IndexType a,
+  const Node::IndexType b
+) const
+{
+  if ((a < m_graph->globalSize()) && (b < m_graph->globalSize())) {
+    return a < b;
+  }
+  const unsigned int ownerA = m_graph->owner(a);
+  const unsigned int ownerB = m_graph->owner(b);
+  return (ownerA < ownerB) || ((ownerA == ownerB) && (a < b));
+}
+
+bool
+Graph::OwnerOrder::operator()(
+  const Node& a,
+  const Node& b
+) const
+{
+  return (*this)(a.index(), b.index());
+}
+
+const MPICommunicator&
+Graph::communicator(
+) const
+{
+  return m_mpiCommunicator;
+}
+
+/**
+ * @brief Adds a local node, which is marked dirty.
+ *
+ * @param payload   Payload of the new node.
+ *
+ * @return Global index of the new node.
+ *
+ * Nodes are added without communication, and can be referred to by other
+ * mutations right away. Graphs built from points need the point of every
+ * new node.
+ */
+Graph::Node::IndexType
+Graph::addNode(
+  const Node::PayloadType payload
+)
+{
+  if ((m_sharedPoints != 0) || !m_points.empty()) {
+    throw std::runtime_error("Nodes of a graph of points need a point!");
+  }
+  return appendNode(payload);
+}
+
+Graph::Node::IndexType
+Graph::addNode(
+  const InputData::Point& point,
+  const Node::PayloadType payload
+)
+{
+  if (m_sharedPoints != 0) {
+    m_points.assign(m_sharedPoints, m_sharedPoints + m_nodeList.size());
+    m_sharedPoints = 0;
+  }
+  if (m_points.size() != m_nodeList.size()) {
+    throw std::runtime_error("Graph doesn't hold points!");
+  }
+  m_points.push_back(point);
+  return appendNode(payload);
+}
+
+Graph::Node::IndexType
+Graph::appendNode(
+  const Node::PayloadType payload
+)
+{
+  const unsigned int i = size();
+  Node node(globalIndex(i));
+  node.payload() = payload;
+  m_nodeList.push_back(node);
+  m_removed.push_back(0);
+  m_versions.push_back(0);
+  if (m_reordered) {
+    m_originalIndices.push_back(node.index());
+  }
+  m_numaPlaced = false;
+  stamp(i);
+  m_dirty.grow(size());
+  m_dirty.activate(i);
+  return node.index();
+}
+
+/**
+ * @brief Removes a node along with its edges.
+ *
+ * @param index   Global index of the node, which may be remote.
+ *
+ * Like all the mutations of possibly remote nodes, the removal takes effect
+ * at the next applyUpdates. Removed nodes keep their local indices, but are
+ * skipped by the computations, and dropped from the neighbors of all nodes.
+ */
+void
+Graph::removeNode(
+  const Node::IndexType index
+)
+{
+  Mutation mutation;
+  mutation.m_kind = Mutation::RemoveNode;
+  mutation.m_node = index;
+  mutation.m_other = Node::s_invalidIndex;
+  mutation.m_payload = Node::PayloadType();
+  m_mutations.push_back(mutation);
+}
+
+/**
+ * @brief Adds an edge, which is stored with its source node.
+ *
+ * @param source   Global index of the source node, which may be remote.
+ * @param target   Global index of the target node.
+ */
+void
+Graph::addEdge(
+  const Node::IndexType source,
+  const Node::IndexType target
+)
+{
+  Mutation mutation;
+  mutation.m_kind = Mutation::AddEdge;
+  mutation.m_node = source;
+  mutation.m_other = target;
+  mutation.m_payload = Node::PayloadType();
+  m_mutations.push_back(mutation);
+}
+
+/**
+ * @brief Removes one edge between the given nodes.
+ *
+ * @param source   Global index of the source node, which may be remote.
+ * @param target   Global index of the target node.
+ */
+void
+Graph::removeEdge(
+  const Node::IndexType source,
+  const Node::IndexType target
+)
+{
+  Mutation mutation;
+  mutation.m_kind = Mutation::RemoveEdge;
+  mutation.m_node = source;
+  mutation.m_other = target;
+  mutation.m_payload = Node::PayloadType();
+  m_mutations.push_back(mutation);
+}
+
+/**
+ * @brief Sets the payload of a node.
+ *
+ * @param index     Global index of the node, which may be remote.
+ * @param payload   New payload of the node.
+ */
+void
+Graph::updatePayload(
+  const Node::IndexType index,
+  const Node::PayloadType payload
+)
+{
+  Mutation mutation;
+  mutation.m_kind = Mutation::UpdatePayload;
+  mutation.m_node = index;
+  mutation.m_other = Node::s_invalidIndex;
+  mutation.m_payload = payload;
+  m_mutations.push_back(mutation);
+}
+
+/**
+ * @brief Applies the buffered mutations at the owners of their nodes.
+ *
+ * All the mutated nodes are marked dirty, and the removed nodes are made
+ * known to all the processors. The communication is proportional to the
+ * number of mutations. This is a collective call.
+ */
+void
+Graph::applyUpdates(
+)
+{
+  const unsigned int numProcs = m_mpiCommunicator.size();
+  std::vector<std::vector<Mutation> > outgoing(numProcs);
+  for (std::vector<Mutation>::const_iterator m = m_mutations.begin(); m != m_mutations.end(); ++m) {
+    outgoing[owner(m->m_node)].push_back(*m);
+  }
+  m_mutations.clear();
+
+  std::vector<Mutation> receiveBuffer;
+  exchangeAll(outgoing, receiveBuffer, m_mpiCommunicator);
+
+  std::vector<Node::IndexType> removed;
+  for (std::vector<Mutation>::const_iterator m = receiveBuffer.begin(); m != receiveBuffer.end(); ++m) {
+    if (!isLocal(m->m_node)) {
+      throw std::runtime_error("Mutation of a node which doesn't exist!");
+    }
+    const unsigned int i = localIndex(m->m_node);
+    if (m_removed[i]) {
+      continue;
+    }
+    switch (m->m_kind) {
+      case Mutation::RemoveNode:
+        m_removed[i] = 1;
+        m_insertedEdges.erase(i);
+        m_erasedEdges.erase(i);
+        removed.push_back(m->m_node);
+        break;
+      case Mutation::AddEdge:
+        insertEdge(i, m->m_other);
+        break;
+      case Mutation::RemoveEdge:
+        eraseEdge(i, m->m_other);
+        break;
+      default:
+        m_nodeList[i].payload() = m->m_payload;
+        stamp(i);
+        break;
+    }
+    m_dirty.activate(i);
+  }
+
+  // Every processor learns of the removed nodes, to drop the edges to them.
+  int numRemoved = static_cast<int>(removed.size());
+  std::vector<int> removedCounts(numProcs, 0);
+  MPI_Allgather(&numRemoved, 1, MPI_INT, &removedCounts[0], 1, MPI_INT, *m_mpiCommunicator);
+  std::vector<int> removedDispls(numProcs, 0);
+  for (unsigned int p = 1; p < numProcs; ++p) {
+    removedDispls[p] = removedDispls[p - 1] + removedCounts[p - 1];
+  }
+  m_lastRemovedNodes.resize(removedDispls[numProcs - 1] + removedCounts[numProcs - 1]);
+  MPI_Allgatherv(removed.empty() ? 0 : &removed[0], numRemoved, indexDatatype(),
+                 m_lastRemovedNodes.empty() ? 0 : &m_lastRemovedNodes[0], &removedCounts[0], &removedDispls[0], indexDatatype(), *m_mpiCommunicator);
+  m_removedNodes.insert(m_lastRemovedNodes.begin(), m_lastRemovedNodes.end());
+
+  // Added and removed nodes change the forest, and the edges the transpose.
+  m_treeIndex.reset();
+  m_transpose.clear();
+  m_hasTranspose = false;
+  m_transposedSets = 0;
+}
+
+bool
+Graph::isRemoved(
+  const Node::IndexType index
+) const
+{
+  if (isLocal(index)) {
+    return m_removed[localIndex(index)] != 0;
+  }
+  return m_removedNodes.find(index) != m_removedNodes.end();
+}
+
+/**
+ * @brief Global indices of the nodes removed by the last applyUpdates, over
+ *        all the processors.
+ */
+const std::vector<Graph::Node::IndexType>&
+Graph::removedNodes(
+) const
+{
+  return m_lastRemovedNodes;
+}
+
+/**
+ * @brief Local nodes which were mutated since the last computation.
+ */
+const Frontier&
+Graph::dirty(
+) const
+{
+  return m_dirty;
+}
+
+/**
+ * @brief Marks a local node to be recomputed by the next computation.
+ */
+void
+Graph::markDirty(
+  const unsigned int i
+)
+{
+  m_dirty.activate(i);
+}
+
+/**
+ * @brief Version of the payload of a local node.
+ *
+ * The version changes whenever a computation or a mutation changes the
+ * payload, and never repeats for a node, even after the node has moved to
+ * another processor. Payloads written directly into the nodes keep their
+ * versions.
+ */
+Graph::VersionType
+Graph::version(
+  const unsigned int i
+) const
+{
+  return m_versions[i];
+}
+
+/**
+ * @brief Gives a local node a new version.
+ *
+ * The versions are drawn from a clock of this processor and interleaved by
+ * the ranks, so that no two processors hand out the same version.
+ */
+void
+Graph::stamp(
+  const unsigned int i
+)
+{
+  ++m_versionClock;
+  m_versions[i] = m_versionClock * m_mpiCommunicator.size() + m_mpiCommunicator.rank();
+}
+
+/**
+ * @brief Lists the targets of the edges of a local node.
+ *
+ * @param i           Local index of the node.
+ * @param neighbors   Global indices of the targets, excluding removed nodes.
+ */
+void
+Graph::neighbors(
+  const unsigned int i,
+  std::vector<Node::IndexType>& neighbors
+) const
+{
+  neighbors.clear();
+  if (m_removed[i]) {
+    return;
+  }
+  if (i < m_edges.numLists()) {
+    m_edges.decode(i, neighbors);
+  }
+  // Every erased target cancels one of the compressed edges to it.
+  std::unordered_map<unsigned int, std::vector<Node::IndexType> >::const_iterator erased = m_erasedEdges.find(i);
+  std::vector<Node::IndexType> erasedTargets;
+  if (erased != m_erasedEdges.end()) {
+    erasedTargets = erased->second;
+  }
+  unsigned int numKept = 0;
+  for (unsigned int e = 0; e < neighbors.size(); ++e) {
+    std::vector<Node::IndexType>::iterator t = std::find(erasedTargets.begin(), erasedTargets.end(), neighbors[e]);
+    if (t != erasedTargets.end()) {
+      erasedTargets.erase(t);
+    }
+    else if (!isRemoved(neighbors[e])) {
+      neighbors[numKept++] = neighbors[e];
+    }
+  }
+  neighbors.resize(numKept);
+  std::unordered_map<unsigned int, std::vector<Node::IndexType> >::const_iterator inserted = m_insertedEdges.find(i);
+  if (inserted != m_insertedEdges.end()) {
+    for (std::vector<Node::IndexType>::const_iterator t = inserted->second.begin(); t != inserted->second.end(); ++t) {
+      if (!isRemoved(*t)) {
+        neighbors.push_back(*t);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Merges the inserted edges into the compressed edge lists, and drops
+ *        the removed ones.
+ *
+ * The edges are kept per node as sorted lists of delta encoded targets,
+ * with the later insertions and removals held separately, so that mutations
+ * don't move the edges of other nodes. This local call rebuilds the
+ * compressed lists, after which the targets of every node are sorted.
+ */
+void
+Graph::compactEdges(
+)
+{
+  CompressedIndexLists<Node::IndexType> edges;
+  std::vector<Node::IndexType> targets;
+  for (unsigned int i = 0; i < size(); ++i) {
+    neighbors(i, targets);
+    std::sort(targets.begin(), targets.end());
+    edges.append(targets.empty() ? 0 : &targets[0], static_cast<unsigned int>(targets.size()));
+  }
+  std::swap(m_edges, edges);
+  m_insertedEdges.clear();
+  m_erasedEdges.clear();
+}
+
+/**
+ * @brief Transposes lists of global indices which are given for the local
+ *        nodes.
+ *
+ * @param lists        Global indices listed by every local node.
+ * @param transposed   Global indices of the nodes which list every local
+ *                     node, sorted.
+ *
+ * Every entry is sent to the owner of the listed node in one exchange, and
+ * the arrived entries are then bucketed by their local nodes with a
+ * counting sort. This is a collective call.
+ */
+void
+Graph::transpose(
+  const std::vector<std::vector<Node::IndexType> >& lists,
+  CompressedIndexLists<Node::IndexType>& transposed
+) const
+{
+  std::vector<std::vector<ReversedEdge> > outgoing(m_mpiCommunicator.size());
+  for (unsigned int i = 0; i < lists.size(); ++i) {
+    const Node::IndexType index = globalIndex(i);
+    for (std::vector<Node::IndexType>::const_iterator t = lists[i].begin(); t != lists[i].end(); ++t) {
+      const ReversedEdge edge = {*t, index};
+      outgoing[owner(*t)].push_back(edge);
+    }
+  }
+  std::vector<ReversedEdge> incoming;
+  exchangeAll(outgoing, incoming, m_mpiCommunicator);
+
+  std::vector<std::size_t> offsets(size() + 1, 0);
+  for (std::vector<ReversedEdge>::const_iterator e = incoming.begin(); e != incoming.end(); ++e) {
+    ++offsets[localIndex(e->m_source) + 1];
+  }
+  for (unsigned int i = 0; i < size(); ++i) {
+    offsets[i + 1] += offsets[i];
+  }
+  std::vector<Node::IndexType> targets(incoming.size());
+  std::vector<std::size_t> next(offsets.begin(), offsets.end() - 1);
+  for (std::vector<ReversedEdge>::const_iterator e = incoming.begin(); e != incoming.end(); ++e) {
+    targets[next[localIndex(e->m_source)]++] = e->m_target;
+  }
+
+  // The entries arrive in the order of the ranks, which is sorted except
+  // for the added nodes.
+  transposed.clear();
+  for (unsigned int i = 0; i < size(); ++i) {
+    std::sort(targets.begin() + offsets[i], targets.begin() + offsets[i + 1]);
+    transposed.append(targets.data() + offsets[i], static_cast<unsigned int>(offsets[i + 1] - offsets[i]));
+  }
+}
+
+/**
+ * @brief Builds the reversed edges of the local nodes, which are kept until
+ *        the edges change.
+ *
+ * This is a collective call.
+ */
+void
+Graph::buildTranspose(
+)
+{
+  std::vector<std::vector<Node::IndexType> > targets(size());
+  for (unsigned int i = 0; i < size(); ++i) {
+    neighbors(i, targets[i]);
+  }
+  transpose(targets, m_transpose);
+  m_hasTranspose = true;
+}
+
+bool
+Graph::hasTranspose(
+) const
+{
+  return m_hasTranspose;
+}
+
+/**
+ * @brief Transposes the interaction sets, which is kept until the graph
+ *        changes, or the sets are generated again, for the reverse
+ *        accumulations on the same interaction sets.
+ *
+ * @param interactionSets   Interaction sets for all the local nodes.
+ *
+ * @return Global indices of the nodes whose interaction sets hold every
+ *         local node, sorted.
+ *
+ * When every interaction set lists the neighbors of its node, the transpose
+ * of the graph is the same, and is used instead. This is a collective call.
+ */
+const CompressedIndexLists<Graph::Node::IndexType>&
+Graph::transposeInteractionSets(
+  const std::vector<std::vector<Node> >& interactionSets
+)
+{
+  std::vector<std::vector<Node::IndexType> > members(size());
+  std::vector<Node::IndexType> targets;
+  int localEdges = 1;
+  for (unsigned int i = 0; i < size(); ++i) {
+    for (std::vector<Node>::const_iterator n = interactionSets[i].begin(); n != interactionSets[i].end(); ++n) {
+      members[i].push_back(n->index());
+    }
+    if (localEdges) {
+      std::sort(members[i].begin(), members[i].end());
+      neighbors(i, targets);
+      std::sort(targets.begin(), targets.end());
+      localEdges = (members[i] == targets) ? 1 : 0;
+    }
+  }
+  int edges = 0;
+  MPI_Allreduce(&localEdges, &edges, 1, MPI_INT, MPI_LAND, *m_mpiCommunicator);
+
+  m_setsAreEdges = (edges != 0);
+  if (m_setsAreEdges) {
+    m_setTranspose.clear();
+    if (!m_hasTranspose) {
+      buildTranspose();
+    }
+  }
+  else {
+    transpose(members, m_setTranspose);
+  }
+  m_transposedSets = &interactionSets;
+  m_transposedGeneration = m_setsGeneration;
+  return m_setsAreEdges ? m_transpose : m_setTranspose;
+}
+
+/**
+ * @brief Notes that interaction sets were generated again, so that none of
+ *        the sets transposed before are taken for them, even at the same
+ *        address.
+ */
+void
+Graph::interactionSetsChanged(
+)
+{
+  ++m_setsGeneration;
+}
+
+/**
+ * @brief Lists the sources of the edges to a local node, from the transpose.
+ *
+ * @param i         Local index of the node.
+ * @param sources   Global indices of the sources, excluding removed nodes.
+ */
+void
+Graph::inNeighbors(
+  const unsigned int i,
+  std::vector<Node::IndexType>& sources
+) const
+{
+  if (!m_hasTranspose) {
+    throw std::runtime_error("The transpose of the graph hasn't been built!");
+  }
+  m_transpose.decode(i, sources);
+}
+
+/**
+ * @brief Ratio of the largest cost of a processor to the mean cost.
+ *
+ * @param costs   Cost of each local node.
+ *
+ * @return 1 for perfectly balanced costs. This is a collective call.
+ */
+double
+Graph::imbalance(
+  const std::vector<double>& costs
+) const
+{
+  double localCost = 0.0;
+  for (std::vector<double>::const_iterator c = costs.begin(); c != costs.end(); ++c) {
+    localCost += *c;
+  }
+  double maxCost = 0.0;
+  double totalCost = 0.0;
+  MPI_Allreduce(&localCost, &maxCost, 1, MPI_DOUBLE, MPI_MAX, *m_mpiCommunicator);
+  MPI_Allreduce(&localCost, &totalCost, 1, MPI_DOUBLE, MPI_SUM, *m_mpiCommunicator);
+  if (!(totalCost > 0.0)) {
+    return 1.0;
+  }
+  return maxCost * m_mpiCommunicator.size() / totalCost;
+}
+
+/**
+ * @brief Moves nodes between the processors to balance their costs.
+ *
+ * @param costs   Cost of each local node, such as the size of its
+ *                interaction set.
+ *
+ * @return true if any node moved.
+ *
+ * The nodes keep their global indices, and so their global order: the
+ * prefix sums of the costs along that order are cut into equal parts, and
+ * each processor takes the nodes of one part, along with their payloads,
+ * points, original indices, compressed edges and removed and dirty marks.
+ *
+ * Only the ranges of the nodes numbered at the construction move. Nodes
+ * added later are never moved: they stay with the processors which added
+ * them, and their costs are left out of the balance, so a graph which grew
+ * unevenly stays unbalanced by the added nodes.
+ *
+ * The edges are compacted, and the local indices change. The halo set on
+ * the graph is therefore dropped rather than updated, and the computations
+ * build a new one over the moved nodes. This is a collective call.
+ */
+bool
+Graph::rebalance(
+  const std::vector<double>& costs
+)
+{
+  if (costs.size() != size()) {
+    throw std::runtime_error("Costs don't match the local nodes!");
+  }
+  const unsigned int numProcs = m_mpiCommunicator.size();
+  const unsigned int myRank = m_mpiCommunicator.rank();
+
+  double localCost = 0.0;
+  for (unsigned int i = 0; i < m_numBaseNodes; ++i) {
+    localCost += costs[i];
+  }
+  double before = 0.0;
+  double totalCost = 0.0;
+  MPI_Exscan(&localCost, &before, 1, MPI_DOUBLE, MPI_SUM, *m_mpiCommunicator);
+  MPI_Allreduce(&localCost, &totalCost, 1, MPI_DOUBLE, MPI_SUM, *m_mpiCommunicator);
+  if (myRank == 0) {
+    before = 0.0;
+  }
+  // Without any cost, the counts of the nodes are balanced instead.
+  const bool uniform = !(totalCost > 0.0);
+  if (uniform) {
+    before = static_cast<double>(m_offsets[myRank]);
+    totalCost = static_cast<double>(globalSize());
+  }
+
+  // Each node goes to the part which holds the middle of its cost.
+  std::vector<std::vector<Migrant> > outgoing(numProcs);
+  std::vector<std::vector<InputData::Point> > outgoingPoints(numProcs);
+  std::vector<std::vector<unsigned char> > outgoingEdges(numProcs);
+  std::vector<Node::IndexType> targets;
+  const InputData::Point* const points = this->points();
+  int moved = 0;
+  for (unsigned int i = 0; i < m_numBaseNodes; ++i) {
+    const double cost = uniform ? 1.0 : costs[i];
+    const unsigned int p = std::min(numProcs - 1, static_cast<unsigned int>((before + 0.5 * cost) * numProcs / totalCost));
+    before += cost;
+
+    const Migrant migrant = {
+      m_nodeList[i],
+      m_versions[i],
+      originalIndex(i),
+      m_removed[i],
+      static_cast<char>(m_dirty.isActive(i) ? 1 : 0)
+    };
+    outgoing[p].push_back(migrant);
+    neighbors(i, targets);
+    std::sort(targets.begin(), targets.end());
+    CompressedIndexLists<Node::IndexType>::encode(targets.empty() ? 0 : &targets[0], static_cast<unsigned int>(targets.size()), outgoingEdges[p]);
+    if (points != 0) {
+      outgoingPoints[p].push_back(points[i]);
+    }
+    if (p != myRank) {
+      moved = 1;
+    }
+  }
+  int anyMoved = 0;
+  MPI_Allreduce(&moved, &anyMoved, 1, MPI_INT, MPI_LOR, *m_mpiCommunicator);
+  if (!anyMoved) {
+    return false;
+  }
+
+  std::vector<Migrant> incoming;
+  std::vector<InputData::Point> incomingPoints;
+  std::vector<unsigned char> incomingEdges;
+  exchangeAll(outgoing, incoming, m_mpiCommunicator);
+  exchangeAll(outgoingPoints, incomingPoints, m_mpiCommunicator);
+  exchangeAll(outgoingEdges, incomingEdges, m_mpiCommunicator);
+
+  // The received nodes arrive in their global order, followed by the added nodes.
+  const unsigned int numBaseNodes = static_cast<unsigned int>(incoming.size());
+  const unsigned int numNodes = numBaseNodes + size() - m_numBaseNodes;
+  std::vector<Node> nodeList;
+  std::vector<VersionType> versions;
+  std::vector<Node::IndexType> originalIndices;
+  std::vector<char> removed;
+  CompressedIndexLists<Node::IndexType> edges;
+  nodeList.reserve(numNodes);
+  versions.reserve(numNodes);
+  removed.reserve(numNodes);
+  const unsigned char* encoded = incomingEdges.empty() ? 0 : &incomingEdges[0];
+  for (std::vector<Migrant>::const_iterator m = incoming.begin(); m != incoming.end(); ++m) {
+    nodeList.push_back(m->m_node);
+    versions.push_back(m->m_version);
+    if (m_reordered) {
+      originalIndices.push_back(m->m_originalIndex);
+    }
+    removed.push_back(m->m_removed);
+    encoded = CompressedIndexLists<Node::IndexType>::decode(encoded, targets);
+    edges.append(targets.empty() ? 0 : &targets[0], static_cast<unsigned int>(targets.size()));
+  }
+  for (unsigned int i = m_numBaseNodes; i < size(); ++i) {
+    nodeList.push_back(m_nodeList[i]);
+    versions.push_back(m_versions[i]);
+    if (m_reordered) {
+      originalIndices.push_back(m_originalIndices[i]);
+    }
+    removed.push_back(m_removed[i]);
+    neighbors(i, targets);
+    std::sort(targets.begin(), targets.end());
+    edges.append(targets.empty() ? 0 : &targets[0], static_cast<unsigned int>(targets.size()));
+  }
+  if (m_points.size() > m_numBaseNodes) {
+    incomingPoints.insert(incomingPoints.end(), m_points.begin() + m_numBaseNodes, m_points.end());
+  }
+
+  Frontier dirty;
+  dirty.reset(numNodes, false);
+  for (unsigned int k = 0; k < numBaseNodes; ++k) {
+    if (incoming[k].m_dirty) {
+      dirty.activate(k);
+    }
+  }
+  for (std::vector<unsigned int>::const_iterator i = m_dirty.active().begin(); i != m_dirty.active().end(); ++i) {
+    if (*i >= m_numBaseNodes) {
+      dirty.activate(*i - m_numBaseNodes + numBaseNodes);
+    }
+  }
+
+  m_nodeList.swap(nodeList);
+  m_versions.swap(versions);
+  m_originalIndices.swap(originalIndices);
+  m_points.swap(incomingPoints);
+  m_sharedPoints = 0;
+  m_removed.swap(removed);
+  std::swap(m_edges, edges);
+  m_insertedEdges.clear();
+  m_erasedEdges.clear();
+  m_dirty = dirty;
+  m_numBaseNodes = numBaseNodes;
+
+  std::vector<unsigned int> counts(numProcs);
+  MPI_Allgather(&m_numBaseNodes, 1, MPI_UNSIGNED, &counts[0], 1, MPI_UNSIGNED, *m_mpiCommunicator);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    m_offsets[p + 1] = m_offsets[p] + counts[p];
+  }
+
+  // The halo maps the old local indices, and is built again by its owner.
+  m_halo = 0;
+  m_treeIndex.reset();
+  m_transpose.clear();
+  m_hasTranspose = false;
+  m_transposedSets = 0;
+  m_numaPlaced = false;
+  m_frontier.reset(size(), true);
+  m_changed.reset(size(), false);
+  return true;
+}
+
+/**
+ * @brief Renumbers the nodes of every processor within its own range, so
+ *        that neighboring nodes get close local indices.
+ *
+ * @param ordering   Order in which the nodes are renumbered.
+ *
+ * @return true if any node got a new index.
+ *
+ * Only the nodes numbered at the construction are renumbered, along with
+ * their payloads, versions, points, and removed and dirty marks, and the
+ * global indices in the edges, the parents and the removed nodes of all the
+ * processors follow them. The orders are found over the edges between the
+ * local nodes, taken in both directions. The original indices of the nodes
+ * are kept for mapping the results back. The edges are compacted, and the
+ * local indices change, so that any halo or interaction sets over the graph
+ * have to be built again. The buffered updates have to be applied first.
+ * This is a collective call.
+ */
+bool
+Graph::reorder(
+  const Ordering ordering
+)
+{
+  if (!m_mutations.empty()) {
+    throw std::runtime_error("Reordering needs the updates to be applied first!");
+  }
+  const unsigned int numProcs = m_mpiCommunicator.size();
+  const unsigned int myRank = m_mpiCommunicator.rank();
+
+  std::vector<unsigned int> order;
+  localOrder(ordering, order);
+  std::vector<unsigned int> positions(m_numBaseNodes);
+  int moved = 0;
+  for (unsigned int k = 0; k < m_numBaseNodes; ++k) {
+    positions[order[k]] = k;
+    if (order[k] != k) {
+      moved = 1;
+    }
+  }
+  int anyMoved = 0;
+  MPI_Allreduce(&moved, &anyMoved, 1, MPI_INT, MPI_LOR, *m_mpiCommunicator);
+  if (!anyMoved) {
+    return false;
+  }
+
+  // The owners of the remote nodes which are referred to send their new indices.
+  std::vector<std::vector<RelabelMessage> > requests(numProcs);
+  std::vector<Node::IndexType> targets;
+  std::vector<Node::IndexType> referred(m_removedNodes.begin(), m_removedNodes.end());
+  for (unsigned int i = 0; i < size(); ++i) {
+    neighbors(i, targets);
+    referred.insert(referred.end(), targets.begin(), targets.end());
+    referred.push_back(m_nodeList[i].parent());
+  }
+  std::sort(referred.begin(), referred.end());
+  referred.erase(std::unique(referred.begin(), referred.end()), referred.end());
+  for (std::vector<Node::IndexType>::const_iterator r = referred.begin(); r != referred.end(); ++r) {
+    if ((*r < globalSize()) && !isLocal(*r)) {
+      const RelabelMessage request = {*r, Node::s_invalidIndex, myRank};
+      requests[owner(*r)].push_back(request);
+    }
+  }
+  std::vector<RelabelMessage> incoming;
+  exchangeAll(requests, incoming, m_mpiCommunicator);
+  std::vector<std::vector<RelabelMessage> > replies(numProcs);
+  for (std::vector<RelabelMessage>::iterator r = incoming.begin(); r != incoming.end(); ++r) {
+    r->m_newNode = m_offsets[myRank] + positions[localIndex(r->m_node)];
+    replies[r->m_rank].push_back(*r);
+  }
+  std::vector<RelabelMessage> answered;
+  exchangeAll(replies, answered, m_mpiCommunicator);
+
+  std::unordered_map<Node::IndexType, Node::IndexType> remote;
+  for (std::vector<RelabelMessage>::const_iterator a = answered.begin(); a != answered.end(); ++a) {
+    remote[a->m_node] = a->m_newNode;
+  }
+  const Relabeling relabel(*this, m_offsets[myRank], positions, remote);
+
+  std::vector<Node> nodeList;
+  std::vector<VersionType> versions;
+  std::vector<Node::IndexType> originalIndices;
+  std::vector<char> removed;
+  std::vector<InputData::Point> points;
+  CompressedIndexLists<Node::IndexType> edges;
+  Frontier dirty;
+  nodeList.reserve(size());
+  versions.reserve(size());
+  originalIndices.reserve(size());
+  removed.reserve(size());
+  const InputData::Point* const sourcePoints = this->points();
+  points.reserve((sourcePoints != 0) ? size() : 0);
+  dirty.reset(size(), false);
+  for (unsigned int k = 0; k < size(); ++k) {
+    const unsigned int i = (k < m_numBaseNodes) ? order[k] : k;
+    const Node& node = m_nodeList[i];
+    nodeList.push_back(Node(relabel(node.index()), relabel(node.parent()), node.numChildren(), node.level()));
+    nodeList.back().payload() = node.payload();
+    versions.push_back(m_versions[i]);
+    originalIndices.push_back(originalIndex(i));
+    removed.push_back(m_removed[i]);
+    if (sourcePoints != 0) {
+      points.push_back(sourcePoints[i]);
+    }
+    neighbors(i, targets);
+    for (std::vector<Node::IndexType>::iterator t = targets.begin(); t != targets.end(); ++t) {
+      *t = relabel(*t);
+    }
+    std::sort(targets.begin(), targets.end());
+    edges.append(targets.empty() ? 0 : &targets[0], static_cast<unsigned int>(targets.size()));
+    if (m_dirty.isActive(i)) {
+      dirty.activate(k);
+    }
+  }
+
+  std::unordered_set<Node::IndexType> removedNodes;
+  for (std::unordered_set<Node::IndexType>::const_iterator r = m_removedNodes.begin(); r != m_removedNodes.end(); ++r) {
+    removedNodes.insert(relabel(*r));
+  }
+  for (std::vector<Node::IndexType>::iterator r = m_lastRemovedNodes.begin(); r != m_lastRemovedNodes.end(); ++r) {
+    *r = relabel(*r);
+  }
+
+  m_nodeList.swap(nodeList);
+  m_versions.swap(versions);
+  m_originalIndices.swap(originalIndices);
+  m_reordered = true;
+  m_removed.swap(removed);
+  m_points.swap(points);
+  m_sharedPoints = 0;
+  std::swap(m_edges, edges);
+  m_insertedEdges.clear();
+  m_erasedEdges.clear();
+  m_removedNodes.swap(removedNodes);
+  m_dirty = dirty;
+
+  m_halo = 0;
+  m_treeIndex.reset();
+  m_transpose.clear();
+  m_hasTranspose = false;
+  m_transposedSets = 0;
+  m_numaPlaced = false;
+  m_frontier.reset(size(), true);
+  m_changed.reset(size(), false);
+  return true;
+}
+
+/**
+ * @brief Global index of a local node before any reordering, for mapping
+ *        the results back to the input.
+ */
+Graph::Node::IndexType
+Graph::originalIndex(
+  const unsigned int i
+) const
+{
+  return m_reordered ? m_originalIndices[i] : m_nodeList[i].index();
+}
+
+/**
+ * @brief Finds the order of the local nodes numbered at the construction.
+ *
+ * @param ordering   Kind of the order.
+ * @param order      Local index of the node at every new position.
+ *
+ * The orders work on the edges between the local nodes in both directions.
+ * The descending degree order puts the nodes with most of these edges in
+ * front, so that the most shared payloads are packed together. The breadth
+ * first order numbers every connected part in the order of a search from
+ * its first node. Reverse Cuthill-McKee starts every part at a node of the
+ * smallest degree, visits the neighbors by increasing degrees, and reverses
+ * the whole order, which keeps the neighbors of every node within a narrow
+ * band.
+ */
+void
+Graph::localOrder(
+  const Ordering ordering,
+  std::vector<unsigned int>& order
+) const
+{
+  const unsigned int numNodes = m_numBaseNodes;
+  const Node::IndexType first = m_offsets[m_mpiCommunicator.rank()];
+
+  // Adjacency of the local nodes, in both directions and without repeats,
+  // bucketed with a counting sort.
+  std::vector<std::pair<unsigned int, unsigned int> > pairs;
+  std::vector<std::size_t> offsets(numNodes + 1, 0);
+  std::vector<Node::IndexType> targets;
+  for (unsigned int i = 0; i < numNodes; ++i) {
+    neighbors(i, targets);
+    for (std::vector<Node::IndexType>::const_iterator t = targets.begin(); t != targets.end(); ++t) {
+      if ((*t >= first) && (*t < first + numNodes) && (*t != first + i)) {
+        const unsigned int j = static_cast<unsigned int>(*t - first);
+        pairs.push_back(std::make_pair(i, j));
+        ++offsets[i + 1];
+        ++offsets[j + 1];
+      }
+    }
+  }
+  for (unsigned int i = 0; i < numNodes; ++i) {
+    offsets[i + 1] += offsets[i];
+  }
+  std::vector<unsigned int> adjacent(offsets[numNodes]);
+  std::vector<std::size_t> ends(offsets.begin(), offsets.end() - 1);
+  for (std::vector<std::pair<unsigned int, unsigned int> >::const_iterator e = pairs.begin(); e != pairs.end(); ++e) {
+    adjacent[ends[e->first]++] = e->second;
+    adjacent[ends[e->second]++] = e->first;
+  }
+  std::vector<std::pair<unsigned int, unsigned int> >().swap(pairs);
+  std::vector<unsigned int> degrees(numNodes);
+  std::size_t numAdjacent = 0;
+  for (unsigned int i = 0; i < numNodes; ++i) {
+    std::sort(adjacent.begin() + offsets[i], adjacent.begin() + offsets[i + 1]);
+    const std::size_t end = std::unique(adjacent.begin() + offsets[i], adjacent.begin() + offsets[i + 1]) - adjacent.begin();
+    degrees[i] = static_cast<unsigned int>(end - offsets[i]);
+    std::copy(adjacent.begin() + offsets[i], adjacent.begin() + end, adjacent.begin() + numAdjacent);
+    offsets[i] = numAdjacent;
+    numAdjacent += degrees[i];
+  }
+  offsets[numNodes] = numAdjacent;
+
+  std::vector<unsigned int> nodes(numNodes);
+  for (unsigned int i = 0; i < numNodes; ++i) {
+    nodes[i] = i;
+  }
+  if (ordering == DescendingDegree) {
+    std::stable_sort(nodes.begin(), nodes.end(), DegreeOrder(degrees, true));
+    order.swap(nodes);
+    return;
+  }
+
+  const bool cuthillMcKee = (ordering == ReverseCuthillMcKee);
+  if (cuthillMcKee) {
+    std::stable_sort(nodes.begin(), nodes.end(), DegreeOrder(degrees, false));
+  }
+  order.clear();
+  order.reserve(numNodes);
+  std::vector<char> visited(numNodes, 0);
+  for (std::vector<unsigned int>::const_iterator start = nodes.begin(); start != nodes.end(); ++start) {
+    if (visited[*start]) {
+      continue;
+    }
+    visited[*start] = 1;
+    order.push_back(*start);
+    for (std::size_t head = order.size() - 1; head < order.size(); ++head) {
+      const unsigned int i = order[head];
+      const std::size_t begin = order.size();
+      for (std::size_t e = offsets[i]; e < offsets[i + 1]; ++e) {
+        if (!visited[adjacent[e]]) {
+          visited[adjacent[e]] = 1;
+          order.push_back(adjacent[e]);
+        }
+      }
+      if (cuthillMcKee) {
+        std::stable_sort(order.begin() + begin, order.end(), DegreeOrder(degrees, false));
+      }
+    }
+  }
+  if (cuthillMcKee) {
+    std::reverse(order.begin(), order.end());
+  }
+}
+
+void
+Graph::insertEdge(
+  const unsigned int i,
+  const Node::IndexType target
+)
+{
+  m_insertedEdges[i].push_back(target);
+}
+
+void
+Graph::eraseEdge(
+  const unsigned int i,
+  const Node::IndexType target
+)
+{
+  std::unordered_map<unsigned int, std::vector<Node::IndexType> >::iterator inserted = m_insertedEdges.find(i);
+  if (inserted != m_insertedEdges.end()) {
+    std::vector<Node::IndexType>::iterator t = std::find(inserted->second.begin(), inserted->second.end(), target);
+    if (t != inserted->second.end()) {
+      inserted->second.erase(t);
+      return;
+    }
+  }
+  // An edge is erased from the compressed ones only if some are left to erase.
+  if (i < m_edges.numLists()) {
+    std::vector<Node::IndexType> targets;
+    m_edges.decode(i, targets);
+    std::vector<Node::IndexType>& erased = m_erasedEdges[i];
+    if (std::count(targets.begin(), targets.end(), target) > std::count(erased.begin(), erased.end(), target)) {
+      erased.push_back(target);
+    }
+  }
+}
+
+/**
+ * @brief Frontier of the sources which changed since the last computation.
+ *
+ * The frontier is defined over the extended indices of the halo set with
+ * setHalo. Without a halo, or with a full frontier, all the nodes are
+ * recomputed.
+ */
+Frontier&
+Graph::frontier(
+)
+{
+  return m_frontier;
+}
+
+const Frontier&
+Graph::frontier(
+) const
+{
+  return m_frontier;
+}
+
+/**
+ * @brief Local nodes for which combine returned true in the last computation.
+ */
+const Frontier&
+Graph::changed(
+) const
+{
+  return m_changed;
+}
+
+/**
+ * @brief Sets the halo over which the frontier is defined.
+ *
+ * @param halo   Halo built over the interaction sets of the following
+ *               computations, or 0 for recomputing all the nodes.
+ */
+void
+Graph::setHalo(
+  const HaloExchange* const halo
+)
 {
+  m_halo = halo;
 }
 
-Graph::NodeIterator
-Graph::begin(
+const HaloExchange*
+Graph::halo(
+) const
+{
+  return m_halo;
+}
+
+/**
+ * @brief Places the nodes, and the points, on the NUMA domains of the host
+ *        in blocks, for the multithreaded computations.
+ *
+ * The nodes are copied into new storage, whose pages are then bound to the
+ * domains of the threads which reduce them, and moved there. Only
+ * constructed storage is placed, so without libnuma the pages stay where
+ * the copy touched them. The domains of the nodes, and of the pinned
+ * threads, are looked up once for counting the local and remote accesses
+ * of the threads. Points which are read in place stay where they are, since
+ * they may be shared with other processors. The scratch arrays of the
+ * kernels aren't placed: they are either used by one thread, or indexed by
+ * the sources which the threads push from rather than by the nodes they
+ * reduce. Appending or moving nodes drops the placement.
+ */
+void
+Graph::placeNodes(
 )
 {
-  return m_nodeList.begin();
+  if (m_numaPlaced) {
+    return;
+  }
+
+  std::vector<Node> nodeList(m_nodeList.begin(), m_nodeList.end());
+  NumaPlacement::place(nodeList.data(), nodeList.size() * sizeof(Node));
+  m_nodeList.swap(nodeList);
+
+  if (!m_points.empty()) {
+    std::vector<InputData::Point> points(m_points.begin(), m_points.end());
+    NumaPlacement::place(points.data(), points.size() * sizeof(InputData::Point));
+    m_points.swap(points);
+  }
+
+  NumaPlacement::pageDomains(m_nodeList.data(), m_nodeList.size(), sizeof(Node), m_nodeDomains);
+  m_threadDomains.assign(numThreads(), -1);
+  #pragma omp parallel
+  {
+    m_threadDomains[threadNumber()] = NumaPlacement::currentDomain();
+  }
+  m_numaPlaced = true;
 }
 
-Graph::ConstNodeIterator
-Graph::begin(
+bool
+Graph::isPlaced(
 ) const
 {
-  return m_nodeList.begin();
+  return m_numaPlaced;
 }
 
-Graph::NodeIterator
-Graph::end(
+/**
+ * @brief Number of the placed nodes which were reduced by threads on their
+ *        own domains.
+ */
+unsigned long long
+Graph::numLocalAccesses(
+) const
+{
+  return m_numLocalAccesses;
+}
+
+/**
+ * @brief Number of the placed nodes which were reduced by threads on other
+ *        domains. Accesses where the domain of the thread or of the node
+ *        isn't known are counted as neither local nor remote.
+ */
+unsigned long long
+Graph::numRemoteAccesses(
+) const
+{
+  return m_numRemoteAccesses;
+}
+
+/**
+ * @brief Builds the index of the forest formed by the parents of the nodes,
+ *        which is dropped again when nodes are added, removed or moved.
+ *
+ * This is a collective call.
+ */
+void
+Graph::buildTreeIndex(
 )
 {
-  return m_nodeList.end();
+  m_treeIndex.reset(new TreeIndex(*this));
 }
 
-Graph::ConstNodeIterator
-Graph::end(
+/**
+ * @brief Index of the forest, or 0 if it hasn't been built since the last
+ *        change of the nodes.
+ */
+const TreeIndex*
+Graph::treeIndex(
 ) const
 {
-  return m_nodeList.end();
+  return m_treeIndex.get();
 }
 
-unsigned int
-Graph::size(
+/**
+ * @brief Finds the local nodes which have a changed source in their
+ *        interaction sets, or which are dirty.
+ *
+ * @return Frontier of the nodes which need to be recomputed.
+ */
+const Frontier&
+Graph::activeNodes(
+)
+{
+  if ((m_halo == 0) || m_frontier.isFull()) {
+    m_active.reset(size(), true);
+    return m_active;
+  }
+
+  m_active.reset(size(), false);
+  for (std::vector<unsigned int>::const_iterator s = m_frontier.active().begin(); s != m_frontier.active().end(); ++s) {
+    const unsigned int* references = m_halo->references(*s);
+    for (unsigned int r = 0; r < m_halo->numReferences(*s); ++r) {
+      m_active.activate(m_halo->referenceTarget(references[r]));
+    }
+  }
+  for (std::vector<unsigned int>::const_iterator i = m_dirty.active().begin(); i != m_dirty.active().end(); ++i) {
+    m_active.activate(*i);
+  }
+  return m_active;
+}
+
+/**
+ * @brief Combines a node with all the nodes in its interaction set.
+ *
+ * @param combine           User provided combine function.
+ * @param node              Node to be updated.
+ * @param interactionSet    Interaction set of the node.
+ * @param payloads          Scratch buffer for gathering the payloads, which
+ *                          is reused across calls.
+ *
+ * @return true if any of the calls to combine returned true.
+ *
+ * Batched combine functions get the whole interaction set in one call,
+ * either as the contiguous nodes themselves or as their gathered payloads.
+ */
+bool
+Graph::combineNode(
+  const CombineFunction& combine,
+  Node& node,
+  const std::vector<Node>& interactionSet,
+  std::vector<Node::PayloadType>& payloads
 ) const
 {
-  return static_cast<unsigned int>(m_nodeList.size());
+  const unsigned int setSize = static_cast<unsigned int>(interactionSet.size());
+  switch (combine.batching()) {
+    case CombineFunction::Nodes:
+      return combine(node, setSize > 0 ? &interactionSet[0] : 0, setSize);
+
+    case CombineFunction::Payloads:
+      payloads.resize(setSize);
+      for (unsigned int j = 0; j < setSize; ++j) {
+        payloads[j] = interactionSet[j].payload();
+      }
+      return combine(node, setSize > 0 ? &payloads[0] : 0, setSize);
+
+    default:
+      bool combined = false;
+      for (unsigned int j = 0; j < setSize; ++j) {
+        combined = combine(node, interactionSet[j]) || combined;
+      }
+      return combined;
+  }
 }
 
 template <Graph::AlgorithmChoice>
@@ -65,16 +1932,482 @@ Graph::compute<Graph::NoDependency>(
   const std::vector<std::vector<Node> >& interactionSets
 )
 {
-  // For each node in the node list, apply combine for all the nodes in its interacton set.
-  for (unsigned int i = 0; i < m_nodeList.size(); ++ i) {
-    for (unsigned int j = 0; j < interactionSets[i].size(); ++ j) {
-      combine(m_nodeList[i], interactionSets[i][j]);
+  if (combine.reduction() != 0) {
+    return pullReduction(*combine.reduction(), interactionSets);
+  }
+
+  // For each active node, apply combine for all the nodes in its interacton set.
+  std::vector<Node::PayloadType> payloads;
+  const Frontier& active = activeNodes();
+  m_changed.reset(size(), false);
+  if (active.isFull()) {
+    for (unsigned int i = 0; i < m_nodeList.size(); ++ i) {
+      if (!m_removed[i] && combineNode(combine, m_nodeList[i], interactionSets[i], payloads)) {
+        m_changed.activate(i);
+      }
+    }
+  }
+  else {
+    for (std::vector<unsigned int>::const_iterator i = active.active().begin(); i != active.active().end(); ++i) {
+      if (!m_removed[*i] && combineNode(combine, m_nodeList[*i], interactionSets[*i], payloads)) {
+        m_changed.activate(*i);
+      }
+    }
+  }
+  endCombine();
+
+  return true;
+}
+
+/**
+ * @brief Push version of the computation for independent interaction sets.
+ *
+ * @param combine           User provided combine function.
+ * @param interactionSets   Interaction sets for all the local nodes.
+ *
+ * @return Result of the computation.
+ *
+ * Instead of visiting the active nodes and combining them with their whole
+ * interaction sets, every changed source is combined into the nodes which
+ * refer to it. The work is then proportional to the references of the
+ * frontier, which is far less than the interaction sets of the active nodes
+ * when the frontier is sparse. Only the changed sources are combined, and
+ * the unchanged ones are not combined again, which gives the same result as
+ * pulling only for idempotent reductions, like the minimum labels or the
+ * shortest distances. Any other combine function is pulled.
+ * Dirty nodes are combined with their whole interaction sets.
+ */
+bool
+Graph::computePush(
+  const CombineFunction& combine,
+  const std::vector<std::vector<Node> >& interactionSets
+)
+{
+  if ((m_halo == 0) || m_frontier.isFull() ||
+      (combine.reduction() == 0) || !combine.reduction()->isIdempotent()) {
+    return compute<NoDependency>(combine, interactionSets);
+  }
+  return pushReduction(*combine.reduction(), interactionSets);
+}
+
+/**
+ * @brief Multithreaded pull version of the computation for combine functions
+ *        which reduce the payloads of the interaction sets.
+ *
+ * @param reduction         Reduction of the combine function.
+ * @param interactionSets   Interaction sets for all the local nodes.
+ *
+ * @return Result of the computation.
+ */
+bool
+Graph::pullReduction(
+  const Reduction& reduction,
+  const std::vector<std::vector<Node> >& interactionSets
+)
+{
+  const Frontier& active = activeNodes();
+  const int numActive = static_cast<int>(active.numActive());
+  std::vector<char> changed(numActive, 0);
+  reduceNodes(std::vector<const Reduction*>(1, &reduction), active.isFull() ? 0 : active.active().data(), numActive,
+              std::vector<const std::vector<std::vector<Node> >*>(1, &interactionSets), changed);
+
+  m_changed.reset(size(), false);
+  for (int k = 0; k < numActive; ++k) {
+    if (changed[k]) {
+      m_changed.activate(active.isFull() ? static_cast<unsigned int>(k) : active.active()[k]);
+    }
+  }
+  endCombine();
+
+  return true;
+}
+
+/**
+ * @brief Reduces the given local nodes with their interaction sets, using
+ *        all the threads.
+ *
+ * @param reductions        Reductions of the combine functions.
+ * @param nodes             Local indices of the nodes, or 0 for all of them.
+ * @param numNodes          Number of nodes to be reduced.
+ * @param interactionSets   Interaction sets for all the local nodes, for
+ *                          every reduction.
+ * @param changed           Set to 1 for the nodes which changed.
+ *
+ * Every node is reduced by exactly one thread, so no synchronization is
+ * needed. Several reductions are applied to a node in their order. Placed
+ * nodes are split with a static schedule, so that every thread reduces the
+ * nodes on its own domain, and the accesses are counted wherever the
+ * domains of both the thread and the node are known.
+ *
+ * A single reduction over the interaction sets of the attached halo reads
+ * its sources through the indices of the halo, from the node storage and
+ * the ghost payloads, instead of from the payload copies of the sets, so
+ * that the reads follow the order of the nodes. The new payloads are then
+ * only stored by endCombine, so that every node still reads the payloads
+ * of the previous computation.
+ */
+void
+Graph::reduceNodes(
+  const std::vector<const Reduction*>& reductions,
+  const unsigned int* const nodes,
+  const int numNodes,
+  const std::vector<const std::vector<std::vector<Node> >*>& interactionSets,
+  std::vector<char>& changed
+)
+{
+  const bool throughHalo = (m_halo != 0) && (reductions.size() == 1) &&
+                           (m_halo->numLocal() == size()) && (interactionSets[0]->size() == size());
+  std::vector<Node::PayloadType> values(throughHalo ? numNodes : 0);
+  if (!m_numaPlaced) {
+    #pragma omp parallel for schedule(dynamic, s_chunkSize)
+    for (int k = 0; k < numNodes; ++k) {
+      const unsigned int i = (nodes == 0) ? static_cast<unsigned int>(k) : nodes[k];
+      if (reduceNode(reductions, i, interactionSets, throughHalo ? &values[k] : 0)) {
+        changed[k] = 1;
+      }
+    }
+  }
+  else {
+    unsigned long long numLocal = 0;
+    unsigned long long numRemote = 0;
+    #pragma omp parallel reduction(+ : numLocal, numRemote)
+    {
+      const unsigned int thread = static_cast<unsigned int>(threadNumber());
+      const int domain = (thread < m_threadDomains.size()) ? m_threadDomains[thread] : -1;
+      #pragma omp for schedule(static)
+      for (int k = 0; k < numNodes; ++k) {
+        const unsigned int i = (nodes == 0) ? static_cast<unsigned int>(k) : nodes[k];
+        if (m_removed[i]) {
+          continue;
+        }
+        if ((domain >= 0) && (m_nodeDomains[i] >= 0)) {
+          if (m_nodeDomains[i] == domain) {
+            ++numLocal;
+          }
+          else {
+            ++numRemote;
+          }
+        }
+        if (reduceNode(reductions, i, interactionSets, throughHalo ? &values[k] : 0)) {
+          changed[k] = 1;
+        }
+      }
+    }
+    m_numLocalAccesses += numLocal;
+    m_numRemoteAccesses += numRemote;
+  }
+
+  for (int k = 0; throughHalo && (k < numNodes); ++k) {
+    if (changed[k]) {
+      m_deferredNodes.push_back((nodes == 0) ? static_cast<unsigned int>(k) : nodes[k]);
+      m_deferredPayloads.push_back(values[k]);
+    }
+  }
+}
+
+/**
+ * @brief Reduces one local node with its interaction sets, for reduceNodes.
+ *
+ * @param deferred   Where the new payload is stored, with the sources read
+ *                   through the halo, or 0 for storing it in the node, with
+ *                   the sources read from the interaction sets.
+ *
+ * @return true if the node changed. Removed nodes never change.
+ */
+bool
+Graph::reduceNode(
+  const std::vector<const Reduction*>& reductions,
+  const unsigned int i,
+  const std::vector<const std::vector<std::vector<Node> >*>& interactionSets,
+  Node::PayloadType* const deferred
+)
+{
+  if (m_removed[i]) {
+    return false;
+  }
+  Node::PayloadType value = m_nodeList[i].payload();
+  bool changed = false;
+  if (deferred != 0) {
+    const unsigned int numSources = static_cast<unsigned int>((*interactionSets[0])[i].size());
+    for (unsigned int j = 0; j < numSources; ++j) {
+      changed = reductions[0]->update(value, m_halo->payload(*this, m_halo->source(i, j))) || changed;
+    }
+    *deferred = value;
+    return changed;
+  }
+  for (unsigned int r = 0; r < reductions.size(); ++r) {
+    const std::vector<Node>& interactionSet = (*interactionSets[r])[i];
+    for (std::vector<Node>::const_iterator n = interactionSet.begin(); n != interactionSet.end(); ++n) {
+      changed = reductions[r]->update(value, n->payload()) || changed;
+    }
+  }
+  if (changed) {
+    m_nodeList[i].payload() = value;
+  }
+  return changed;
+}
+
+/**
+ * @brief Multithreaded push version of the computation for combine functions
+ *        which reduce the payloads of the interaction sets.
+ *
+ * @param reduction         Reduction of the combine function.
+ * @param interactionSets   Interaction sets for all the local nodes.
+ *
+ * @return Result of the computation.
+ *
+ * The changed sources are split between the threads, so several threads
+ * may update the same node. When every node receives few updates, the
+ * updates are applied directly with lock free atomic operations. When the
+ * nodes receive, on average, at least as many updates as there are threads,
+ * the atomic operations would mostly contend with each other, and every
+ * thread reduces into a private buffer instead, the buffers being merged
+ * per node at the end. Both only reduce the changed sources, so reductions
+ * which are not idempotent, like Sum, are pulled instead.
+ */
+bool
+Graph::pushReduction(
+  const Reduction& reduction,
+  const std::vector<std::vector<Node> >& interactionSets
+)
+{
+  if (!reduction.isIdempotent()) {
+    return pullReduction(reduction, interactionSets);
+  }
+
+  // Number the active nodes, which include the dirty ones.
+  const Frontier& active = activeNodes();
+  const std::vector<unsigned int>& targets = active.active();
+  const unsigned int numTargets = static_cast<unsigned int>(targets.size());
+  m_slots.resize(size());
+  for (unsigned int k = 0; k < numTargets; ++k) {
+    m_slots[targets[k]] = k;
+  }
+
+  const std::vector<unsigned int>& sources = m_frontier.active();
+  const int numSources = static_cast<int>(sources.size());
+  unsigned long long numUpdates = 0;
+  for (int k = 0; k < numSources; ++k) {
+    numUpdates += m_halo->numReferences(sources[k]);
+  }
+  const int threads = numThreads();
+  const bool privatize = (threads > 1) && (numUpdates >= static_cast<unsigned long long>(threads) * numTargets);
+
+  std::vector<char> changed(numTargets, 0);
+  if (privatize) {
+    std::vector<Node::PayloadType> buffers(static_cast<size_t>(threads) * numTargets, reduction.identity());
+    std::vector<char> touched(static_cast<size_t>(threads) * numTargets, 0);
+
+    #pragma omp parallel
+    {
+      const size_t base = static_cast<size_t>(threadNumber()) * numTargets;
+      #pragma omp for schedule(dynamic, s_chunkSize)
+      for (int k = 0; k < numSources; ++k) {
+        const unsigned int* references = m_halo->references(sources[k]);
+        for (unsigned int r = 0; r < m_halo->numReferences(sources[k]); ++r) {
+          const unsigned int i = m_halo->referenceTarget(references[r]);
+          if (m_removed[i] || m_dirty.isActive(i)) {
+            continue;
+          }
+          const size_t slot = base + m_slots[i];
+          buffers[slot] = reduction(buffers[slot], interactionSets[i][m_halo->referenceSlot(references[r])].payload());
+          touched[slot] = 1;
+        }
+      }
+
+      #pragma omp for schedule(dynamic, s_chunkSize)
+      for (int k = 0; k < static_cast<int>(numTargets); ++k) {
+        Node::PayloadType& payload = m_nodeList[targets[k]].payload();
+        for (int t = 0; t < threads; ++t) {
+          const size_t slot = static_cast<size_t>(t) * numTargets + k;
+          if (touched[slot] && reduction.update(payload, buffers[slot])) {
+            changed[k] = 1;
+          }
+        }
+      }
     }
   }
+  else {
+    #pragma omp parallel for schedule(dynamic, s_chunkSize)
+    for (int k = 0; k < numSources; ++k) {
+      const unsigned int* references = m_halo->references(sources[k]);
+      for (unsigned int r = 0; r < m_halo->numReferences(sources[k]); ++r) {
+        const unsigned int i = m_halo->referenceTarget(references[r]);
+        if (m_removed[i] || m_dirty.isActive(i)) {
+          continue;
+        }
+        if (reduction.atomicUpdate(m_nodeList[i].payload(), interactionSets[i][m_halo->referenceSlot(references[r])].payload())) {
+          __atomic_store_n(&changed[m_slots[i]], 1, __ATOMIC_RELAXED);
+        }
+      }
+    }
+  }
+
+  // Dirty nodes are reduced with their whole interaction sets.
+  for (std::vector<unsigned int>::const_iterator i = m_dirty.active().begin(); i != m_dirty.active().end(); ++i) {
+    if (m_removed[*i]) {
+      continue;
+    }
+    for (std::vector<Node>::const_iterator n = interactionSets[*i].begin(); n != interactionSets[*i].end(); ++n) {
+      if (reduction.update(m_nodeList[*i].payload(), n->payload())) {
+        changed[m_slots[*i]] = 1;
+      }
+    }
+  }
+
+  m_changed.reset(size(), false);
+  for (unsigned int k = 0; k < numTargets; ++k) {
+    if (changed[k]) {
+      m_changed.activate(targets[k]);
+    }
+  }
+  endCombine();
+
+  return true;
+}
+
+/**
+ * @brief Starts a computation which combines the local nodes one at a time,
+ *        in an order chosen by the caller.
+ */
+void
+Graph::beginCombine(
+)
+{
+  m_changed.reset(size(), false);
+}
 
+/**
+ * @brief Combines one local node with its interaction set.
+ *
+ * @param combine           User provided combine function.
+ * @param i                 Local index of the node.
+ * @param interactionSet    Interaction set of the node.
+ *
+ * @return true if the node changed.
+ */
+bool
+Graph::combineLocalNode(
+  const CombineFunction& combine,
+  const unsigned int i,
+  const std::vector<Node>& interactionSet
+)
+{
+  if (m_removed[i] || !combineNode(combine, m_nodeList[i], interactionSet, m_payloads)) {
+    return false;
+  }
+  m_changed.activate(i);
   return true;
 }
 
+/**
+ * @brief Combines a batch of local nodes with their interaction sets, with
+ *        the kernel which compute<NoDependency> uses for the combine
+ *        function.
+ *
+ * @param combine           User provided combine function.
+ * @param nodes             Local indices of the nodes.
+ * @param interactionSets   Interaction sets for all the local nodes.
+ *
+ * Reductions are applied by all the threads, like in pullReduction, and the
+ * other combine functions one node at a time.
+ */
+void
+Graph::combineLocalNodes(
+  const CombineFunction& combine,
+  const std::vector<unsigned int>& nodes,
+  const std::vector<std::vector<Node> >& interactionSets
+)
+{
+  if (combine.reduction() == 0) {
+    for (std::vector<unsigned int>::const_iterator i = nodes.begin(); i != nodes.end(); ++i) {
+      combineLocalNode(combine, *i, interactionSets[*i]);
+    }
+    return;
+  }
+
+  const int numNodes = static_cast<int>(nodes.size());
+  std::vector<char> changed(numNodes, 0);
+  reduceNodes(std::vector<const Reduction*>(1, combine.reduction()), nodes.data(), numNodes,
+              std::vector<const std::vector<std::vector<Node> >*>(1, &interactionSets), changed);
+  for (int k = 0; k < numNodes; ++k) {
+    if (changed[k]) {
+      m_changed.activate(nodes[k]);
+    }
+  }
+}
+
+/**
+ * @brief Combines a copy of a local node with its interaction set, leaving
+ *        the node as it is.
+ *
+ * @param combine           User provided combine function.
+ * @param i                 Local index of the node.
+ * @param interactionSet    Interaction set of the node.
+ * @param payload           Payload of the combined copy.
+ * @param payloads          Scratch buffer for gathering the payloads.
+ *
+ * @return true if the copy changed.
+ *
+ * The graph isn't modified, so that other threads may keep reading the
+ * nodes while the results wait to be committed.
+ */
+bool
+Graph::combineLocalCopy(
+  const CombineFunction& combine,
+  const unsigned int i,
+  const std::vector<Node>& interactionSet,
+  Node::PayloadType& payload,
+  std::vector<Node::PayloadType>& payloads
+) const
+{
+  if (m_removed[i]) {
+    return false;
+  }
+  Node copy(m_nodeList[i]);
+  const bool combined = combineNode(combine, copy, interactionSet, payloads);
+  payload = copy.payload();
+  return combined;
+}
+
+/**
+ * @brief Stores the payload of a combined copy into its local node.
+ *
+ * @param i         Local index of the node.
+ * @param payload   Payload of the combined copy.
+ */
+void
+Graph::commitPayload(
+  const unsigned int i,
+  const Node::PayloadType payload
+)
+{
+  m_nodeList[i].payload() = payload;
+  m_changed.activate(i);
+}
+
+/**
+ * @brief Ends a computation, storing the payloads deferred by reduceNodes
+ *        and giving the changed nodes new versions.
+ */
+void
+Graph::endCombine(
+)
+{
+  const int numDeferred = static_cast<int>(m_deferredNodes.size());
+  #pragma omp parallel for schedule(static)
+  for (int k = 0; k < numDeferred; ++k) {
+    m_nodeList[m_deferredNodes[k]].payload() = m_deferredPayloads[k];
+  }
+  m_deferredNodes.clear();
+  m_deferredPayloads.clear();
+  const std::vector<unsigned int>& changed = m_changed.active();
+  for (std::vector<unsigned int>::const_iterator i = changed.begin(); i != changed.end(); ++i) {
+    stamp(*i);
+  }
+  m_dirty.reset(size(), false);
+}
+
 template <>
 bool
 Graph::compute<Graph::LocalComputation>(
@@ -82,32 +2415,372 @@ Graph::compute<Graph::LocalComputation>(
   const std::vector<std::vector<Node> >&
 )
 {
-  // Apply combine function on each node in the node list.
-  for (std::vector<Node>::iterator node = m_nodeList.begin(); node != m_nodeList.end(); ++node) {
-    combine(*node, *node);
+  // Apply combine function on each node in the node list, or only on the
+  // nodes which changed in the last computation.
+  m_changed.reset(size(), false);
+  if ((m_halo == 0) || m_frontier.isFull()) {
+    for (unsigned int i = 0; i < m_nodeList.size(); ++i) {
+      if (!m_removed[i] && combine(m_nodeList[i], m_nodeList[i])) {
+        m_changed.activate(i);
+      }
+    }
+  }
+  else {
+    for (std::vector<unsigned int>::const_iterator i = m_frontier.active().begin(); i != m_frontier.active().end(); ++i) {
+      if ((*i < size()) && !m_removed[*i] && combine(m_nodeList[*i], m_nodeList[*i])) {
+        m_changed.activate(*i);
+      }
+    }
+    for (std::vector<unsigned int>::const_iterator i = m_dirty.active().begin(); i != m_dirty.active().end(); ++i) {
+      if (!m_removed[*i] && !m_changed.isActive(*i) && !m_frontier.isActive(*i) && combine(m_nodeList[*i], m_nodeList[*i])) {
+        m_changed.activate(*i);
+      }
+    }
   }
+  endCombine();
 
   return true;
 }
 
+/**
+ * @brief Combines the nodes of a level of a forest with the current
+ *        payloads of their interaction sets.
+ *
+ * @param tree              Index of the forest.
+ * @param combine           User provided combine function.
+ * @param level             Level of the nodes to be combined.
+ * @param interactionSets   Interaction sets for all the local nodes.
+ * @param remote            Current payloads of the remote nodes, which
+ *                          replace the generated ones where known.
+ */
+void
+Graph::combineLevel(
+  const TreeIndex& tree,
+  const CombineFunction& combine,
+  const unsigned int level,
+  const std::vector<std::vector<Node> >& interactionSets,
+  const std::unordered_map<Node::IndexType, Node::PayloadType>& remote
+)
+{
+  std::vector<Node> interactionSet;
+  const unsigned int* nodes = tree.levelNodes(level);
+  for (unsigned int k = 0; k < tree.numLevelNodes(level); ++k) {
+    const unsigned int i = nodes[k];
+    interactionSet.clear();
+    for (std::vector<Node>::const_iterator n = interactionSets[i].begin(); n != interactionSets[i].end(); ++n) {
+      interactionSet.push_back(*n);
+      if (isLocal(n->index())) {
+        interactionSet.back().payload() = m_nodeList[localIndex(n->index())].payload();
+      }
+      else {
+        std::unordered_map<Node::IndexType, Node::PayloadType>::const_iterator r = remote.find(n->index());
+        if (r != remote.end()) {
+          interactionSet.back().payload() = r->second;
+        }
+      }
+    }
+    if (combineNode(combine, m_nodeList[i], interactionSet, m_payloads)) {
+      m_changed.activate(i);
+    }
+  }
+}
+
+/**
+ * @brief Accumulation from the children up, where the interaction set of
+ *        every node holds its children in a forest.
+ *
+ * @param tree              Index of the forest.
+ * @param combine           User provided combine function.
+ * @param interactionSets   Interaction sets for all the local nodes.
+ *
+ * The levels of the forest are combined from the deepest one up, so that
+ * every node sees the accumulated payloads of its children. The nodes of a
+ * level with remote parents then send their payloads to the owners of the
+ * parents through a message aggregator, which only exchanges the counts of
+ * the messages collectively, once per level.
+ */
+void
+Graph::accumulateUpward(
+  const TreeIndex& tree,
+  const CombineFunction& combine,
+  const std::vector<std::vector<Node> >& interactionSets
+)
+{
+  std::unordered_map<Node::IndexType, Node::PayloadType> accumulated;
+  AccumulatedPayloads handler(accumulated);
+  MessageAggregator aggregator(m_mpiCommunicator, handler);
+  m_changed.reset(size(), false);
+  for (unsigned int l = tree.maxLevel() + 1; l-- > tree.minLevel(); ) {
+    combineLevel(tree, combine, l, interactionSets, accumulated);
+
+    const unsigned int* nodes = tree.levelNodes(l);
+    for (unsigned int k = 0; k < tree.numLevelNodes(l); ++k) {
+      const unsigned int i = nodes[k];
+      if (!tree.isRoot(i) && !isLocal(tree.parent(i))) {
+        aggregator.send(owner(tree.parent(i)), globalIndex(i), m_nodeList[i].payload());
+      }
+    }
+    aggregator.finish();
+  }
+  endCombine();
+}
+
+/**
+ * @brief Accumulation from the parents down, where the interaction set of
+ *        every node holds its parent in a forest.
+ *
+ * @param tree              Index of the forest.
+ * @param combine           User provided combine function.
+ * @param interactionSets   Interaction sets for all the local nodes.
+ *
+ * The levels of the forest are combined from the roots down, so that every
+ * node sees the accumulated payload of its parent. The nodes of a level
+ * with remote children then send their payloads to the owners of the
+ * children through a message aggregator, which only exchanges the counts of
+ * the messages collectively, once per level.
+ */
+void
+Graph::accumulateDownward(
+  const TreeIndex& tree,
+  const CombineFunction& combine,
+  const std::vector<std::vector<Node> >& interactionSets
+)
+{
+  std::unordered_map<Node::IndexType, Node::PayloadType> accumulated;
+  AccumulatedPayloads handler(accumulated);
+  MessageAggregator aggregator(m_mpiCommunicator, handler);
+  m_changed.reset(size(), false);
+  for (unsigned int l = tree.minLevel(); l <= tree.maxLevel(); ++l) {
+    combineLevel(tree, combine, l, interactionSets, accumulated);
+
+    const unsigned int* nodes = tree.levelNodes(l);
+    for (unsigned int k = 0; k < tree.numLevelNodes(l); ++k) {
+      const unsigned int i = nodes[k];
+      const Node::IndexType* children = tree.children(i);
+      // The sorted children of an owner are mostly adjacent, and sending
+      // to an owner again only repeats the payload.
+      unsigned int lastOwner = m_mpiCommunicator.rank();
+      for (unsigned int c = 0; c < tree.numChildren(i); ++c) {
+        if (isLocal(children[c]) || (owner(children[c]) == lastOwner)) {
+          continue;
+        }
+        lastOwner = owner(children[c]);
+        aggregator.send(lastOwner, globalIndex(i), m_nodeList[i].payload());
+      }
+    }
+    aggregator.finish();
+  }
+  endCombine();
+}
+
 template <>
 bool
 Graph::compute<Graph::UpwardAccumulateSpecial>(
-  const CombineFunction&,
-  const std::vector<std::vector<Node> >& 
+  const CombineFunction& combine,
+  const std::vector<std::vector<Node> >& interactionSets
 )
 {
-  return false;
+  if (m_treeIndex == 0) {
+    throw std::runtime_error("Accumulation needs the tree index of the graph!");
+  }
+  if (interactionSets.size() != size()) {
+    std::vector<std::vector<Node> > forestSets;
+    forestInteractionSets(*m_treeIndex, size(), true, forestSets);
+    accumulateUpward(*m_treeIndex, combine, forestSets);
+    return true;
+  }
+  accumulateUpward(*m_treeIndex, combine, interactionSets);
+  return true;
 }
 
 template <>
 bool
 Graph::compute<Graph::DownwardAccumulateSpecial>(
-  const CombineFunction&,
-  const std::vector<std::vector<Node> >&
+  const CombineFunction& combine,
+  const std::vector<std::vector<Node> >& interactionSets
 )
 {
-  return false;
+  if (m_treeIndex == 0) {
+    throw std::runtime_error("Accumulation needs the tree index of the graph!");
+  }
+  if (interactionSets.size() != size()) {
+    std::vector<std::vector<Node> > forestSets;
+    forestInteractionSets(*m_treeIndex, size(), false, forestSets);
+    accumulateDownward(*m_treeIndex, combine, forestSets);
+    return true;
+  }
+  accumulateDownward(*m_treeIndex, combine, interactionSets);
+  return true;
+}
+
+/**
+ * @brief Upward accumulation on the upside-down forest, where every node is
+ *        in at most one interaction set.
+ *
+ * The node whose interaction set holds a node is the parent of that node in
+ * the upside-down forest, which is found by transposing the interaction
+ * sets, unless the same sets, not generated again since, were already
+ * transposed when the accumulation was detected. The forward upward
+ * accumulation then runs over that forest.
+ */
+template <>
+bool
+Graph::compute<Graph::UpwardAccumulateReverse>(
+  const CombineFunction& combine,
+  const std::vector<std::vector<Node> >& interactionSets
+)
+{
+  const CompressedIndexLists<Node::IndexType>& holders = ((m_transposedSets == &interactionSets) && (m_transposedGeneration == m_setsGeneration)) ?
+    (m_setsAreEdges ? m_transpose : m_setTranspose) : transposeInteractionSets(interactionSets);
+
+  std::vector<Node::IndexType> parents(size(), Node::s_invalidIndex);
+  std::vector<Node::IndexType> nodeHolders;
+  for (unsigned int i = 0; i < size(); ++i) {
+    holders.decode(i, nodeHolders);
+    if (!nodeHolders.empty()) {
+      parents[i] = nodeHolders[0];
+    }
+  }
+  accumulateUpward(TreeIndex(*this, parents), combine, interactionSets);
+  return true;
+}
+
+/**
+ * @brief Downward accumulation on the upside-down forest, where every
+ *        interaction set holds at most one node.
+ *
+ * The node in the interaction set of a node is its parent in the upside-down
+ * forest, whose children are found by transposing the parents. The forward
+ * downward accumulation then runs over that forest.
+ */
+template <>
+bool
+Graph::compute<Graph::DownwardAccumulateReverse>(
+  const CombineFunction& combine,
+  const std::vector<std::vector<Node> >& interactionSets
+)
+{
+  std::vector<Node::IndexType> parents(size(), Node::s_invalidIndex);
+  for (unsigned int i = 0; i < size(); ++i) {
+    if (!interactionSets[i].empty()) {
+      parents[i] = interactionSets[i][0].index();
+    }
+  }
+  accumulateDownward(TreeIndex(*this, parents), combine, interactionSets);
+  return true;
+}
+
+/**
+ * @brief Runtime dispatch to the computation for an algorithm choice.
+ *
+ * @param algorithmChoice   Combine case detected for the interaction sets.
+ * @param combine           User provided combine function.
+ * @param interactionSets   Interaction sets for all the local nodes.
+ *
+ * @return Result of the computation.
+ */
+bool
+Graph::compute(
+  const AlgorithmChoice algorithmChoice,
+  const CombineFunction& combine,
+  const std::vector<std::vector<Node> >& interactionSets
+)
+{
+  switch (algorithmChoice) {
+    case LocalComputation:
+      return compute<LocalComputation>(combine, interactionSets);
+    case NoDependency:
+      return compute<NoDependency>(combine, interactionSets);
+    case UpwardAccumulateReverse:
+      return compute<UpwardAccumulateReverse>(combine, interactionSets);
+    case UpwardAccumulateSpecial:
+      return compute<UpwardAccumulateSpecial>(combine, interactionSets);
+    case UpwardAccumulateGeneral:
+      return compute<UpwardAccumulateGeneral>(combine, interactionSets);
+    case DownwardAccumulateSpecial:
+      return compute<DownwardAccumulateSpecial>(combine, interactionSets);
+    case DownwardAccumulateGeneral:
+      return compute<DownwardAccumulateGeneral>(combine, interactionSets);
+    case DownwardAccumulateReverse:
+      return compute<DownwardAccumulateReverse>(combine, interactionSets);
+    default:
+      return compute<General>(combine, interactionSets);
+  }
+}
+
+/**
+ * @brief Fused version of the computations for several combine functions
+ *        whose interaction sets have the same independent combine case.
+ *
+ * @param algorithmChoice   Combine case of all the interaction sets, either
+ *                          LocalComputation or NoDependency.
+ * @param combines          User provided combine functions.
+ * @param interactionSets   Interaction sets for all the local nodes, for
+ *                          every combine function.
+ *
+ * @return false if the computations can't be fused, else true.
+ *
+ * Every node is combined with all the functions, in their order, while it
+ * is visited once, instead of going over all the nodes for every function,
+ * so the computations must not read each other's results.
+ * Only the computations over all the nodes can be fused, which the callers
+ * have to agree on across the processors. Independent combine functions
+ * which all reduce their interaction sets are applied by all the threads,
+ * with the kernel of pullReduction.
+ */
+bool
+Graph::computeFused(
+  const AlgorithmChoice algorithmChoice,
+  const std::vector<const CombineFunction*>& combines,
+  const std::vector<const std::vector<std::vector<Node> >*>& interactionSets
+)
+{
+  if ((algorithmChoice != LocalComputation) && (algorithmChoice != NoDependency)) {
+    return false;
+  }
+
+  m_changed.reset(size(), false);
+  if (algorithmChoice == NoDependency) {
+    std::vector<const Reduction*> reductions;
+    for (unsigned int k = 0; k < combines.size(); ++k) {
+      if (combines[k]->reduction() != 0) {
+        reductions.push_back(combines[k]->reduction());
+      }
+    }
+    if (reductions.size() == combines.size()) {
+      const int numNodes = static_cast<int>(size());
+      std::vector<char> changed(numNodes, 0);
+      reduceNodes(reductions, 0, numNodes, interactionSets, changed);
+      for (int i = 0; i < numNodes; ++i) {
+        if (changed[i]) {
+          m_changed.activate(static_cast<unsigned int>(i));
+        }
+      }
+      endCombine();
+      return true;
+    }
+  }
+
+  for (unsigned int i = 0; i < m_nodeList.size(); ++i) {
+    if (m_removed[i]) {
+      continue;
+    }
+    bool combined = false;
+    for (unsigned int k = 0; k < combines.size(); ++k) {
+      if (algorithmChoice == LocalComputation) {
+        combined = (*combines[k])(m_nodeList[i], m_nodeList[i]) || combined;
+      }
+      else {
+        combined = combineNode(*combines[k], m_nodeList[i], (*interactionSets[k])[i], m_payloads) || combined;
+      }
+    }
+    if (combined) {
+      m_changed.activate(i);
+    }
+  }
+  endCombine();
+
+  return true;
 }
 
 Graph::~Graph(
@@ -117,7 +2790,5 @@ Graph::~Graph(
 
 
 template bool Graph::compute<Graph::General>(const CombineFunction&, const std::vector<std::vector<Node> >&);
-template bool Graph::compute<Graph::UpwardAccumulateReverse>(const CombineFunction&, const std::vector<std::vector<Node> >&);
 template bool Graph::compute<Graph::UpwardAccumulateGeneral>(const CombineFunction&, const std::vector<std::vector<Node> >&);
-template bool Graph::compute<Graph::DownwardAccumulateReverse>(const CombineFunction&, const std::vector<std::vector<Node> >&);
 template bool Graph::compute<Graph::DownwardAccumulateGeneral>(const CombineFunction&, const std::vector<std::vector<Node> >&);
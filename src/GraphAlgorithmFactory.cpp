@@ -7,6 +7,31 @@
 
 #include "GraphAlgorithmFactory.hpp"
 
+#include "NoDependencyAlgorithmFunction.hpp"
+
+#include <algorithm>
+
+namespace {
+
+NoDependencyPullAlgorithmFunction s_noDependencyPull;
+NoDependencyPushAlgorithmFunction s_noDependencyPush;
+
+} // namespace
+
+/**
+ * @brief Creates a factory with the built in algorithms registered.
+ *
+ * @param mpiCommunicator   Communicator over which the graph is distributed.
+ */
+GraphAlgorithmFactory::GraphAlgorithmFactory(
+  const MPICommunicator& mpiCommunicator
+) : m_mpiCommunicator(mpiCommunicator),
+  m_algorithms()
+{
+  registerAlgorithm(&s_noDependencyPull);
+  registerAlgorithm(&s_noDependencyPush);
+}
+
 void
 GraphAlgorithmFactory::registerAlgorithm(
   GraphAlgorithmFunction* algorithm
@@ -17,23 +42,42 @@ GraphAlgorithmFactory::registerAlgorithm(
 
 void
 GraphAlgorithmFactory::unregisterAlgorithm(
-  GraphAlgorithmFunction*
+  GraphAlgorithmFunction* algorithm
 )
 {
-	//TODO
+	m_algorithms.erase(std::remove(m_algorithms.begin(), m_algorithms.end(), algorithm), m_algorithms.end());
 }
 
+/**
+ * @brief Chooses among the algorithms registered for an algorithm choice.
+ *
+ * @param g                 Graph on which computation is to be done.
+ * @param combine           User provided combine function.
+ * @param interactionSets   Interaction sets for all the local nodes.
+ * @param algorithmChoice   Combine case detected for the interaction sets.
+ *
+ * @return The algorithm with the highest score, the earliest registered one
+ *         among equal scores, or nullptr if none is registered.
+ */
 GraphAlgorithmFunction*
 GraphAlgorithmFactory::getAlgorithm(
-  const Graph&,
+  Graph& g,
+  const CombineFunction& combine,
+  const std::vector<std::vector<Graph::Node> >& interactionSets,
   const Graph::AlgorithmChoice algorithmChoice
 )
 {
+	GraphAlgorithmFunction* best = nullptr;
+	float bestScore = 0.0f;
 	for (GraphAlgorithmFunction* algorithm : m_algorithms) {
 		if (algorithm->getType() == algorithmChoice) {
-			return algorithm;
+			float score = algorithm->getScore(g, combine, interactionSets);
+			if ((best == nullptr) || (score > bestScore)) {
+				best = algorithm;
+				bestScore = score;
+			}
 		}
 	}
-  return nullptr;
+  return best;
 }
 
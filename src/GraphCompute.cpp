@@ -2,15 +2,109 @@
 
 #include "MPICommunicator.hpp"
 
+#include <algorithm>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <iterator>
 
+#include "ExchangeAll.hpp"
 #include "GraphAlgorithmFactory.hpp"
+#include "HaloExchange.hpp"
+#include "NumaPlacement.hpp"
+#include "NoDependencyAlgorithmFunction.hpp"
+#include "PerfCounters.hpp"
+#include "RemoteCache.hpp"
 #include "SampleLocalCombineFunction.hpp"
 #include "SampleLocalGenerateFunction.hpp"
+#include "TaskPool.hpp"
+#include "TreeIndex.hpp"
 
+namespace {
+
+/** Interior nodes combined between tests for arrived messages **/
+const unsigned int s_pipelineChunkSize = 256;
+
+/** Nodes whose interaction sets are generated by one asynchronous task **/
+const unsigned int s_asyncChunkSize = 4096;
+
+/** Phases of a computation whose hardware events are counted **/
+const unsigned int s_generatePhase = 0;
+const unsigned int s_detectPhase = 1;
+const unsigned int s_combinePhase = 2;
+const unsigned int s_numPhases = 3;
+
+/** Positions of the votes for the detected accumulations **/
+const unsigned int s_downwardSpecial = 0;
+const unsigned int s_upwardSpecial = 1;
+const unsigned int s_downwardReverse = 2;
+const unsigned int s_upwardReverse = 3;
+const unsigned int s_numAccumulations = 4;
+
+/** Node of an interaction set, sent to its owner with the level of the
+    node whose interaction set holds it **/
+class LevelMessage {
+public:
+  Graph::Node::IndexType m_node;
+  unsigned int m_level;
+}; // class LevelMessage
+
+/** Whether two nodes are the same, for dropping repeated nodes **/
+class SameIndex {
+public:
+  bool
+  operator()(
+    const Graph::Node& a,
+    const Graph::Node& b
+  ) const
+  {
+    return a.index() == b.index();
+  }
+}; // class SameIndex
+
+/** Whether an interaction set holds only local nodes **/
+bool
+isInterior(
+  const Graph& g,
+  const std::vector<Graph::Node>& interactionSet
+)
+{
+  for (std::vector<Graph::Node>::const_iterator n = interactionSet.begin(); n != interactionSet.end(); ++n) {
+    if (!g.isLocal(n->index())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+/**
+ * @brief Creates the computations over the processors of a communicator.
+ *
+ * @param mpiCommunicator   Communicator of the processors, which may be a
+ *                          group split off from a larger one. A copy of it
+ *                          is kept.
+ *
+ * The graphs given to the computations have to be distributed over the same
+ * processors.
+ */
 GraphCompute::GraphCompute(
   const MPICommunicator& mpiCommunicator
-) : m_mpiCommunicator(mpiCommunicator)
+) : m_mpiCommunicator(mpiCommunicator),
+  m_interactionSets(),
+  m_combineCase(Graph::General),
+  m_requests(),
+  m_halo(),
+  m_pipelineActive(),
+  m_pipelinePending(),
+  m_pipelineSources(),
+  m_pipelineRanks(),
+  m_pipelineReady(),
+  m_tasks(),
+  m_remoteCache(),
+  m_perfCounters(),
+  m_numaPlacement(false)
 {
 }
 
@@ -54,6 +148,9 @@ GraphCompute::generateInteractionSetForNode(
  * @param generate          User provided generate function.
  * @param generateType      Type of generate function.
  * @param interactionSets   Interaction sets for all the nodes of the graph.
+ * @param requests          Remote nodes of the interaction sets for every
+ *                          owner, if the interaction sets were normalized,
+ *                          else left empty.
  *
  * @return Dependency flag for all the nodes.
  *
@@ -62,39 +159,65 @@ GraphCompute::generateInteractionSetForNode(
  */
 bool
 GraphCompute::generateAllInteractionSets(
-  const Graph& g,
+  Graph& g,
   const GenerateFunction& generate,
   GraphAlgorithmChoice& generateType,
-  std::vector<std::vector<GraphNode> >& interactionSets
+  std::vector<std::vector<GraphNode> >& interactionSets,
+  std::vector<std::vector<GraphNode::IndexType> >& requests
 ) const
 {
   bool dependencyFlag = false;
 
+  g.interactionSetsChanged();
+  generate.prepare(g);
+
   // Apply generate function on all nodes of the graph.
+  bool firstNode = true;
   for (GraphNodeIterator ni = g.begin(); ni != g.end(); ++ni) {
 
+    // Removed nodes keep empty interaction sets.
+    if (g.isRemoved((*ni).index())) {
+      if (generateType == Graph::General) {
+        interactionSets.push_back(std::vector<GraphNode>());
+      }
+      continue;
+    }
+
     bool nodeDependencyFlag = generateInteractionSetForNode(g, generate, generateType, *ni, interactionSets);
 
     // Check that flag for each call to generate returns the same thing.
-    if (ni == g.begin()) {
+    if (firstNode) {
       dependencyFlag = nodeDependencyFlag;
+      firstNode = false;
     }
     else if (nodeDependencyFlag != dependencyFlag) {
       throw std::runtime_error("Dependency flags are not consistent!");
     }
   }
 
+  requests.clear();
+  if (generate.normalize() && (generateType == Graph::General)) {
+    normalizeInteractionSets(g, interactionSets, requests);
+  }
+
   // Identify the local computation case.
   // Each node should only have itself in its interaction set.
   if (generateType == Graph::General) {
     unsigned int i = 0;
     for (GraphNodeIterator ni = g.begin(); ni != g.end(); ++ni, ++i) {
+      if (g.isRemoved((*ni).index())) {
+        continue;
+      }
       // Check if interaction set size is 1 and if it contains only the node.
       if ((interactionSets[i].size() != 1) || (interactionSets[i][0].index() != (*ni).index())) {
         break;
       }
     }
-    if (i == interactionSets.size()) {
+    // All the processors need to agree, including the ones without nodes.
+    int localComputation = (i == interactionSets.size()) ? 1 : 0;
+    int globalLocalComputation = 0;
+    MPI_Allreduce(&localComputation, &globalLocalComputation, 1, MPI_INT, MPI_LAND, *m_mpiCommunicator);
+    if (globalLocalComputation) {
       generateType = Graph::LocalComputation;
     }
   }
@@ -104,6 +227,206 @@ GraphCompute::generateAllInteractionSets(
   return dependencyFlag;
 }
 
+/**
+ * @brief Interaction set generator for all the nodes, for a batch of
+ *        computations.
+ *
+ * @param g                 Graph on which computation is to be done.
+ * @param batch             User provided computations.
+ * @param generateTypes     Types of the generate functions.
+ * @param interactionSets   Interaction sets for all the nodes of the graph,
+ *                          for every computation.
+ * @param dependencyFlags   Dependency flags for all the nodes, for every
+ *                          computation.
+ *
+ * All the generate functions are applied to a node while it is visited, so
+ * that the nodes are gone through once for the whole batch. The local
+ * computation cases of all the computations are then agreed on in a single
+ * reduction.
+ */
+void
+GraphCompute::generateBatchInteractionSets(
+  Graph& g,
+  const std::vector<Computation>& batch,
+  std::vector<GraphAlgorithmChoice>& generateTypes,
+  std::vector<std::vector<std::vector<GraphNode> > >& interactionSets,
+  std::vector<int>& dependencyFlags
+) const
+{
+  const unsigned int numComputations = static_cast<unsigned int>(batch.size());
+  generateTypes.resize(numComputations);
+  interactionSets.assign(numComputations, std::vector<std::vector<GraphNode> >());
+  // Flags stay negative until the first node is generated.
+  dependencyFlags.assign(numComputations, -1);
+  g.interactionSetsChanged();
+  for (unsigned int k = 0; k < numComputations; ++k) {
+    generateTypes[k] = batch[k].m_generate->type();
+    batch[k].m_generate->prepare(g);
+  }
+
+  for (GraphNodeIterator ni = g.begin(); ni != g.end(); ++ni) {
+    const bool removed = g.isRemoved((*ni).index());
+    for (unsigned int k = 0; k < numComputations; ++k) {
+      // Removed nodes keep empty interaction sets.
+      if (removed) {
+        if (generateTypes[k] == Graph::General) {
+          interactionSets[k].push_back(std::vector<GraphNode>());
+        }
+        continue;
+      }
+
+      const int nodeDependencyFlag = generateInteractionSetForNode(g, *batch[k].m_generate, generateTypes[k], *ni, interactionSets[k]) ? 1 : 0;
+      if (dependencyFlags[k] < 0) {
+        dependencyFlags[k] = nodeDependencyFlag;
+      }
+      else if (nodeDependencyFlag != dependencyFlags[k]) {
+        throw std::runtime_error("Dependency flags are not consistent!");
+      }
+    }
+  }
+
+  // Votes of this processor on whether every interaction set of a
+  // computation holds only its node.
+  std::vector<int> localComputations(numComputations, 0);
+  for (unsigned int k = 0; k < numComputations; ++k) {
+    dependencyFlags[k] = (dependencyFlags[k] == 1) ? 1 : 0;
+    if (generateTypes[k] != Graph::General) {
+      continue;
+    }
+    std::vector<std::vector<GraphNode> >& sets = interactionSets[k];
+    if (batch[k].m_generate->normalize()) {
+      for (std::vector<std::vector<GraphNode> >::iterator set = sets.begin(); set != sets.end(); ++set) {
+        normalizeInteractionSet(g, *set);
+      }
+    }
+    unsigned int i = 0;
+    for (GraphNodeIterator ni = g.begin(); ni != g.end(); ++ni, ++i) {
+      if (g.isRemoved((*ni).index())) {
+        continue;
+      }
+      if ((sets[i].size() != 1) || (sets[i][0].index() != (*ni).index())) {
+        break;
+      }
+    }
+    localComputations[k] = (i == sets.size()) ? 1 : 0;
+  }
+
+  if (numComputations > 0) {
+    std::vector<int> globalLocalComputations(numComputations, 0);
+    MPI_Allreduce(&localComputations[0], &globalLocalComputations[0], numComputations, MPI_INT, MPI_LAND, *m_mpiCommunicator);
+    for (unsigned int k = 0; k < numComputations; ++k) {
+      if (globalLocalComputations[k]) {
+        generateTypes[k] = Graph::LocalComputation;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Generates the interaction sets of a range of the local nodes, for
+ *        a general generate function.
+ *
+ * @param g          Graph on which computation is to be done.
+ * @param generate   User provided generate function, already prepared.
+ * @param begin      Local index of the first node of the range.
+ *
+ * @return Interaction sets of the range, along with what they tell about
+ *         the combine case.
+ *
+ * Only reads the graph, and calls no MPI, so that it can run on a worker
+ * thread while the earlier ranges are being combined.
+ */
+GraphCompute::InteractionSetChunk
+GraphCompute::generateInteractionSetChunk(
+  const Graph& g,
+  const GenerateFunction& generate,
+  const unsigned int begin
+) const
+{
+  InteractionSetChunk chunk;
+  chunk.m_begin = begin;
+  chunk.m_end = std::min(g.size(), begin + s_asyncChunkSize);
+  chunk.m_dependencyFlag = -1;
+  chunk.m_localOnly = true;
+  chunk.m_interactionSets.reserve(chunk.m_end - chunk.m_begin);
+
+  GraphNodeIterator ni = g.begin() + begin;
+  for (unsigned int i = chunk.m_begin; i < chunk.m_end; ++i, ++ni) {
+    if (g.isRemoved((*ni).index())) {
+      chunk.m_interactionSets.push_back(std::vector<GraphNode>());
+      continue;
+    }
+
+    const int nodeDependencyFlag = generateInteractionSetForNode(g, generate, Graph::General, *ni, chunk.m_interactionSets) ? 1 : 0;
+    if (chunk.m_dependencyFlag < 0) {
+      chunk.m_dependencyFlag = nodeDependencyFlag;
+    }
+    else if (nodeDependencyFlag != chunk.m_dependencyFlag) {
+      throw std::runtime_error("Dependency flags are not consistent!");
+    }
+
+    std::vector<GraphNode>& interactionSet = chunk.m_interactionSets.back();
+    if (generate.normalize()) {
+      normalizeInteractionSet(g, interactionSet);
+    }
+    if ((interactionSet.size() != 1) || (interactionSet[0].index() != (*ni).index())) {
+      chunk.m_localOnly = false;
+    }
+  }
+
+  return chunk;
+}
+
+/**
+ * @brief Sorts an interaction set by the owners of its nodes, and then by
+ *        their local indices, keeping one copy of every node.
+ */
+void
+GraphCompute::normalizeInteractionSet(
+  const Graph& g,
+  std::vector<GraphNode>& interactionSet
+) const
+{
+  std::sort(interactionSet.begin(), interactionSet.end(), Graph::OwnerOrder(g));
+  interactionSet.erase(std::unique(interactionSet.begin(), interactionSet.end(), SameIndex()), interactionSet.end());
+}
+
+/**
+ * @brief Normalizes all the interaction sets, and lists their remote nodes
+ *        for every owner in the same pass.
+ *
+ * @param g                 Graph on which computation is to be done.
+ * @param interactionSets   Interaction sets for all the nodes of the graph.
+ * @param requests          Sorted remote nodes of the interaction sets,
+ *                          without repetitions, for every processor.
+ *
+ * The nodes of a normalized interaction set are visited in the order in
+ * which they are stored by their owners, and its remote nodes form one run
+ * per owner, which is appended to the requests of that owner. The requests
+ * are then ready for the halo, which doesn't collect the ghosts again.
+ */
+void
+GraphCompute::normalizeInteractionSets(
+  const Graph& g,
+  std::vector<std::vector<GraphNode> >& interactionSets,
+  std::vector<std::vector<GraphNode::IndexType> >& requests
+) const
+{
+  requests.assign(m_mpiCommunicator.size(), std::vector<GraphNode::IndexType>());
+  for (std::vector<std::vector<GraphNode> >::iterator set = interactionSets.begin(); set != interactionSets.end(); ++set) {
+    normalizeInteractionSet(g, *set);
+    for (std::vector<GraphNode>::const_iterator n = set->begin(); n != set->end(); ++n) {
+      if (!g.isLocal(n->index())) {
+        requests[g.owner(n->index())].push_back(n->index());
+      }
+    }
+  }
+  for (unsigned int p = 0; p < requests.size(); ++p) {
+    std::sort(requests[p].begin(), requests[p].end());
+    requests[p].erase(std::unique(requests[p].begin(), requests[p].end()), requests[p].end());
+  }
+}
+
 /**
  * @brief Function for detecting combine case. 
  *
@@ -116,13 +439,25 @@ GraphCompute::generateAllInteractionSets(
  */
 GraphCompute::GraphAlgorithmChoice
 GraphCompute::detectCombineCase(
-  const Graph& g,
+  Graph& g,
   const GraphAlgorithmChoice generateType,
   const std::vector<std::vector<GraphNode> >& interactionSets,
   const bool dependencyFlag
 ) const
 {
+  // The accumulations, and their detection, need the tree index, which is
+  // built by all the processors once any of them has dependencies.
+  int localDependency = dependencyFlag ? 1 : 0;
+  int globalDependency = 0;
+  MPI_Allreduce(&localDependency, &globalDependency, 1, MPI_INT, MPI_LOR, *m_mpiCommunicator);
+  if (globalDependency && (g.treeIndex() == 0)) {
+    g.buildTreeIndex();
+  }
+
   GraphAlgorithmChoice combineCase = Graph::General;
+  // Votes of this processor for the accumulations, which are only cast by
+  // the processors that have to detect them.
+  int votes[s_numAccumulations] = {0, 0, 0, 0};
   if (dependencyFlag == false) {
     // This is simple, just use each node in the interaction set
     // of each local node and perform the computations.
@@ -166,56 +501,54 @@ GraphCompute::detectCombineCase(
       combineCase = Graph::DownwardAccumulateSpecial;
     }
     else {
-      // detect the cases for the special cases of upward and downward accumulations
+      // detect the cases for the special cases of upward and downward accumulations.
+      // Every processor votes for each of them, and they are decided together
+      // below, since the checks hold trivially on processors whose nodes have
+      // empty i-sets.
+      std::fill(votes, votes + s_numAccumulations, 1);
+
+      // The structural queries are lookups in the tree index.
+      const TreeIndex& tree = *g.treeIndex();
 
       // check for special downward accumulation:
-      if (combineCase == Graph::General) {
-        //std::cout << "Checking for the special case of downward accumulation"
-        //	<< std::endl;
-        // for each node check if the I-set has only one node in it
-        // and check about the levels of the nodes
-        unsigned int i = 0;
-        for (GraphNodeIterator ni = g.begin(); ni != g.end(); ++ni, ++i) {
-          if (!(*ni).isRoot()) {
-            // check if i-set sizes are == 1
-            if (interactionSets[i].size() != 1) {
-              break;
-            }
-            // check if the node in i-set of each node is its parent
-            if (!interactionSets[i][0].isParent(*ni)) {
-              break;
-            }
-          }
-        }
-        if (i == interactionSets.size()) {
-          combineCase = Graph::DownwardAccumulateSpecial;
+      // each non-root node should only have its parent in its i-set,
+      // and the roots nothing.
+      for (unsigned int i = 0; i < interactionSets.size(); ++i) {
+        if (tree.isRoot(i) ? !interactionSets[i].empty() : ((interactionSets[i].size() != 1) || (interactionSets[i][0].index() != tree.parent(i)))) {
+          votes[s_downwardSpecial] = 0;
+          break;
         }
       }
 
       // check for special upward accumulation:
-      if (combineCase == Graph::General) {
-        // for each node check if the I-set has same # of nodes as its # of children
-        // and check for each node if it is its child
-        unsigned int i = 0;
-        for (GraphNodeIterator ni = g.begin(); ni != g.end(); ++ni, ++i) {
-          if (!(*ni).isLeaf()) {
-            // check if i-set sizes are == num of children
-            if ((*ni).numChildren() != interactionSets[i].size()) break;
-            // check if the node in i-set of each node is its parent
-            bool breakFlag = false;
-            for (unsigned int j = 0; j < interactionSets[i].size(); ++j) {
-              if (!interactionSets[i][j].isChild(*ni)) {
-                breakFlag = true;
-                break;
-              }
-            }
-            if (breakFlag) {
-              break;
-            }
-          }
+      // each node should have exactly its children in its i-set. The
+      // children come from the tree index, since the parents of the
+      // remote copies are not kept up to date.
+      std::vector<GraphNode::IndexType> members;
+      for (unsigned int i = 0; i < interactionSets.size(); ++i) {
+        const unsigned int numChildren = tree.numChildren(i);
+        if (interactionSets[i].size() != numChildren) {
+          votes[s_upwardSpecial] = 0;
+          break;
+        }
+        members.clear();
+        for (std::vector<GraphNode>::const_iterator n = interactionSets[i].begin(); n != interactionSets[i].end(); ++n) {
+          members.push_back((*n).index());
         }
-        if (i == interactionSets.size()) {
-          combineCase = Graph::UpwardAccumulateSpecial;
+        std::sort(members.begin(), members.end());
+        if (!std::equal(members.begin(), members.end(), tree.children(i))) {
+          votes[s_upwardSpecial] = 0;
+          break;
+        }
+      }
+
+      // check for the accumulations on the upside-down forest, where the
+      // levels decrease, or increase, along the i-sets. The levels are
+      // compared below, by the owners of the nodes in the i-sets.
+      for (unsigned int i = 0; i < interactionSets.size(); ++i) {
+        if (interactionSets[i].size() > 1) {
+          votes[s_downwardReverse] = 0;
+          break;
         }
       }
 
@@ -225,6 +558,64 @@ GraphCompute::detectCombineCase(
     }
   }
 
+  if (globalDependency) {
+    int consensusVotes[s_numAccumulations];
+    MPI_Allreduce(votes, consensusVotes, s_numAccumulations, MPI_INT, MPI_MIN, *m_mpiCommunicator);
+    if (!consensusVotes[s_downwardSpecial] && !consensusVotes[s_upwardSpecial] &&
+        (consensusVotes[s_downwardReverse] || consensusVotes[s_upwardReverse])) {
+      // The levels of the remote nodes in the i-sets aren't kept up to date,
+      // so every node of an i-set is sent, with the level of the node which
+      // holds it, to its owner, which compares it with the level in its
+      // tree index.
+      const TreeIndex& tree = *g.treeIndex();
+      std::vector<std::vector<LevelMessage> > outgoing(m_mpiCommunicator.size());
+      for (unsigned int i = 0; i < interactionSets.size(); ++i) {
+        for (std::vector<GraphNode>::const_iterator n = interactionSets[i].begin(); n != interactionSets[i].end(); ++n) {
+          const LevelMessage message = {(*n).index(), tree.level(i)};
+          outgoing[g.owner((*n).index())].push_back(message);
+        }
+      }
+      std::vector<LevelMessage> incoming;
+      exchangeAll(outgoing, incoming, m_mpiCommunicator);
+      for (std::vector<LevelMessage>::const_iterator m = incoming.begin(); m != incoming.end(); ++m) {
+        const unsigned int level = tree.level(g.localIndex(m->m_node));
+        if (level >= m->m_level) {
+          consensusVotes[s_upwardReverse] = 0;
+        }
+        if (level <= m->m_level) {
+          consensusVotes[s_downwardReverse] = 0;
+        }
+      }
+      MPI_Allreduce(MPI_IN_PLACE, consensusVotes, s_numAccumulations, MPI_INT, MPI_MIN, *m_mpiCommunicator);
+    }
+
+    if (consensusVotes[s_downwardSpecial]) {
+      combineCase = Graph::DownwardAccumulateSpecial;
+    }
+    else if (consensusVotes[s_upwardSpecial]) {
+      combineCase = Graph::UpwardAccumulateSpecial;
+    }
+    else if (consensusVotes[s_downwardReverse]) {
+      combineCase = Graph::DownwardAccumulateReverse;
+    }
+    else if (consensusVotes[s_upwardReverse]) {
+      // Every node also has to be in at most one i-set, which is checked
+      // on the transposed i-sets, kept for the accumulation.
+      const CompressedIndexLists<GraphNode::IndexType>& holders = g.transposeInteractionSets(interactionSets);
+      int localSingle = 1;
+      for (unsigned int i = 0; i < holders.numLists(); ++i) {
+        if (holders.size(i) > 1) {
+          localSingle = 0;
+        }
+      }
+      int single = 0;
+      MPI_Allreduce(&localSingle, &single, 1, MPI_INT, MPI_LAND, *m_mpiCommunicator);
+      if (single) {
+        combineCase = Graph::UpwardAccumulateReverse;
+      }
+    }
+  }
+
   MPI_Barrier(*m_mpiCommunicator);
 
   // find consensus combine case among all procs
@@ -256,11 +647,135 @@ GraphCompute::combineAll(
 ) const
 {
 	GraphAlgorithmFactory factory(m_mpiCommunicator);
-	GraphAlgorithmFunction* algorithm = factory.getAlgorithm(g, combineCase);
-	(*algorithm)(g, combine, interactionSets);
+	GraphAlgorithmFunction* algorithm = factory.getAlgorithm(g, combine, interactionSets, combineCase);
+	if (algorithm != nullptr) {
+		(*algorithm)(g, combine, interactionSets);
+	}
+	else if (!g.compute(combineCase, combine, interactionSets)) {
+		throw std::runtime_error("Computation for the combine case failed!");
+	}
 	MPI_Barrier(*m_mpiCommunicator);
 }
 
+/**
+ * @brief Pipelined version of combineAll for the supersteps of independent
+ *        interaction sets, which also exchanges the changes of the previous
+ *        superstep.
+ *
+ * @param g         Graph on which computation is to be done.
+ * @param combine   User provided combine function.
+ *
+ * The changes of the previous superstep are sent without blocking. The
+ * interior nodes, which have no ghosts in their interaction sets, are
+ * combined in chunks while the messages are in flight, testing for arrived
+ * messages after every chunk. A boundary node is combined as soon as the
+ * messages from all the owners of its ghosts have arrived. The nodes which
+ * are ready are combined together by Graph::combineLocalNodes, with the same
+ * kernel as combineAll.
+ */
+void
+GraphCompute::combineAllPipelined(
+  Graph& g,
+  const CombineFunction& combine
+)
+{
+  HaloExchange& halo = *m_halo;
+  halo.post(g, g.changed());
+
+  // Until the ghosts arrive, only the local changes are known.
+  Frontier& frontier = g.frontier();
+  frontier.reset(halo.numExtended(), false);
+  const std::vector<unsigned int>& changed = g.changed().active();
+  for (std::vector<unsigned int>::const_iterator i = changed.begin(); i != changed.end(); ++i) {
+    frontier.activate(*i);
+  }
+  halo.refresh(g, frontier, m_interactionSets);
+
+  m_pipelineActive.reset(g.size(), false);
+  activateReferences(frontier.active());
+  for (std::vector<unsigned int>::const_iterator i = g.dirty().active().begin(); i != g.dirty().active().end(); ++i) {
+    m_pipelineActive.activate(*i);
+  }
+  m_pipelinePending.resize(g.size());
+  for (unsigned int i = 0; i < g.size(); ++i) {
+    m_pipelinePending[i] = halo.numSourceRanks(i);
+  }
+
+  g.beginCombine();
+  m_pipelineReady.clear();
+  const unsigned int numInterior = static_cast<unsigned int>(m_pipelineActive.active().size());
+  for (unsigned int k = 0; k < numInterior; ++k) {
+    const unsigned int i = m_pipelineActive.active()[k];
+    if (!halo.isBoundary(i)) {
+      m_pipelineReady.push_back(i);
+    }
+    if (m_pipelineReady.size() == s_pipelineChunkSize) {
+      g.combineLocalNodes(combine, m_pipelineReady, m_interactionSets);
+      m_pipelineReady.clear();
+      combineArrived(g, combine, false);
+    }
+  }
+  g.combineLocalNodes(combine, m_pipelineReady, m_interactionSets);
+  m_pipelineReady.clear();
+  while (halo.isReceiving()) {
+    combineArrived(g, combine, true);
+  }
+  halo.waitSends();
+  g.endCombine();
+}
+
+/**
+ * @brief Activates the local nodes which refer to the given sources.
+ *
+ * @param sources   Extended indices of the changed sources.
+ */
+void
+GraphCompute::activateReferences(
+  const std::vector<unsigned int>& sources
+)
+{
+  for (std::vector<unsigned int>::const_iterator s = sources.begin(); s != sources.end(); ++s) {
+    const unsigned int* references = m_halo->references(*s);
+    for (unsigned int r = 0; r < m_halo->numReferences(*s); ++r) {
+      m_pipelineActive.activate(m_halo->referenceTarget(references[r]));
+    }
+  }
+}
+
+/**
+ * @brief Handles the arrived halo messages, and combines the active boundary
+ *        nodes which have all their ghosts.
+ *
+ * @param g         Graph on which computation is to be done.
+ * @param combine   User provided combine function.
+ * @param wait      Whether to block until some message arrives.
+ */
+void
+GraphCompute::combineArrived(
+  Graph& g,
+  const CombineFunction& combine,
+  const bool wait
+)
+{
+  m_pipelineSources.clear();
+  m_pipelineRanks.clear();
+  m_halo->receiveSome(wait, g.frontier(), m_pipelineSources, m_pipelineRanks);
+  m_halo->refresh(g, m_pipelineSources, m_interactionSets);
+  activateReferences(m_pipelineSources);
+
+  for (std::vector<unsigned int>::const_iterator r = m_pipelineRanks.begin(); r != m_pipelineRanks.end(); ++r) {
+    const unsigned int* dependents = m_halo->dependents(*r);
+    for (unsigned int d = 0; d < m_halo->numDependents(*r); ++d) {
+      const unsigned int i = dependents[d];
+      if ((--m_pipelinePending[i] == 0) && m_pipelineActive.isActive(i)) {
+        m_pipelineReady.push_back(i);
+      }
+    }
+  }
+  g.combineLocalNodes(combine, m_pipelineReady, m_interactionSets);
+  m_pipelineReady.clear();
+}
+
 /**
  * @brief Function which is called by the user for performing computations. 
  *
@@ -285,34 +800,72 @@ GraphCompute::operator()(
 
   try {
     std::vector<std::vector<GraphNode> > interactionSets;
+    const unsigned long long accesses[2] = {g.numLocalAccesses(), g.numRemoteAccesses()};
+    unsigned long long events[s_numPhases * PerfCounters::NumEvents] = {0};
 
     double graphComputeTotalTime = MPI_Wtime();
 
     double generateTime = MPI_Wtime();
+    if (m_perfCounters) {
+      m_perfCounters->start();
+    }
+    if (m_numaPlacement) {
+      g.placeNodes();
+    }
     GraphAlgorithmChoice generateType = generate.type();
-    bool dependencyFlag = generateAllInteractionSets(g, generate, generateType, interactionSets);
+    std::vector<std::vector<GraphNode::IndexType> > requests;
+    bool dependencyFlag = generateAllInteractionSets(g, generate, generateType, interactionSets, requests);
+    fillRemotePayloads(g, generateType, interactionSets, requests);
+    if (m_numaPlacement) {
+      placeInteractionSets(interactionSets);
+    }
+    if (m_perfCounters) {
+      m_perfCounters->stop(events + s_generatePhase * PerfCounters::NumEvents);
+    }
     generateTime = MPI_Wtime() - generateTime;
 
     double detectionTime = MPI_Wtime();
+    if (m_perfCounters) {
+      m_perfCounters->start();
+    }
     GraphAlgorithmChoice combineCase = detectCombineCase(g, generateType, interactionSets, dependencyFlag);
+    if (m_perfCounters) {
+      m_perfCounters->stop(events + s_detectPhase * PerfCounters::NumEvents);
+    }
     detectionTime = MPI_Wtime() - detectionTime;
 
     // Currently only the special cases, UpwardAccumulateSpecial and DownwardAccumulateSpecial,
     // are implemented, were the nodes in the all interaction sets are all children, or the parent,
     // respectively. In these cases, new dependency forest is not constructed.
     double computeTime = MPI_Wtime();
+    if (m_perfCounters) {
+      m_perfCounters->start();
+    }
     combineAll(g, combine, interactionSets, combineCase);
+    if (m_perfCounters) {
+      m_perfCounters->stop(events + s_combinePhase * PerfCounters::NumEvents);
+    }
     computeTime = MPI_Wtime() - computeTime;
 
     graphComputeTotalTime = MPI_Wtime() - graphComputeTotalTime;
 
+    const double localRatio = m_numaPlacement ? localAccessRatio(g, accesses) : -1.0;
     if (m_mpiCommunicator.rank() == 0) {
       std::cout << "done: "
         << graphComputeTotalTime * 1000 << "ms"
         << " [g: " << generateTime * 1000 << "ms"
         << ", d: " << detectionTime * 1000 << "ms"
-        << ", c: " << computeTime * 1000 << "ms]"
-        << std::endl;
+        << ", c: " << computeTime * 1000 << "ms";
+      if (localRatio >= 0.0) {
+        std::cout << ", l: " << localRatio * 100 << "%";
+      }
+      else if (m_numaPlacement) {
+        std::cout << ", l: n/a";
+      }
+      std::cout << "]" << std::endl;
+    }
+    if (m_perfCounters) {
+      reportPerfCounters(events);
     }
 
   }
@@ -325,6 +878,1179 @@ GraphCompute::operator()(
   return true;
 }
 
+/**
+ * @brief Asynchronous version of the computations, which overlaps the
+ *        generation of the interaction sets with their combines.
+ *
+ * @param g          Graph on which computation is to be done.
+ * @param generate   User provided generate function.
+ * @param combine    User provided combine function.
+ *
+ * @return true if computation was successful, else return false.
+ *
+ * The interaction sets are generated in chunks of nodes by a worker thread,
+ * which goes on with the next chunk while this thread combines the last
+ * one. The combine case is voted on as soon as the first chunk arrives, in
+ * a nonblocking reduction which completes while the chunks flow. Until it
+ * is confirmed, the chunks are combined speculatively as independent
+ * interaction sets, into copies of the nodes, so that the later chunks are
+ * still generated from the original payloads. The copies are committed
+ * once every processor agreed that the interaction sets are independent,
+ * and are otherwise dropped for the detected combine case. Only the
+ * interaction sets of local nodes are combined speculatively; the others
+ * wait for the payloads of their remote nodes, which are filled in once
+ * all the chunks were generated.
+ *
+ * Only the general generate functions are pipelined, over all the nodes;
+ * the other computations, and the sparse frontiers of any processor, fall
+ * back to operator(). The generate function runs on the worker thread, and
+ * must not call MPI other than in prepare(), which runs on this thread.
+ *
+ * A processor which fails before it voted still votes, for a failure, so
+ * that the other processors fail as well instead of waiting for its vote.
+ * A failure never leaves the vote pending. This is a collective call.
+ */
+bool
+GraphCompute::computeAsync(
+  Graph& g,
+  const GenerateFunction& generate,
+  const CombineFunction& combine
+)
+{
+  if (generate.type() != Graph::General) {
+    return (*this)(g, generate, combine);
+  }
+
+  // Sparse frontiers are left to operator() on every processor, since the
+  // fallback is collective as well.
+  int sparse = ((g.halo() != 0) && !g.frontier().isFull()) ? 1 : 0;
+  int anySparse = 0;
+  MPI_Allreduce(&sparse, &anySparse, 1, MPI_INT, MPI_LOR, *m_mpiCommunicator);
+  if (anySparse) {
+    return (*this)(g, generate, combine);
+  }
+
+  if (m_mpiCommunicator.rank() == 0) {
+    std::cout << "+ performing asynchronous Graph compute ... ";
+  }
+
+  MPI_Barrier(*m_mpiCommunicator);
+
+  if (!m_tasks) {
+    m_tasks.reset(new TaskPool(1));
+  }
+
+  std::future<InteractionSetChunk> next;
+  // Votes of this processor, after its first generated chunk, on whether
+  // no node depends on others, on whether every interaction set holds only
+  // its node, and on whether it is still without failure. Processors
+  // without nodes vote for all of them.
+  int votes[3] = {1, 1, 1};
+  int consensus[3] = {1, 1, 1};
+  MPI_Request detection = MPI_REQUEST_NULL;
+  bool voted = false;
+  try {
+    std::vector<std::vector<GraphNode> > interactionSets;
+    interactionSets.reserve(g.size());
+
+    double graphComputeTotalTime = MPI_Wtime();
+    double generateTime = 0.0;
+    double computeTime = 0.0;
+
+    g.interactionSetsChanged();
+    generate.prepare(g);
+
+    int dependencyFlag = -1;
+    bool localOnly = true;
+
+    std::vector<unsigned int> combined;
+    std::vector<GraphNode::PayloadType> combinedPayloads;
+    std::vector<unsigned int> deferred;
+    std::vector<GraphNode::PayloadType> payloads;
+
+    // Chunks are generated one after the other, since generate functions
+    // may keep state across calls.
+    const unsigned int numNodes = g.size();
+    next = m_tasks->submit(std::bind(&GraphCompute::generateInteractionSetChunk, this, std::cref(g), std::cref(generate), 0u));
+    for (bool more = true; more; ) {
+      double waitTime = MPI_Wtime();
+      InteractionSetChunk chunk = next.get();
+      generateTime += MPI_Wtime() - waitTime;
+      more = chunk.m_end < numNodes;
+      if (more) {
+        next = m_tasks->submit(std::bind(&GraphCompute::generateInteractionSetChunk, this, std::cref(g), std::cref(generate), chunk.m_end));
+      }
+
+      if (chunk.m_dependencyFlag >= 0) {
+        if (dependencyFlag < 0) {
+          dependencyFlag = chunk.m_dependencyFlag;
+        }
+        else if (chunk.m_dependencyFlag != dependencyFlag) {
+          throw std::runtime_error("Dependency flags are not consistent!");
+        }
+      }
+      localOnly = localOnly && chunk.m_localOnly;
+
+      if (!voted && ((dependencyFlag >= 0) || !more)) {
+        votes[0] = (dependencyFlag == 1) ? 0 : 1;
+        votes[1] = localOnly ? 1 : 0;
+        MPI_Iallreduce(votes, consensus, 3, MPI_INT, MPI_MIN, *m_mpiCommunicator, &detection);
+        voted = true;
+      }
+
+      double chunkTime = MPI_Wtime();
+      if (dependencyFlag == 0) {
+        for (unsigned int i = chunk.m_begin; i < chunk.m_end; ++i) {
+          const std::vector<GraphNode>& set = chunk.m_interactionSets[i - chunk.m_begin];
+          if (!isInterior(g, set)) {
+            deferred.push_back(i);
+            continue;
+          }
+          GraphNode::PayloadType payload;
+          if (g.combineLocalCopy(combine, i, set, payload, payloads)) {
+            combined.push_back(i);
+            combinedPayloads.push_back(payload);
+          }
+        }
+      }
+      interactionSets.insert(interactionSets.end(), std::make_move_iterator(chunk.m_interactionSets.begin()), std::make_move_iterator(chunk.m_interactionSets.end()));
+      computeTime += MPI_Wtime() - chunkTime;
+
+      // Let the reduction progress.
+      if (detection != MPI_REQUEST_NULL) {
+        int done = 0;
+        MPI_Test(&detection, &done, MPI_STATUS_IGNORE);
+      }
+    }
+
+    double detectionTime = MPI_Wtime();
+    MPI_Wait(&detection, MPI_STATUS_IGNORE);
+    if (consensus[2] == 0) {
+      throw std::runtime_error("Interaction sets couldn't be generated on all the processors!");
+    }
+    // Independent, but not local, interaction sets on all the processors.
+    const bool confirmed = (consensus[0] == 1) && (consensus[1] == 0);
+    GraphAlgorithmChoice combineCase = Graph::NoDependency;
+    GraphAlgorithmChoice generateType = Graph::General;
+    if (!confirmed) {
+      int localComputation = localOnly ? 1 : 0;
+      int globalLocalComputation = 0;
+      MPI_Allreduce(&localComputation, &globalLocalComputation, 1, MPI_INT, MPI_LAND, *m_mpiCommunicator);
+      generateType = globalLocalComputation ? Graph::LocalComputation : Graph::General;
+      combineCase = detectCombineCase(g, generateType, interactionSets, dependencyFlag == 1);
+    }
+    detectionTime = MPI_Wtime() - detectionTime;
+
+    double commitTime = MPI_Wtime();
+    fillRemotePayloads(g, generateType, interactionSets, std::vector<std::vector<GraphNode::IndexType> >());
+    if (confirmed) {
+      for (std::vector<unsigned int>::const_iterator i = deferred.begin(); i != deferred.end(); ++i) {
+        GraphNode::PayloadType payload;
+        if (g.combineLocalCopy(combine, *i, interactionSets[*i], payload, payloads)) {
+          combined.push_back(*i);
+          combinedPayloads.push_back(payload);
+        }
+      }
+      g.beginCombine();
+      for (unsigned int k = 0; k < combined.size(); ++k) {
+        g.commitPayload(combined[k], combinedPayloads[k]);
+      }
+      g.endCombine();
+      MPI_Barrier(*m_mpiCommunicator);
+    }
+    else {
+      combineAll(g, combine, interactionSets, combineCase);
+    }
+    computeTime += MPI_Wtime() - commitTime;
+
+    graphComputeTotalTime = MPI_Wtime() - graphComputeTotalTime;
+
+    if (m_mpiCommunicator.rank() == 0) {
+      std::cout << "done: "
+        << graphComputeTotalTime * 1000 << "ms"
+        << " [g: " << generateTime * 1000 << "ms"
+        << ", d: " << detectionTime * 1000 << "ms"
+        << ", c: " << computeTime * 1000 << "ms"
+        << (confirmed ? "" : ", not pipelined") << "]"
+        << std::endl;
+    }
+
+  }
+  catch (std::runtime_error& e) {
+    // The worker may still be generating from the graph.
+    if (next.valid()) {
+      next.wait();
+    }
+    if (!voted) {
+      votes[2] = 0;
+      MPI_Iallreduce(votes, consensus, 3, MPI_INT, MPI_MIN, *m_mpiCommunicator, &detection);
+    }
+    MPI_Wait(&detection, MPI_STATUS_IGNORE);
+    std::cerr << e.what() << std::endl;
+    std::cerr << "Aborting!" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Batched version of the computations, for several computations
+ *        which don't depend on each other.
+ *
+ * @param g       Graph on which computation is to be done.
+ * @param batch   User provided computations, which must not read each
+ *                other's results.
+ *
+ * @return true if all the computations were successful, else return false.
+ *
+ * The interaction sets of all the computations are generated in one pass
+ * over the nodes, before any of them is combined, and their combine cases
+ * are detected together. The computations without dependencies on any
+ * processor are agreed on in one reduction, instead of in a detection of
+ * their own. Unless some processor has a sparse frontier, every run of
+ * consecutive computations with the same local or independent combine case
+ * is then combined in one traversal of the nodes, which applies their
+ * combine functions to a node in their order, so that the computations
+ * are never reordered. The other computations are combined one at a time.
+ */
+bool
+GraphCompute::computeBatch(
+  Graph& g,
+  const std::vector<Computation>& batch
+)
+{
+  if (m_mpiCommunicator.rank() == 0) {
+    std::cout << "+ performing batched Graph compute ... ";
+  }
+
+  MPI_Barrier(*m_mpiCommunicator);
+
+  try {
+    const unsigned int numComputations = static_cast<unsigned int>(batch.size());
+
+    double graphComputeTotalTime = MPI_Wtime();
+
+    double generateTime = MPI_Wtime();
+    std::vector<GraphAlgorithmChoice> generateTypes;
+    std::vector<std::vector<std::vector<GraphNode> > > interactionSets;
+    std::vector<int> dependencyFlags;
+    generateBatchInteractionSets(g, batch, generateTypes, interactionSets, dependencyFlags);
+    for (unsigned int k = 0; k < numComputations; ++k) {
+      fillRemotePayloads(g, generateTypes[k], interactionSets[k], std::vector<std::vector<GraphNode::IndexType> >());
+    }
+    generateTime = MPI_Wtime() - generateTime;
+
+    double detectionTime = MPI_Wtime();
+    std::vector<int> globalDependencyFlags(numComputations, 0);
+    if (numComputations > 0) {
+      MPI_Allreduce(&dependencyFlags[0], &globalDependencyFlags[0], numComputations, MPI_INT, MPI_LOR, *m_mpiCommunicator);
+    }
+    std::vector<GraphAlgorithmChoice> combineCases(numComputations, Graph::General);
+    for (unsigned int k = 0; k < numComputations; ++k) {
+      if (globalDependencyFlags[k]) {
+        combineCases[k] = detectCombineCase(g, generateTypes[k], interactionSets[k], dependencyFlags[k] == 1);
+      }
+      else {
+        combineCases[k] = (generateTypes[k] == Graph::LocalComputation) ? Graph::LocalComputation : Graph::NoDependency;
+      }
+    }
+    detectionTime = MPI_Wtime() - detectionTime;
+
+    // Only the computations over all the nodes are fused, which has to be
+    // agreed on by the processors, since the others combine collectively.
+    int sparse = ((g.halo() != 0) && !g.frontier().isFull()) ? 1 : 0;
+    int anySparse = 0;
+    MPI_Allreduce(&sparse, &anySparse, 1, MPI_INT, MPI_LOR, *m_mpiCommunicator);
+
+    double computeTime = MPI_Wtime();
+    unsigned int numTraversals = 0;
+    std::vector<const CombineFunction*> combines;
+    std::vector<const std::vector<std::vector<GraphNode> >*> sets;
+    for (unsigned int k = 0; k < numComputations; ) {
+      const GraphAlgorithmChoice combineCase = combineCases[k];
+      const bool fusable = !anySparse && ((combineCase == Graph::LocalComputation) || (combineCase == Graph::NoDependency));
+      combines.clear();
+      sets.clear();
+      unsigned int end = k;
+      do {
+        combines.push_back(batch[end].m_combine);
+        sets.push_back(&interactionSets[end]);
+        ++end;
+      } while (fusable && (end < numComputations) && (combineCases[end] == combineCase));
+
+      if (combines.size() > 1) {
+        if (!g.computeFused(combineCase, combines, sets)) {
+          throw std::runtime_error("Fused computation for the combine case failed!");
+        }
+        MPI_Barrier(*m_mpiCommunicator);
+      }
+      else {
+        combineAll(g, *combines[0], *sets[0], combineCase);
+      }
+      ++numTraversals;
+      k = end;
+    }
+    computeTime = MPI_Wtime() - computeTime;
+
+    graphComputeTotalTime = MPI_Wtime() - graphComputeTotalTime;
+
+    if (m_mpiCommunicator.rank() == 0) {
+      std::cout << "done: "
+        << graphComputeTotalTime * 1000 << "ms"
+        << " [g: " << generateTime * 1000 << "ms"
+        << ", d: " << detectionTime * 1000 << "ms"
+        << ", c: " << computeTime * 1000 << "ms"
+        << ", " << numComputations << " computations"
+        << " in " << numTraversals << " traversals]"
+        << std::endl;
+    }
+
+  }
+  catch (std::runtime_error& e) {
+    std::cerr << e.what() << std::endl;
+    std::cerr << "Aborting!" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Iterative version of the computations, in bulk synchronous supersteps.
+ *
+ * @param g               Graph on which computation is to be done.
+ * @param generate        User provided generate function.
+ * @param combine         User provided combine function, which returns true
+ *                        if it changed the node.
+ * @param maxSupersteps   Maximum number of supersteps.
+ *
+ * @return true if the computation converged, else return false.
+ *
+ * The interaction sets are generated, and the combine case detected, only
+ * once. Every superstep combines the nodes which have a changed node in
+ * their interaction sets, then sends the changed payloads to the processors
+ * holding ghosts of them, and copies them into the interaction sets. The
+ * first superstep combines all the nodes. The computation converges once no
+ * node changed in a superstep, which is decided with a single reduction.
+ * The interaction sets are kept for later incremental updates.
+ */
+bool
+GraphCompute::iterate(
+  Graph& g,
+  const GenerateFunction& generate,
+  const CombineFunction& combine,
+  const unsigned int maxSupersteps
+)
+{
+  if (m_mpiCommunicator.rank() == 0) {
+    std::cout << "+ performing iterative Graph compute ... ";
+  }
+
+  MPI_Barrier(*m_mpiCommunicator);
+
+  bool converged = false;
+  try {
+    m_halo.reset();
+    m_interactionSets.clear();
+    const unsigned long long accesses[2] = {g.numLocalAccesses(), g.numRemoteAccesses()};
+
+    double graphComputeTotalTime = MPI_Wtime();
+
+    double generateTime = MPI_Wtime();
+    if (m_numaPlacement) {
+      g.placeNodes();
+    }
+    GraphAlgorithmChoice generateType = generate.type();
+    bool dependencyFlag = generateAllInteractionSets(g, generate, generateType, m_interactionSets, m_requests);
+    if (m_numaPlacement) {
+      placeInteractionSets(m_interactionSets);
+    }
+    generateTime = MPI_Wtime() - generateTime;
+
+    double detectionTime = MPI_Wtime();
+    m_combineCase = detectCombineCase(g, generateType, m_interactionSets, dependencyFlag);
+    detectionTime = MPI_Wtime() - detectionTime;
+    if ((m_combineCase != Graph::NoDependency) && (m_combineCase != Graph::LocalComputation)) {
+      throw std::runtime_error("Iterative computations need interaction sets without dependencies!");
+    }
+
+    double exchangeTime = MPI_Wtime();
+    rebuildHalo(g);
+    g.frontier().reset(m_halo->numExtended(), true);
+    exchangeTime = MPI_Wtime() - exchangeTime;
+
+    double computeTime = 0.0;
+    unsigned int superstep = 0;
+    converged = runSupersteps(g, combine, maxSupersteps, superstep, computeTime, exchangeTime);
+
+    graphComputeTotalTime = MPI_Wtime() - graphComputeTotalTime;
+
+    const double localRatio = m_numaPlacement ? localAccessRatio(g, accesses) : -1.0;
+    if (m_mpiCommunicator.rank() == 0) {
+      std::cout << "done: "
+        << graphComputeTotalTime * 1000 << "ms"
+        << " [g: " << generateTime * 1000 << "ms"
+        << ", d: " << detectionTime * 1000 << "ms"
+        << ", c: " << computeTime * 1000 << "ms"
+        << ", x: " << exchangeTime * 1000 << "ms"
+        << ", " << superstep << " supersteps";
+      if (localRatio >= 0.0) {
+        std::cout << ", l: " << localRatio * 100 << "%";
+      }
+      else if (m_numaPlacement) {
+        std::cout << ", l: n/a";
+      }
+      std::cout << (converged ? "" : ", not converged") << "]" << std::endl;
+    }
+
+  }
+  catch (std::runtime_error& e) {
+    m_halo.reset();
+    g.setHalo(0);
+    g.frontier().reset(g.size(), true);
+    std::cerr << e.what() << std::endl;
+    std::cerr << "Aborting!" << std::endl;
+    return false;
+  }
+
+  return converged;
+}
+
+/**
+ * @brief Incremental version of the iterative computations, after the graph
+ *        has been mutated.
+ *
+ * @param g               Graph on which the last iterative computation was done.
+ * @param generate        User provided generate function, as used in that computation.
+ * @param combine         User provided combine function.
+ * @param maxSupersteps   Maximum number of supersteps.
+ *
+ * @return true if the computation converged, else return false.
+ *
+ * The buffered mutations of the graph are applied first. Only the interaction
+ * sets of the dirty nodes, and of the nodes which refer to removed nodes, are
+ * generated again. The supersteps then start from the dirty nodes and their
+ * dependents, instead of from all the nodes. The generate function is only
+ * prepared for the regenerated nodes. If some interaction sets changed
+ * their members, the ghosts which they gained or lost are subscribed and
+ * unsubscribed at their owners, while the other ghosts are kept.
+ */
+bool
+GraphCompute::update(
+  Graph& g,
+  const GenerateFunction& generate,
+  const CombineFunction& combine,
+  const unsigned int maxSupersteps
+)
+{
+  if (m_mpiCommunicator.rank() == 0) {
+    std::cout << "+ performing incremental Graph compute ... ";
+  }
+
+  bool converged = false;
+  try {
+    if (!m_halo) {
+      throw std::runtime_error("Incremental computations need a previous iterative computation!");
+    }
+
+    double graphComputeTotalTime = MPI_Wtime();
+
+    double generateTime = MPI_Wtime();
+    g.applyUpdates();
+    if (m_numaPlacement) {
+      g.placeNodes();
+    }
+
+    // Nodes which refer to removed nodes need new interaction sets as well.
+    Frontier affected;
+    affected.reset(g.size(), false);
+    for (std::vector<unsigned int>::const_iterator i = g.dirty().active().begin(); i != g.dirty().active().end(); ++i) {
+      affected.activate(*i);
+    }
+    const std::vector<GraphNode::IndexType>& removed = g.removedNodes();
+    for (std::vector<GraphNode::IndexType>::const_iterator r = removed.begin(); r != removed.end(); ++r) {
+      const unsigned int s = m_halo->extendedIndex(g, *r);
+      if (s < m_halo->numExtended()) {
+        const unsigned int* references = m_halo->references(s);
+        for (unsigned int e = 0; e < m_halo->numReferences(s); ++e) {
+          affected.activate(m_halo->referenceTarget(references[e]));
+        }
+      }
+    }
+
+    g.interactionSetsChanged();
+    generate.prepareUpdate(g, affected.active());
+    int structural = (g.size() != m_halo->numLocal()) ? 1 : 0;
+    m_interactionSets.resize(g.size());
+    std::vector<std::vector<GraphNode> > interactionSet;
+    for (std::vector<unsigned int>::const_iterator i = affected.active().begin(); i != affected.active().end(); ++i) {
+      const GraphNode& node = *(g.begin() + *i);
+      interactionSet.clear();
+      if (!g.isRemoved(node.index())) {
+        if (generateInteractionSetForNode(g, generate, Graph::General, node, interactionSet)) {
+          throw std::runtime_error("Incremental computations need interaction sets without dependencies!");
+        }
+      }
+      else {
+        interactionSet.push_back(std::vector<GraphNode>());
+      }
+      if (generate.normalize()) {
+        normalizeInteractionSet(g, interactionSet[0]);
+      }
+      std::vector<GraphNode>& current = m_interactionSets[*i];
+      bool sameMembers = (current.size() == interactionSet[0].size());
+      for (unsigned int j = 0; sameMembers && (j < current.size()); ++j) {
+        sameMembers = (current[j].index() == interactionSet[0][j].index());
+      }
+      if (!sameMembers) {
+        structural = 1;
+      }
+      current.swap(interactionSet[0]);
+      g.markDirty(*i);
+    }
+    generateTime = MPI_Wtime() - generateTime;
+
+    // The subscriptions of the ghosts change only if some interaction set
+    // changed its members, and then only for the ghosts which it gained or lost.
+    double exchangeTime = MPI_Wtime();
+    int globalStructural = 0;
+    MPI_Allreduce(&structural, &globalStructural, 1, MPI_INT, MPI_LOR, *m_mpiCommunicator);
+    if (globalStructural) {
+      m_requests.clear();
+      m_halo->update(g, m_interactionSets, affected.active());
+    }
+    g.setHalo(m_halo.get());
+    for (std::vector<unsigned int>::const_iterator i = affected.active().begin(); i != affected.active().end(); ++i) {
+      m_halo->refresh(g, *i, m_interactionSets[*i]);
+    }
+
+    // The dirty local nodes and the ghosts of remote dirty nodes form the frontier.
+    g.frontier().reset(m_halo->numExtended(), false);
+    for (std::vector<unsigned int>::const_iterator i = g.dirty().active().begin(); i != g.dirty().active().end(); ++i) {
+      g.frontier().activate(*i);
+    }
+    m_halo->exchange(g, g.dirty(), g.frontier());
+    m_halo->refresh(g, g.frontier(), m_interactionSets);
+    exchangeTime = MPI_Wtime() - exchangeTime;
+
+    double computeTime = 0.0;
+    unsigned int superstep = 0;
+    converged = runSupersteps(g, combine, maxSupersteps, superstep, computeTime, exchangeTime);
+
+    graphComputeTotalTime = MPI_Wtime() - graphComputeTotalTime;
+
+    if (m_mpiCommunicator.rank() == 0) {
+      std::cout << "done: "
+        << graphComputeTotalTime * 1000 << "ms"
+        << " [g: " << generateTime * 1000 << "ms"
+        << ", c: " << computeTime * 1000 << "ms"
+        << ", x: " << exchangeTime * 1000 << "ms"
+        << ", " << superstep << " supersteps"
+        << (globalStructural ? ", updated halo" : "")
+        << (converged ? "" : ", not converged") << "]"
+        << std::endl;
+    }
+
+  }
+  catch (std::runtime_error& e) {
+    m_halo.reset();
+    g.setHalo(0);
+    g.frontier().reset(g.size(), true);
+    std::cerr << e.what() << std::endl;
+    std::cerr << "Aborting!" << std::endl;
+    return false;
+  }
+
+  return converged;
+}
+
+/**
+ * @brief Moves nodes between the processors when the costs of the last
+ *        iterative computation are imbalanced.
+ *
+ * @param g           Graph on which the last iterative computation was done.
+ * @param generate    User provided generate function, as used in that computation.
+ * @param threshold   Ratio of the largest to the mean cost of a processor
+ *                    above which the nodes are moved; 1 always balances.
+ *
+ * @return true if the nodes were moved, else return false.
+ *
+ * The cost of a node is the size of its interaction set, which the combines
+ * go through in every superstep. After moving, the interaction sets are
+ * generated again and the ghosts collected again, so that later incremental
+ * computations can go on.
+ */
+bool
+GraphCompute::rebalance(
+  Graph& g,
+  const GenerateFunction& generate,
+  const double threshold
+)
+{
+  if (m_mpiCommunicator.rank() == 0) {
+    std::cout << "+ rebalancing Graph ... ";
+  }
+
+  bool moved = false;
+  try {
+    if (!m_halo || (m_interactionSets.size() != g.size())) {
+      throw std::runtime_error("Rebalancing needs a previous iterative computation!");
+    }
+
+    double rebalanceTime = MPI_Wtime();
+    std::vector<double> costs(g.size(), 0.0);
+    unsigned int i = 0;
+    for (GraphNodeIterator ni = g.begin(); ni != g.end(); ++ni, ++i) {
+      if (!g.isRemoved((*ni).index())) {
+        costs[i] = 1.0 + m_interactionSets[i].size();
+      }
+    }
+    const double imbalance = g.imbalance(costs);
+    if (imbalance > threshold) {
+      moved = g.rebalance(costs);
+    }
+
+    double newImbalance = imbalance;
+    if (moved) {
+      m_halo.reset();
+      m_interactionSets.clear();
+      if (m_remoteCache) {
+        m_remoteCache->clear();
+      }
+      GraphAlgorithmChoice generateType = Graph::General;
+      generateAllInteractionSets(g, generate, generateType, m_interactionSets, m_requests);
+      if (m_numaPlacement) {
+        g.placeNodes();
+        placeInteractionSets(m_interactionSets);
+      }
+      rebuildHalo(g);
+      g.setHalo(0);
+      g.frontier().reset(g.size(), true);
+
+      costs.assign(g.size(), 0.0);
+      i = 0;
+      for (GraphNodeIterator ni = g.begin(); ni != g.end(); ++ni, ++i) {
+        if (!g.isRemoved((*ni).index())) {
+          costs[i] = 1.0 + m_interactionSets[i].size();
+        }
+      }
+      newImbalance = g.imbalance(costs);
+    }
+    rebalanceTime = MPI_Wtime() - rebalanceTime;
+
+    if (m_mpiCommunicator.rank() == 0) {
+      std::cout << "done: "
+        << rebalanceTime * 1000 << "ms"
+        << " [imbalance: " << imbalance;
+      if (moved) {
+        std::cout << " -> " << newImbalance;
+      }
+      std::cout << "]" << std::endl;
+    }
+
+  }
+  catch (std::runtime_error& e) {
+    m_halo.reset();
+    g.setHalo(0);
+    g.frontier().reset(g.size(), true);
+    std::cerr << e.what() << std::endl;
+    std::cerr << "Aborting!" << std::endl;
+    return false;
+  }
+
+  return moved;
+}
+
+/**
+ * @brief Renumbers the local nodes of a graph for the locality of the
+ *        accesses to their neighbors.
+ *
+ * @param g          Graph to reorder.
+ * @param generate   User provided generate function, for the interaction
+ *                   sets kept by a previous iterative computation.
+ * @param ordering   Order of the nodes.
+ *
+ * @return true if any node got a new index.
+ *
+ * The kept interaction sets and their halo are generated again over the
+ * new indices, and the remote cache is emptied. The profile reports the mean
+ * distance between the local indices of the nodes and of their local
+ * neighbors, and, for kept interaction sets, the time of the reads of a
+ * combine over them, before and after. Results are mapped back to the input
+ * through Graph::originalIndex.
+ */
+bool
+GraphCompute::reorder(
+  Graph& g,
+  const GenerateFunction& generate,
+  const Graph::Ordering ordering
+)
+{
+  if (m_mpiCommunicator.rank() == 0) {
+    std::cout << "+ reordering Graph ... ";
+  }
+
+  bool moved = false;
+  try {
+    double reorderTime = MPI_Wtime();
+    const double span = meanEdgeSpan(g);
+    const bool kept = m_halo && (m_interactionSets.size() == g.size());
+    const double readTime = combineReadTime(g);
+    moved = g.reorder(ordering);
+
+    // The cached nodes, and their subscribers, are known by the old indices.
+    if (moved && m_remoteCache) {
+      m_remoteCache->clear();
+    }
+    if (moved && kept) {
+      m_halo.reset();
+      m_interactionSets.clear();
+      GraphAlgorithmChoice generateType = Graph::General;
+      generateAllInteractionSets(g, generate, generateType, m_interactionSets, m_requests);
+      if (m_numaPlacement) {
+        g.placeNodes();
+        placeInteractionSets(m_interactionSets);
+      }
+      rebuildHalo(g);
+      g.setHalo(0);
+      g.frontier().reset(g.size(), true);
+    }
+    else if (moved) {
+      m_halo.reset();
+      m_interactionSets.clear();
+    }
+    const double newSpan = moved ? meanEdgeSpan(g) : span;
+    const double newReadTime = moved ? combineReadTime(g) : readTime;
+    reorderTime = MPI_Wtime() - reorderTime;
+
+    if (m_mpiCommunicator.rank() == 0) {
+      std::cout << "done: "
+        << reorderTime * 1000 << "ms"
+        << " [span: " << span;
+      if (moved) {
+        std::cout << " -> " << newSpan;
+      }
+      if (kept) {
+        std::cout << ", combine reads: " << readTime * 1000 << "ms";
+        if (moved) {
+          std::cout << " -> " << newReadTime * 1000 << "ms";
+        }
+      }
+      std::cout << "]" << std::endl;
+    }
+
+  }
+  catch (std::runtime_error& e) {
+    m_halo.reset();
+    g.setHalo(0);
+    g.frontier().reset(g.size(), true);
+    std::cerr << e.what() << std::endl;
+    std::cerr << "Aborting!" << std::endl;
+    return false;
+  }
+
+  return moved;
+}
+
+/**
+ * @brief Mean distance between the local indices of the nodes and of their
+ *        local neighbors, over all the processors.
+ *
+ * This is a collective call.
+ */
+double
+GraphCompute::meanEdgeSpan(
+  const Graph& g
+) const
+{
+  double spans[2] = {0.0, 0.0};
+  std::vector<GraphNode::IndexType> targets;
+  for (unsigned int i = 0; i < g.size(); ++i) {
+    g.neighbors(i, targets);
+    for (std::vector<GraphNode::IndexType>::const_iterator t = targets.begin(); t != targets.end(); ++t) {
+      if (g.isLocal(*t)) {
+        const unsigned int j = g.localIndex(*t);
+        spans[0] += (j > i) ? (j - i) : (i - j);
+        spans[1] += 1.0;
+      }
+    }
+  }
+  double globalSpans[2] = {0.0, 0.0};
+  MPI_Allreduce(spans, globalSpans, 2, MPI_DOUBLE, MPI_SUM, *m_mpiCommunicator);
+  return (globalSpans[1] > 0.0) ? (globalSpans[0] / globalSpans[1]) : 0.0;
+}
+
+/**
+ * @brief Time of the reads of a combine over the kept interaction sets,
+ *        which reads every source through the halo, as Graph::pullReduction
+ *        does, on the slowest processor.
+ *
+ * @return The time, which is 0 on the processors without kept interaction
+ *         sets.
+ *
+ * The payloads are summed, and the sum is reduced with the time, so that
+ * the reads are not optimized away. This is a collective call.
+ */
+double
+GraphCompute::combineReadTime(
+  const Graph& g
+) const
+{
+  double times[2] = {0.0, 0.0};
+  if (m_halo && (m_interactionSets.size() == g.size()) && (m_halo->numLocal() == g.size())) {
+    const HaloExchange& halo = *m_halo;
+    const int numSets = static_cast<int>(m_interactionSets.size());
+    double sum = 0.0;
+    times[0] = MPI_Wtime();
+    #pragma omp parallel for schedule(static) reduction(+ : sum)
+    for (int i = 0; i < numSets; ++i) {
+      const unsigned int numSources = static_cast<unsigned int>(m_interactionSets[i].size());
+      for (unsigned int j = 0; j < numSources; ++j) {
+        sum += halo.payload(g, halo.source(i, j));
+      }
+    }
+    times[0] = MPI_Wtime() - times[0];
+    times[1] = sum;
+  }
+  double globalTimes[2] = {0.0, 0.0};
+  MPI_Allreduce(times, globalTimes, 2, MPI_DOUBLE, MPI_MAX, *m_mpiCommunicator);
+  return globalTimes[0];
+}
+
+/**
+ * @brief Copies every interaction set from the thread which reduces its
+ *        node, so that the sets are allocated on the domains of the nodes.
+ */
+void
+GraphCompute::placeInteractionSets(
+  std::vector<std::vector<GraphNode> >& interactionSets
+) const
+{
+  const int numSets = static_cast<int>(interactionSets.size());
+  #pragma omp parallel for schedule(static)
+  for (int i = 0; i < numSets; ++i) {
+    std::vector<GraphNode>(interactionSets[i]).swap(interactionSets[i]);
+  }
+}
+
+/**
+ * @brief Fraction of the accesses to the nodes since the given counts which
+ *        were local to the domains of the threads, over all the processors.
+ *
+ * @return The fraction, or -1 if the domains of no access were known, as
+ *         is always the case without libnuma.
+ *
+ * This is a collective call.
+ */
+double
+GraphCompute::localAccessRatio(
+  const Graph& g,
+  const unsigned long long* const before
+) const
+{
+  unsigned long long accesses[2] = {g.numLocalAccesses() - before[0], g.numRemoteAccesses() - before[1]};
+  unsigned long long globalAccesses[2] = {0, 0};
+  MPI_Allreduce(accesses, globalAccesses, 2, MPI_UNSIGNED_LONG_LONG, MPI_SUM, *m_mpiCommunicator);
+  if (globalAccesses[0] + globalAccesses[1] == 0) {
+    return -1.0;
+  }
+  return static_cast<double>(globalAccesses[0]) / (globalAccesses[0] + globalAccesses[1]);
+}
+
+/**
+ * @brief Prints the counts of the hardware events in the phases of a
+ *        computation, summed over all the processors.
+ *
+ * @param events   Counts of the events of this processor, per phase.
+ *
+ * An event is only reported if it could be counted on all the processors.
+ * This is a collective call.
+ */
+void
+GraphCompute::reportPerfCounters(
+  const unsigned long long* const events
+) const
+{
+  unsigned long long globalEvents[s_numPhases * PerfCounters::NumEvents] = {0};
+  MPI_Allreduce(const_cast<unsigned long long*>(events), globalEvents, s_numPhases * PerfCounters::NumEvents,
+                MPI_UNSIGNED_LONG_LONG, MPI_SUM, *m_mpiCommunicator);
+  int available[PerfCounters::NumEvents];
+  for (unsigned int e = 0; e < PerfCounters::NumEvents; ++e) {
+    available[e] = m_perfCounters->isAvailable(static_cast<PerfCounters::Event>(e)) ? 1 : 0;
+  }
+  int globalAvailable[PerfCounters::NumEvents];
+  MPI_Allreduce(available, globalAvailable, PerfCounters::NumEvents, MPI_INT, MPI_MIN, *m_mpiCommunicator);
+
+  if (m_mpiCommunicator.rank() == 0) {
+    const char* const phases[s_numPhases] = {"g", "d", "c"};
+    std::cout << "  counters";
+    for (unsigned int p = 0; p < s_numPhases; ++p) {
+      std::cout << ((p == 0) ? " [" : "; ") << phases[p] << ":";
+      bool any = false;
+      for (unsigned int e = 0; e < PerfCounters::NumEvents; ++e) {
+        if (globalAvailable[e]) {
+          std::cout << (any ? ", " : " ") << globalEvents[p * PerfCounters::NumEvents + e]
+            << " " << PerfCounters::name(static_cast<PerfCounters::Event>(e));
+          any = true;
+        }
+      }
+      if (!any) {
+        std::cout << " n/a";
+      }
+    }
+    std::cout << "]" << std::endl;
+  }
+}
+
+/**
+ * @brief Collects the ghosts of the kept interaction sets, and brings the
+ *        interaction sets up to date with the current payloads.
+ *
+ * @param g   Graph on which computation is to be done.
+ *
+ * The payloads of the ghosts are filled in by the remote cache, if it is
+ * enabled, and are else all sent by their owners.
+ */
+void
+GraphCompute::rebuildHalo(
+  Graph& g
+)
+{
+  if (m_requests.empty()) {
+    m_halo.reset(new HaloExchange(g, m_interactionSets));
+  }
+  else {
+    m_halo.reset(new HaloExchange(g, m_interactionSets, m_requests));
+  }
+  g.setHalo(m_halo.get());
+
+  // The cached ghosts are served without asking their owners.
+  Frontier allSources;
+  allSources.reset(m_halo->numExtended(), true);
+  if (m_remoteCache) {
+    m_remoteCache->fill(g, m_interactionSets);
+    m_halo->load(m_interactionSets);
+  }
+  else {
+    Frontier allNodes;
+    allNodes.reset(g.size(), true);
+    m_halo->exchange(g, allNodes, allSources);
+  }
+  m_halo->refresh(g, allSources, m_interactionSets);
+}
+
+/**
+ * @brief Fills the payloads of the remote nodes in the interaction sets,
+ *        which are generated with default payloads.
+ *
+ * @param g                 Graph on which computation is to be done.
+ * @param generateType      Type of the generate function, as agreed on by
+ *                          all the processors.
+ * @param interactionSets   Interaction sets of the local nodes.
+ * @param requests          Sorted remote nodes of the interaction sets, per
+ *                          owner, if they were collected along with them.
+ *
+ * The payloads come from the remote cache, if it is enabled, and are else
+ * sent by their owners through a halo which is dropped afterwards. The halo
+ * is only built if some processor has remote nodes in its interaction sets,
+ * which is agreed on in one reduction, and never for local computations.
+ * This is a collective call.
+ */
+void
+GraphCompute::fillRemotePayloads(
+  const Graph& g,
+  const GraphAlgorithmChoice generateType,
+  std::vector<std::vector<GraphNode> >& interactionSets,
+  const std::vector<std::vector<GraphNode::IndexType> >& requests
+)
+{
+  if (m_remoteCache) {
+    m_remoteCache->fill(g, interactionSets);
+    return;
+  }
+  // All the processors agreed on the local computation.
+  if ((m_mpiCommunicator.size() == 1) || (generateType == Graph::LocalComputation)) {
+    return;
+  }
+
+  int localRemote = 0;
+  if (!requests.empty()) {
+    for (unsigned int p = 0; (p < requests.size()) && !localRemote; ++p) {
+      localRemote = requests[p].empty() ? 0 : 1;
+    }
+  }
+  else {
+    for (unsigned int i = 0; (i < interactionSets.size()) && !localRemote; ++i) {
+      for (std::vector<GraphNode>::const_iterator n = interactionSets[i].begin(); n != interactionSets[i].end(); ++n) {
+        if (!g.isLocal(n->index())) {
+          localRemote = 1;
+          break;
+        }
+      }
+    }
+  }
+  int globalRemote = 0;
+  MPI_Allreduce(&localRemote, &globalRemote, 1, MPI_INT, MPI_LOR, *m_mpiCommunicator);
+  if (!globalRemote) {
+    return;
+  }
+
+  std::unique_ptr<HaloExchange> halo;
+  if (requests.empty()) {
+    halo.reset(new HaloExchange(g, interactionSets));
+  }
+  else {
+    halo.reset(new HaloExchange(g, interactionSets, requests));
+  }
+  Frontier allNodes;
+  allNodes.reset(g.size(), true);
+  Frontier allSources;
+  allSources.reset(halo->numExtended(), true);
+  halo->exchange(g, allNodes, allSources);
+  halo->refresh(g, allSources, interactionSets);
+}
+
+/**
+ * @brief Runs supersteps from the current frontier of the graph until no
+ *        node changes.
+ *
+ * @param g               Graph on which computation is to be done.
+ * @param combine         User provided combine function.
+ * @param maxSupersteps   Maximum number of supersteps.
+ * @param superstep       Number of supersteps which were run.
+ * @param computeTime     Time spent in combining, accumulated.
+ * @param exchangeTime    Time spent in exchanging payloads, accumulated.
+ *
+ * @return true if the computation converged, else return false.
+ */
+bool
+GraphCompute::runSupersteps(
+  Graph& g,
+  const CombineFunction& combine,
+  const unsigned int maxSupersteps,
+  unsigned int& superstep,
+  double& computeTime,
+  double& exchangeTime
+)
+{
+  bool converged = false;
+  bool pipelined = false;
+  while (superstep < maxSupersteps) {
+    double stepTime = MPI_Wtime();
+    if (pipelined) {
+      combineAllPipelined(g, combine);
+    }
+    else {
+      combineAll(g, combine, m_interactionSets, m_combineCase);
+    }
+    computeTime += MPI_Wtime() - stepTime;
+    ++superstep;
+
+    // Count the changed nodes, along with all the nodes for the density.
+    unsigned long long counts[2] = {g.changed().numActive(), g.size()};
+    unsigned long long globalCounts[2] = {0, 0};
+    MPI_Allreduce(counts, globalCounts, 2, MPI_UNSIGNED_LONG_LONG, MPI_SUM, *m_mpiCommunicator);
+    if (globalCounts[0] == 0) {
+      converged = true;
+      break;
+    }
+
+    // Dense frontiers are pulled, overlapping the exchange of the changes
+    // with the combines. Sparse ones are exchanged first, so that they can
+    // be pushed.
+    pipelined = (m_combineCase == Graph::NoDependency) &&
+                (globalCounts[0] >= NoDependencyPushAlgorithmFunction::s_pushDensity * globalCounts[1]);
+    if (pipelined) {
+      continue;
+    }
+
+    // The changed local nodes and the changed ghosts form the next frontier.
+    stepTime = MPI_Wtime();
+    g.frontier().reset(m_halo->numExtended(), false);
+    const std::vector<unsigned int>& changed = g.changed().active();
+    for (std::vector<unsigned int>::const_iterator i = changed.begin(); i != changed.end(); ++i) {
+      g.frontier().activate(*i);
+    }
+    m_halo->exchange(g, g.changed(), g.frontier());
+    m_halo->refresh(g, g.frontier(), m_interactionSets);
+    exchangeTime += MPI_Wtime() - stepTime;
+  }
+
+  g.setHalo(0);
+  g.frontier().reset(g.size(), true);
+
+  return converged;
+}
+
+/**
+ * @brief Places the per-processor data on the NUMA domains of the hosts, for
+ *        the multithreaded computations.
+ *
+ * The threads are pinned to the domains, and the computations place the
+ * nodes and the interaction sets next to the threads which reduce them.
+ * The profile of every computation then reports the fraction of the
+ * accesses to the nodes which were local to the domains of the threads.
+ * This has to be enabled on all the processors.
+ */
+void
+GraphCompute::enableNumaPlacement(
+)
+{
+  NumaPlacement::pinThreads();
+  m_numaPlacement = true;
+}
+
+/**
+ * @brief Counts the hardware events of the processors in the phases of the
+ *        computations, which are reported next to their times.
+ *
+ * Cycles, instructions, last level cache read misses, data TLB misses and
+ * branch misses are counted in user space, through the Linux perf_event_open
+ * interface. Every OpenMP thread opens its own counters, so the threads of
+ * a pool which was started before are counted as well, as long as the
+ * runtime keeps them for the later parallel regions. Events which the
+ * system doesn't allow to count are left out. This has to be enabled on all
+ * the processors.
+ */
+void
+GraphCompute::enablePerfCounters(
+)
+{
+  m_perfCounters.reset(new PerfCounters());
+}
+
+/**
+ * @brief Keeps the payloads of the remote nodes of the interaction sets in
+ *        a cache, through which they are filled in by the later computations.
+ *
+ * @param capacity   Number of remote nodes held by the cache.
+ *
+ * Only the nodes whose payloads changed since they were cached are pushed
+ * by their owners again, and the initial ghosts of the iterative
+ * computations come from the cache as well. The payloads follow the
+ * versions of the nodes, so that payloads written directly into the nodes
+ * aren't seen by the cache. The cache is kept for one graph, is emptied when
+ * its nodes are rebalanced, and is emptied if enabled again.
+ */
+void
+GraphCompute::enableRemoteCache(
+  const unsigned int capacity
+)
+{
+  m_remoteCache.reset(new RemoteCache(capacity, m_mpiCommunicator));
+}
+
+/**
+ * @brief Cache of the remote nodes, or 0 if it isn't enabled.
+ */
+const RemoteCache*
+GraphCompute::remoteCache(
+) const
+{
+  return m_remoteCache.get();
+}
+
 GraphCompute::~GraphCompute(
 )
 {
@@ -1,13 +1,46 @@
 #include "Graph.hpp"
 
+const Graph::Node::IndexType Graph::Node::s_invalidIndex;
+
+Graph::Node::Node(
+) : m_index(s_invalidIndex),
+  m_parent(s_invalidIndex),
+  m_numChildren(0),
+  m_level(0),
+  m_payload()
+{
+}
+
 Graph::Node::Node(
-) : m_index(-1)
+  const IndexType index
+) : m_index(index),
+  m_parent(s_invalidIndex),
+  m_numChildren(0),
+  m_level(0),
+  m_payload()
+{
+}
+
+Graph::Node::Node(
+  const IndexType index,
+  const IndexType parent,
+  const unsigned int numChildren,
+  const unsigned int level
+) : m_index(index),
+  m_parent(parent),
+  m_numChildren(numChildren),
+  m_level(level),
+  m_payload()
 {
 }
 
 Graph::Node::Node(
   const Node& node
-) : m_index(node.index())
+) : m_index(node.index()),
+  m_parent(node.parent()),
+  m_numChildren(node.numChildren()),
+  m_level(node.level()),
+  m_payload(node.payload())
 {
 }
 
@@ -18,38 +51,73 @@ Graph::Node::index(
   return m_index;
 }
 
+Graph::Node::IndexType
+Graph::Node::parent(
+) const
+{
+  return m_parent;
+}
+
+unsigned int
+Graph::Node::level(
+) const
+{
+  return m_level;
+}
+
 bool
 Graph::Node::isRoot(
 ) const
 {
-  return false;
+  return (m_parent == s_invalidIndex);
 }
 
 bool
 Graph::Node::isLeaf(
 ) const
 {
-  return false;
+  return (m_numChildren == 0);
 }
+
+/**
+ * @brief Checks if this node is the parent of the given node.
+ */
 bool
 Graph::Node::isParent(
-  const Node&
+  const Node& node
 ) const
 {
-  return false;
+  return (node.parent() == m_index);
 }
 
+/**
+ * @brief Checks if this node is a child of the given node.
+ */
 bool
 Graph::Node::isChild(
-  const Node&
+  const Node& node
 ) const
 {
-  return false;
+  return (m_parent == node.index());
 }
 
 unsigned int
 Graph::Node::numChildren(
 ) const
 {
-  return 0;
+  return m_numChildren;
+}
+
+Graph::Node::PayloadType&
+Graph::Node::payload(
+)
+{
+  return m_payload;
+}
+
+const Graph::Node::PayloadType&
+Graph::Node::payload(
+) const
+{
+  return m_payload;
 }
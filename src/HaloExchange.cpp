@@ -0,0 +1,937 @@
+#include "HaloExchange.hpp"
+
+#include "Frontier.hpp"
+#include "MPICommunicator.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+const int s_haloTag = 0x4858;
+
+} // namespace
+
+/**
+ * @brief Collects the ghosts of the given interaction sets, and subscribes
+ *        to their updates at their owners.
+ *
+ * @param g                 Graph over which the interaction sets are defined.
+ * @param interactionSets   Interaction sets of the local nodes. An empty list,
+ *                          as generated for local computations, is treated as
+ *                          empty interaction sets.
+ *
+ * This is a collective call.
+ */
+HaloExchange::HaloExchange(
+  const Graph& g,
+  const std::vector<std::vector<Graph::Node> >& interactionSets
+) : HaloExchange(g, interactionSets, collectRequests(g, interactionSets))
+{
+}
+
+/**
+ * @brief Subscribes to the updates of the given ghosts at their owners.
+ *
+ * @param g                 Graph over which the interaction sets are defined.
+ * @param interactionSets   Interaction sets of the local nodes.
+ * @param requests          Remote nodes of the interaction sets for every
+ *                          owner, sorted and without repetitions, as built
+ *                          along with normalized interaction sets.
+ *
+ * This is a collective call.
+ */
+HaloExchange::HaloExchange(
+  const Graph& g,
+  const std::vector<std::vector<Graph::Node> >& interactionSets,
+  const std::vector<std::vector<IndexType> >& requests
+) : m_mpiCommunicator(g.communicator()),
+  m_numLocal(g.size()),
+  m_ghostIndices(),
+  m_ghostOffsets(g.communicator().size() + 1, 0),
+  m_ghostPayloads(),
+  m_setOffsets(g.size() + 1, 0),
+  m_setSources(),
+  m_setTargets(),
+  m_referenceOffsets(),
+  m_references(),
+  m_sendOffsets(g.communicator().size() + 1, 0),
+  m_sendIndices(),
+  m_numSourceRanks(g.size(), 0),
+  m_dependentOffsets(),
+  m_dependents(),
+  m_receiveRanks(),
+  m_receiveRequests(),
+  m_receiveBuffers(),
+  m_sendRanks(),
+  m_sendRequests(),
+  m_sendBuffers(),
+  m_numReceiving(0)
+{
+  const unsigned int numSets = std::min(m_numLocal, static_cast<unsigned int>(interactionSets.size()));
+  for (unsigned int i = 0; i < m_numLocal; ++i) {
+    m_setOffsets[i + 1] = m_setOffsets[i] + ((i < numSets) ? static_cast<unsigned int>(interactionSets[i].size()) : 0);
+  }
+
+  // The ghosts are sorted by their owners, so that the ghosts of every
+  // owner are contiguous.
+  const unsigned int numProcs = m_mpiCommunicator.size();
+  if (requests.size() != numProcs) {
+    throw std::runtime_error("Ghosts have to be requested from every processor!");
+  }
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    m_ghostIndices.insert(m_ghostIndices.end(), requests[p].begin(), requests[p].end());
+    m_ghostOffsets[p + 1] = static_cast<unsigned int>(m_ghostIndices.size());
+  }
+  m_ghostPayloads.resize(m_ghostIndices.size());
+
+  // Map every interaction set entry to the extended index of its source.
+  m_setSources.resize(m_setOffsets[m_numLocal]);
+  m_setTargets.resize(m_setOffsets[m_numLocal]);
+  for (unsigned int i = 0; i < numSets; ++i) {
+    for (unsigned int j = 0; j < interactionSets[i].size(); ++j) {
+      const Graph::Node& n = interactionSets[i][j];
+      unsigned int source;
+      if (g.isLocal(n.index())) {
+        source = g.localIndex(n.index());
+      }
+      else {
+        source = m_numLocal + static_cast<unsigned int>(std::lower_bound(m_ghostIndices.begin(), m_ghostIndices.end(), n.index(), Graph::OwnerOrder(g)) - m_ghostIndices.begin());
+        m_ghostPayloads[source - m_numLocal] = n.payload();
+      }
+      m_setSources[m_setOffsets[i] + j] = source;
+      m_setTargets[m_setOffsets[i] + j] = i;
+    }
+  }
+
+  mapReferences();
+
+  // Subscribe to the ghosts at their owners, with the sorted ghosts of
+  // every owner sent as a compressed list.
+  std::vector<unsigned char> encodedRequests;
+  std::vector<int> requestBytes(numProcs, 0);
+  std::vector<int> requestDispls(numProcs, 0);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    requestDispls[p] = static_cast<int>(encodedRequests.size());
+    CompressedIndexLists<IndexType>::encode(requests[p].empty() ? 0 : &requests[p][0], static_cast<unsigned int>(requests[p].size()), encodedRequests);
+    requestBytes[p] = static_cast<int>(encodedRequests.size()) - requestDispls[p];
+  }
+  std::vector<int> subscribedBytes(numProcs, 0);
+  MPI_Alltoall(&requestBytes[0], 1, MPI_INT, &subscribedBytes[0], 1, MPI_INT, *m_mpiCommunicator);
+  std::vector<int> subscribedDispls(numProcs, 0);
+  for (unsigned int p = 1; p < numProcs; ++p) {
+    subscribedDispls[p] = subscribedDispls[p - 1] + subscribedBytes[p - 1];
+  }
+  std::vector<unsigned char> subscribed(subscribedDispls[numProcs - 1] + subscribedBytes[numProcs - 1]);
+  MPI_Alltoallv(&encodedRequests[0], &requestBytes[0], &requestDispls[0], MPI_BYTE,
+                &subscribed[0], &subscribedBytes[0], &subscribedDispls[0], MPI_BYTE, *m_mpiCommunicator);
+
+  std::vector<IndexType> indices;
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    CompressedIndexLists<IndexType>::decode(&subscribed[subscribedDispls[p]], indices);
+    m_sendOffsets[p + 1] = m_sendOffsets[p] + static_cast<unsigned int>(indices.size());
+    for (std::vector<IndexType>::const_iterator index = indices.begin(); index != indices.end(); ++index) {
+      m_sendIndices.push_back(g.localIndex(*index));
+    }
+  }
+
+  connect();
+}
+
+/**
+ * @brief Brings the halo up to date with interaction sets which changed
+ *        their members, and with the nodes added since it was built.
+ *
+ * @param g                 Graph over which the halo was built, with the
+ *                          later updates applied.
+ * @param interactionSets   Interaction sets of all the local nodes.
+ * @param changed           Local nodes whose interaction sets changed. The
+ *                          added nodes are taken as changed as well.
+ *
+ * Only the ghosts which are no longer referred to, and the ones which are
+ * referred to for the first time, are unsubscribed and subscribed at their
+ * owners, which send along the payloads of the new ghosts. The entries of
+ * the unchanged interaction sets keep their sources, renumbered for the new
+ * ghosts; the changed interaction sets have to be refreshed afterwards.
+ * This is a collective call.
+ */
+void
+HaloExchange::update(
+  const Graph& g,
+  const std::vector<std::vector<Graph::Node> >& interactionSets,
+  const std::vector<unsigned int>& changed
+)
+{
+  const unsigned int numProcs = m_mpiCommunicator.size();
+  const unsigned int numLocal = g.size();
+  const unsigned int numOldGhosts = numGhosts();
+  if (interactionSets.size() != numLocal) {
+    throw std::runtime_error("Halo needs the interaction sets of all the local nodes!");
+  }
+  std::vector<char> isChanged(numLocal, 0);
+  for (std::vector<unsigned int>::const_iterator i = changed.begin(); i != changed.end(); ++i) {
+    isChanged[*i] = 1;
+  }
+  for (unsigned int i = m_numLocal; i < numLocal; ++i) {
+    isChanged[i] = 1;
+  }
+
+  // Count the references which remain to every ghost, and collect the remote
+  // nodes which aren't ghosts yet.
+  const Graph::OwnerOrder order(g);
+  std::vector<unsigned int> numKept(numOldGhosts, 0);
+  for (unsigned int ghost = 0; ghost < numOldGhosts; ++ghost) {
+    numKept[ghost] = numReferences(m_numLocal + ghost);
+  }
+  std::vector<IndexType> added;
+  for (unsigned int i = 0; i < numLocal; ++i) {
+    if (!isChanged[i]) {
+      continue;
+    }
+    if (i < m_numLocal) {
+      for (unsigned int e = m_setOffsets[i]; e < m_setOffsets[i + 1]; ++e) {
+        if (m_setSources[e] >= m_numLocal) {
+          --numKept[m_setSources[e] - m_numLocal];
+        }
+      }
+    }
+    for (std::vector<Graph::Node>::const_iterator n = interactionSets[i].begin(); n != interactionSets[i].end(); ++n) {
+      if (g.isLocal(n->index())) {
+        continue;
+      }
+      std::vector<IndexType>::const_iterator ghost = std::lower_bound(m_ghostIndices.begin(), m_ghostIndices.end(), n->index(), order);
+      if ((ghost != m_ghostIndices.end()) && (*ghost == n->index())) {
+        ++numKept[ghost - m_ghostIndices.begin()];
+      }
+      else {
+        added.push_back(n->index());
+      }
+    }
+  }
+  std::sort(added.begin(), added.end(), order);
+  added.erase(std::unique(added.begin(), added.end()), added.end());
+
+  // Merge the kept and the added ghosts, which are both sorted by their owners.
+  std::vector<IndexType> ghostIndices;
+  std::vector<unsigned int> renumbered(numOldGhosts, 0);
+  std::vector<std::vector<IndexType> > subscriptions(numProcs);
+  std::vector<std::vector<IndexType> > cancellations(numProcs);
+  ghostIndices.reserve(numOldGhosts + added.size());
+  std::vector<IndexType>::const_iterator a = added.begin();
+  for (unsigned int ghost = 0; ghost <= numOldGhosts; ++ghost) {
+    const bool last = (ghost == numOldGhosts);
+    for (; (a != added.end()) && (last || order(*a, m_ghostIndices[ghost])); ++a) {
+      subscriptions[g.owner(*a)].push_back(*a);
+      ghostIndices.push_back(*a);
+    }
+    if (last) {
+      break;
+    }
+    if (numKept[ghost] > 0) {
+      renumbered[ghost] = static_cast<unsigned int>(ghostIndices.size());
+      ghostIndices.push_back(m_ghostIndices[ghost]);
+    }
+    else {
+      cancellations[g.owner(m_ghostIndices[ghost])].push_back(m_ghostIndices[ghost]);
+    }
+  }
+
+  // Send the changes of the subscriptions to the owners, as two compressed
+  // lists for every owner.
+  std::vector<unsigned char> encodedChanges;
+  std::vector<int> changeBytes(numProcs, 0);
+  std::vector<int> changeDispls(numProcs, 0);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    changeDispls[p] = static_cast<int>(encodedChanges.size());
+    CompressedIndexLists<IndexType>::encode(subscriptions[p].empty() ? 0 : &subscriptions[p][0], static_cast<unsigned int>(subscriptions[p].size()), encodedChanges);
+    CompressedIndexLists<IndexType>::encode(cancellations[p].empty() ? 0 : &cancellations[p][0], static_cast<unsigned int>(cancellations[p].size()), encodedChanges);
+    changeBytes[p] = static_cast<int>(encodedChanges.size()) - changeDispls[p];
+  }
+  std::vector<int> receivedBytes(numProcs, 0);
+  MPI_Alltoall(&changeBytes[0], 1, MPI_INT, &receivedBytes[0], 1, MPI_INT, *m_mpiCommunicator);
+  std::vector<int> receivedDispls(numProcs, 0);
+  for (unsigned int p = 1; p < numProcs; ++p) {
+    receivedDispls[p] = receivedDispls[p - 1] + receivedBytes[p - 1];
+  }
+  std::vector<unsigned char> received(receivedDispls[numProcs - 1] + receivedBytes[numProcs - 1]);
+  MPI_Alltoallv(&encodedChanges[0], &changeBytes[0], &changeDispls[0], MPI_BYTE,
+                &received[0], &receivedBytes[0], &receivedDispls[0], MPI_BYTE, *m_mpiCommunicator);
+
+  // Apply the changes to the sorted subscriptions of every processor, and
+  // answer the new subscriptions with the current payloads.
+  std::vector<unsigned int> sendOffsets(numProcs + 1, 0);
+  std::vector<unsigned int> sendIndices;
+  std::vector<PayloadType> replies;
+  std::vector<int> replyBytes(numProcs, 0);
+  std::vector<int> replyDispls(numProcs, 0);
+  std::vector<IndexType> subscribed;
+  std::vector<IndexType> cancelled;
+  std::vector<unsigned int> dropped;
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    const unsigned char* encoded = &received[receivedDispls[p]];
+    encoded = CompressedIndexLists<IndexType>::decode(encoded, subscribed);
+    CompressedIndexLists<IndexType>::decode(encoded, cancelled);
+    dropped.clear();
+    for (std::vector<IndexType>::const_iterator c = cancelled.begin(); c != cancelled.end(); ++c) {
+      dropped.push_back(g.localIndex(*c));
+    }
+    replyDispls[p] = static_cast<int>(replies.size() * sizeof(PayloadType));
+    std::vector<unsigned int>::const_iterator d = dropped.begin();
+    std::vector<IndexType>::const_iterator n = subscribed.begin();
+    for (unsigned int k = m_sendOffsets[p]; k <= m_sendOffsets[p + 1]; ++k) {
+      const bool last = (k == m_sendOffsets[p + 1]);
+      for (; (n != subscribed.end()) && (last || (g.localIndex(*n) < m_sendIndices[k])); ++n) {
+        sendIndices.push_back(g.localIndex(*n));
+        replies.push_back((g.begin() + sendIndices.back())->payload());
+      }
+      if (last) {
+        break;
+      }
+      if ((d != dropped.end()) && (*d == m_sendIndices[k])) {
+        ++d;
+      }
+      else {
+        sendIndices.push_back(m_sendIndices[k]);
+      }
+    }
+    sendOffsets[p + 1] = static_cast<unsigned int>(sendIndices.size());
+    replyBytes[p] = static_cast<int>(replies.size() * sizeof(PayloadType)) - replyDispls[p];
+  }
+  m_sendOffsets.swap(sendOffsets);
+  m_sendIndices.swap(sendIndices);
+
+  std::vector<int> answerBytes(numProcs, 0);
+  std::vector<int> answerDispls(numProcs, 0);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    answerBytes[p] = static_cast<int>(subscriptions[p].size() * sizeof(PayloadType));
+    answerDispls[p] = (p > 0) ? answerDispls[p - 1] + answerBytes[p - 1] : 0;
+  }
+  std::vector<PayloadType> answers(added.size());
+  MPI_Alltoallv(replies.empty() ? 0 : &replies[0], &replyBytes[0], &replyDispls[0], MPI_BYTE,
+                answers.empty() ? 0 : &answers[0], &answerBytes[0], &answerDispls[0], MPI_BYTE, *m_mpiCommunicator);
+
+  // The answers arrive in the order of the added ghosts.
+  std::vector<unsigned int> ghostOffsets(numProcs + 1, 0);
+  std::vector<PayloadType> ghostPayloads(ghostIndices.size());
+  for (unsigned int ghost = 0; ghost < numOldGhosts; ++ghost) {
+    if (numKept[ghost] > 0) {
+      ghostPayloads[renumbered[ghost]] = m_ghostPayloads[ghost];
+    }
+  }
+  std::vector<PayloadType>::const_iterator answer = answers.begin();
+  a = added.begin();
+  for (unsigned int ghost = 0; ghost < ghostIndices.size(); ++ghost) {
+    if ((a != added.end()) && (*a == ghostIndices[ghost])) {
+      ghostPayloads[ghost] = *answer++;
+      ++a;
+    }
+    ++ghostOffsets[g.owner(ghostIndices[ghost]) + 1];
+  }
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    ghostOffsets[p + 1] += ghostOffsets[p];
+  }
+
+  // Map the entries to their sources again, renumbering the ghosts of the
+  // unchanged interaction sets.
+  std::vector<unsigned int> setOffsets(numLocal + 1, 0);
+  std::vector<unsigned int> setSources;
+  std::vector<unsigned int> setTargets;
+  setSources.reserve(m_setSources.size());
+  setTargets.reserve(m_setTargets.size());
+  for (unsigned int i = 0; i < numLocal; ++i) {
+    if (!isChanged[i]) {
+      for (unsigned int e = m_setOffsets[i]; e < m_setOffsets[i + 1]; ++e) {
+        const unsigned int source = m_setSources[e];
+        setSources.push_back((source < m_numLocal) ? source : numLocal + renumbered[source - m_numLocal]);
+        setTargets.push_back(i);
+      }
+    }
+    else {
+      for (std::vector<Graph::Node>::const_iterator n = interactionSets[i].begin(); n != interactionSets[i].end(); ++n) {
+        if (g.isLocal(n->index())) {
+          setSources.push_back(g.localIndex(n->index()));
+        }
+        else {
+          setSources.push_back(numLocal + static_cast<unsigned int>(std::lower_bound(ghostIndices.begin(), ghostIndices.end(), n->index(), order) - ghostIndices.begin()));
+        }
+        setTargets.push_back(i);
+      }
+    }
+    setOffsets[i + 1] = static_cast<unsigned int>(setSources.size());
+  }
+
+  m_numLocal = numLocal;
+  m_ghostIndices.swap(ghostIndices);
+  m_ghostOffsets.swap(ghostOffsets);
+  m_ghostPayloads.swap(ghostPayloads);
+  m_setOffsets.swap(setOffsets);
+  m_setSources.swap(setSources);
+  m_setTargets.swap(setTargets);
+  mapReferences();
+  connect();
+}
+
+/**
+ * @brief Lists the interaction set entries of every source, by inverting
+ *        the sources of the entries.
+ */
+void
+HaloExchange::mapReferences(
+)
+{
+  m_referenceOffsets.assign(numExtended() + 1, 0);
+  for (std::vector<unsigned int>::const_iterator s = m_setSources.begin(); s != m_setSources.end(); ++s) {
+    ++m_referenceOffsets[*s + 1];
+  }
+  for (unsigned int s = 0; s < numExtended(); ++s) {
+    m_referenceOffsets[s + 1] += m_referenceOffsets[s];
+  }
+  m_references.resize(m_setSources.size());
+  std::vector<unsigned int> cursors(m_referenceOffsets.begin(), m_referenceOffsets.end() - 1);
+  for (unsigned int e = 0; e < m_setSources.size(); ++e) {
+    m_references[cursors[m_setSources[e]]++] = e;
+  }
+}
+
+/**
+ * @brief Finds the neighbors which are received from and sent to, along
+ *        with the boundary nodes which depend on every neighbor.
+ */
+void
+HaloExchange::connect(
+)
+{
+  const unsigned int numProcs = m_mpiCommunicator.size();
+  m_receiveRanks.clear();
+  m_sendRanks.clear();
+  m_numSourceRanks.assign(m_numLocal, 0);
+
+  // Neighbors from which ghosts are received, and to which updates are sent.
+  std::vector<unsigned int> receiveSlots(numProcs, 0);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    if (m_ghostOffsets[p + 1] > m_ghostOffsets[p]) {
+      receiveSlots[p] = static_cast<unsigned int>(m_receiveRanks.size());
+      m_receiveRanks.push_back(p);
+    }
+    if (m_sendOffsets[p + 1] > m_sendOffsets[p]) {
+      m_sendRanks.push_back(p);
+    }
+  }
+  m_receiveRequests.assign(m_receiveRanks.size(), MPI_REQUEST_NULL);
+  m_receiveBuffers.resize(m_receiveRanks.size());
+  for (unsigned int r = 0; r < m_receiveRanks.size(); ++r) {
+    m_receiveBuffers[r].resize(m_ghostOffsets[m_receiveRanks[r] + 1] - m_ghostOffsets[m_receiveRanks[r]]);
+  }
+  m_sendRequests.assign(m_sendRanks.size(), MPI_REQUEST_NULL);
+  m_sendBuffers.resize(m_sendRanks.size());
+
+  // Boundary nodes are the ones with ghosts in their interaction sets. List
+  // them per neighbor which owns any of their ghosts.
+  std::vector<std::pair<unsigned int, unsigned int> > dependencies;
+  std::vector<unsigned int> slots;
+  for (unsigned int i = 0; i < m_numLocal; ++i) {
+    slots.clear();
+    for (unsigned int e = m_setOffsets[i]; e < m_setOffsets[i + 1]; ++e) {
+      if (m_setSources[e] >= m_numLocal) {
+        const unsigned int ghost = m_setSources[e] - m_numLocal;
+        const unsigned int p = static_cast<unsigned int>(std::upper_bound(m_ghostOffsets.begin(), m_ghostOffsets.end(), ghost) - m_ghostOffsets.begin()) - 1;
+        slots.push_back(receiveSlots[p]);
+      }
+    }
+    std::sort(slots.begin(), slots.end());
+    slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+    m_numSourceRanks[i] = static_cast<unsigned int>(slots.size());
+    for (std::vector<unsigned int>::const_iterator r = slots.begin(); r != slots.end(); ++r) {
+      dependencies.push_back(std::make_pair(*r, i));
+    }
+  }
+  std::sort(dependencies.begin(), dependencies.end());
+  m_dependentOffsets.assign(m_receiveRanks.size() + 1, 0);
+  m_dependents.resize(dependencies.size());
+  for (unsigned int d = 0; d < dependencies.size(); ++d) {
+    ++m_dependentOffsets[dependencies[d].first + 1];
+    m_dependents[d] = dependencies[d].second;
+  }
+  for (unsigned int r = 0; r < m_receiveRanks.size(); ++r) {
+    m_dependentOffsets[r + 1] += m_dependentOffsets[r];
+  }
+}
+
+/**
+ * @brief Lists the remote nodes of the interaction sets for every owner.
+ *
+ * @return Sorted global indices of the remote nodes, without repetitions,
+ *         for every processor.
+ */
+std::vector<std::vector<HaloExchange::IndexType> >
+HaloExchange::collectRequests(
+  const Graph& g,
+  const std::vector<std::vector<Graph::Node> >& interactionSets
+)
+{
+  std::vector<std::vector<IndexType> > requests(g.communicator().size());
+  for (std::vector<std::vector<Graph::Node> >::const_iterator set = interactionSets.begin(); set != interactionSets.end(); ++set) {
+    for (std::vector<Graph::Node>::const_iterator n = set->begin(); n != set->end(); ++n) {
+      if (!g.isLocal(n->index())) {
+        requests[g.owner(n->index())].push_back(n->index());
+      }
+    }
+  }
+  for (unsigned int p = 0; p < requests.size(); ++p) {
+    std::sort(requests[p].begin(), requests[p].end());
+    requests[p].erase(std::unique(requests[p].begin(), requests[p].end()), requests[p].end());
+  }
+  return requests;
+}
+
+unsigned int
+HaloExchange::numLocal(
+) const
+{
+  return m_numLocal;
+}
+
+unsigned int
+HaloExchange::numGhosts(
+) const
+{
+  return static_cast<unsigned int>(m_ghostIndices.size());
+}
+
+/**
+ * @brief Number of local nodes and ghosts together.
+ */
+unsigned int
+HaloExchange::numExtended(
+) const
+{
+  return m_numLocal + numGhosts();
+}
+
+HaloExchange::IndexType
+HaloExchange::ghostIndex(
+  const unsigned int ghost
+) const
+{
+  return m_ghostIndices[ghost];
+}
+
+/**
+ * @brief Extended index of a node given its global index.
+ *
+ * @param g       Graph over which the halo was built.
+ * @param index   Global index of the node.
+ *
+ * @return Extended index of the node, or numExtended() if the node is
+ *         neither local nor a ghost.
+ */
+unsigned int
+HaloExchange::extendedIndex(
+  const Graph& g,
+  const IndexType index
+) const
+{
+  if (g.isLocal(index)) {
+    const unsigned int i = g.localIndex(index);
+    return (i < m_numLocal) ? i : numExtended();
+  }
+  std::vector<IndexType>::const_iterator ghost = std::lower_bound(m_ghostIndices.begin(), m_ghostIndices.end(), index, Graph::OwnerOrder(g));
+  if ((ghost == m_ghostIndices.end()) || (*ghost != index)) {
+    return numExtended();
+  }
+  return m_numLocal + static_cast<unsigned int>(ghost - m_ghostIndices.begin());
+}
+
+/**
+ * @brief Extended index of the source of an interaction set entry.
+ *
+ * @param i   Local index of the node owning the interaction set.
+ * @param j   Position of the entry in the interaction set.
+ */
+unsigned int
+HaloExchange::source(
+  const unsigned int i,
+  const unsigned int j
+) const
+{
+  return m_setSources[m_setOffsets[i] + j];
+}
+
+/**
+ * @brief Number of interaction set entries with the given source.
+ *
+ * @param s   Extended index of the source.
+ */
+unsigned int
+HaloExchange::numReferences(
+  const unsigned int s
+) const
+{
+  return m_referenceOffsets[s + 1] - m_referenceOffsets[s];
+}
+
+/**
+ * @brief Interaction set entries with the given source, as opaque entry
+ *        identifiers to be resolved with referenceTarget and referenceSlot.
+ *
+ * @param s   Extended index of the source.
+ */
+const unsigned int*
+HaloExchange::references(
+  const unsigned int s
+) const
+{
+  return m_references.empty() ? 0 : &m_references[0] + m_referenceOffsets[s];
+}
+
+/**
+ * @brief Local index of the node owning the interaction set of an entry.
+ */
+unsigned int
+HaloExchange::referenceTarget(
+  const unsigned int e
+) const
+{
+  return m_setTargets[e];
+}
+
+/**
+ * @brief Position of an entry in its interaction set.
+ */
+unsigned int
+HaloExchange::referenceSlot(
+  const unsigned int e
+) const
+{
+  return e - m_setOffsets[m_setTargets[e]];
+}
+
+/**
+ * @brief Current payload of a local node or a ghost.
+ *
+ * @param g   Graph over which the halo was built.
+ * @param s   Extended index of the node.
+ */
+HaloExchange::PayloadType
+HaloExchange::payload(
+  const Graph& g,
+  const unsigned int s
+) const
+{
+  return (s < m_numLocal) ? (g.begin() + s)->payload() : m_ghostPayloads[s - m_numLocal];
+}
+
+/**
+ * @brief Sends the payloads of the changed local nodes to their subscribers,
+ *        and receives the changed ghosts.
+ *
+ * @param g         Graph over which the halo was built.
+ * @param changed   Changed local nodes.
+ * @param updated   Frontier over the extended indices, in which the received
+ *                  ghosts are activated.
+ *
+ * Only the changed payloads are sent, each tagged with its position in the
+ * subscription list of the receiver. This is a collective call.
+ */
+void
+HaloExchange::exchange(
+  const Graph& g,
+  const Frontier& changed,
+  Frontier& updated
+)
+{
+  const unsigned int numProcs = m_mpiCommunicator.size();
+  std::vector<Update> sendBuffer;
+  sendBuffer.reserve(changed.isFull() ? m_sendIndices.size() : std::min(m_sendIndices.size(), static_cast<size_t>(changed.numActive()) * numProcs));
+  std::vector<int> sendCounts(numProcs, 0);
+  std::vector<int> sendDispls(numProcs, 0);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    sendDispls[p] = static_cast<int>(sendBuffer.size() * sizeof(Update));
+    for (unsigned int k = m_sendOffsets[p]; k < m_sendOffsets[p + 1]; ++k) {
+      if (changed.isActive(m_sendIndices[k])) {
+        Update update;
+        update.m_position = k - m_sendOffsets[p];
+        update.m_value = payload(g, m_sendIndices[k]);
+        sendBuffer.push_back(update);
+      }
+    }
+    sendCounts[p] = static_cast<int>(sendBuffer.size() * sizeof(Update)) - sendDispls[p];
+  }
+
+  std::vector<int> receiveCounts(numProcs, 0);
+  MPI_Alltoall(&sendCounts[0], 1, MPI_INT, &receiveCounts[0], 1, MPI_INT, *m_mpiCommunicator);
+  std::vector<int> receiveDispls(numProcs, 0);
+  for (unsigned int p = 1; p < numProcs; ++p) {
+    receiveDispls[p] = receiveDispls[p - 1] + receiveCounts[p - 1];
+  }
+  std::vector<Update> receiveBuffer((receiveDispls[numProcs - 1] + receiveCounts[numProcs - 1]) / sizeof(Update));
+  MPI_Alltoallv(sendBuffer.empty() ? 0 : &sendBuffer[0], &sendCounts[0], &sendDispls[0], MPI_BYTE,
+                receiveBuffer.empty() ? 0 : &receiveBuffer[0], &receiveCounts[0], &receiveDispls[0], MPI_BYTE, *m_mpiCommunicator);
+
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    const unsigned int begin = receiveDispls[p] / sizeof(Update);
+    const unsigned int end = begin + receiveCounts[p] / sizeof(Update);
+    for (unsigned int u = begin; u < end; ++u) {
+      const unsigned int ghost = m_ghostOffsets[p] + receiveBuffer[u].m_position;
+      m_ghostPayloads[ghost] = receiveBuffer[u].m_value;
+      updated.activate(m_numLocal + ghost);
+    }
+  }
+}
+
+/**
+ * @brief Takes the payloads of the ghosts from interaction sets which were
+ *        filled in otherwise, instead of exchanging all of them.
+ *
+ * @param interactionSets   Interaction sets over which the halo was built.
+ */
+void
+HaloExchange::load(
+  const std::vector<std::vector<Graph::Node> >& interactionSets
+)
+{
+  for (unsigned int ghost = 0; ghost < m_ghostPayloads.size(); ++ghost) {
+    const unsigned int s = m_numLocal + ghost;
+    if (m_referenceOffsets[s] < m_referenceOffsets[s + 1]) {
+      const unsigned int e = m_references[m_referenceOffsets[s]];
+      m_ghostPayloads[ghost] = interactionSets[m_setTargets[e]][referenceSlot(e)].payload();
+    }
+  }
+}
+
+/**
+ * @brief Copies the current payloads of the given sources into all the
+ *        interaction set entries which refer to them.
+ *
+ * @param g                 Graph over which the halo was built.
+ * @param sources           Frontier of the sources over the extended indices.
+ * @param interactionSets   Interaction sets over which the halo was built.
+ */
+void
+HaloExchange::refresh(
+  const Graph& g,
+  const Frontier& sources,
+  std::vector<std::vector<Graph::Node> >& interactionSets
+) const
+{
+  if (sources.isFull()) {
+    for (unsigned int e = 0; e < m_setSources.size(); ++e) {
+      interactionSets[m_setTargets[e]][referenceSlot(e)].payload() = payload(g, m_setSources[e]);
+    }
+    return;
+  }
+
+  refresh(g, sources.active(), interactionSets);
+}
+
+/**
+ * @brief Copies the current payloads of the listed sources into all the
+ *        interaction set entries which refer to them.
+ *
+ * @param g                 Graph over which the halo was built.
+ * @param sources           Extended indices of the sources.
+ * @param interactionSets   Interaction sets over which the halo was built.
+ */
+void
+HaloExchange::refresh(
+  const Graph& g,
+  const std::vector<unsigned int>& sources,
+  std::vector<std::vector<Graph::Node> >& interactionSets
+) const
+{
+  for (std::vector<unsigned int>::const_iterator s = sources.begin(); s != sources.end(); ++s) {
+    const PayloadType value = payload(g, *s);
+    for (unsigned int r = m_referenceOffsets[*s]; r < m_referenceOffsets[*s + 1]; ++r) {
+      const unsigned int e = m_references[r];
+      interactionSets[m_setTargets[e]][referenceSlot(e)].payload() = value;
+    }
+  }
+}
+
+/**
+ * @brief Copies the current payloads of the sources of one interaction set
+ *        into its entries.
+ *
+ * @param g                 Graph over which the halo was built.
+ * @param i                 Local index of the node owning the interaction set.
+ * @param interactionSet    Interaction set with the same members as the one
+ *                          over which the halo was built.
+ */
+void
+HaloExchange::refresh(
+  const Graph& g,
+  const unsigned int i,
+  std::vector<Graph::Node>& interactionSet
+) const
+{
+  for (unsigned int e = m_setOffsets[i]; e < m_setOffsets[i + 1]; ++e) {
+    interactionSet[e - m_setOffsets[i]].payload() = payload(g, m_setSources[e]);
+  }
+}
+
+/**
+ * @brief Whether the interaction set of a local node has any ghosts.
+ */
+bool
+HaloExchange::isBoundary(
+  const unsigned int i
+) const
+{
+  return m_numSourceRanks[i] > 0;
+}
+
+/**
+ * @brief Number of neighbors owning the ghosts in the interaction set of a
+ *        local node.
+ */
+unsigned int
+HaloExchange::numSourceRanks(
+  const unsigned int i
+) const
+{
+  return m_numSourceRanks[i];
+}
+
+/**
+ * @brief Number of boundary nodes with ghosts owned by a neighbor.
+ *
+ * @param r   Position of the neighbor among the neighbors which are
+ *            received from, as reported by receiveSome.
+ */
+unsigned int
+HaloExchange::numDependents(
+  const unsigned int r
+) const
+{
+  return m_dependentOffsets[r + 1] - m_dependentOffsets[r];
+}
+
+/**
+ * @brief Local indices of the boundary nodes with ghosts owned by a neighbor.
+ */
+const unsigned int*
+HaloExchange::dependents(
+  const unsigned int r
+) const
+{
+  return m_dependents.empty() ? 0 : &m_dependents[0] + m_dependentOffsets[r];
+}
+
+/**
+ * @brief Starts the nonblocking exchange of the changed local nodes.
+ *
+ * @param g         Graph over which the halo was built.
+ * @param changed   Changed local nodes.
+ *
+ * Every neighbor gets one message, possibly empty, so that receivers know
+ * when all their ghosts are up to date. The payloads are copied, so the
+ * local nodes may change while the exchange is in flight. This call, the
+ * following receiveSome calls, and waitSends make up one collective exchange.
+ */
+void
+HaloExchange::post(
+  const Graph& g,
+  const Frontier& changed
+)
+{
+  for (unsigned int r = 0; r < m_receiveRanks.size(); ++r) {
+    MPI_Irecv(m_receiveBuffers[r].empty() ? 0 : &m_receiveBuffers[r][0], static_cast<int>(m_receiveBuffers[r].size() * sizeof(Update)), MPI_BYTE,
+              static_cast<int>(m_receiveRanks[r]), s_haloTag, *m_mpiCommunicator, &m_receiveRequests[r]);
+  }
+  m_numReceiving = static_cast<unsigned int>(m_receiveRanks.size());
+
+  for (unsigned int r = 0; r < m_sendRanks.size(); ++r) {
+    const unsigned int p = m_sendRanks[r];
+    std::vector<Update>& buffer = m_sendBuffers[r];
+    buffer.clear();
+    for (unsigned int k = m_sendOffsets[p]; k < m_sendOffsets[p + 1]; ++k) {
+      if (changed.isActive(m_sendIndices[k])) {
+        Update update;
+        update.m_position = k - m_sendOffsets[p];
+        update.m_value = payload(g, m_sendIndices[k]);
+        buffer.push_back(update);
+      }
+    }
+    MPI_Isend(buffer.empty() ? 0 : &buffer[0], static_cast<int>(buffer.size() * sizeof(Update)), MPI_BYTE,
+              static_cast<int>(p), s_haloTag, *m_mpiCommunicator, &m_sendRequests[r]);
+  }
+}
+
+/**
+ * @brief Whether any of the posted receives is yet to complete.
+ */
+bool
+HaloExchange::isReceiving(
+) const
+{
+  return m_numReceiving > 0;
+}
+
+/**
+ * @brief Completes the posted receives which have arrived, and updates their
+ *        ghosts.
+ *
+ * @param wait      Whether to block until at least one receive completes.
+ * @param updated   Frontier over the extended indices, in which the received
+ *                  ghosts are activated.
+ * @param sources   Extended indices of the received ghosts, appended.
+ * @param ranks     Positions of the neighbors whose messages completed, appended.
+ */
+void
+HaloExchange::receiveSome(
+  const bool wait,
+  Frontier& updated,
+  std::vector<unsigned int>& sources,
+  std::vector<unsigned int>& ranks
+)
+{
+  if (m_numReceiving == 0) {
+    return;
+  }
+
+  std::vector<int> indices(m_receiveRequests.size());
+  std::vector<MPI_Status> statuses(m_receiveRequests.size());
+  int numCompleted = 0;
+  if (wait) {
+    MPI_Waitsome(static_cast<int>(m_receiveRequests.size()), &m_receiveRequests[0], &numCompleted, &indices[0], &statuses[0]);
+  }
+  else {
+    MPI_Testsome(static_cast<int>(m_receiveRequests.size()), &m_receiveRequests[0], &numCompleted, &indices[0], &statuses[0]);
+  }
+  if (numCompleted == MPI_UNDEFINED) {
+    m_numReceiving = 0;
+    return;
+  }
+
+  for (int c = 0; c < numCompleted; ++c) {
+    const unsigned int r = static_cast<unsigned int>(indices[c]);
+    int size;
+    MPI_Get_count(&statuses[c], MPI_BYTE, &size);
+    const unsigned int begin = m_ghostOffsets[m_receiveRanks[r]];
+    for (unsigned int u = 0; u < size / sizeof(Update); ++u) {
+      const unsigned int ghost = begin + m_receiveBuffers[r][u].m_position;
+      m_ghostPayloads[ghost] = m_receiveBuffers[r][u].m_value;
+      updated.activate(m_numLocal + ghost);
+      sources.push_back(m_numLocal + ghost);
+    }
+    ranks.push_back(r);
+  }
+  m_numReceiving -= static_cast<unsigned int>(numCompleted);
+}
+
+/**
+ * @brief Waits until the posted sends complete.
+ */
+void
+HaloExchange::waitSends(
+)
+{
+  if (!m_sendRequests.empty()) {
+    MPI_Waitall(static_cast<int>(m_sendRequests.size()), &m_sendRequests[0], MPI_STATUSES_IGNORE);
+  }
+}
+
+HaloExchange::~HaloExchange(
+)
+{
+}
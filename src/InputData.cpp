@@ -1,38 +1,216 @@
 #include "InputData.hpp"
 
+#include "BlockFile.hpp"
+#include "ExchangeAll.hpp"
 #include "MPICommunicator.hpp"
+#include "SharedMemoryWindow.hpp"
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <fstream>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Finds the bounding box of the points of all the processors, from
+ *        their coordinates, as the lower corner followed by the upper one.
+ *
+ * The maximum is reduced as the minimum of the negation. The box of no
+ * points is empty. This is a collective call.
+ */
+void
+reduceBox(
+  const std::vector<double>& coords,
+  const unsigned int numLocalPoints,
+  const unsigned int numGlobalPoints,
+  const MPICommunicator& mpiCommunicator,
+  double* const box
+)
+{
+  double localBox[6];
+  for (unsigned int d = 0; d < 6; ++d) {
+    localBox[d] = std::numeric_limits<double>::max();
+  }
+  for (unsigned int i = 0; i < numLocalPoints; ++i) {
+    for (unsigned int d = 0; d < 3; ++d) {
+      localBox[d] = std::min(localBox[d], coords[(i * 3) + d]);
+      localBox[d + 3] = std::min(localBox[d + 3], -coords[(i * 3) + d]);
+    }
+  }
+  MPI_Allreduce(localBox, box, 6, MPI_DOUBLE, MPI_MIN, *mpiCommunicator);
+  for (unsigned int d = 0; d < 3; ++d) {
+    box[d + 3] = -box[d + 3];
+  }
+  if (numGlobalPoints == 0) {
+    std::fill(box, box + 6, 0.0);
+  }
+}
+
+} // namespace
 
 InputData::InputData(
+  const bool sharedMemory
 ) : m_points(0),
+  m_bounds(),
   m_numGlobalPoints(0),
-  m_numLocalPoints(0)
+  m_numLocalPoints(0),
+  m_sharedMemory(sharedMemory),
+  m_window(0)
+{
+}
+
+InputData::Bounds::Bounds(
+)
+{
+  for (unsigned int d = 0; d < 3; ++d) {
+    m_lower[d] = 0.0;
+    m_upper[d] = 0.0;
+    m_step[d] = 0.0;
+  }
+}
+
+/**
+ * @brief Constructs the bounds of a data set from its bounding box.
+ *
+ * @param lower   Lower corner of the box.
+ * @param upper   Upper corner of the box.
+ *
+ * The box is split into 2^s_bits - 1 steps along every dimension. A box
+ * without extent along a dimension maps all the coordinates to its lower
+ * corner, which is the case for the empty bounds.
+ */
+InputData::Bounds::Bounds(
+  const double* const lower,
+  const double* const upper
+)
+{
+  const double maxCode = static_cast<double>((1ULL << s_bits) - 1);
+  for (unsigned int d = 0; d < 3; ++d) {
+    m_lower[d] = lower[d];
+    m_upper[d] = upper[d];
+    m_step[d] = (upper[d] > lower[d]) ? ((upper[d] - lower[d]) / maxCode) : 0.0;
+  }
+}
+
+double
+InputData::Bounds::lower(
+  const unsigned int d
+) const
 {
+  return m_lower[d];
+}
+
+double
+InputData::Bounds::upper(
+  const unsigned int d
+) const
+{
+  return m_upper[d];
+}
+
+/**
+ * @brief Distance between consecutive quantized coordinates along a dimension.
+ */
+double
+InputData::Bounds::step(
+  const unsigned int d
+) const
+{
+  return m_step[d];
 }
 
 InputData::Point::Point(
-) : m_x(0.0),
+)
+#if defined(GRAPHWORKS_COORDS_QUANTIZED)
+  : m_code(0)
+#else
+  : m_x(0.0),
   m_y(0.0),
   m_z(0.0)
+#endif
 {
 }
 
+/**
+ * @brief Sets the coordinates, which are rounded to the representation.
+ *
+ * @param bounds   Bounds of the data set of the point.
+ *
+ * Quantized coordinates outside the bounds are clamped to the bounds.
+ */
 void
 InputData::Point::set(
   const double x,
   const double y,
-  const double z
+  const double z,
+  const Bounds& bounds
 )
 {
+#if defined(GRAPHWORKS_COORDS_QUANTIZED)
+  const double coords[3] = {x, y, z};
+  const double maxCode = static_cast<double>((1ULL << Bounds::s_bits) - 1);
+  m_code = 0;
+  for (unsigned int d = 0; d < 3; ++d) {
+    const double step = bounds.step(d);
+    double q = (step > 0.0) ? std::floor(((coords[d] - bounds.lower(d)) / step) + 0.5) : 0.0;
+    q = std::min(std::max(q, 0.0), maxCode);
+    m_code |= static_cast<unsigned long long>(q) << (d * Bounds::s_bits);
+  }
+#elif defined(GRAPHWORKS_COORDS_FLOAT)
+  (void)bounds;
+  m_x = static_cast<float>(x);
+  m_y = static_cast<float>(y);
+  m_z = static_cast<float>(z);
+#else
+  (void)bounds;
   m_x = x;
   m_y = y;
   m_z = z;
+#endif
+}
+
+#if defined(GRAPHWORKS_COORDS_QUANTIZED)
+double
+InputData::Point::coordinate(
+  const unsigned int d,
+  const Bounds& bounds
+) const
+{
+  const unsigned long long q = (m_code >> (d * Bounds::s_bits)) & ((1ULL << Bounds::s_bits) - 1);
+  return bounds.lower(d) + (static_cast<double>(q) * bounds.step(d));
 }
 
 double
 InputData::Point::x(
+  const Bounds& bounds
+) const
+{
+  return coordinate(0, bounds);
+}
+
+double
+InputData::Point::y(
+  const Bounds& bounds
+) const
+{
+  return coordinate(1, bounds);
+}
+
+double
+InputData::Point::z(
+  const Bounds& bounds
+) const
+{
+  return coordinate(2, bounds);
+}
+#else
+double
+InputData::Point::x(
+  const Bounds&
 ) const
 {
   return m_x;
@@ -40,6 +218,7 @@ InputData::Point::x(
 
 double
 InputData::Point::y(
+  const Bounds&
 ) const
 {
   return m_y;
@@ -47,11 +226,35 @@ InputData::Point::y(
 
 double
 InputData::Point::z(
+  const Bounds&
 ) const
 {
   return m_z;
 }
+#endif
 
+/**
+ * @brief Reads the points from a file and distributes them.
+ *
+ * @param fileName          Name of the file with the points.
+ * @param mpiCommunicator   Communicator over which the points are distributed.
+ *
+ * @return true if the points were read successfully.
+ *
+ * The file starts with the number of points, optionally followed on the
+ * same line by the lower and the upper corners of their bounding box, and
+ * then lists the coordinates of the points. The file is read by processor 0,
+ * which converts the points to their representation and sends every
+ * processor its contiguous share of them. When the coordinates are
+ * quantized without the box in the file, processor 0 first reads through
+ * the points for finding it. In the shared memory mode, all the points
+ * of a host are placed in one shared memory window, filled by the first
+ * processor on the host, so that co-located processors can access each
+ * other's points directly.
+ *
+ * Files which start with the header of a BlockFile are read as compressed
+ * records of the three double coordinates instead, by all the processors.
+ */
 bool
 InputData::read(
   const std::string& fileName,
@@ -63,62 +266,322 @@ InputData::read(
 
   std::ifstream inputFile;
 
+  int opened = 1;
+  int compressed = 0;
   if (myRank == 0) {
-    inputFile.open(fileName);
-    if (!inputFile) {
-      return false;
+    compressed = BlockFile::isBlockFile(fileName) ? 1 : 0;
+    if (!compressed) {
+      inputFile.open(fileName);
+      if (!inputFile) {
+        opened = 0;
+      }
+      else {
+        inputFile >> m_numGlobalPoints;
+      }
     }
-
-    inputFile >> m_numGlobalPoints;
   }
 
+  MPI_Bcast(&opened, 1, MPI_INT, 0, *mpiCommunicator);
+  if (opened == 0) {
+    return false;
+  }
+  MPI_Bcast(&compressed, 1, MPI_INT, 0, *mpiCommunicator);
+  if (compressed) {
+    return readCompressed(fileName, mpiCommunicator);
+  }
   MPI_Bcast(&m_numGlobalPoints, 1, MPI_UNSIGNED, 0, *mpiCommunicator);
 
-  unsigned int avgPoints = (m_numGlobalPoints / numProcs) + (m_numLocalPoints % numProcs) ? 1 : 0;
+  // The lower corner is followed by the upper corner.
+  double bounds[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  if (myRank == 0) {
+    readBounds(inputFile, bounds, bounds + 3);
+  }
+#if defined(GRAPHWORKS_COORDS_QUANTIZED)
+  MPI_Bcast(bounds, 6, MPI_DOUBLE, 0, *mpiCommunicator);
+#endif
+  m_bounds = Bounds(bounds, bounds + 3);
+
+  deallocate();
+
+  unsigned int avgPoints = (m_numGlobalPoints / numProcs) + (((m_numGlobalPoints % numProcs) != 0) ? 1 : 0);
   unsigned int myOffset = myRank * avgPoints;
+  m_numLocalPoints = 0;
   if (m_numGlobalPoints > myOffset) {
     m_numLocalPoints = std::min(avgPoints, m_numGlobalPoints - myOffset); 
   }
 
-  if (!allocate()) {
+  if (m_sharedMemory) {
+    readShared(inputFile, mpiCommunicator, avgPoints);
+  }
+  else {
+    if (!allocate()) {
+      return false;
+    }
+    readDistributed(inputFile, mpiCommunicator, avgPoints);
+  }
+
+  return true;
+}
+
+/**
+ * @brief Writes the points to a compressed file, which read() takes in
+ *        place of the text file they were read from.
+ *
+ * @param fileName          Name of the file.
+ * @param mpiCommunicator   Communicator over which the points were read.
+ *
+ * @return true if the file was written successfully.
+ *
+ * The points are gathered on processor 0 in the order of the processors,
+ * which is the order of the file they were read from, with gatherv, and are
+ * written as
+ * the records of their three double coordinates, converted back from their
+ * representation. The bounding box is stored in the metadata of the file,
+ * as the lower corner followed by the upper one, so that quantized
+ * coordinates are read back within the box they were quantized in. Without
+ * quantization, the box is found from the points. This is a collective
+ * call.
+ */
+bool
+InputData::write(
+  const std::string& fileName,
+  const MPICommunicator& mpiCommunicator
+) const
+{
+  unsigned int myRank = mpiCommunicator.rank();
+  unsigned int numProcs = mpiCommunicator.size();
+
+  std::vector<double> coords(m_numLocalPoints * 3 + 1);
+  for (unsigned int i = 0; i < m_numLocalPoints; ++i) {
+    coords[(i * 3)] = m_points[i].x(m_bounds);
+    coords[(i * 3) + 1] = m_points[i].y(m_bounds);
+    coords[(i * 3) + 2] = m_points[i].z(m_bounds);
+  }
+
+  std::vector<char> metadata(6 * sizeof(double));
+  double* const box = reinterpret_cast<double*>(&metadata[0]);
+#if defined(GRAPHWORKS_COORDS_QUANTIZED)
+  for (unsigned int d = 0; d < 3; ++d) {
+    box[d] = m_bounds.lower(d);
+    box[d + 3] = m_bounds.upper(d);
+  }
+#else
+  reduceBox(coords, m_numLocalPoints, m_numGlobalPoints, mpiCommunicator, box);
+#endif
+
+  MPI_Datatype recordType;
+  MPI_Type_contiguous(3, MPI_DOUBLE, &recordType);
+  MPI_Type_commit(&recordType);
+  unsigned long long myCount = m_numLocalPoints;
+  std::vector<unsigned long long> counts(numProcs, 0);
+  MPI_Gather(&myCount, 1, MPI_UNSIGNED_LONG_LONG, &counts[0], 1, MPI_UNSIGNED_LONG_LONG, 0, *mpiCommunicator);
+  std::vector<double> allCoords;
+  if (myRank == 0) {
+    allCoords.resize((static_cast<std::size_t>(m_numGlobalPoints) * 3) + 1);
+  }
+  gatherv(&coords[0], myCount, (myRank == 0) ? &allCoords[0] : 0, counts, recordType, mpiCommunicator);
+  MPI_Type_free(&recordType);
+
+  int written = 0;
+  if (myRank == 0) {
+    written = BlockFile::write(fileName, reinterpret_cast<const char*>(&allCoords[0]), 3 * sizeof(double), m_numGlobalPoints, 0, metadata) ? 1 : 0;
+  }
+  MPI_Bcast(&written, 1, MPI_INT, 0, *mpiCommunicator);
+  return written != 0;
+}
+
+/**
+ * @brief Reads the bounding box of the points from the rest of the first
+ *        line of the file.
+ *
+ * @param inputFile   File, positioned after the number of points.
+ * @param lower       Lower corner of the box.
+ * @param upper       Upper corner of the box.
+ *
+ * @return true if the box is known. If the file doesn't have it, the box is
+ *         found from the points only when the coordinates are quantized,
+ *         and the file is then positioned back at the first point.
+ */
+bool
+InputData::readBounds(
+  std::ifstream& inputFile,
+  double* const lower,
+  double* const upper
+) const
+{
+  std::string header;
+  std::getline(inputFile, header);
+  std::istringstream headerStream(header);
+  if ((headerStream >> lower[0] >> lower[1] >> lower[2] >> upper[0] >> upper[1] >> upper[2])) {
+    return true;
+  }
+
+#if defined(GRAPHWORKS_COORDS_QUANTIZED)
+  for (unsigned int d = 0; d < 3; ++d) {
+    lower[d] = std::numeric_limits<double>::max();
+    upper[d] = -std::numeric_limits<double>::max();
+  }
+  const std::streampos first = inputFile.tellg();
+  double coords[3];
+  for (unsigned int i = 0; i < m_numGlobalPoints; ++i) {
+    inputFile >> coords[0] >> coords[1] >> coords[2];
+    for (unsigned int d = 0; d < 3; ++d) {
+      lower[d] = std::min(lower[d], coords[d]);
+      upper[d] = std::max(upper[d], coords[d]);
+    }
+  }
+  inputFile.clear();
+  inputFile.seekg(first);
+  if (m_numGlobalPoints == 0) {
+    std::fill(lower, lower + 3, 0.0);
+    std::fill(upper, upper + 3, 0.0);
+  }
+  return true;
+#else
+  std::fill(lower, lower + 3, 0.0);
+  std::fill(upper, upper + 3, 0.0);
+  return false;
+#endif
+}
+
+/**
+ * @brief Reads the points of a compressed file, every processor reading and
+ *        decompressing its own share.
+ *
+ * The box is read from the metadata of the file. For files without it, the
+ * box for the quantized coordinates is found from the points of all the
+ * processors. This is a collective call.
+ */
+bool
+InputData::readCompressed(
+  const std::string& fileName,
+  const MPICommunicator& mpiCommunicator
+)
+{
+  unsigned int myRank = mpiCommunicator.rank();
+  unsigned int numProcs = mpiCommunicator.size();
+
+  MPI_File file;
+  char* name = const_cast<char*>(fileName.c_str());
+  if (MPI_File_open(*mpiCommunicator, name, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS) {
     return false;
   }
+  BlockFile blockFile;
+  int valid = (blockFile.open(file) && (blockFile.recordSize() == 3 * sizeof(double)) &&
+               (blockFile.numRecords() <= std::numeric_limits<unsigned int>::max())) ? 1 : 0;
+  int allValid = 0;
+  MPI_Allreduce(&valid, &allValid, 1, MPI_INT, MPI_LAND, *mpiCommunicator);
+  if (!allValid) {
+    MPI_File_close(&file);
+    return false;
+  }
+  m_numGlobalPoints = static_cast<unsigned int>(blockFile.numRecords());
+
+  deallocate();
+
+  unsigned int avgPoints = (m_numGlobalPoints / numProcs) + (((m_numGlobalPoints % numProcs) != 0) ? 1 : 0);
+  unsigned int myOffset = myRank * avgPoints;
+  m_numLocalPoints = 0;
+  if (m_numGlobalPoints > myOffset) {
+    m_numLocalPoints = std::min(avgPoints, m_numGlobalPoints - myOffset);
+  }
+
+  std::vector<double> coords(m_numLocalPoints * 3 + 1);
+  valid = blockFile.read(file, myOffset, m_numLocalPoints, reinterpret_cast<char*>(&coords[0])) ? 1 : 0;
+  MPI_File_close(&file);
+  MPI_Allreduce(&valid, &allValid, 1, MPI_INT, MPI_LAND, *mpiCommunicator);
+  if (!allValid) {
+    return false;
+  }
+
+  // All the processors read the same header, so they agree on whether the
+  // file has the box.
+  double box[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  if (blockFile.metadata().size() == sizeof(box)) {
+    std::memcpy(box, &blockFile.metadata()[0], sizeof(box));
+  }
+#if defined(GRAPHWORKS_COORDS_QUANTIZED)
+  else {
+    reduceBox(coords, m_numLocalPoints, m_numGlobalPoints, mpiCommunicator, box);
+  }
+#endif
+  m_bounds = Bounds(box, box + 3);
+
+  if (m_sharedMemory) {
+    MPICommunicator nodeCommunicator = mpiCommunicator.splitShared();
+    m_window = new SharedMemoryWindow<Point>(nodeCommunicator, m_numLocalPoints);
+    m_points = m_window->local();
+  }
+  else if (!allocate()) {
+    return false;
+  }
+  #pragma omp parallel for schedule(static)
+  for (int i = 0; i < static_cast<int>(m_numLocalPoints); ++i) {
+    m_points[i].set(coords[(i * 3)], coords[(i * 3) + 1], coords[(i * 3) + 2], m_bounds);
+  }
+  if (m_window != 0) {
+    m_window->sync();
+  }
+
+  return true;
+}
+
+/**
+ * @brief Reads the points and sends every processor its own copy.
+ *
+ * The points are sent in their representation, as bytes. Processor 0 knows
+ * the share of every processor from the number of points, so the shares
+ * are sent without being asked for.
+ */
+void
+InputData::readDistributed(
+  std::ifstream& inputFile,
+  const MPICommunicator& mpiCommunicator,
+  const unsigned int avgPoints
+)
+{
+  unsigned int myRank = mpiCommunicator.rank();
+  unsigned int numProcs = mpiCommunicator.size();
+
+  MPI_Datatype pointType;
+  MPI_Type_contiguous(sizeof(Point), MPI_BYTE, &pointType);
+  MPI_Type_commit(&pointType);
 
   if (myRank == 0) {
-    double* tmpBuffer[2];
+    std::vector<Point> tmpBuffer[2];
     MPI_Request request[2];
     bool active[2] = {false, false};
 
     for (unsigned int i = 0; i < 2; ++i) {
-      tmpBuffer[i] = new (std::nothrow) double[avgPoints * 3];
-      if (tmpBuffer[i] == 0) {
-        return false;
-      }
+      tmpBuffer[i].resize(avgPoints);
     }
+    double x, y, z;
     for (unsigned int proc = 0; proc < numProcs; ++proc) {
-      unsigned int procPoints = m_numLocalPoints;
       if (proc != myRank) {
-        double* readBuffer = tmpBuffer[proc % 2];
+        // The shares follow from the number of points, like in read().
+        unsigned int procPoints = 0;
+        if (m_numGlobalPoints > (proc * avgPoints)) {
+          procPoints = std::min(avgPoints, m_numGlobalPoints - (proc * avgPoints));
+        }
+        Point* readBuffer = &tmpBuffer[proc % 2][0];
         if (active[proc % 2]) {
           MPI_Wait(&request[proc % 2], MPI_STATUS_IGNORE);
         }
         active[proc % 2] = true;
-        MPI_Status status;
-        MPI_Recv(&procPoints, 1, MPI_UNSIGNED, proc, proc, *mpiCommunicator, &status);
         for (unsigned int i = 0; i < procPoints; ++i) {
-          inputFile >> readBuffer[(i * 3)];
-          inputFile >> readBuffer[(i * 3) + 1];
-          inputFile >> readBuffer[(i * 3) + 2];
+          inputFile >> x;
+          inputFile >> y;
+          inputFile >> z;
+          readBuffer[i].set(x, y, z, m_bounds);
         }
-        MPI_Isend(readBuffer, procPoints, MPI_DOUBLE, proc, 0, *mpiCommunicator, &request[proc % 2]);
+        MPI_Isend(readBuffer, procPoints, pointType, proc, 0, *mpiCommunicator, &request[proc % 2]);
       }
       else {
-        double x, y, z;
         for (unsigned int i = 0; i < m_numLocalPoints; ++i) {
           inputFile >> x;
           inputFile >> y;
           inputFile >> z;
-          m_points[i].set(x, y, z);
+          m_points[i].set(x, y, z, m_bounds);
         }
       }
     }
@@ -128,19 +591,98 @@ InputData::read(
         MPI_Wait(&request[i], &status);
       }
     }
-    for (unsigned int i = 0; i < 2; ++i) {
-      delete[] tmpBuffer[i];
-    }
   }
   else {
-    double* readBuffer = new double[m_numLocalPoints];
-    MPI_Send(&m_numLocalPoints, 1, MPI_UNSIGNED, 0, myRank, *mpiCommunicator);
     MPI_Status status;
-    MPI_Recv(readBuffer, m_numLocalPoints, MPI_DOUBLE, 0, 0, *mpiCommunicator, &status);
-    for (unsigned int i = 0; i < m_numLocalPoints; ++i) {
-      m_points[i].set(readBuffer[(i * 3)], readBuffer[(i * 3) + 1], readBuffer[(i * 3) + 2]);
+    MPI_Recv(m_points, m_numLocalPoints, pointType, 0, 0, *mpiCommunicator, &status);
+  }
+
+  MPI_Type_free(&pointType);
+}
+
+/**
+ * @brief Reads the points into shared memory windows, one per host.
+ *
+ * Every processor allocates its share of the points as its segment of the
+ * host's window. Processor 0 then sends the share of every processor to the
+ * first processor on its host, which receives it directly into the
+ * segment of the destination processor.
+ */
+void
+InputData::readShared(
+  std::ifstream& inputFile,
+  const MPICommunicator& mpiCommunicator,
+  const unsigned int avgPoints
+)
+{
+  unsigned int myRank = mpiCommunicator.rank();
+  unsigned int numProcs = mpiCommunicator.size();
+
+  MPICommunicator nodeCommunicator = mpiCommunicator.splitShared();
+  m_window = new SharedMemoryWindow<Point>(nodeCommunicator, m_numLocalPoints);
+  m_points = m_window->local();
+
+  MPI_Datatype pointType;
+  MPI_Type_contiguous(sizeof(Point), MPI_BYTE, &pointType);
+  MPI_Type_commit(&pointType);
+
+  // Find the processors on this host, and the host leaders of all processors.
+  int myLeader = static_cast<int>(myRank);
+  MPI_Bcast(&myLeader, 1, MPI_INT, 0, *nodeCommunicator);
+  std::vector<unsigned int> nodeRanks(nodeCommunicator.size());
+  MPI_Allgather(&myRank, 1, MPI_UNSIGNED, &nodeRanks[0], 1, MPI_UNSIGNED, *nodeCommunicator);
+  std::vector<int> leaders(numProcs);
+  MPI_Gather(&myLeader, 1, MPI_INT, &leaders[0], 1, MPI_INT, 0, *mpiCommunicator);
+
+  if (myRank == 0) {
+    // Processor 0 is always the leader of its own host.
+    std::vector<Point> tmpBuffer[2];
+    MPI_Request request[2];
+    bool active[2] = {false, false};
+    for (unsigned int i = 0; i < 2; ++i) {
+      tmpBuffer[i].resize(avgPoints);
+    }
+    double x, y, z;
+    for (unsigned int proc = 0, nodeRank = 0; proc < numProcs; ++proc) {
+      unsigned int procPoints = 0;
+      if (m_numGlobalPoints > (proc * avgPoints)) {
+        procPoints = std::min(avgPoints, m_numGlobalPoints - (proc * avgPoints));
+      }
+      Point* readBuffer = 0;
+      if (leaders[proc] == 0) {
+        readBuffer = m_window->segment(nodeRank++);
+      }
+      else {
+        readBuffer = &tmpBuffer[proc % 2][0];
+        if (active[proc % 2]) {
+          MPI_Wait(&request[proc % 2], MPI_STATUS_IGNORE);
+        }
+      }
+      for (unsigned int i = 0; i < procPoints; ++i) {
+        inputFile >> x;
+        inputFile >> y;
+        inputFile >> z;
+        readBuffer[i].set(x, y, z, m_bounds);
+      }
+      if (leaders[proc] != 0) {
+        MPI_Isend(readBuffer, procPoints, pointType, leaders[proc], proc, *mpiCommunicator, &request[proc % 2]);
+        active[proc % 2] = true;
+      }
+    }
+    for (unsigned int i = 0; i < 2; ++i) {
+      if (active[i]) {
+        MPI_Wait(&request[i], MPI_STATUS_IGNORE);
+      }
     }
   }
+  else if (nodeCommunicator.rank() == 0) {
+    for (unsigned int p = 0; p < nodeCommunicator.size(); ++p) {
+      MPI_Recv(m_window->segment(p), static_cast<int>(m_window->count(p)), pointType, 0, static_cast<int>(nodeRanks[p]), *mpiCommunicator, MPI_STATUS_IGNORE);
+    }
+  }
+
+  MPI_Type_free(&pointType);
+  m_window->sync();
 }
 
 const InputData::Point*
@@ -150,6 +692,17 @@ InputData::points(
   return m_points;
 }
 
+/**
+ * @brief Bounds with which the points were set, which are the same on all
+ *        the processors.
+ */
+const InputData::Bounds&
+InputData::bounds(
+) const
+{
+  return m_bounds;
+}
+
 unsigned int
 InputData::numLocalPoints(
 ) const
@@ -157,6 +710,49 @@ InputData::numLocalPoints(
   return m_numLocalPoints;
 }
 
+/**
+ * @brief Number of processors whose points are directly accessible.
+ */
+unsigned int
+InputData::numNodeProcs(
+) const
+{
+  return (m_window != 0) ? static_cast<unsigned int>(m_window->communicator().size()) : 1;
+}
+
+/**
+ * @brief Gets the points of a co-located processor in the shared memory mode.
+ *
+ * @param nodeRank    Rank of the processor among the processors on this host.
+ * @param numPoints   Number of points of the processor.
+ *
+ * @return Points of the processor, which are accessed through plain loads.
+ */
+const InputData::Point*
+InputData::nodePoints(
+  const unsigned int nodeRank,
+  unsigned int& numPoints
+) const
+{
+  if (m_window == 0) {
+    numPoints = m_numLocalPoints;
+    return m_points;
+  }
+  numPoints = static_cast<unsigned int>(m_window->count(nodeRank));
+  return m_window->segment(nodeRank);
+}
+
+/**
+ * @brief Communicator of the processors on this host, in the shared memory
+ *        mode, whose ranks are the ranks of nodePoints(). Otherwise 0.
+ */
+const MPICommunicator*
+InputData::nodeCommunicator(
+) const
+{
+  return (m_window != 0) ? &m_window->communicator() : 0;
+}
+
 bool
 InputData::allocate(
 )
@@ -169,10 +765,14 @@ void
 InputData::deallocate(
 )
 {
-  if (m_points != 0) {
+  if (m_window != 0) {
+    delete m_window;
+    m_window = 0;
+  }
+  else if (m_points != 0) {
     delete[] m_points;
-    m_points = 0;
   }
+  m_points = 0;
 }
 
 InputData::~InputData(
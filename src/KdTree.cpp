@@ -0,0 +1,302 @@
+#include "KdTree.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+/**
+ * @brief Orders point indices along one coordinate axis.
+ */
+class AxisCompare {
+public:
+  AxisCompare(
+    const InputData::Point* const points,
+    const InputData::Bounds& bounds,
+    const unsigned int dim
+  ) : m_points(points),
+    m_bounds(bounds),
+    m_dim(dim)
+  { }
+
+  bool
+  operator()(
+    const unsigned int a,
+    const unsigned int b
+  ) const
+  {
+    return value(a) < value(b);
+  }
+
+private:
+  double
+  value(
+    const unsigned int i
+  ) const
+  {
+    return (m_dim == 0) ? m_points[i].x(m_bounds) : ((m_dim == 1) ? m_points[i].y(m_bounds) : m_points[i].z(m_bounds));
+  }
+
+private:
+  const InputData::Point* const m_points;
+  const InputData::Bounds& m_bounds;
+  const unsigned int m_dim;
+}; // class AxisCompare
+
+} // namespace
+
+KdTree::KdTree(
+) : m_points(0),
+  m_bounds(),
+  m_order(),
+  m_cells()
+{
+}
+
+/**
+ * @brief Builds the tree over the given points.
+ *
+ * @param points      Points to be indexed; these are not copied and must
+ *                    outlive the tree.
+ * @param bounds      Bounds with which the points were set.
+ * @param numPoints   Number of points.
+ *
+ * Cells are split at the median of their widest dimension until they hold
+ * at most s_leafSize points.
+ */
+void
+KdTree::build(
+  const InputData::Point* const points,
+  const InputData::Bounds& bounds,
+  const unsigned int numPoints
+)
+{
+  m_points = points;
+  m_bounds = bounds;
+  m_order.resize(numPoints);
+  for (unsigned int i = 0; i < numPoints; ++i) {
+    m_order[i] = i;
+  }
+  m_cells.clear();
+  if (numPoints > 0) {
+    m_cells.reserve(4 * ((numPoints / s_leafSize) + 1));
+    m_cells.push_back(Cell());
+    buildCell(0, 0, numPoints);
+  }
+}
+
+void
+KdTree::buildCell(
+  const unsigned int c,
+  const unsigned int begin,
+  const unsigned int end
+)
+{
+  m_cells[c].m_begin = begin;
+  m_cells[c].m_end = end;
+  m_cells[c].m_child = 0;
+  for (unsigned int d = 0; d < 3; ++d) {
+    m_cells[c].m_min[d] = std::numeric_limits<double>::max();
+    m_cells[c].m_max[d] = -std::numeric_limits<double>::max();
+  }
+  for (unsigned int i = begin; i < end; ++i) {
+    for (unsigned int d = 0; d < 3; ++d) {
+      double value = coordinate(m_order[i], d);
+      m_cells[c].m_min[d] = std::min(m_cells[c].m_min[d], value);
+      m_cells[c].m_max[d] = std::max(m_cells[c].m_max[d], value);
+    }
+  }
+
+  if ((end - begin) > s_leafSize) {
+    unsigned int splitDim = 0;
+    for (unsigned int d = 1; d < 3; ++d) {
+      if ((m_cells[c].m_max[d] - m_cells[c].m_min[d]) > (m_cells[c].m_max[splitDim] - m_cells[c].m_min[splitDim])) {
+        splitDim = d;
+      }
+    }
+    unsigned int middle = begin + ((end - begin) / 2);
+    std::nth_element(m_order.begin() + begin, m_order.begin() + middle, m_order.begin() + end, AxisCompare(m_points, m_bounds, splitDim));
+
+    // Children are always stored next to each other.
+    unsigned int child = static_cast<unsigned int>(m_cells.size());
+    m_cells[c].m_child = child;
+    m_cells.resize(child + 2);
+    buildCell(child, begin, middle);
+    buildCell(child + 1, middle, end);
+  }
+}
+
+/**
+ * @brief Finds the k nearest points to a query point.
+ *
+ * @param query       Coordinates of the query point.
+ * @param k           Number of neighbors to be found.
+ * @param bound       Squared distance beyond which points are not reported.
+ * @param neighbors   Found neighbors as (squared distance, point index),
+ *                    sorted by increasing distance.
+ */
+void
+KdTree::nearest(
+  const double* const query,
+  const unsigned int k,
+  const double bound,
+  std::vector<Neighbor>& neighbors
+) const
+{
+  neighbors.clear();
+  if (m_cells.empty() || (k == 0)) {
+    return;
+  }
+  neighbors.reserve(k + 1);
+  searchNearest(0, query, k, bound, neighbors);
+  std::sort_heap(neighbors.begin(), neighbors.end());
+}
+
+void
+KdTree::searchNearest(
+  const unsigned int c,
+  const double* const query,
+  const unsigned int k,
+  const double bound,
+  std::vector<Neighbor>& heap
+) const
+{
+  const Cell& cell = m_cells[c];
+  if (cell.m_child == 0) {
+    for (unsigned int i = cell.m_begin; i < cell.m_end; ++i) {
+      double d = distance(query, m_order[i]);
+      if ((d < bound) && ((heap.size() < k) || (d < heap.front().first))) {
+        heap.push_back(Neighbor(d, m_order[i]));
+        std::push_heap(heap.begin(), heap.end());
+        if (heap.size() > k) {
+          std::pop_heap(heap.begin(), heap.end());
+          heap.pop_back();
+        }
+      }
+    }
+    return;
+  }
+
+  // Visit the closer child first to shrink the search radius early.
+  unsigned int first = cell.m_child;
+  unsigned int second = cell.m_child + 1;
+  double firstDistance = cellDistance(query, first);
+  double secondDistance = cellDistance(query, second);
+  if (secondDistance < firstDistance) {
+    std::swap(first, second);
+    std::swap(firstDistance, secondDistance);
+  }
+  if ((firstDistance < bound) && ((heap.size() < k) || (firstDistance < heap.front().first))) {
+    searchNearest(first, query, k, bound, heap);
+  }
+  if ((secondDistance < bound) && ((heap.size() < k) || (secondDistance < heap.front().first))) {
+    searchNearest(second, query, k, bound, heap);
+  }
+}
+
+/**
+ * @brief Finds all the points within a given distance of a query point.
+ *
+ * @param query       Coordinates of the query point.
+ * @param radius      Search radius.
+ * @param neighbors   Found neighbors as (squared distance, point index),
+ *                    sorted by increasing distance.
+ */
+void
+KdTree::withinRadius(
+  const double* const query,
+  const double radius,
+  std::vector<Neighbor>& neighbors
+) const
+{
+  neighbors.clear();
+  if (m_cells.empty()) {
+    return;
+  }
+  searchRadius(0, query, radius * radius, neighbors);
+  std::sort(neighbors.begin(), neighbors.end());
+}
+
+void
+KdTree::searchRadius(
+  const unsigned int c,
+  const double* const query,
+  const double squaredRadius,
+  std::vector<Neighbor>& neighbors
+) const
+{
+  const Cell& cell = m_cells[c];
+  if (cellDistance(query, c) > squaredRadius) {
+    return;
+  }
+  if (cell.m_child == 0) {
+    for (unsigned int i = cell.m_begin; i < cell.m_end; ++i) {
+      double d = distance(query, m_order[i]);
+      if (d <= squaredRadius) {
+        neighbors.push_back(Neighbor(d, m_order[i]));
+      }
+    }
+    return;
+  }
+  searchRadius(cell.m_child, query, squaredRadius, neighbors);
+  searchRadius(cell.m_child + 1, query, squaredRadius, neighbors);
+}
+
+unsigned int
+KdTree::size(
+) const
+{
+  return static_cast<unsigned int>(m_order.size());
+}
+
+double
+KdTree::coordinate(
+  const unsigned int i,
+  const unsigned int dim
+) const
+{
+  return (dim == 0) ? m_points[i].x(m_bounds) : ((dim == 1) ? m_points[i].y(m_bounds) : m_points[i].z(m_bounds));
+}
+
+/**
+ * @brief Squared distance of a point from the query.
+ */
+double
+KdTree::distance(
+  const double* const query,
+  const unsigned int i
+) const
+{
+  double dx = query[0] - m_points[i].x(m_bounds);
+  double dy = query[1] - m_points[i].y(m_bounds);
+  double dz = query[2] - m_points[i].z(m_bounds);
+  return (dx * dx) + (dy * dy) + (dz * dz);
+}
+
+/**
+ * @brief Squared distance of a cell's bounding box from the query.
+ */
+double
+KdTree::cellDistance(
+  const double* const query,
+  const unsigned int c
+) const
+{
+  double d = 0.0;
+  for (unsigned int dim = 0; dim < 3; ++dim) {
+    double delta = 0.0;
+    if (query[dim] < m_cells[c].m_min[dim]) {
+      delta = m_cells[c].m_min[dim] - query[dim];
+    }
+    else if (query[dim] > m_cells[c].m_max[dim]) {
+      delta = query[dim] - m_cells[c].m_max[dim];
+    }
+    d += delta * delta;
+  }
+  return d;
+}
+
+KdTree::~KdTree(
+)
+{
+}
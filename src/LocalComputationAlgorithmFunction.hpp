@@ -26,7 +26,8 @@ public:
 
   float
   getScore(
-    Graph&
+    Graph&,
+    const CombineFunction&,
     const std::vector<std::vector<Graph::Node> >&
   ) const
   {
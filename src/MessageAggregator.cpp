@@ -0,0 +1,256 @@
+#include "MessageAggregator.hpp"
+
+#include "MPICommunicator.hpp"
+
+#include <algorithm>
+
+namespace {
+
+/** Tags alternate between consecutive epochs, see finish() **/
+const int s_updateTag = 0x4757;
+
+} // namespace
+
+/**
+ * @brief Creates an aggregator over the given communicator.
+ *
+ * @param mpiCommunicator       Communicator over which updates are sent.
+ * @param handler               Callback for the received updates.
+ * @param maxBufferedUpdates    Updates buffered per destination before it is flushed.
+ * @param flushInterval         Seconds after which all the buffers are flushed.
+ * @param combiner              If given, updates of the same node are combined
+ *                              using this reduction before being sent.
+ */
+MessageAggregator::MessageAggregator(
+  const MPICommunicator& mpiCommunicator,
+  UpdateHandler& handler,
+  const unsigned int maxBufferedUpdates,
+  const double flushInterval,
+  const Reduction* const combiner
+) : m_mpiCommunicator(mpiCommunicator),
+  m_handler(handler),
+  m_maxBufferedUpdates(maxBufferedUpdates > 0 ? maxBufferedUpdates : 1),
+  m_flushInterval(flushInterval),
+  m_combiner(combiner),
+  m_buffers(mpiCommunicator.size()),
+  m_positions(combiner != 0 ? mpiCommunicator.size() : 0),
+  m_inFlight(),
+  m_sentMessages(mpiCommunicator.size(), 0),
+  m_receiveBuffer(),
+  m_epoch(0),
+  m_receivedMessages(0),
+  m_lastFlush(MPI_Wtime()),
+  m_numMessages(0),
+  m_numUpdates(0),
+  m_numCombinedUpdates(0)
+{
+}
+
+/**
+ * @brief Queues an update of a node owned by the given processor.
+ *
+ * @param destination   Rank of the processor which owns the node.
+ * @param target        Global index of the node.
+ * @param value         Value with which the node is to be updated.
+ *
+ * Updates of local nodes are handed to the handler right away, and are
+ * counted like the other updates.
+ */
+void
+MessageAggregator::send(
+  const unsigned int destination,
+  const Graph::Node::IndexType target,
+  const Graph::Node::PayloadType value
+)
+{
+  ++m_numUpdates;
+  if (destination == m_mpiCommunicator.rank()) {
+    m_handler(target, value);
+    return;
+  }
+
+  std::vector<Update>& buffer = m_buffers[destination];
+  if (m_combiner != 0) {
+    std::unordered_map<Graph::Node::IndexType, unsigned int>::iterator position = m_positions[destination].find(target);
+    if (position != m_positions[destination].end()) {
+      Update& update = buffer[position->second];
+      update.m_value = (*m_combiner)(update.m_value, value);
+      ++m_numCombinedUpdates;
+      return;
+    }
+    m_positions[destination][target] = static_cast<unsigned int>(buffer.size());
+  }
+  Update update;
+  update.m_target = target;
+  update.m_value = value;
+  buffer.push_back(update);
+
+  if (buffer.size() >= m_maxBufferedUpdates) {
+    flush(destination);
+  }
+  if ((MPI_Wtime() - m_lastFlush) > m_flushInterval) {
+    flush();
+    poll();
+  }
+}
+
+/**
+ * @brief Sends out all the buffered updates.
+ */
+void
+MessageAggregator::flush(
+)
+{
+  for (unsigned int p = 0; p < m_buffers.size(); ++p) {
+    flush(p);
+  }
+  m_lastFlush = MPI_Wtime();
+}
+
+void
+MessageAggregator::flush(
+  const unsigned int destination
+)
+{
+  std::vector<Update>& buffer = m_buffers[destination];
+  if (buffer.empty()) {
+    return;
+  }
+
+  m_inFlight.push_back(std::make_pair(MPI_Request(MPI_REQUEST_NULL), std::vector<Update>()));
+  std::pair<MPI_Request, std::vector<Update> >& message = m_inFlight.back();
+  message.second.swap(buffer);
+  MPI_Isend(&message.second[0], static_cast<int>(message.second.size() * sizeof(Update)), MPI_BYTE,
+            static_cast<int>(destination), s_updateTag + static_cast<int>(m_epoch % 2), *m_mpiCommunicator, &message.first);
+  ++m_sentMessages[destination];
+  ++m_numMessages;
+  if (m_combiner != 0) {
+    m_positions[destination].clear();
+  }
+
+  completeSends(false);
+}
+
+/**
+ * @brief Releases the buffers of the completed sends.
+ *
+ * @param wait    Whether to block until all the sends complete.
+ */
+void
+MessageAggregator::completeSends(
+  const bool wait
+)
+{
+  std::list<std::pair<MPI_Request, std::vector<Update> > >::iterator message = m_inFlight.begin();
+  while (message != m_inFlight.end()) {
+    int completed = 0;
+    if (wait) {
+      MPI_Wait(&message->first, MPI_STATUS_IGNORE);
+      completed = 1;
+    }
+    else {
+      MPI_Test(&message->first, &completed, MPI_STATUS_IGNORE);
+    }
+    if (completed) {
+      message = m_inFlight.erase(message);
+    }
+    else {
+      ++message;
+    }
+  }
+}
+
+/**
+ * @brief Handles all the updates which have arrived so far.
+ */
+void
+MessageAggregator::poll(
+)
+{
+  const int tag = s_updateTag + static_cast<int>(m_epoch % 2);
+  int arrived = 1;
+  while (arrived) {
+    MPI_Status status;
+    MPI_Iprobe(MPI_ANY_SOURCE, tag, *m_mpiCommunicator, &arrived, &status);
+    if (arrived) {
+      int size;
+      MPI_Get_count(&status, MPI_BYTE, &size);
+      receive(status.MPI_SOURCE, size);
+    }
+  }
+}
+
+void
+MessageAggregator::receive(
+  const int source,
+  const int size
+)
+{
+  m_receiveBuffer.resize(size / sizeof(Update));
+  MPI_Recv(m_receiveBuffer.empty() ? 0 : &m_receiveBuffer[0], size, MPI_BYTE,
+           source, s_updateTag + static_cast<int>(m_epoch % 2), *m_mpiCommunicator, MPI_STATUS_IGNORE);
+  ++m_receivedMessages;
+  for (std::vector<Update>::const_iterator u = m_receiveBuffer.begin(); u != m_receiveBuffer.end(); ++u) {
+    m_handler(u->m_target, u->m_value);
+  }
+}
+
+/**
+ * @brief Flushes all the updates and waits until all the updates sent to
+ *        this processor have been handled.
+ *
+ * This is a collective call which ends the current epoch of updates.
+ * The number of messages sent to every processor is summed up using one
+ * reduction, after which every processor knows how many messages to wait
+ * for. Since a processor can't finish the next epoch before all the
+ * processors have finished this one, alternating between two tags keeps
+ * the messages of consecutive epochs apart.
+ */
+void
+MessageAggregator::finish(
+)
+{
+  flush();
+
+  int expected = 0;
+  MPI_Reduce_scatter_block(&m_sentMessages[0], &expected, 1, MPI_INT, MPI_SUM, *m_mpiCommunicator);
+  while (m_receivedMessages < expected) {
+    MPI_Status status;
+    MPI_Probe(MPI_ANY_SOURCE, s_updateTag + static_cast<int>(m_epoch % 2), *m_mpiCommunicator, &status);
+    int size;
+    MPI_Get_count(&status, MPI_BYTE, &size);
+    receive(status.MPI_SOURCE, size);
+  }
+  completeSends(true);
+
+  std::fill(m_sentMessages.begin(), m_sentMessages.end(), 0);
+  m_receivedMessages = 0;
+  ++m_epoch;
+}
+
+unsigned long long
+MessageAggregator::numMessages(
+) const
+{
+  return m_numMessages;
+}
+
+unsigned long long
+MessageAggregator::numUpdates(
+) const
+{
+  return m_numUpdates;
+}
+
+unsigned long long
+MessageAggregator::numCombinedUpdates(
+) const
+{
+  return m_numCombinedUpdates;
+}
+
+MessageAggregator::~MessageAggregator(
+)
+{
+  completeSends(true);
+}
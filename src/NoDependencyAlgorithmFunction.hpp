@@ -0,0 +1,83 @@
+#ifndef GRAPHWORKS_NODEPENDENCYALGORITHMFUNCTION_HPP_
+#define GRAPHWORKS_NODEPENDENCYALGORITHMFUNCTION_HPP_
+
+#include "CombineFunction.hpp"
+#include "GraphAlgorithmFunction.hpp"
+#include "Reduction.hpp"
+
+#include <vector>
+
+/**
+ * Pull and push alternatives for combining independent interaction sets.
+ * Pulling visits every active node and combines it with its interaction set,
+ * while pushing combines every changed source into the nodes which refer to
+ * it. The scores choose pushing for frontiers sparser than s_pushDensity,
+ * and pulling otherwise, when the work of visiting the active nodes is
+ * mostly spent on sources which did change anyway. Pushing combines only
+ * the changed sources, so it is only offered for combine functions with an
+ * idempotent reduction, for which combining a source again is harmless.
+ */
+class NoDependencyPullAlgorithmFunction : public GraphAlgorithmFunction {
+public:
+  bool
+  operator()(
+    Graph& g,
+    const CombineFunction& combine,
+    const std::vector<std::vector<Graph::Node> >& interactionSets
+  ) const
+  {
+    return g.compute<Graph::NoDependency>(combine, interactionSets);
+  }
+
+  float
+  getScore(
+    Graph& g,
+    const CombineFunction&,
+    const std::vector<std::vector<Graph::Node> >&
+  ) const
+  {
+    if ((g.halo() == 0) || g.frontier().isFull()) {
+      return 1.0f;
+    }
+    return static_cast<float>(g.frontier().density());
+  }
+
+  Graph::AlgorithmChoice
+  getType() const { return Graph::NoDependency; }
+}; // class NoDependencyPullAlgorithmFunction
+
+class NoDependencyPushAlgorithmFunction : public GraphAlgorithmFunction {
+public:
+  bool
+  operator()(
+    Graph& g,
+    const CombineFunction& combine,
+    const std::vector<std::vector<Graph::Node> >& interactionSets
+  ) const
+  {
+    return g.computePush(combine, interactionSets);
+  }
+
+  float
+  getScore(
+    Graph& g,
+    const CombineFunction& combine,
+    const std::vector<std::vector<Graph::Node> >&
+  ) const
+  {
+    if ((g.halo() == 0) || g.frontier().isFull() ||
+        (combine.reduction() == 0) || !combine.reduction()->isIdempotent()) {
+      return 0.0f;
+    }
+    return s_pushDensity;
+  }
+
+  Graph::AlgorithmChoice
+  getType() const { return Graph::NoDependency; }
+
+public:
+  /** Frontier density below which pushing is preferred **/
+  static constexpr float s_pushDensity = 0.05f;
+}; // class NoDependencyPushAlgorithmFunction
+
+#endif // GRAPHWORKS_NODEPENDENCYALGORITHMFUNCTION_HPP_
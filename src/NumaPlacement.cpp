@@ -0,0 +1,250 @@
+#include "NumaPlacement.hpp"
+
+#ifdef GRAPHWORKS_HAVE_LIBNUMA
+#include <numa.h>
+#include <numaif.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <sched.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+unsigned int
+numThreads(
+)
+{
+#ifdef _OPENMP
+  return static_cast<unsigned int>(omp_get_num_threads());
+#else
+  return 1;
+#endif
+}
+
+unsigned int
+threadNumber(
+)
+{
+#ifdef _OPENMP
+  return static_cast<unsigned int>(omp_get_thread_num());
+#else
+  return 0;
+#endif
+}
+
+/**
+ * @brief Lists the NUMA nodes which the processor may run on, which are
+ *        numbered as the domains in their order.
+ */
+void
+runDomains(
+  std::vector<int>& nodes
+)
+{
+  nodes.clear();
+#ifdef GRAPHWORKS_HAVE_LIBNUMA
+  if (numa_available() < 0) {
+    return;
+  }
+  struct bitmask* mask = numa_get_run_node_mask();
+  for (int n = 0; n <= numa_max_node(); ++n) {
+    if (numa_bitmask_isbitset(mask, static_cast<unsigned int>(n))) {
+      nodes.push_back(n);
+    }
+  }
+  numa_bitmask_free(mask);
+#endif
+}
+
+std::size_t
+pageSize(
+)
+{
+  return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+}
+
+} // namespace
+
+/**
+ * @brief Number of the domains the processor may run on.
+ */
+unsigned int
+NumaPlacement::numDomains(
+)
+{
+  std::vector<int> nodes;
+  runDomains(nodes);
+  return std::max(static_cast<unsigned int>(nodes.size()), 1u);
+}
+
+/**
+ * @brief Domain of a thread, among all the threads of a parallel region.
+ */
+unsigned int
+NumaPlacement::threadDomain(
+  const unsigned int thread,
+  const unsigned int numThreads
+)
+{
+  return static_cast<unsigned int>((static_cast<unsigned long long>(thread) * numDomains()) / numThreads);
+}
+
+/**
+ * @brief Pins the OpenMP threads to their domains.
+ *
+ * The threads keep their pinning in the later parallel regions, which reuse
+ * them. Without libnuma, the threads are left to the binding of the OpenMP
+ * runtime, e.g. OMP_PROC_BIND=spread.
+ */
+void
+NumaPlacement::pinThreads(
+)
+{
+#ifdef GRAPHWORKS_HAVE_LIBNUMA
+  std::vector<int> nodes;
+  runDomains(nodes);
+  if (nodes.size() < 2) {
+    return;
+  }
+  #pragma omp parallel
+  {
+    const unsigned int domain = static_cast<unsigned int>((static_cast<unsigned long long>(threadNumber()) * nodes.size()) / numThreads());
+    numa_run_on_node(nodes[domain]);
+  }
+#endif
+}
+
+/**
+ * @brief Domain of the CPU which runs the calling thread, or -1 if it isn't
+ *        known.
+ */
+int
+NumaPlacement::currentDomain(
+)
+{
+#ifdef GRAPHWORKS_HAVE_LIBNUMA
+  std::vector<int> nodes;
+  runDomains(nodes);
+  const int cpu = sched_getcpu();
+  if (nodes.empty() || (cpu < 0)) {
+    return -1;
+  }
+  std::vector<int>::const_iterator node = std::find(nodes.begin(), nodes.end(), numa_node_of_cpu(cpu));
+  return (node != nodes.end()) ? static_cast<int>(node - nodes.begin()) : -1;
+#else
+  return -1;
+#endif
+}
+
+/**
+ * @brief Places the pages of an array on the domains, in blocks.
+ *
+ * @param data    Start of the array.
+ * @param bytes   Size of the array.
+ *
+ * Only the pages which lie completely within the array are placed. The
+ * pages are then touched by the threads, in the blocks of the static
+ * schedule, so that the pages which weren't touched before are allocated
+ * by the threads which are going to work on them.
+ */
+void
+NumaPlacement::place(
+  void* const data,
+  const std::size_t bytes
+)
+{
+  const std::size_t page = pageSize();
+  const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(data);
+  const std::uintptr_t first = ((begin + page - 1) / page) * page;
+  const std::uintptr_t last = ((begin + bytes) / page) * page;
+  if ((data == 0) || (last <= first)) {
+    return;
+  }
+  const std::size_t numPages = (last - first) / page;
+
+#ifdef GRAPHWORKS_HAVE_LIBNUMA
+  std::vector<int> nodes;
+  runDomains(nodes);
+  if (nodes.size() > 1) {
+    struct bitmask* mask = numa_allocate_nodemask();
+    for (std::size_t d = 0; d < nodes.size(); ++d) {
+      const std::size_t blockBegin = (d * numPages) / nodes.size();
+      const std::size_t blockEnd = ((d + 1) * numPages) / nodes.size();
+      if (blockEnd == blockBegin) {
+        continue;
+      }
+      numa_bitmask_clearall(mask);
+      numa_bitmask_setbit(mask, static_cast<unsigned int>(nodes[d]));
+      // Placement is best effort, the pages stay where they are on failure.
+      mbind(reinterpret_cast<void*>(first + blockBegin * page), (blockEnd - blockBegin) * page,
+            MPOL_PREFERRED, mask->maskp, mask->size + 1, MPOL_MF_MOVE);
+    }
+    numa_bitmask_free(mask);
+  }
+#endif
+
+  #pragma omp parallel
+  {
+    const std::size_t blockBegin = (threadNumber() * numPages) / numThreads();
+    const std::size_t blockEnd = ((threadNumber() + 1) * numPages) / numThreads();
+    for (std::size_t p = blockBegin; p < blockEnd; ++p) {
+      volatile char* touched = reinterpret_cast<volatile char*>(first + p * page);
+      *touched = *touched;
+    }
+  }
+}
+
+/**
+ * @brief Looks up the domains of the elements of an array.
+ *
+ * @param data          Start of the array.
+ * @param count         Number of the elements.
+ * @param elementSize   Size of an element.
+ * @param domains       Domain of the page of every element, or -1 if it
+ *                      isn't known, which is always the case without
+ *                      libnuma.
+ */
+void
+NumaPlacement::pageDomains(
+  const void* const data,
+  const std::size_t count,
+  const std::size_t elementSize,
+  std::vector<int>& domains
+)
+{
+  domains.assign(count, -1);
+#ifdef GRAPHWORKS_HAVE_LIBNUMA
+  std::vector<int> nodes;
+  runDomains(nodes);
+  if (nodes.empty() || (count == 0)) {
+    return;
+  }
+  const std::size_t page = pageSize();
+  const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(data);
+  const std::uintptr_t first = (begin / page) * page;
+  const std::size_t numPages = (begin + count * elementSize - 1) / page - first / page + 1;
+  std::vector<void*> pages(numPages);
+  for (std::size_t p = 0; p < numPages; ++p) {
+    pages[p] = reinterpret_cast<void*>(first + p * page);
+  }
+  std::vector<int> status(numPages, -1);
+  if (numa_move_pages(0, numPages, &pages[0], 0, &status[0], 0) != 0) {
+    return;
+  }
+  for (std::size_t k = 0; k < count; ++k) {
+    const int node = status[(begin + k * elementSize - first) / page];
+    std::vector<int>::const_iterator n = std::find(nodes.begin(), nodes.end(), node);
+    domains[k] = (n != nodes.end()) ? static_cast<int>(n - nodes.begin()) : -1;
+  }
+#else
+  (void)data;
+  (void)elementSize;
+#endif
+}
@@ -0,0 +1,538 @@
+#include "Octree.hpp"
+
+#include "MPICommunicator.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+namespace {
+
+/**
+ * @brief Spreads the lower 21 bits of a coordinate, so that two zero bits
+ *        separate every pair of consecutive bits.
+ */
+Octree::KeyType
+spreadBits(
+  Octree::KeyType x
+)
+{
+  x &= 0x1fffffULL;
+  x = (x | (x << 32)) & 0x1f00000000ffffULL;
+  x = (x | (x << 16)) & 0x1f0000ff0000ffULL;
+  x = (x | (x << 8)) & 0x100f00f00f00f00fULL;
+  x = (x | (x << 4)) & 0x10c30c30c30c30c3ULL;
+  x = (x | (x << 2)) & 0x1249249249249249ULL;
+  return x;
+}
+
+class RootCell {
+public:
+  Octree::KeyType m_key;
+  uint64_t m_level;
+}; // class RootCell
+
+} // namespace
+
+const unsigned int Octree::s_maxLevel;
+
+Octree::Octree(
+  const MPICommunicator& mpiCommunicator,
+  const unsigned int maxPointsPerLeaf,
+  const unsigned int maxLevel
+) : m_mpiCommunicator(mpiCommunicator),
+  m_maxPointsPerLeaf(std::max(maxPointsPerLeaf, 1U)),
+  m_maxLevel(std::min(maxLevel, s_maxLevel)),
+  m_points(),
+  m_bounds(),
+  m_keys(),
+  m_cells(),
+  m_nodes()
+{
+}
+
+/**
+ * @brief Builds the distributed octree over the given points.
+ *
+ * @param points      Points local to this processor.
+ * @param bounds      Bounds with which the points were set, which are the
+ *                    same on all the processors.
+ * @param numPoints   Number of local points.
+ *
+ * @return true if the tree was built successfully.
+ *
+ * The tree is built bottom-up in the following steps:
+ *  1. The points are sorted globally by their Morton keys using sample sort.
+ *     Points with the same key always end up on the same processor.
+ *  2. Every processor finds its local roots, i.e. the largest cells which
+ *     contain only its own points, and builds the subtrees below them.
+ *  3. The local roots are gathered on all the processors, which then
+ *     identically build the top levels of the tree, i.e. all the ancestors
+ *     of the local roots. The top level nodes are owned by processor 0.
+ *
+ * Nodes are numbered in preorder, with the top level nodes first.
+ */
+bool
+Octree::build(
+  const InputData::Point* const points,
+  const InputData::Bounds& bounds,
+  const unsigned int numPoints
+)
+{
+  const unsigned int numProcs = m_mpiCommunicator.size();
+  const unsigned int myRank = m_mpiCommunicator.rank();
+
+  m_bounds = bounds;
+  std::vector<Record> records;
+  computeKeys(points, bounds, numPoints, records);
+  sampleSort(records);
+
+  m_points.resize(records.size());
+  m_keys.resize(records.size());
+  for (unsigned int i = 0; i < records.size(); ++i) {
+    m_points[i] = records[i].m_point;
+    m_keys[i] = records[i].m_key;
+  }
+  std::vector<Record>().swap(records);
+
+  // Find the keys bounding the points of the neighboring processors.
+  const unsigned int numLocal = static_cast<unsigned int>(m_keys.size());
+  KeyType myBounds[2] = {0, 0};
+  if (numLocal > 0) {
+    myBounds[0] = m_keys.front();
+    myBounds[1] = m_keys.back();
+  }
+  std::vector<KeyType> allBounds(numProcs * 2);
+  std::vector<unsigned int> allCounts(numProcs);
+  MPI_Allgather(myBounds, 2, MPI_UINT64_T, &allBounds[0], 2, MPI_UINT64_T, *m_mpiCommunicator);
+  MPI_Allgather(&numLocal, 1, MPI_UNSIGNED, &allCounts[0], 1, MPI_UNSIGNED, *m_mpiCommunicator);
+  bool hasPrev = false, hasNext = false;
+  KeyType prevLast = 0, nextFirst = 0;
+  for (unsigned int p = 0; p < myRank; ++p) {
+    if (allCounts[p] > 0) {
+      hasPrev = true;
+      prevLast = allBounds[(p * 2) + 1];
+    }
+  }
+  for (unsigned int p = numProcs; p > myRank + 1; --p) {
+    if (allCounts[p - 1] > 0) {
+      hasNext = true;
+      nextFirst = allBounds[(p - 1) * 2];
+    }
+  }
+
+  std::vector<Cell> localRoots;
+  findLocalRoots(0, 0, 0, numLocal, hasPrev, prevLast, hasNext, nextFirst, localRoots);
+
+  // Gather the local roots of all the processors.
+  std::vector<RootCell> myRoots(localRoots.size());
+  for (unsigned int r = 0; r < localRoots.size(); ++r) {
+    myRoots[r].m_key = localRoots[r].m_key;
+    myRoots[r].m_level = localRoots[r].m_level;
+  }
+  int mySize = static_cast<int>(myRoots.size() * sizeof(RootCell));
+  std::vector<int> rootSizes(numProcs), rootDispls(numProcs + 1, 0);
+  MPI_Allgather(&mySize, 1, MPI_INT, &rootSizes[0], 1, MPI_INT, *m_mpiCommunicator);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    rootDispls[p + 1] = rootDispls[p] + rootSizes[p];
+  }
+  std::vector<RootCell> allRoots(rootDispls[numProcs] / sizeof(RootCell));
+  MPI_Allgatherv(myRoots.empty() ? 0 : &myRoots[0], mySize, MPI_BYTE,
+                 allRoots.empty() ? 0 : &allRoots[0], &rootSizes[0], &rootDispls[0], MPI_BYTE,
+                 *m_mpiCommunicator);
+
+  // Top levels consist of all the ancestors of the local roots, in preorder.
+  typedef std::map<std::pair<KeyType, unsigned int>, unsigned int> TopMap;
+  TopMap top;
+  for (std::vector<RootCell>::const_iterator r = allRoots.begin(); r != allRoots.end(); ++r) {
+    for (unsigned int l = 0; l < r->m_level; ++l) {
+      top.insert(std::make_pair(std::make_pair(firstKey(r->m_key, l), l), 0));
+    }
+  }
+  const unsigned int numTop = static_cast<unsigned int>(top.size());
+  std::vector<unsigned int> topChildren(numTop, 0);
+  unsigned int t = 0;
+  for (TopMap::iterator c = top.begin(); c != top.end(); ++c, ++t) {
+    c->second = t;
+  }
+  std::vector<unsigned int> topParents(numTop, std::numeric_limits<unsigned int>::max());
+  for (TopMap::const_iterator c = top.begin(); c != top.end(); ++c) {
+    unsigned int level = c->first.second;
+    if (level > 0) {
+      unsigned int parent = top[std::make_pair(firstKey(c->first.first, level - 1), level - 1)];
+      topParents[c->second] = parent;
+      ++topChildren[parent];
+    }
+  }
+  for (std::vector<RootCell>::const_iterator r = allRoots.begin(); r != allRoots.end(); ++r) {
+    if (r->m_level > 0) {
+      unsigned int level = static_cast<unsigned int>(r->m_level);
+      ++topChildren[top[std::make_pair(firstKey(r->m_key, level - 1), level - 1)]];
+    }
+  }
+
+  // Build the local subtrees, with processor 0 holding the top levels first.
+  const unsigned int noParent = std::numeric_limits<unsigned int>::max();
+  std::vector<unsigned int> parents, numChildren;
+  m_cells.clear();
+  if (myRank == 0) {
+    for (TopMap::const_iterator c = top.begin(); c != top.end(); ++c) {
+      Cell cell;
+      cell.m_key = c->first.first;
+      cell.m_level = c->first.second;
+      cell.m_begin = cell.m_end = 0;
+      m_cells.push_back(cell);
+      parents.push_back(topParents[c->second]);
+      numChildren.push_back(topChildren[c->second]);
+    }
+  }
+  const unsigned int myTop = static_cast<unsigned int>(m_cells.size());
+  for (std::vector<Cell>::const_iterator r = localRoots.begin(); r != localRoots.end(); ++r) {
+    buildSubtree(*r, noParent, parents, numChildren);
+  }
+
+  // The global indices may need more bits than the local counts.
+  const unsigned int numNodes = static_cast<unsigned int>(m_cells.size());
+  Graph::Node::IndexType numIndices = numNodes;
+  Graph::Node::IndexType numBefore = 0;
+#ifdef GRAPHWORKS_INDEX64
+  MPI_Exscan(&numIndices, &numBefore, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, *m_mpiCommunicator);
+#else
+  MPI_Exscan(&numIndices, &numBefore, 1, MPI_UNSIGNED, MPI_SUM, *m_mpiCommunicator);
+#endif
+  const Graph::Node::IndexType offset = (myRank == 0) ? 0 : numBefore;
+
+  m_nodes.clear();
+  m_nodes.reserve(numNodes);
+  for (unsigned int i = 0; i < numNodes; ++i) {
+    Graph::Node::IndexType parent = Graph::Node::s_invalidIndex;
+    if (parents[i] != noParent) {
+      // The parents of the top level nodes are top level nodes as well.
+      parent = (i < myTop) ? parents[i] : offset + parents[i];
+    }
+    else if (m_cells[i].m_level > 0) {
+      // This is a local root, whose parent is a top level node on processor 0.
+      unsigned int level = m_cells[i].m_level;
+      parent = top[std::make_pair(firstKey(m_cells[i].m_key, level - 1), level - 1)];
+    }
+    m_nodes.push_back(Graph::Node(offset + i, parent, numChildren[i], m_cells[i].m_level));
+  }
+
+  return true;
+}
+
+/**
+ * @brief Computes the Morton keys of the points within the global bounding cube.
+ */
+void
+Octree::computeKeys(
+  const InputData::Point* const points,
+  const InputData::Bounds& bounds,
+  const unsigned int numPoints,
+  std::vector<Record>& records
+) const
+{
+  double localBox[6], globalBox[6];
+  for (unsigned int d = 0; d < 6; ++d) {
+    localBox[d] = std::numeric_limits<double>::max();
+  }
+  for (unsigned int i = 0; i < numPoints; ++i) {
+    double coords[3] = {points[i].x(bounds), points[i].y(bounds), points[i].z(bounds)};
+    for (unsigned int d = 0; d < 3; ++d) {
+      // The maximum is reduced as the minimum of the negation.
+      localBox[d] = std::min(localBox[d], coords[d]);
+      localBox[d + 3] = std::min(localBox[d + 3], -coords[d]);
+    }
+  }
+  MPI_Allreduce(localBox, globalBox, 6, MPI_DOUBLE, MPI_MIN, *m_mpiCommunicator);
+
+  double side = 0.0;
+  for (unsigned int d = 0; d < 3; ++d) {
+    side = std::max(side, -globalBox[d + 3] - globalBox[d]);
+  }
+  const double resolution = static_cast<double>(1U << s_maxLevel);
+  const double scale = (side > 0.0) ? (resolution / side) : 0.0;
+  const KeyType maxCoord = (1U << s_maxLevel) - 1;
+
+  records.resize(numPoints);
+  for (unsigned int i = 0; i < numPoints; ++i) {
+    double coords[3] = {points[i].x(bounds), points[i].y(bounds), points[i].z(bounds)};
+    KeyType key = 0;
+    for (unsigned int d = 0; d < 3; ++d) {
+      KeyType q = std::min(static_cast<KeyType>((coords[d] - globalBox[d]) * scale), maxCoord);
+      key |= spreadBits(q) << (2 - d);
+    }
+    records[i].m_key = key;
+    records[i].m_point = points[i];
+  }
+}
+
+/**
+ * @brief Sorts the records globally by key using regular sampling.
+ *
+ * Records are bucketed using upper bounds on the splitters, so that the
+ * records with equal keys are always sent to the same processor.
+ */
+void
+Octree::sampleSort(
+  std::vector<Record>& records
+) const
+{
+  const unsigned int numProcs = m_mpiCommunicator.size();
+  std::sort(records.begin(), records.end());
+  if (numProcs == 1) {
+    return;
+  }
+
+  std::vector<KeyType> samples;
+  if (!records.empty()) {
+    for (unsigned int i = 1; i < numProcs; ++i) {
+      samples.push_back(records[(i * records.size()) / numProcs].m_key);
+    }
+  }
+  int numSamples = static_cast<int>(samples.size());
+  std::vector<int> sampleCounts(numProcs), sampleDispls(numProcs + 1, 0);
+  MPI_Allgather(&numSamples, 1, MPI_INT, &sampleCounts[0], 1, MPI_INT, *m_mpiCommunicator);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    sampleDispls[p + 1] = sampleDispls[p] + sampleCounts[p];
+  }
+  std::vector<KeyType> allSamples(sampleDispls[numProcs]);
+  if (allSamples.empty()) {
+    return;
+  }
+  MPI_Allgatherv(samples.empty() ? 0 : &samples[0], numSamples, MPI_UINT64_T,
+                 &allSamples[0], &sampleCounts[0], &sampleDispls[0], MPI_UINT64_T,
+                 *m_mpiCommunicator);
+  std::sort(allSamples.begin(), allSamples.end());
+  std::vector<KeyType> splitters;
+  for (unsigned int i = 1; i < numProcs; ++i) {
+    splitters.push_back(allSamples[(i * allSamples.size()) / numProcs]);
+  }
+
+  std::vector<int> sendCounts(numProcs, 0), sendDispls(numProcs + 1, 0);
+  std::vector<int> recvCounts(numProcs), recvDispls(numProcs + 1, 0);
+  std::vector<Record>::const_iterator begin = records.begin();
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    std::vector<Record>::const_iterator end = records.end();
+    if (p < splitters.size()) {
+      Record bound;
+      bound.m_key = splitters[p];
+      end = std::upper_bound(begin, end, bound);
+    }
+    sendCounts[p] = static_cast<int>((end - begin) * sizeof(Record));
+    sendDispls[p + 1] = sendDispls[p] + sendCounts[p];
+    begin = end;
+  }
+  MPI_Alltoall(&sendCounts[0], 1, MPI_INT, &recvCounts[0], 1, MPI_INT, *m_mpiCommunicator);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    recvDispls[p + 1] = recvDispls[p] + recvCounts[p];
+  }
+  std::vector<Record> received(recvDispls[numProcs] / sizeof(Record));
+  MPI_Alltoallv(records.empty() ? 0 : &records[0], &sendCounts[0], &sendDispls[0], MPI_BYTE,
+                received.empty() ? 0 : &received[0], &recvCounts[0], &recvDispls[0], MPI_BYTE,
+                *m_mpiCommunicator);
+  std::sort(received.begin(), received.end());
+  records.swap(received);
+}
+
+/**
+ * @brief Recursively finds the largest cells containing only local points.
+ *
+ * @param key         First key of the cell.
+ * @param level       Level of the cell.
+ * @param begin       First local point in the cell.
+ * @param end         One past the last local point in the cell.
+ * @param hasPrev     If any lower processor has points.
+ * @param prevLast    Last key on the lower processors.
+ * @param hasNext     If any higher processor has points.
+ * @param nextFirst   First key on the higher processors.
+ * @param roots       Found local roots.
+ */
+void
+Octree::findLocalRoots(
+  const KeyType key,
+  const unsigned int level,
+  const unsigned int begin,
+  const unsigned int end,
+  const bool hasPrev,
+  const KeyType prevLast,
+  const bool hasNext,
+  const KeyType nextFirst,
+  std::vector<Cell>& roots
+) const
+{
+  if (begin == end) {
+    return;
+  }
+  bool shared = (hasPrev && (firstKey(key, level) <= prevLast)) || (hasNext && (lastKey(key, level) >= nextFirst));
+  if (!shared) {
+    Cell cell;
+    cell.m_key = key;
+    cell.m_level = level;
+    cell.m_begin = begin;
+    cell.m_end = end;
+    roots.push_back(cell);
+    return;
+  }
+
+  // Since equal keys are never split, a shared cell is never at the finest level.
+  const unsigned int shift = 3 * (s_maxLevel - level - 1);
+  unsigned int childBegin = begin;
+  for (KeyType octant = 0; octant < 8; ++octant) {
+    KeyType childKey = key | (octant << shift);
+    unsigned int childEnd = findPoint(childBegin, end, lastKey(childKey, level + 1));
+    findLocalRoots(childKey, level + 1, childBegin, childEnd, hasPrev, prevLast, hasNext, nextFirst, roots);
+    childBegin = childEnd;
+  }
+}
+
+/**
+ * @brief Recursively builds the subtree below a local cell in preorder.
+ *
+ * @param cell          Cell at the root of the subtree.
+ * @param parent        Local position of the parent of the cell.
+ * @param parents       Local positions of the parents of all the local cells.
+ * @param numChildren   Number of children of all the local cells.
+ */
+void
+Octree::buildSubtree(
+  const Cell& cell,
+  const unsigned int parent,
+  std::vector<unsigned int>& parents,
+  std::vector<unsigned int>& numChildren
+)
+{
+  const unsigned int position = static_cast<unsigned int>(m_cells.size());
+  m_cells.push_back(cell);
+  parents.push_back(parent);
+  numChildren.push_back(0);
+
+  if (((cell.m_end - cell.m_begin) <= m_maxPointsPerLeaf) || (cell.m_level >= m_maxLevel)) {
+    return;
+  }
+
+  const unsigned int shift = 3 * (s_maxLevel - cell.m_level - 1);
+  Cell child;
+  child.m_level = cell.m_level + 1;
+  child.m_begin = cell.m_begin;
+  for (KeyType octant = 0; octant < 8; ++octant) {
+    child.m_key = cell.m_key | (octant << shift);
+    child.m_end = findPoint(child.m_begin, cell.m_end, lastKey(child.m_key, child.m_level));
+    if (child.m_end > child.m_begin) {
+      ++numChildren[position];
+      buildSubtree(child, position, parents, numChildren);
+    }
+    child.m_begin = child.m_end;
+  }
+}
+
+/**
+ * @brief Finds the first local point in the range with key greater than the given key.
+ */
+unsigned int
+Octree::findPoint(
+  const unsigned int begin,
+  const unsigned int end,
+  const KeyType key
+) const
+{
+  return static_cast<unsigned int>(std::upper_bound(m_keys.begin() + begin, m_keys.begin() + end, key) - m_keys.begin());
+}
+
+Octree::KeyType
+Octree::firstKey(
+  const KeyType key,
+  const unsigned int level
+)
+{
+  if (level == 0) {
+    return 0;
+  }
+  const KeyType mask = (static_cast<KeyType>(1) << (3 * (s_maxLevel - level))) - 1;
+  return key & ~mask;
+}
+
+Octree::KeyType
+Octree::lastKey(
+  const KeyType key,
+  const unsigned int level
+)
+{
+  const KeyType mask = (static_cast<KeyType>(1) << (3 * (s_maxLevel - level))) - 1;
+  return key | mask;
+}
+
+const std::vector<Graph::Node>&
+Octree::nodes(
+) const
+{
+  return m_nodes;
+}
+
+const InputData::Point*
+Octree::points(
+) const
+{
+  return m_points.empty() ? 0 : &m_points[0];
+}
+
+/**
+ * @brief Bounds with which the points of the tree are read, which are the
+ *        bounds the tree was built with.
+ */
+const InputData::Bounds&
+Octree::bounds(
+) const
+{
+  return m_bounds;
+}
+
+unsigned int
+Octree::numLocalPoints(
+) const
+{
+  return static_cast<unsigned int>(m_points.size());
+}
+
+Octree::KeyType
+Octree::cellKey(
+  const unsigned int i
+) const
+{
+  return m_cells[i].m_key;
+}
+
+unsigned int
+Octree::cellLevel(
+  const unsigned int i
+) const
+{
+  return m_cells[i].m_level;
+}
+
+/**
+ * @brief Gets the range of the sorted local points contained in a local node.
+ *
+ * @param i       Local index of the node.
+ * @param begin   First point in the node.
+ * @param end     One past the last point in the node.
+ *
+ * The top level nodes contain points from several processors, and therefore
+ * have an empty range.
+ */
+void
+Octree::pointRange(
+  const unsigned int i,
+  unsigned int& begin,
+  unsigned int& end
+) const
+{
+  begin = m_cells[i].m_begin;
+  end = m_cells[i].m_end;
+}
+
+Octree::~Octree(
+)
+{
+}
@@ -0,0 +1,219 @@
+#include "PerfCounters.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+#ifdef __linux__
+
+/** Types and configurations of the events, in the order of PerfCounters::Event **/
+const unsigned int s_eventTypes[PerfCounters::NumEvents] = {
+  PERF_TYPE_HARDWARE,
+  PERF_TYPE_HARDWARE,
+  PERF_TYPE_HW_CACHE,
+  PERF_TYPE_HW_CACHE,
+  PERF_TYPE_HARDWARE
+};
+
+const unsigned long long s_eventConfigs[PerfCounters::NumEvents] = {
+  PERF_COUNT_HW_CPU_CYCLES,
+  PERF_COUNT_HW_INSTRUCTIONS,
+  PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+  PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+  PERF_COUNT_HW_BRANCH_MISSES
+};
+
+/**
+ * @brief Opens a disabled counter of the calling thread, and of the threads
+ *        it starts later, in user space.
+ *
+ * @return Descriptor of the counter, or -1 if it can't be opened.
+ */
+int
+openEvent(
+  const unsigned int type,
+  const unsigned long long config
+)
+{
+  struct perf_event_attr attributes;
+  std::memset(&attributes, 0, sizeof(attributes));
+  attributes.size = sizeof(attributes);
+  attributes.type = type;
+  attributes.config = config;
+  attributes.disabled = 1;
+  attributes.inherit = 1;
+  attributes.exclude_kernel = 1;
+  attributes.exclude_hv = 1;
+  attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return static_cast<int>(syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0));
+}
+
+#endif
+
+unsigned int
+maxThreads(
+)
+{
+#ifdef _OPENMP
+  return static_cast<unsigned int>(omp_get_max_threads());
+#else
+  return 1;
+#endif
+}
+
+unsigned int
+threadNumber(
+)
+{
+#ifdef _OPENMP
+  return static_cast<unsigned int>(omp_get_thread_num());
+#else
+  return 0;
+#endif
+}
+
+} // namespace
+
+/**
+ * @brief Opens the counters, which don't count until started.
+ *
+ * Every thread of a parallel region opens its own counters, so that the
+ * threads which the OpenMP runtime started before are counted as well. An
+ * event is only counted if it could be opened on all the threads.
+ */
+PerfCounters::PerfCounters(
+) : m_numThreads(maxThreads()),
+  m_descriptors(m_numThreads * NumEvents, -1)
+{
+#ifdef __linux__
+  // The runtime may start fewer threads than the maximum.
+  std::vector<char> started(m_numThreads, 0);
+  #pragma omp parallel num_threads(m_numThreads)
+  {
+    const unsigned int thread = threadNumber();
+    started[thread] = 1;
+    for (unsigned int e = 0; e < NumEvents; ++e) {
+      m_descriptors[(thread * NumEvents) + e] = openEvent(s_eventTypes[e], s_eventConfigs[e]);
+    }
+  }
+
+  for (unsigned int e = 0; e < NumEvents; ++e) {
+    bool available = true;
+    for (unsigned int t = 0; t < m_numThreads; ++t) {
+      available = available && (!started[t] || (m_descriptors[(t * NumEvents) + e] >= 0));
+    }
+    if (!available) {
+      for (unsigned int t = 0; t < m_numThreads; ++t) {
+        int& descriptor = m_descriptors[(t * NumEvents) + e];
+        if (descriptor >= 0) {
+          close(descriptor);
+          descriptor = -1;
+        }
+      }
+    }
+  }
+#endif
+}
+
+bool
+PerfCounters::isAvailable(
+  const Event event
+) const
+{
+  return m_descriptors[event] >= 0;
+}
+
+/**
+ * @brief Starts counting from zero.
+ */
+void
+PerfCounters::start(
+)
+{
+#ifdef __linux__
+  for (unsigned int d = 0; d < m_descriptors.size(); ++d) {
+    if (m_descriptors[d] >= 0) {
+      ioctl(m_descriptors[d], PERF_EVENT_IOC_RESET, 0);
+      ioctl(m_descriptors[d], PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+#endif
+}
+
+/**
+ * @brief Stops counting, and adds the counts of all the threads since the
+ *        start.
+ *
+ * @param counts   Counts of all the events, which are left as they are for
+ *                 the unavailable events.
+ */
+void
+PerfCounters::stop(
+  unsigned long long* const counts
+)
+{
+#ifdef __linux__
+  for (unsigned int d = 0; d < m_descriptors.size(); ++d) {
+    if (m_descriptors[d] < 0) {
+      continue;
+    }
+    ioctl(m_descriptors[d], PERF_EVENT_IOC_DISABLE, 0);
+    // Value, and the times for which the counter was enabled and running.
+    unsigned long long values[3] = {0, 0, 0};
+    if (read(m_descriptors[d], values, sizeof(values)) != static_cast<ssize_t>(sizeof(values))) {
+      continue;
+    }
+    if ((values[2] > 0) && (values[2] < values[1])) {
+      values[0] = static_cast<unsigned long long>(static_cast<double>(values[0]) * values[1] / values[2]);
+    }
+    counts[d % NumEvents] += values[0];
+  }
+#else
+  (void)counts;
+#endif
+}
+
+const char*
+PerfCounters::name(
+  const Event event
+)
+{
+  switch (event) {
+    case Cycles:
+      return "cycles";
+    case Instructions:
+      return "instructions";
+    case LLCMisses:
+      return "LLC read misses";
+    case DTLBMisses:
+      return "dTLB misses";
+    case BranchMisses:
+      return "branch misses";
+    default:
+      return "";
+  }
+}
+
+PerfCounters::~PerfCounters(
+)
+{
+#ifdef __linux__
+  for (unsigned int d = 0; d < m_descriptors.size(); ++d) {
+    if (m_descriptors[d] >= 0) {
+      close(m_descriptors[d]);
+    }
+  }
+#endif
+}
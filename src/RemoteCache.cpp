@@ -0,0 +1,284 @@
+#include "RemoteCache.hpp"
+
+#include "ExchangeAll.hpp"
+#include "MPICommunicator.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+
+/** Subscription to a node, or its cancellation, sent to its owner **/
+class SubscriptionMessage {
+public:
+  Graph::Node::IndexType m_node;
+  int m_subscribe;
+}; // class SubscriptionMessage
+
+/** Current payload of a node, sent by its owner **/
+class RefreshMessage {
+public:
+  Graph::Node::IndexType m_node;
+  Graph::Node::PayloadType m_payload;
+}; // class RefreshMessage
+
+} // namespace
+
+/**
+ * @brief Creates an empty cache.
+ *
+ * @param capacity          Number of entries of the cache.
+ * @param mpiCommunicator   Communicator over which the graphs are distributed.
+ */
+RemoteCache::RemoteCache(
+  const unsigned int capacity,
+  const MPICommunicator& mpiCommunicator
+) : m_mpiCommunicator(mpiCommunicator),
+  m_graph(0),
+  m_entries(),
+  m_subscriptions(),
+  m_cancellations(mpiCommunicator.size()),
+  m_numHits(0),
+  m_numMisses(0)
+{
+  if (capacity == 0) {
+    throw std::runtime_error("Remote cache needs at least one entry!");
+  }
+  const Entry empty = {Graph::Node::s_invalidIndex, PayloadType()};
+  m_entries.assign(capacity, empty);
+}
+
+/**
+ * @brief Entry of the cache which holds a node.
+ */
+unsigned int
+RemoteCache::slot(
+  const IndexType index
+) const
+{
+  return static_cast<unsigned int>(index % m_entries.size());
+}
+
+/**
+ * @brief Fills the payloads of the remote nodes in the interaction sets.
+ *
+ * @param g                 Graph over which the interaction sets are defined.
+ * @param interactionSets   Interaction sets of the local nodes.
+ *
+ * The owners first push the changed payloads of the nodes cached by other
+ * processors, and the cached nodes are then served from the cache. Every
+ * remote node is counted once per call, as a hit if it was cached, and else
+ * as a miss, which is requested from its owner. The pushes and the requests
+ * are only exchanged if some processor has any, which is agreed on in one
+ * reduction. This is a collective call.
+ */
+void
+RemoteCache::fill(
+  const Graph& g,
+  std::vector<std::vector<Graph::Node> >& interactionSets
+)
+{
+  if (m_graph != &g) {
+    clear();
+    m_graph = &g;
+  }
+
+  const unsigned int numProcs = m_mpiCommunicator.size();
+  std::vector<std::vector<IndexType> > requests(numProcs);
+  for (std::vector<std::vector<Graph::Node> >::const_iterator set = interactionSets.begin(); set != interactionSets.end(); ++set) {
+    for (std::vector<Graph::Node>::const_iterator n = set->begin(); n != set->end(); ++n) {
+      if (!g.isLocal(n->index())) {
+        requests[g.owner(n->index())].push_back(n->index());
+      }
+    }
+  }
+
+  // Only the uncached nodes are requested, and the nodes requested again
+  // are no longer cancelled.
+  std::vector<std::vector<SubscriptionMessage> > subscriptions(numProcs);
+  unsigned long long numRequested = 0;
+  unsigned long long numMissed = 0;
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    std::sort(requests[p].begin(), requests[p].end());
+    requests[p].erase(std::unique(requests[p].begin(), requests[p].end()), requests[p].end());
+    numRequested += requests[p].size();
+    std::vector<IndexType>& cancellations = m_cancellations[p];
+    std::sort(cancellations.begin(), cancellations.end());
+    cancellations.erase(std::unique(cancellations.begin(), cancellations.end()), cancellations.end());
+    std::vector<IndexType> misses;
+    for (std::vector<IndexType>::const_iterator r = requests[p].begin(); r != requests[p].end(); ++r) {
+      if (m_entries[slot(*r)].m_index != *r) {
+        misses.push_back(*r);
+      }
+    }
+    std::vector<IndexType> kept;
+    std::set_difference(cancellations.begin(), cancellations.end(), misses.begin(), misses.end(), std::back_inserter(kept));
+    for (std::vector<IndexType>::const_iterator c = kept.begin(); c != kept.end(); ++c) {
+      const SubscriptionMessage message = {*c, 0};
+      subscriptions[p].push_back(message);
+    }
+    for (std::vector<IndexType>::const_iterator m = misses.begin(); m != misses.end(); ++m) {
+      const SubscriptionMessage message = {*m, 1};
+      subscriptions[p].push_back(message);
+    }
+    cancellations.clear();
+    numMissed += misses.size();
+  }
+
+  // The owners push the nodes which changed since they were last sent.
+  std::vector<std::vector<RefreshMessage> > pushes(numProcs);
+  int localActivity[2] = {0, 0};
+  for (std::unordered_map<IndexType, Subscription>::iterator s = m_subscriptions.begin(); s != m_subscriptions.end(); ++s) {
+    const unsigned int i = g.localIndex(s->first);
+    if (g.version(i) != s->second.m_version) {
+      const RefreshMessage message = {s->first, (g.begin() + i)->payload()};
+      for (std::vector<unsigned int>::const_iterator r = s->second.m_ranks.begin(); r != s->second.m_ranks.end(); ++r) {
+        pushes[*r].push_back(message);
+      }
+      s->second.m_version = g.version(i);
+      localActivity[0] = 1;
+    }
+  }
+  for (unsigned int p = 0; (p < numProcs) && !localActivity[1]; ++p) {
+    localActivity[1] = subscriptions[p].empty() ? 0 : 1;
+  }
+  int activity[2] = {0, 0};
+  MPI_Allreduce(localActivity, activity, 2, MPI_INT, MPI_LOR, *m_mpiCommunicator);
+
+  std::vector<RefreshMessage> refreshed;
+  if (activity[0]) {
+    exchangeAll(pushes, refreshed, m_mpiCommunicator);
+    for (std::vector<RefreshMessage>::const_iterator r = refreshed.begin(); r != refreshed.end(); ++r) {
+      Entry& entry = m_entries[slot(r->m_node)];
+      if (entry.m_index == r->m_node) {
+        entry.m_payload = r->m_payload;
+      }
+    }
+  }
+
+  // The hits are taken before the misses replace any entry, so that the
+  // nodes which evict each other in the same call are still filled in.
+  std::unordered_map<IndexType, PayloadType> payloads;
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    for (std::vector<IndexType>::const_iterator r = requests[p].begin(); r != requests[p].end(); ++r) {
+      const Entry& entry = m_entries[slot(*r)];
+      if (entry.m_index == *r) {
+        payloads[*r] = entry.m_payload;
+      }
+    }
+  }
+
+  if (activity[1]) {
+    std::vector<SubscriptionMessage> incoming;
+    std::vector<unsigned int> offsets;
+    exchangeAll(subscriptions, incoming, offsets, m_mpiCommunicator);
+    std::vector<std::vector<RefreshMessage> > replies(numProcs);
+    for (unsigned int p = 0; p < numProcs; ++p) {
+      for (unsigned int k = offsets[p]; k < offsets[p + 1]; ++k) {
+        const IndexType node = incoming[k].m_node;
+        if (!incoming[k].m_subscribe) {
+          std::unordered_map<IndexType, Subscription>::iterator s = m_subscriptions.find(node);
+          if (s != m_subscriptions.end()) {
+            std::vector<unsigned int>& ranks = s->second.m_ranks;
+            ranks.erase(std::remove(ranks.begin(), ranks.end(), p), ranks.end());
+            if (ranks.empty()) {
+              m_subscriptions.erase(s);
+            }
+          }
+          continue;
+        }
+        const unsigned int i = g.localIndex(node);
+        std::unordered_map<IndexType, Subscription>::iterator s = m_subscriptions.find(node);
+        if (s == m_subscriptions.end()) {
+          s = m_subscriptions.insert(std::make_pair(node, Subscription())).first;
+          s->second.m_version = g.version(i);
+        }
+        if (std::find(s->second.m_ranks.begin(), s->second.m_ranks.end(), p) == s->second.m_ranks.end()) {
+          s->second.m_ranks.push_back(p);
+        }
+        const RefreshMessage message = {node, (g.begin() + i)->payload()};
+        replies[p].push_back(message);
+      }
+    }
+    exchangeAll(replies, refreshed, m_mpiCommunicator);
+    for (std::vector<RefreshMessage>::const_iterator r = refreshed.begin(); r != refreshed.end(); ++r) {
+      payloads[r->m_node] = r->m_payload;
+      Entry& entry = m_entries[slot(r->m_node)];
+      if ((entry.m_index != Graph::Node::s_invalidIndex) && (entry.m_index != r->m_node)) {
+        m_cancellations[g.owner(entry.m_index)].push_back(entry.m_index);
+      }
+      entry.m_index = r->m_node;
+      entry.m_payload = r->m_payload;
+    }
+  }
+  m_numMisses += numMissed;
+  m_numHits += numRequested - numMissed;
+
+  for (std::vector<std::vector<Graph::Node> >::iterator set = interactionSets.begin(); set != interactionSets.end(); ++set) {
+    for (std::vector<Graph::Node>::iterator n = set->begin(); n != set->end(); ++n) {
+      if (!g.isLocal(n->index())) {
+        n->payload() = payloads[n->index()];
+      }
+    }
+  }
+}
+
+/**
+ * @brief Drops all the cached nodes and the subscribers, as needed when the
+ *        nodes of the graph move, or the cache is used for another graph.
+ *
+ * All the processors have to clear their caches together.
+ */
+void
+RemoteCache::clear(
+)
+{
+  const Entry empty = {Graph::Node::s_invalidIndex, PayloadType()};
+  std::fill(m_entries.begin(), m_entries.end(), empty);
+  m_subscriptions.clear();
+  for (unsigned int p = 0; p < m_cancellations.size(); ++p) {
+    m_cancellations[p].clear();
+  }
+  m_graph = 0;
+}
+
+unsigned int
+RemoteCache::capacity(
+) const
+{
+  return static_cast<unsigned int>(m_entries.size());
+}
+
+/**
+ * @brief Number of remote nodes which were served by the cache.
+ */
+unsigned long long
+RemoteCache::numHits(
+) const
+{
+  return m_numHits;
+}
+
+/**
+ * @brief Number of remote nodes which were sent by their owners.
+ */
+unsigned long long
+RemoteCache::numMisses(
+) const
+{
+  return m_numMisses;
+}
+
+void
+RemoteCache::resetCounters(
+)
+{
+  m_numHits = 0;
+  m_numMisses = 0;
+}
+
+RemoteCache::~RemoteCache(
+)
+{
+}
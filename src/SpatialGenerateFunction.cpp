@@ -0,0 +1,129 @@
+#include "SpatialGenerateFunction.hpp"
+
+#include <stdexcept>
+
+SpatialGenerateFunction::SpatialGenerateFunction(
+  const bool includeSelf
+) : m_includeSelf(includeSelf),
+  m_neighbors()
+{
+}
+
+/**
+ * @brief Builds the spatial index and finds the neighborhoods of all the
+ *        local points.
+ *
+ * @param g   Graph on which computation is to be done.
+ */
+void
+SpatialGenerateFunction::prepare(
+  const Graph& g
+) const
+{
+  DistributedKdTree tree(g.communicator());
+  tree.build(g);
+  query(tree, 0, m_neighbors);
+}
+
+/**
+ * @brief Builds the spatial index and finds the neighborhoods of the listed
+ *        local points again, keeping the others.
+ *
+ * @param g       Graph on which computation is to be done.
+ * @param nodes   Local indices of the points.
+ */
+void
+SpatialGenerateFunction::prepareUpdate(
+  const Graph& g,
+  const std::vector<unsigned int>& nodes
+) const
+{
+  DistributedKdTree tree(g.communicator());
+  tree.build(g);
+  std::vector<std::vector<Graph::Node::IndexType> > neighbors;
+  query(tree, &nodes, neighbors);
+  m_neighbors.resize(g.size());
+  for (unsigned int k = 0; k < nodes.size(); ++k) {
+    m_neighbors[nodes[k]].swap(neighbors[k]);
+  }
+}
+
+/**
+ * @brief Emits the precomputed neighborhood of a node.
+ *
+ * @param g                 Graph on which computation is to be done.
+ * @param node              Node for which interaction set is to be generated.
+ * @param iteratorList      Iterator for the interaction set of the node.
+ * @param dependencyFlag    Set to false since the neighborhoods are independent.
+ *
+ * @return true if the neighborhood of the node is known.
+ */
+bool
+SpatialGenerateFunction::operator()(
+  const Graph& g,
+  const Graph::Node& node,
+  std::back_insert_iterator<std::vector<Graph::Node> >& iteratorList,
+  bool& dependencyFlag
+) const
+{
+  if (m_neighbors.size() != g.size()) {
+    throw std::runtime_error("Neighborhoods haven't been computed for the graph!");
+  }
+
+  const std::vector<Graph::Node::IndexType>& neighbors = m_neighbors[g.localIndex(node.index())];
+  for (std::vector<Graph::Node::IndexType>::const_iterator n = neighbors.begin(); n != neighbors.end(); ++n) {
+    // Local neighbors are emitted along with their payloads.
+    if (g.isLocal(*n)) {
+      iteratorList = *(g.begin() + g.localIndex(*n));
+    }
+    else {
+      iteratorList = Graph::Node(*n);
+    }
+  }
+  dependencyFlag = false;
+  return true;
+}
+
+SpatialGenerateFunction::~SpatialGenerateFunction(
+)
+{
+}
+
+NearestNeighborGenerateFunction::NearestNeighborGenerateFunction(
+  const unsigned int k,
+  const bool includeSelf
+) : SpatialGenerateFunction(includeSelf),
+  m_k(k)
+{
+  if (m_k == 0) {
+    throw std::invalid_argument("Number of nearest neighbors should be positive!");
+  }
+}
+
+void
+NearestNeighborGenerateFunction::query(
+  const DistributedKdTree& tree,
+  const std::vector<unsigned int>* const nodes,
+  std::vector<std::vector<Graph::Node::IndexType> >& neighbors
+) const
+{
+  tree.nearest(m_k, m_includeSelf, nodes, neighbors);
+}
+
+RadiusGenerateFunction::RadiusGenerateFunction(
+  const double radius,
+  const bool includeSelf
+) : SpatialGenerateFunction(includeSelf),
+  m_radius(radius)
+{
+}
+
+void
+RadiusGenerateFunction::query(
+  const DistributedKdTree& tree,
+  const std::vector<unsigned int>* const nodes,
+  std::vector<std::vector<Graph::Node::IndexType> >& neighbors
+) const
+{
+  tree.withinRadius(m_radius, m_includeSelf, nodes, neighbors);
+}
@@ -0,0 +1,66 @@
+#include "TaskPool.hpp"
+
+/**
+ * @brief Starts the worker threads.
+ *
+ * @param numThreads    Number of worker threads, at least one.
+ */
+TaskPool::TaskPool(
+  const unsigned int numThreads
+) : m_threads(),
+  m_tasks(),
+  m_mutex(),
+  m_ready(),
+  m_stopping(false)
+{
+  for (unsigned int t = 0; t < ((numThreads > 0) ? numThreads : 1); ++t) {
+    m_threads.push_back(std::thread(&TaskPool::run, this));
+  }
+}
+
+unsigned int
+TaskPool::size(
+) const
+{
+  return static_cast<unsigned int>(m_threads.size());
+}
+
+/**
+ * @brief Runs the queued tasks until the pool is destroyed.
+ */
+void
+TaskPool::run(
+)
+{
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      while (!m_stopping && m_tasks.empty()) {
+        m_ready.wait(lock);
+      }
+      if (m_tasks.empty()) {
+        return;
+      }
+      task = m_tasks.front();
+      m_tasks.pop_front();
+    }
+    task();
+  }
+}
+
+/**
+ * @brief Finishes the queued tasks, and then joins the worker threads.
+ */
+TaskPool::~TaskPool(
+)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_ready.notify_all();
+  for (std::vector<std::thread>::iterator t = m_threads.begin(); t != m_threads.end(); ++t) {
+    t->join();
+  }
+}
@@ -0,0 +1,401 @@
+#include "TreeIndex.hpp"
+
+#include "ExchangeAll.hpp"
+#include "MPICommunicator.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+/** Level of the nodes which haven't been reached from the roots **/
+const unsigned int s_unreached = std::numeric_limits<unsigned int>::max();
+
+/** Subtree of a child, sent to the owner of its parent **/
+class ChildMessage {
+public:
+  Graph::Node::IndexType m_parent;
+  Graph::Node::IndexType m_child;
+  unsigned long long m_size;
+}; // class ChildMessage
+
+/** Tour number of a child, sent to its owner **/
+class EntryMessage {
+public:
+  Graph::Node::IndexType m_node;
+  unsigned long long m_entry;
+}; // class EntryMessage
+
+} // namespace
+
+/**
+ * @brief Builds the index of the forest formed by the parents of the nodes.
+ *
+ * @param g   Graph whose parents form the forest.
+ *
+ * This is a collective call. The levels stored in the nodes are trusted to
+ * be one more than the levels of their parents, which is checked as the
+ * subtree sizes are accumulated.
+ */
+TreeIndex::TreeIndex(
+  const Graph& g
+) : m_levels(g.size(), 0),
+  m_parents(g.size(), Graph::Node::s_invalidIndex),
+  m_subtreeSizes(g.size(), 0),
+  m_entries(g.size(), 0),
+  m_childOffsets(g.size() + 1, 0),
+  m_children(),
+  m_levelOffsets(),
+  m_levelNodes(),
+  m_minLevel(0),
+  m_maxLevel(0)
+{
+  unsigned int i = 0;
+  for (Graph::ConstNodeIterator n = g.begin(); n != g.end(); ++n, ++i) {
+    if (g.isRemoved((*n).index())) {
+      continue;
+    }
+    m_levels[i] = (*n).level();
+    m_subtreeSizes[i] = 1;
+    if (!(*n).isRoot() && !g.isRemoved((*n).parent())) {
+      m_parents[i] = (*n).parent();
+    }
+  }
+  build(g, true);
+}
+
+/**
+ * @brief Builds the index of the forest formed by the given parents.
+ *
+ * @param g         Graph over whose nodes the forest is formed.
+ * @param parents   Global index of the parent of every local node, or
+ *                  Graph::Node::s_invalidIndex for the roots.
+ *
+ * This is a collective call. The levels are found from the roots down, and
+ * parents which form a cycle are an error.
+ */
+TreeIndex::TreeIndex(
+  const Graph& g,
+  const std::vector<IndexType>& parents
+) : m_levels(g.size(), 0),
+  m_parents(g.size(), Graph::Node::s_invalidIndex),
+  m_subtreeSizes(g.size(), 0),
+  m_entries(g.size(), 0),
+  m_childOffsets(g.size() + 1, 0),
+  m_children(),
+  m_levelOffsets(),
+  m_levelNodes(),
+  m_minLevel(0),
+  m_maxLevel(0)
+{
+  for (unsigned int i = 0; i < g.size(); ++i) {
+    if (g.isRemoved(g.globalIndex(i))) {
+      continue;
+    }
+    m_subtreeSizes[i] = 1;
+    if ((parents[i] != Graph::Node::s_invalidIndex) && !g.isRemoved(parents[i])) {
+      m_parents[i] = parents[i];
+    }
+  }
+  build(g, false);
+}
+
+/**
+ * @brief Builds the index, once the parents are known.
+ *
+ * @param g             Graph over whose nodes the forest is formed.
+ * @param levelsKnown   Whether the levels are already set.
+ *
+ * The children are listed by transposing the parents. The subtree sizes
+ * are then accumulated from the deepest level up, and the tour is numbered
+ * from the roots down, with one exchange per level each, so that the work
+ * is proportional to the nodes and the number of exchanges to the height
+ * of the forest.
+ */
+void
+TreeIndex::build(
+  const Graph& g,
+  const bool levelsKnown
+)
+{
+  listChildren(g);
+
+  if (levelsKnown) {
+    unsigned int localMinLevel = std::numeric_limits<unsigned int>::max();
+    unsigned int localMaxLevel = 0;
+    for (unsigned int i = 0; i < g.size(); ++i) {
+      if (m_subtreeSizes[i] != 0) {
+        localMinLevel = std::min(localMinLevel, m_levels[i]);
+        localMaxLevel = std::max(localMaxLevel, m_levels[i]);
+      }
+    }
+    MPI_Allreduce(&localMinLevel, &m_minLevel, 1, MPI_UNSIGNED, MPI_MIN, *g.communicator());
+    MPI_Allreduce(&localMaxLevel, &m_maxLevel, 1, MPI_UNSIGNED, MPI_MAX, *g.communicator());
+    if (m_minLevel > m_maxLevel) {
+      m_minLevel = m_maxLevel + 1;
+    }
+  }
+  else {
+    computeLevels(g);
+  }
+
+  bucketLevels();
+
+  std::vector<unsigned long long> childSizes;
+  accumulateSubtreeSizes(g, childSizes);
+  numberTour(g, childSizes);
+}
+
+/**
+ * @brief Lists the children of every node, by transposing the parents.
+ */
+void
+TreeIndex::listChildren(
+  const Graph& g
+)
+{
+  std::vector<std::vector<IndexType> > parents(g.size());
+  for (unsigned int i = 0; i < g.size(); ++i) {
+    if (!isRoot(i)) {
+      parents[i].push_back(m_parents[i]);
+    }
+  }
+  CompressedIndexLists<IndexType> children;
+  g.transpose(parents, children);
+
+  std::vector<IndexType> nodeChildren;
+  for (unsigned int i = 0; i < g.size(); ++i) {
+    children.decode(i, nodeChildren);
+    m_children.insert(m_children.end(), nodeChildren.begin(), nodeChildren.end());
+    m_childOffsets[i + 1] = m_children.size();
+  }
+}
+
+/**
+ * @brief Finds the levels as the depths below the roots, one level per
+ *        exchange.
+ */
+void
+TreeIndex::computeLevels(
+  const Graph& g
+)
+{
+  const MPICommunicator& mpiCommunicator = g.communicator();
+  std::vector<unsigned int> frontier;
+  for (unsigned int i = 0; i < g.size(); ++i) {
+    m_levels[i] = s_unreached;
+    if ((m_subtreeSizes[i] != 0) && isRoot(i)) {
+      m_levels[i] = 0;
+      frontier.push_back(i);
+    }
+  }
+
+  std::vector<unsigned int> next;
+  std::vector<std::vector<IndexType> > outgoing(mpiCommunicator.size());
+  std::vector<IndexType> incoming;
+  unsigned int level = 0;
+  while (true) {
+    int localActive = frontier.empty() ? 0 : 1;
+    int active = 0;
+    MPI_Allreduce(&localActive, &active, 1, MPI_INT, MPI_LOR, *mpiCommunicator);
+    if (!active) {
+      break;
+    }
+
+    for (unsigned int p = 0; p < outgoing.size(); ++p) {
+      outgoing[p].clear();
+    }
+    next.clear();
+    for (std::vector<unsigned int>::const_iterator i = frontier.begin(); i != frontier.end(); ++i) {
+      for (std::size_t c = m_childOffsets[*i]; c < m_childOffsets[*i + 1]; ++c) {
+        if (g.isLocal(m_children[c])) {
+          next.push_back(g.localIndex(m_children[c]));
+        }
+        else {
+          outgoing[g.owner(m_children[c])].push_back(m_children[c]);
+        }
+      }
+    }
+    exchangeAll(outgoing, incoming, mpiCommunicator);
+    for (std::vector<IndexType>::const_iterator c = incoming.begin(); c != incoming.end(); ++c) {
+      next.push_back(g.localIndex(*c));
+    }
+    ++level;
+    for (std::vector<unsigned int>::const_iterator i = next.begin(); i != next.end(); ++i) {
+      m_levels[*i] = level;
+    }
+    frontier.swap(next);
+  }
+
+  // The nodes on cycles are never reached from the roots.
+  int localCycle = 0;
+  for (unsigned int i = 0; i < g.size(); ++i) {
+    if ((m_subtreeSizes[i] != 0) && (m_levels[i] == s_unreached)) {
+      localCycle = 1;
+    }
+  }
+  int cycle = 0;
+  MPI_Allreduce(&localCycle, &cycle, 1, MPI_INT, MPI_LOR, *mpiCommunicator);
+  if (cycle) {
+    throw std::runtime_error("Parents of the nodes form a cycle!");
+  }
+
+  m_minLevel = (level == 0) ? 1 : 0;
+  m_maxLevel = (level == 0) ? 0 : level - 1;
+}
+
+/**
+ * @brief Buckets the nodes by their levels.
+ */
+void
+TreeIndex::bucketLevels(
+)
+{
+  m_levelOffsets.assign(m_maxLevel + 2 - m_minLevel, 0);
+  for (unsigned int i = 0; i < m_levels.size(); ++i) {
+    if (m_subtreeSizes[i] != 0) {
+      ++m_levelOffsets[m_levels[i] - m_minLevel + 1];
+    }
+  }
+  for (unsigned int l = 1; l < m_levelOffsets.size(); ++l) {
+    m_levelOffsets[l] += m_levelOffsets[l - 1];
+  }
+  m_levelNodes.resize(m_levelOffsets.back());
+  std::vector<unsigned int> next(m_levelOffsets.begin(), m_levelOffsets.end() - 1);
+  for (unsigned int i = 0; i < m_levels.size(); ++i) {
+    if (m_subtreeSizes[i] != 0) {
+      m_levelNodes[next[m_levels[i] - m_minLevel]++] = i;
+    }
+  }
+}
+
+/**
+ * @brief Accumulates the subtree sizes from the deepest level up.
+ *
+ * @param g            Graph over whose nodes the forest is formed.
+ * @param childSizes   Subtree sizes of the listed children.
+ */
+void
+TreeIndex::accumulateSubtreeSizes(
+  const Graph& g,
+  std::vector<unsigned long long>& childSizes
+)
+{
+  const MPICommunicator& mpiCommunicator = g.communicator();
+  childSizes.assign(m_children.size(), 0);
+  std::vector<std::vector<ChildMessage> > outgoing(mpiCommunicator.size());
+  std::vector<ChildMessage> incoming;
+  std::vector<ChildMessage> arrived;
+  int localMismatch = 0;
+  for (unsigned int l = m_maxLevel + 1; l-- > m_minLevel; ) {
+    for (unsigned int p = 0; p < outgoing.size(); ++p) {
+      outgoing[p].clear();
+    }
+    incoming.clear();
+    const unsigned int* nodes = levelNodes(l);
+    for (unsigned int k = 0; k < numLevelNodes(l); ++k) {
+      const unsigned int i = nodes[k];
+      if (isRoot(i)) {
+        continue;
+      }
+      ChildMessage message = {m_parents[i], g.globalIndex(i), m_subtreeSizes[i]};
+      if (g.isLocal(m_parents[i])) {
+        incoming.push_back(message);
+      }
+      else {
+        outgoing[g.owner(m_parents[i])].push_back(message);
+      }
+    }
+    exchangeAll(outgoing, arrived, mpiCommunicator);
+    incoming.insert(incoming.end(), arrived.begin(), arrived.end());
+
+    for (std::vector<ChildMessage>::const_iterator m = incoming.begin(); m != incoming.end(); ++m) {
+      const unsigned int parent = g.localIndex(m->m_parent);
+      // The mismatch is only thrown once all the levels were exchanged,
+      // so that the other processors don't wait for this one.
+      if (m_levels[parent] + 1 != l) {
+        localMismatch = 1;
+        continue;
+      }
+      const std::size_t c = std::lower_bound(m_children.begin() + m_childOffsets[parent], m_children.begin() + m_childOffsets[parent + 1], m->m_child) - m_children.begin();
+      childSizes[c] = m->m_size;
+      m_subtreeSizes[parent] += m->m_size;
+    }
+  }
+
+  int mismatch = 0;
+  MPI_Allreduce(&localMismatch, &mismatch, 1, MPI_INT, MPI_LOR, *mpiCommunicator);
+  if (mismatch) {
+    throw std::runtime_error("Levels of the nodes don't follow their parents!");
+  }
+}
+
+/**
+ * @brief Numbers the Euler tour from the roots down.
+ *
+ * @param g            Graph over whose nodes the forest is formed.
+ * @param childSizes   Subtree sizes of the listed children.
+ *
+ * A subtree of s nodes takes 2s consecutive numbers, so that the tour
+ * number of every child follows from its parent and its earlier siblings.
+ */
+void
+TreeIndex::numberTour(
+  const Graph& g,
+  const std::vector<unsigned long long>& childSizes
+)
+{
+  const MPICommunicator& mpiCommunicator = g.communicator();
+
+  // The roots follow the roots of the lower ranks.
+  unsigned long long localTour = 0;
+  for (unsigned int i = 0; i < g.size(); ++i) {
+    if ((m_subtreeSizes[i] != 0) && isRoot(i)) {
+      localTour += 2 * m_subtreeSizes[i];
+    }
+  }
+  unsigned long long tourBefore = 0;
+  MPI_Exscan(&localTour, &tourBefore, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, *mpiCommunicator);
+  if (mpiCommunicator.rank() == 0) {
+    tourBefore = 0;
+  }
+  for (unsigned int i = 0; i < g.size(); ++i) {
+    if ((m_subtreeSizes[i] != 0) && isRoot(i)) {
+      m_entries[i] = tourBefore;
+      tourBefore += 2 * m_subtreeSizes[i];
+    }
+  }
+
+  std::vector<std::vector<EntryMessage> > outgoing(mpiCommunicator.size());
+  std::vector<EntryMessage> incoming;
+  for (unsigned int l = m_minLevel; l <= m_maxLevel; ++l) {
+    for (unsigned int p = 0; p < outgoing.size(); ++p) {
+      outgoing[p].clear();
+    }
+    const unsigned int* nodes = levelNodes(l);
+    for (unsigned int k = 0; k < numLevelNodes(l); ++k) {
+      const unsigned int i = nodes[k];
+      unsigned long long entry = m_entries[i] + 1;
+      for (std::size_t c = m_childOffsets[i]; c < m_childOffsets[i + 1]; ++c) {
+        if (g.isLocal(m_children[c])) {
+          m_entries[g.localIndex(m_children[c])] = entry;
+        }
+        else {
+          EntryMessage message = {m_children[c], entry};
+          outgoing[g.owner(m_children[c])].push_back(message);
+        }
+        entry += 2 * childSizes[c];
+      }
+    }
+    exchangeAll(outgoing, incoming, mpiCommunicator);
+    for (std::vector<EntryMessage>::const_iterator m = incoming.begin(); m != incoming.end(); ++m) {
+      m_entries[g.localIndex(m->m_node)] = m->m_entry;
+    }
+  }
+}
+
+TreeIndex::~TreeIndex(
+)
+{
+}
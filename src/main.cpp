@@ -29,7 +29,7 @@ int main(int argc, char** argv)
     return 1;
   }
 
-  Graph myGraph(inputData.points(), inputData.numLocalPoints(), mpiCommunicator); 
+  Graph myGraph(inputData, mpiCommunicator);
 
   GraphCompute graphCompute(mpiCommunicator);
 
@@ -0,0 +1,227 @@
+#include "Check.hpp"
+
+#include "BlockFile.hpp"
+#include "EdgeList.hpp"
+#include "InputData.hpp"
+#include "MPICommunicator.hpp"
+
+#include <mpi.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* const s_recordsFile = "BlockFileTest.records.gwb";
+const char* const s_pointsText = "BlockFileTest.points.txt";
+const char* const s_pointsFile = "BlockFileTest.points.gwb";
+const char* const s_edgesText = "BlockFileTest.edges.txt";
+const char* const s_edgesFile = "BlockFileTest.edges.gwb";
+
+/**
+ * @brief Reads ranges of records which start and end within the blocks, on
+ *        the block boundaries, and across many blocks, and the metadata,
+ *        which doesn't fill its last word.
+ */
+void
+testRanges(
+  const MPICommunicator& mpiCommunicator
+)
+{
+  const unsigned long long numRecords = 1000;
+  std::vector<unsigned long long> records(numRecords);
+  for (unsigned long long r = 0; r < numRecords; ++r) {
+    records[r] = (r * 2654435761ULL) ^ (r << 40);
+  }
+  const std::string text("records with metadata");
+  const std::vector<char> metadata(text.begin(), text.end());
+  int written = 0;
+  if (mpiCommunicator.rank() == 0) {
+    written = BlockFile::write(s_recordsFile, reinterpret_cast<const char*>(&records[0]), sizeof(unsigned long long), numRecords, 37, metadata) ? 1 : 0;
+  }
+  MPI_Bcast(&written, 1, MPI_INT, 0, *mpiCommunicator);
+  GRAPHWORKS_CHECK(written);
+  GRAPHWORKS_CHECK(BlockFile::isBlockFile(s_recordsFile));
+  GRAPHWORKS_CHECK(!BlockFile::isBlockFile(s_pointsText));
+
+  MPI_File file;
+  GRAPHWORKS_CHECK(MPI_File_open(*mpiCommunicator, const_cast<char*>(s_recordsFile), MPI_MODE_RDONLY, MPI_INFO_NULL, &file) == MPI_SUCCESS);
+  BlockFile blockFile;
+  GRAPHWORKS_CHECK(blockFile.open(file));
+  GRAPHWORKS_CHECK(blockFile.recordSize() == sizeof(unsigned long long));
+  GRAPHWORKS_CHECK(blockFile.numRecords() == numRecords);
+  GRAPHWORKS_CHECK(blockFile.numBlocks() == (numRecords + 36) / 37);
+  GRAPHWORKS_CHECK(blockFile.metadata() == metadata);
+
+  const unsigned long long ranges[][2] = {{0, numRecords}, {0, 1}, {5, 10}, {37, 37}, {30, 100}, {999, 1}, {500, 0}};
+  for (unsigned int t = 0; t < sizeof(ranges) / sizeof(ranges[0]); ++t) {
+    const unsigned long long first = ranges[t][0] + mpiCommunicator.rank() % 2;
+    const unsigned long long count = std::min(ranges[t][1], numRecords - first);
+    std::vector<unsigned long long> read(count + 1, 0);
+    GRAPHWORKS_CHECK(blockFile.read(file, first, count, reinterpret_cast<char*>(&read[0])));
+    for (unsigned long long r = 0; r < count; ++r) {
+      GRAPHWORKS_CHECK(read[r] == records[first + r]);
+    }
+  }
+  std::vector<unsigned long long> read(2);
+  GRAPHWORKS_CHECK(!blockFile.read(file, numRecords - 1, 2, reinterpret_cast<char*>(&read[0])));
+  MPI_File_close(&file);
+}
+
+/**
+ * @brief Converts a text file of points to a compressed one, which has to
+ *        read back as the same points, within the same bounds.
+ */
+void
+testPoints(
+  const MPICommunicator& mpiCommunicator
+)
+{
+  const unsigned int numPoints = 1001;
+  if (mpiCommunicator.rank() == 0) {
+    std::ofstream text(s_pointsText);
+    text << numPoints << std::endl;
+    for (unsigned int i = 0; i < numPoints; ++i) {
+      text << (i % 17) * 0.25 << " " << (i % 101) * -1.5 << " " << i * 0.001 << std::endl;
+    }
+  }
+  MPI_Barrier(*mpiCommunicator);
+
+  for (unsigned int shared = 0; shared < 2; ++shared) {
+    InputData textData(shared == 1);
+    GRAPHWORKS_CHECK(textData.read(s_pointsText, mpiCommunicator));
+    GRAPHWORKS_CHECK(textData.write(s_pointsFile, mpiCommunicator));
+    GRAPHWORKS_CHECK(BlockFile::isBlockFile(s_pointsFile));
+    InputData compressedData(shared == 1);
+    GRAPHWORKS_CHECK(compressedData.read(s_pointsFile, mpiCommunicator));
+    GRAPHWORKS_CHECK(compressedData.numLocalPoints() == textData.numLocalPoints());
+    const InputData::Bounds& textBounds = textData.bounds();
+    const InputData::Bounds& compressedBounds = compressedData.bounds();
+#if defined(GRAPHWORKS_COORDS_QUANTIZED)
+    for (unsigned int d = 0; d < 3; ++d) {
+      GRAPHWORKS_CHECK(compressedBounds.lower(d) == textBounds.lower(d));
+      GRAPHWORKS_CHECK(compressedBounds.step(d) == textBounds.step(d));
+    }
+#endif
+    for (unsigned int i = 0; (i < textData.numLocalPoints()) && (i < compressedData.numLocalPoints()); ++i) {
+      const InputData::Point& a = textData.points()[i];
+      const InputData::Point& b = compressedData.points()[i];
+      GRAPHWORKS_CHECK(a.x(textBounds) == b.x(compressedBounds));
+      GRAPHWORKS_CHECK(a.y(textBounds) == b.y(compressedBounds));
+      GRAPHWORKS_CHECK(a.z(textBounds) == b.z(compressedBounds));
+    }
+  }
+}
+
+/**
+ * @brief Gathers the edges of all the processors in the order of the
+ *        processors, which is the order of their sources, as triples of the
+ *        source, the target and the weight.
+ *
+ * The splitters depend on how the edges were read, so only the gathered
+ * edges, and not the rows of a processor, are the same for every format.
+ */
+void
+gatherEdges(
+  const EdgeList& edgeList,
+  const MPICommunicator& mpiCommunicator,
+  std::vector<double>& rows
+)
+{
+  std::vector<double> local;
+  for (unsigned int i = 0; i < edgeList.numLocalNodes(); ++i) {
+    for (std::size_t k = 0; k < edgeList.numEdges(i); ++k) {
+      const EdgeList::Edge& edge = edgeList.edges(i)[k];
+      GRAPHWORKS_CHECK(edge.m_source == edgeList.firstNode() + i);
+      local.push_back(static_cast<double>(edge.m_source));
+      local.push_back(static_cast<double>(edge.m_target));
+      local.push_back(edge.m_weight);
+    }
+  }
+  const unsigned int numProcs = mpiCommunicator.size();
+  int count = static_cast<int>(local.size());
+  std::vector<int> counts(numProcs, 0);
+  MPI_Allgather(&count, 1, MPI_INT, &counts[0], 1, MPI_INT, *mpiCommunicator);
+  std::vector<int> displacements(numProcs, 0);
+  for (unsigned int p = 1; p < numProcs; ++p) {
+    displacements[p] = displacements[p - 1] + counts[p - 1];
+  }
+  rows.resize(displacements[numProcs - 1] + counts[numProcs - 1] + 1);
+  local.push_back(0.0);
+  MPI_Allgatherv(&local[0], count, MPI_DOUBLE, &rows[0], &counts[0], &displacements[0], MPI_DOUBLE, *mpiCommunicator);
+  rows.pop_back();
+}
+
+/**
+ * @brief Converts a text edge list to a compressed one, which has to build
+ *        the same rows, for weighted and unweighted edges.
+ */
+void
+testEdges(
+  const MPICommunicator& mpiCommunicator
+)
+{
+  for (unsigned int weighted = 0; weighted < 2; ++weighted) {
+    if (mpiCommunicator.rank() == 0) {
+      std::ofstream text(s_edgesText);
+      text << "# test edges" << std::endl;
+      for (unsigned int e = 0; e < 3000; ++e) {
+        text << (e * 7) % 701 << " " << (e * 13) % 503;
+        if (weighted && (e % 2 == 1)) {
+          text << " " << (e % 10) * 0.5;
+        }
+        text << std::endl;
+      }
+    }
+    MPI_Barrier(*mpiCommunicator);
+
+    EdgeList textEdges;
+    GRAPHWORKS_CHECK(textEdges.read(s_edgesText, EdgeList::Text, mpiCommunicator));
+    GRAPHWORKS_CHECK(textEdges.write(s_edgesFile, mpiCommunicator));
+    textEdges.build(mpiCommunicator);
+    EdgeList compressedEdges;
+    GRAPHWORKS_CHECK(compressedEdges.read(s_edgesFile, EdgeList::Compressed, mpiCommunicator));
+    compressedEdges.build(mpiCommunicator);
+
+    GRAPHWORKS_CHECK(compressedEdges.numGlobalEdges() == textEdges.numGlobalEdges());
+    GRAPHWORKS_CHECK(compressedEdges.numGlobalNodes() == textEdges.numGlobalNodes());
+    std::vector<double> textRows;
+    std::vector<double> compressedRows;
+    gatherEdges(textEdges, mpiCommunicator, textRows);
+    gatherEdges(compressedEdges, mpiCommunicator, compressedRows);
+    GRAPHWORKS_CHECK(textRows.size() == 3 * textEdges.numGlobalEdges());
+    GRAPHWORKS_CHECK(compressedRows == textRows);
+  }
+}
+
+} // namespace
+
+int
+main(
+  int argc,
+  char** argv
+)
+{
+  MPI_Init(&argc, &argv);
+  int status = 0;
+  {
+    MPICommunicator mpiCommunicator(MPI_COMM_WORLD);
+#ifdef GRAPHWORKS_HAVE_ZLIB
+    testRanges(mpiCommunicator);
+    testPoints(mpiCommunicator);
+    testEdges(mpiCommunicator);
+    MPI_Barrier(*mpiCommunicator);
+    if (mpiCommunicator.rank() == 0) {
+      const char* const files[] = {s_recordsFile, s_pointsText, s_pointsFile, s_edgesText, s_edgesFile};
+      for (unsigned int f = 0; f < sizeof(files) / sizeof(files[0]); ++f) {
+        std::remove(files[f]);
+      }
+    }
+#endif
+    status = finishTest("BlockFile", mpiCommunicator);
+  }
+  MPI_Finalize();
+  return status;
+}
@@ -0,0 +1,68 @@
+#ifndef GRAPHWORKS_TESTS_CHECK_HPP_
+#define GRAPHWORKS_TESTS_CHECK_HPP_
+
+#include "MPICommunicator.hpp"
+
+#include <mpi.h>
+
+#include <iostream>
+
+/**
+ * Checks of the tests, which are MPI programs exiting with a non zero
+ * status if a check failed on any of the processors.
+ */
+namespace {
+
+/** Number of the failed checks of this processor **/
+unsigned int s_numFailures = 0;
+
+/** Failed checks which are printed, before they are only counted **/
+const unsigned int s_maxReported = 10;
+
+void
+reportFailure(
+  const char* const file,
+  const int line,
+  const char* const condition
+)
+{
+  if (s_numFailures++ < s_maxReported) {
+    std::cerr << file << ":" << line << ": check failed: " << condition << std::endl;
+  }
+}
+
+/**
+ * @brief Counts the failed checks over all the processors, and reports the
+ *        result of a test. This is a collective call.
+ *
+ * @return Exit status of the test.
+ */
+int
+finishTest(
+  const char* const name,
+  const MPICommunicator& mpiCommunicator
+)
+{
+  unsigned int numFailures = 0;
+  MPI_Allreduce(&s_numFailures, &numFailures, 1, MPI_UNSIGNED, MPI_SUM, *mpiCommunicator);
+  if (mpiCommunicator.rank() == 0) {
+    std::cout << name << ": " << ((numFailures == 0) ? "passed" : "FAILED")
+      << " [" << mpiCommunicator.size() << " processors";
+    if (numFailures > 0) {
+      std::cout << ", " << numFailures << " failed checks";
+    }
+    std::cout << "]" << std::endl;
+  }
+  return (numFailures == 0) ? 0 : 1;
+}
+
+} // namespace
+
+#define GRAPHWORKS_CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      reportFailure(__FILE__, __LINE__, #condition); \
+    } \
+  } while (0)
+
+#endif // GRAPHWORKS_TESTS_CHECK_HPP_
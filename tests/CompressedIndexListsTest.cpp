@@ -0,0 +1,80 @@
+#include "Check.hpp"
+
+#include "CompressedIndexLists.hpp"
+#include "MPICommunicator.hpp"
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Encodes sorted lists of small, large, extreme and repeated
+ *        indices, and checks that they decode to the same lists.
+ */
+template <typename IndexType>
+void
+testRoundTrip(
+)
+{
+  std::srand(1);
+  CompressedIndexLists<IndexType> lists;
+  std::vector<std::vector<IndexType> > expected;
+  for (unsigned int l = 0; l < 2000; ++l) {
+    const unsigned int count = static_cast<unsigned int>(std::rand() % (((l % 7) == 0) ? 1000 : 40));
+    std::vector<IndexType> indices(count);
+    for (unsigned int k = 0; k < count; ++k) {
+      switch (l % 4) {
+        case 0:
+          indices[k] = static_cast<IndexType>(std::rand() % 1000);
+          break;
+        case 1:
+          indices[k] = static_cast<IndexType>(std::rand()) * static_cast<IndexType>(std::rand());
+          break;
+        case 2:
+          indices[k] = static_cast<IndexType>(~static_cast<IndexType>(0) - (std::rand() % 5));
+          break;
+        default:
+          indices[k] = static_cast<IndexType>(std::rand() % 3);
+          break;
+      }
+    }
+    std::sort(indices.begin(), indices.end());
+    lists.append(indices.empty() ? 0 : &indices[0], count);
+    expected.push_back(indices);
+  }
+
+  GRAPHWORKS_CHECK(lists.numLists() == expected.size());
+  std::vector<IndexType> decoded;
+  for (unsigned int l = 0; l < expected.size(); ++l) {
+    lists.decode(l, decoded);
+    GRAPHWORKS_CHECK(lists.size(l) == expected[l].size());
+    GRAPHWORKS_CHECK(decoded == expected[l]);
+  }
+
+  lists.clear();
+  GRAPHWORKS_CHECK(lists.numLists() == 0);
+}
+
+} // namespace
+
+int
+main(
+  int argc,
+  char** argv
+)
+{
+  MPI_Init(&argc, &argv);
+  int status = 0;
+  {
+    MPICommunicator mpiCommunicator(MPI_COMM_WORLD);
+    testRoundTrip<unsigned int>();
+    testRoundTrip<unsigned long long>();
+    status = finishTest("CompressedIndexLists", mpiCommunicator);
+  }
+  MPI_Finalize();
+  return status;
+}
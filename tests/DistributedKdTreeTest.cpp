@@ -0,0 +1,130 @@
+#include "Check.hpp"
+
+#include "DistributedKdTree.hpp"
+#include "Graph.hpp"
+#include "InputData.hpp"
+#include "MPICommunicator.hpp"
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+double
+squaredDistance(
+  const InputData::Point& a,
+  const InputData::Point& b,
+  const InputData::Bounds& bounds
+)
+{
+  const double dx = a.x(bounds) - b.x(bounds);
+  const double dy = a.y(bounds) - b.y(bounds);
+  const double dz = a.z(bounds) - b.z(bounds);
+  return (dx * dx) + (dy * dy) + (dz * dz);
+}
+
+/**
+ * @brief Answers the k nearest neighbor and the radius queries of all the
+ *        points, which are split unevenly between the processors, and checks
+ *        them against a brute force search over all the points.
+ *
+ * The neighbors are compared by their distances, which doesn't depend on
+ * how ties are broken.
+ */
+void
+testQueries(
+  const MPICommunicator& mpiCommunicator
+)
+{
+  const unsigned int numPoints = 600;
+  const unsigned int k = 5;
+  const double radius = 1.5;
+  const double lower[3] = {0.0, 0.0, 0.0};
+  const double upper[3] = {10.0, 10.0, 10.0};
+  const InputData::Bounds bounds(lower, upper);
+
+  std::srand(7);
+  std::vector<InputData::Point> points(numPoints);
+  for (unsigned int i = 0; i < numPoints; ++i) {
+    points[i].set((std::rand() % 1000) / 100.0, (std::rand() % 1000) / 100.0, (std::rand() % 1000) / 100.0, bounds);
+  }
+
+  // The second processor gets no points, and the first one the most.
+  const unsigned int numProcs = mpiCommunicator.size();
+  const unsigned int myRank = mpiCommunicator.rank();
+  std::vector<unsigned int> offsets(numProcs + 1, 0);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    const unsigned int weight = (p == 1) ? 0 : ((p == 0) ? 3 : 1);
+    offsets[p + 1] = offsets[p] + weight;
+  }
+  const unsigned int totalWeight = offsets[numProcs];
+  for (unsigned int p = 0; p <= numProcs; ++p) {
+    offsets[p] = (offsets[p] * numPoints) / totalWeight;
+  }
+  const unsigned int first = offsets[myRank];
+  const unsigned int numLocal = offsets[myRank + 1] - first;
+
+  Graph g(numLocal > 0 ? &points[first] : 0, numLocal, bounds, mpiCommunicator);
+  DistributedKdTree tree(mpiCommunicator);
+  tree.build(g);
+
+  for (unsigned int includeSelf = 0; includeSelf < 2; ++includeSelf) {
+    std::vector<std::vector<Graph::Node::IndexType> > nearest;
+    std::vector<std::vector<Graph::Node::IndexType> > withinRadius;
+    tree.nearest(k, includeSelf == 1, nearest);
+    tree.withinRadius(radius, includeSelf == 1, withinRadius);
+    GRAPHWORKS_CHECK(nearest.size() == numLocal);
+    GRAPHWORKS_CHECK(withinRadius.size() == numLocal);
+
+    for (unsigned int i = 0; (i < numLocal) && (i < nearest.size()) && (i < withinRadius.size()); ++i) {
+      const InputData::Point& query = points[first + i];
+      std::vector<double> distances;
+      std::vector<Graph::Node::IndexType> inRadius;
+      for (unsigned int j = 0; j < numPoints; ++j) {
+        if ((j == first + i) && !includeSelf) {
+          continue;
+        }
+        const double distance = squaredDistance(query, points[j], bounds);
+        distances.push_back(distance);
+        if (distance <= radius * radius) {
+          inRadius.push_back(j);
+        }
+      }
+      std::sort(distances.begin(), distances.end());
+
+      GRAPHWORKS_CHECK(nearest[i].size() == k);
+      std::vector<double> found;
+      for (unsigned int n = 0; n < nearest[i].size(); ++n) {
+        GRAPHWORKS_CHECK(nearest[i][n] < numPoints);
+        found.push_back(squaredDistance(query, points[nearest[i][n] % numPoints], bounds));
+      }
+      GRAPHWORKS_CHECK(found == std::vector<double>(distances.begin(), distances.begin() + std::min<std::size_t>(k, distances.size())));
+
+      std::vector<Graph::Node::IndexType> neighbors(withinRadius[i]);
+      std::sort(neighbors.begin(), neighbors.end());
+      GRAPHWORKS_CHECK(neighbors == inRadius);
+    }
+  }
+}
+
+} // namespace
+
+int
+main(
+  int argc,
+  char** argv
+)
+{
+  MPI_Init(&argc, &argv);
+  int status = 0;
+  {
+    MPICommunicator mpiCommunicator(MPI_COMM_WORLD);
+    testQueries(mpiCommunicator);
+    status = finishTest("DistributedKdTree", mpiCommunicator);
+  }
+  MPI_Finalize();
+  return status;
+}
@@ -0,0 +1,320 @@
+#include "Check.hpp"
+
+#include "EdgeGenerateFunction.hpp"
+#include "ExchangeAll.hpp"
+#include "Graph.hpp"
+#include "GraphCompute.hpp"
+#include "MPICommunicator.hpp"
+#include "ReductionCombineFunction.hpp"
+
+#include <mpi.h>
+
+#include <vector>
+
+namespace {
+
+/** Object sent by exchangeAll **/
+class Item {
+  public:
+    unsigned int m_from;
+    unsigned int m_to;
+    unsigned int m_position;
+}; // class Item
+
+/**
+ * @brief Number of the items sent from one processor to another, which is
+ *        zero for some of the pairs.
+ */
+unsigned int
+numItems(
+  const unsigned int from,
+  const unsigned int to
+)
+{
+  return (from + (2 * to)) % 4;
+}
+
+/**
+ * @brief Sends a different number of items to every processor, and checks
+ *        the received items and their offsets.
+ */
+void
+testExchangeAll(
+  const MPICommunicator& mpiCommunicator
+)
+{
+  const unsigned int numProcs = mpiCommunicator.size();
+  const unsigned int myRank = mpiCommunicator.rank();
+  std::vector<std::vector<Item> > outgoing(numProcs);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    for (unsigned int k = 0; k < numItems(myRank, p); ++k) {
+      Item item;
+      item.m_from = myRank;
+      item.m_to = p;
+      item.m_position = k;
+      outgoing[p].push_back(item);
+    }
+  }
+
+  std::vector<Item> incoming;
+  std::vector<unsigned int> offsets;
+  exchangeAll(outgoing, incoming, offsets, mpiCommunicator);
+
+  GRAPHWORKS_CHECK(offsets.size() == numProcs + 1);
+  GRAPHWORKS_CHECK(offsets[0] == 0);
+  GRAPHWORKS_CHECK(offsets[numProcs] == incoming.size());
+  for (unsigned int p = 0; (p < numProcs) && (offsets.size() == numProcs + 1); ++p) {
+    GRAPHWORKS_CHECK(offsets[p + 1] - offsets[p] == numItems(p, myRank));
+    for (unsigned int i = offsets[p]; (i < offsets[p + 1]) && (i < incoming.size()); ++i) {
+      GRAPHWORKS_CHECK(incoming[i].m_from == p);
+      GRAPHWORKS_CHECK(incoming[i].m_to == myRank);
+      GRAPHWORKS_CHECK(incoming[i].m_position == i - offsets[p]);
+    }
+  }
+
+  std::vector<Item> incomingOnly;
+  exchangeAll(outgoing, incomingOnly, mpiCommunicator);
+  GRAPHWORKS_CHECK(incomingOnly.size() == incoming.size());
+}
+
+/**
+ * @brief Exchanges counts which exceed the largest count given to MPI, here
+ *        made small, so that the elements are sent as whole chunks and
+ *        remainders, and checks the received elements.
+ */
+void
+testExchangeAllvChunks(
+  const MPICommunicator& mpiCommunicator
+)
+{
+  const unsigned int numProcs = mpiCommunicator.size();
+  const unsigned int myRank = mpiCommunicator.rank();
+  const unsigned long long maxCount = 3;
+  std::vector<unsigned int> sendBuffer;
+  std::vector<unsigned long long> sendCounts(numProcs, 0);
+  std::vector<unsigned long long> sendDispls(numProcs, 0);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    sendDispls[p] = sendBuffer.size();
+    sendCounts[p] = 4 * numItems(myRank, p);
+    for (unsigned int k = 0; k < sendCounts[p]; ++k) {
+      sendBuffer.push_back((myRank * 1000000) + (p * 1000) + k);
+    }
+  }
+  std::vector<unsigned long long> receiveCounts(numProcs, 0);
+  std::vector<unsigned long long> receiveDispls(numProcs, 0);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    receiveCounts[p] = 4 * numItems(p, myRank);
+    receiveDispls[p] = (p > 0) ? receiveDispls[p - 1] + receiveCounts[p - 1] : 0;
+  }
+  std::vector<unsigned int> receiveBuffer(receiveDispls[numProcs - 1] + receiveCounts[numProcs - 1], 0);
+
+  exchangeAllv(sendBuffer.empty() ? 0 : &sendBuffer[0], sendCounts, sendDispls,
+               receiveBuffer.empty() ? 0 : &receiveBuffer[0], receiveCounts, receiveDispls,
+               MPI_UNSIGNED, mpiCommunicator, maxCount);
+
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    for (unsigned int k = 0; k < receiveCounts[p]; ++k) {
+      GRAPHWORKS_CHECK(receiveBuffer[receiveDispls[p] + k] == (p * 1000000) + (myRank * 1000) + k);
+    }
+  }
+}
+
+/**
+ * @brief Gathers a different number of elements from every processor, in
+ *        chunks as in testExchangeAllvChunks, and checks them on processor 0.
+ */
+void
+testGathervChunks(
+  const MPICommunicator& mpiCommunicator
+)
+{
+  const unsigned int numProcs = mpiCommunicator.size();
+  const unsigned int myRank = mpiCommunicator.rank();
+  std::vector<unsigned int> sendBuffer(5 * myRank + 4);
+  for (unsigned int k = 0; k < sendBuffer.size(); ++k) {
+    sendBuffer[k] = (myRank * 1000) + k;
+  }
+  std::vector<unsigned long long> receiveCounts(numProcs, 0);
+  unsigned long long numElements = 0;
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    receiveCounts[p] = 5 * p + 4;
+    numElements += receiveCounts[p];
+  }
+  std::vector<unsigned int> receiveBuffer((myRank == 0) ? numElements : 0);
+
+  gatherv(&sendBuffer[0], sendBuffer.size(), receiveBuffer.empty() ? 0 : &receiveBuffer[0], receiveCounts,
+          MPI_UNSIGNED, mpiCommunicator, 3);
+
+  for (unsigned int p = 0, i = 0; (p < numProcs) && (myRank == 0); ++p) {
+    for (unsigned int k = 0; k < receiveCounts[p]; ++k, ++i) {
+      GRAPHWORKS_CHECK(receiveBuffer[i] == (p * 1000) + k);
+    }
+  }
+}
+
+/**
+ * @brief Targets of the edges of a node of the test graph, which cross the
+ *        processors in both directions and form cycles.
+ */
+void
+edgeTargets(
+  const Graph::Node::IndexType node,
+  const Graph::Node::IndexType numNodes,
+  Graph::Node::IndexType* const targets
+)
+{
+  targets[0] = ((node * 17) + 3) % numNodes;
+  targets[1] = ((node * 31) + 5) % numNodes;
+}
+
+/**
+ * @brief Propagates the maximum payload along the edges of a graph, whose
+ *        nodes are split unevenly between the processors, until it
+ *        converges, and checks every payload against the same fixpoint
+ *        computed serially.
+ *
+ * The remote payloads only reach the interaction sets through the halo
+ * exchanges of the supersteps.
+ */
+void
+testHaloFixpoint(
+  const MPICommunicator& mpiCommunicator
+)
+{
+  const unsigned int numProcs = mpiCommunicator.size();
+  const unsigned int myRank = mpiCommunicator.rank();
+  std::vector<unsigned int> offsets(numProcs + 1, 0);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    offsets[p + 1] = offsets[p] + ((p == 1) ? 0 : (300 + (50 * p)));
+  }
+  const Graph::Node::IndexType numNodes = offsets[numProcs];
+
+  std::vector<Graph::Node::PayloadType> expected(numNodes);
+  for (Graph::Node::IndexType i = 0; i < numNodes; ++i) {
+    expected[i] = static_cast<Graph::Node::PayloadType>((i * 7919) % numNodes);
+  }
+
+  std::vector<Graph::Node> nodes;
+  for (unsigned int i = offsets[myRank]; i < offsets[myRank + 1]; ++i) {
+    nodes.push_back(Graph::Node(i));
+  }
+  Graph g(nodes, mpiCommunicator);
+  for (unsigned int i = offsets[myRank]; i < offsets[myRank + 1]; ++i) {
+    Graph::Node::IndexType targets[2];
+    edgeTargets(i, numNodes, targets);
+    g.addEdge(i, targets[0]);
+    g.addEdge(i, targets[1]);
+    g.updatePayload(i, expected[i]);
+  }
+  g.applyUpdates();
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (Graph::Node::IndexType i = 0; i < numNodes; ++i) {
+      Graph::Node::IndexType targets[2];
+      edgeTargets(i, numNodes, targets);
+      for (unsigned int t = 0; t < 2; ++t) {
+        if (expected[targets[t]] > expected[i]) {
+          expected[i] = expected[targets[t]];
+          changed = true;
+        }
+      }
+    }
+  }
+
+  GraphCompute graphCompute(mpiCommunicator);
+  EdgeGenerateFunction generate;
+  ReductionCombineFunction combine(Reduction::Max);
+  GRAPHWORKS_CHECK(graphCompute.iterate(g, generate, combine, numNodes));
+
+  GRAPHWORKS_CHECK(g.size() == offsets[myRank + 1] - offsets[myRank]);
+  for (unsigned int i = 0; i < g.size(); ++i) {
+    GRAPHWORKS_CHECK((g.begin() + i)->payload() == expected[g.globalIndex(i)]);
+  }
+}
+
+/**
+ * @brief Sums the payloads along the edges of the same graph for a fixed
+ *        number of supersteps, and checks every payload against the same
+ *        sums computed serially.
+ *
+ * The sum isn't idempotent, so every superstep has to read only the
+ * payloads of the previous one, also when the sources are read through the
+ * halo rather than from the interaction sets.
+ */
+void
+testHaloSum(
+  const MPICommunicator& mpiCommunicator
+)
+{
+  const unsigned int numProcs = mpiCommunicator.size();
+  const unsigned int myRank = mpiCommunicator.rank();
+  const unsigned int numSupersteps = 3;
+  std::vector<unsigned int> offsets(numProcs + 1, 0);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    offsets[p + 1] = offsets[p] + ((p == 1) ? 0 : (300 + (50 * p)));
+  }
+  const Graph::Node::IndexType numNodes = offsets[numProcs];
+
+  std::vector<Graph::Node::PayloadType> expected(numNodes);
+  for (Graph::Node::IndexType i = 0; i < numNodes; ++i) {
+    expected[i] = static_cast<Graph::Node::PayloadType>(1 + (i % 5));
+  }
+
+  std::vector<Graph::Node> nodes;
+  for (unsigned int i = offsets[myRank]; i < offsets[myRank + 1]; ++i) {
+    nodes.push_back(Graph::Node(i));
+  }
+  Graph g(nodes, mpiCommunicator);
+  for (unsigned int i = offsets[myRank]; i < offsets[myRank + 1]; ++i) {
+    Graph::Node::IndexType targets[2];
+    edgeTargets(i, numNodes, targets);
+    g.addEdge(i, targets[0]);
+    g.addEdge(i, targets[1]);
+    g.updatePayload(i, expected[i]);
+  }
+  g.applyUpdates();
+
+  for (unsigned int superstep = 0; superstep < numSupersteps; ++superstep) {
+    const std::vector<Graph::Node::PayloadType> previous(expected);
+    for (Graph::Node::IndexType i = 0; i < numNodes; ++i) {
+      Graph::Node::IndexType targets[2];
+      edgeTargets(i, numNodes, targets);
+      expected[i] += previous[targets[0]] + previous[targets[1]];
+    }
+  }
+
+  GraphCompute graphCompute(mpiCommunicator);
+  EdgeGenerateFunction generate;
+  ReductionCombineFunction combine(Reduction::Sum);
+  GRAPHWORKS_CHECK(!graphCompute.iterate(g, generate, combine, numSupersteps));
+
+  GRAPHWORKS_CHECK(g.size() == offsets[myRank + 1] - offsets[myRank]);
+  for (unsigned int i = 0; i < g.size(); ++i) {
+    GRAPHWORKS_CHECK((g.begin() + i)->payload() == expected[g.globalIndex(i)]);
+  }
+}
+
+} // namespace
+
+int
+main(
+  int argc,
+  char** argv
+)
+{
+  MPI_Init(&argc, &argv);
+  int status = 0;
+  {
+    MPICommunicator mpiCommunicator(MPI_COMM_WORLD);
+    testExchangeAll(mpiCommunicator);
+    testExchangeAllvChunks(mpiCommunicator);
+    testGathervChunks(mpiCommunicator);
+    testHaloFixpoint(mpiCommunicator);
+    testHaloSum(mpiCommunicator);
+    status = finishTest("Exchange", mpiCommunicator);
+  }
+  MPI_Finalize();
+  return status;
+}
@@ -0,0 +1,96 @@
+#include "Check.hpp"
+
+#include "MPICommunicator.hpp"
+#include "MessageAggregator.hpp"
+#include "Reduction.hpp"
+
+#include <mpi.h>
+
+#include <vector>
+
+namespace {
+
+/** Number of the nodes owned by every processor **/
+const unsigned int s_nodesPerProc = 10;
+
+/** Sums the received updates of the local nodes **/
+class SumHandler : public MessageAggregator::UpdateHandler {
+public:
+  SumHandler(
+    const unsigned int first
+  ) : m_first(first),
+    m_sums(s_nodesPerProc, 0.0)
+  { }
+
+  void
+  operator()(
+    const Graph::Node::IndexType target,
+    const Graph::Node::PayloadType value
+  )
+  {
+    m_sums[target - m_first] += value;
+  }
+
+  const std::vector<Graph::Node::PayloadType>&
+  sums() const { return m_sums; }
+
+private:
+  const unsigned int m_first;
+  std::vector<Graph::Node::PayloadType> m_sums;
+}; // class SumHandler
+
+/**
+ * @brief Sends every node, local ones included, the same update several
+ *        times from every processor, in two epochs and through buffers small
+ *        enough to be flushed several times, and checks the received sums
+ *        and the counts of the aggregator.
+ */
+void
+testSums(
+  const MPICommunicator& mpiCommunicator
+)
+{
+  const unsigned int numProcs = mpiCommunicator.size();
+  const unsigned int myRank = mpiCommunicator.rank();
+  const unsigned int numRepeats = 3;
+  const unsigned int numEpochs = 2;
+  const Reduction sum(Reduction::Sum);
+
+  SumHandler handler(myRank * s_nodesPerProc);
+  MessageAggregator aggregator(mpiCommunicator, handler, 4, 1e-4, &sum);
+  for (unsigned int epoch = 0; epoch < numEpochs; ++epoch) {
+    for (unsigned int r = 0; r < numRepeats; ++r) {
+      for (unsigned int n = 0; n < numProcs * s_nodesPerProc; ++n) {
+        aggregator.send(n / s_nodesPerProc, n, 1.0);
+      }
+    }
+    aggregator.finish();
+
+    for (unsigned int n = 0; n < s_nodesPerProc; ++n) {
+      GRAPHWORKS_CHECK(handler.sums()[n] == (epoch + 1) * numRepeats * numProcs);
+    }
+  }
+
+  GRAPHWORKS_CHECK(aggregator.numUpdates() == numEpochs * numRepeats * numProcs * s_nodesPerProc);
+  GRAPHWORKS_CHECK(aggregator.numCombinedUpdates() <= aggregator.numUpdates());
+  GRAPHWORKS_CHECK((numProcs == 1) || (aggregator.numMessages() > 0));
+}
+
+} // namespace
+
+int
+main(
+  int argc,
+  char** argv
+)
+{
+  MPI_Init(&argc, &argv);
+  int status = 0;
+  {
+    MPICommunicator mpiCommunicator(MPI_COMM_WORLD);
+    testSums(mpiCommunicator);
+    status = finishTest("MessageAggregator", mpiCommunicator);
+  }
+  MPI_Finalize();
+  return status;
+}
@@ -0,0 +1,175 @@
+#include "Check.hpp"
+
+#include "CombineFunction.hpp"
+#include "EdgeGenerateFunction.hpp"
+#include "Graph.hpp"
+#include "GraphCompute.hpp"
+#include "MPICommunicator.hpp"
+#include "RemoteCache.hpp"
+
+#include <mpi.h>
+
+#include <vector>
+
+namespace {
+
+/**
+ * Combine function which copies larger payloads into a third of the nodes,
+ * and counts the remote nodes whose payloads differ from the payloads
+ * their processors had before the computation.
+ */
+class CheckedMaxCombineFunction : public CombineFunction {
+public:
+  CheckedMaxCombineFunction(
+    const Graph& g,
+    const std::vector<Graph::Node::PayloadType>& payloads
+  ) : m_graph(g),
+    m_payloads(payloads),
+    m_numStale(0)
+  { }
+
+  bool
+  operator()(
+    Graph::Node& node,
+    const Graph::Node& other
+  ) const
+  {
+    if (!m_graph.isLocal(other.index()) && (other.payload() != m_payloads[other.index()])) {
+#pragma omp atomic
+      ++m_numStale;
+    }
+    if ((other.payload() > node.payload()) && ((node.index() % 3) == 0)) {
+      node.payload() = other.payload();
+      return true;
+    }
+    return false;
+  }
+
+  unsigned long long
+  numStale() const { return m_numStale; }
+
+private:
+  const Graph& m_graph;
+  const std::vector<Graph::Node::PayloadType>& m_payloads;
+  mutable unsigned long long m_numStale;
+}; // class CheckedMaxCombineFunction
+
+/**
+ * @brief Gathers the payloads of all the nodes, in the order of their
+ *        global indices. This is a collective call.
+ */
+void
+gatherPayloads(
+  const Graph& g,
+  const MPICommunicator& mpiCommunicator,
+  std::vector<Graph::Node::PayloadType>& payloads
+)
+{
+  const unsigned int numProcs = mpiCommunicator.size();
+  std::vector<Graph::Node::PayloadType> myPayloads;
+  for (unsigned int i = 0; i < g.size(); ++i) {
+    myPayloads.push_back((g.begin() + i)->payload());
+  }
+  int numMine = static_cast<int>(myPayloads.size());
+  std::vector<int> counts(numProcs, 0);
+  MPI_Allgather(&numMine, 1, MPI_INT, &counts[0], 1, MPI_INT, *mpiCommunicator);
+  std::vector<int> displs(numProcs, 0);
+  for (unsigned int p = 1; p < numProcs; ++p) {
+    displs[p] = displs[p - 1] + counts[p - 1];
+  }
+  payloads.resize(displs[numProcs - 1] + counts[numProcs - 1]);
+  MPI_Allgatherv(myPayloads.empty() ? 0 : &myPayloads[0], numMine, MPI_DOUBLE,
+                 payloads.empty() ? 0 : &payloads[0], &counts[0], &displs[0], MPI_DOUBLE, *mpiCommunicator);
+}
+
+/**
+ * @brief Runs several computations on the same graph, with payloads updated
+ *        between them, and checks that every remote payload seen by the
+ *        combine function is current, whether or not it came from the cache
+ *        of the given capacity, if any.
+ *
+ * @return Payloads of all the nodes after the computations.
+ */
+std::vector<Graph::Node::PayloadType>
+runComputations(
+  const MPICommunicator& mpiCommunicator,
+  const unsigned int cacheCapacity
+)
+{
+  const unsigned int numProcs = mpiCommunicator.size();
+  const unsigned int myRank = mpiCommunicator.rank();
+  std::vector<unsigned int> offsets(numProcs + 1, 0);
+  for (unsigned int p = 0; p < numProcs; ++p) {
+    offsets[p + 1] = offsets[p] + ((p == 1) ? 0 : (1000 + (500 * p)));
+  }
+  const Graph::Node::IndexType numNodes = offsets[numProcs];
+
+  std::vector<Graph::Node> nodes;
+  for (unsigned int i = offsets[myRank]; i < offsets[myRank + 1]; ++i) {
+    nodes.push_back(Graph::Node(i));
+  }
+  Graph g(nodes, mpiCommunicator);
+  for (unsigned int i = offsets[myRank]; i < offsets[myRank + 1]; ++i) {
+    g.updatePayload(i, static_cast<Graph::Node::PayloadType>((i * 7919) % numNodes));
+    g.addEdge(i, (i + 1) % numNodes);
+    g.addEdge(i, ((i * 17) + 3) % numNodes);
+    g.addEdge(i, ((i * 31) + 5) % numNodes);
+  }
+  g.applyUpdates();
+
+  GraphCompute graphCompute(mpiCommunicator);
+  if (cacheCapacity > 0) {
+    graphCompute.enableRemoteCache(cacheCapacity);
+  }
+  EdgeGenerateFunction generate;
+  std::vector<Graph::Node::PayloadType> payloads;
+  for (unsigned int r = 0; r < 5; ++r) {
+    gatherPayloads(g, mpiCommunicator, payloads);
+    CheckedMaxCombineFunction combine(g, payloads);
+    GRAPHWORKS_CHECK(graphCompute(g, generate, combine));
+    GRAPHWORKS_CHECK(combine.numStale() == 0);
+
+    // Payloads changed outside of the computations invalidate the cache.
+    if (r == 2) {
+      if (myRank == 0) {
+        for (Graph::Node::IndexType k = 0; k < 50; ++k) {
+          g.updatePayload((k * 97) % numNodes, 1.0e6 + k);
+        }
+      }
+      g.applyUpdates();
+    }
+  }
+
+  const RemoteCache* remoteCache = graphCompute.remoteCache();
+  GRAPHWORKS_CHECK((cacheCapacity == 0) || (remoteCache != 0));
+  if ((cacheCapacity > 0) && (remoteCache != 0)) {
+    unsigned long long numHits = remoteCache->numHits();
+    unsigned long long totalHits = 0;
+    MPI_Allreduce(&numHits, &totalHits, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, *mpiCommunicator);
+    GRAPHWORKS_CHECK((numProcs == 1) || (totalHits > 0));
+  }
+
+  gatherPayloads(g, mpiCommunicator, payloads);
+  return payloads;
+}
+
+} // namespace
+
+int
+main(
+  int argc,
+  char** argv
+)
+{
+  MPI_Init(&argc, &argv);
+  int status = 0;
+  {
+    MPICommunicator mpiCommunicator(MPI_COMM_WORLD);
+    const std::vector<Graph::Node::PayloadType> uncached = runComputations(mpiCommunicator, 0);
+    GRAPHWORKS_CHECK(runComputations(mpiCommunicator, 64) == uncached);
+    GRAPHWORKS_CHECK(runComputations(mpiCommunicator, 1 << 20) == uncached);
+    status = finishTest("RemoteCache", mpiCommunicator);
+  }
+  MPI_Finalize();
+  return status;
+}
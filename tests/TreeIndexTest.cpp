@@ -0,0 +1,299 @@
+#include "Check.hpp"
+
+#include "CombineFunction.hpp"
+#include "GenerateFunction.hpp"
+#include "Graph.hpp"
+#include "GraphCompute.hpp"
+#include "MPICommunicator.hpp"
+#include "TreeIndex.hpp"
+
+#include <mpi.h>
+
+#include <iterator>
+#include <vector>
+
+namespace {
+
+typedef Graph::Node::IndexType IndexType;
+
+/** Number of the nodes of the binary heap used as the tree **/
+const IndexType s_numNodes = 1000;
+
+unsigned int
+heapLevel(
+  const IndexType node
+)
+{
+  unsigned int level = 0;
+  for (IndexType n = node + 1; n > 1; n >>= 1) {
+    ++level;
+  }
+  return level;
+}
+
+unsigned int
+heapNumChildren(
+  const IndexType node
+)
+{
+  return ((2 * node + 1 < s_numNodes) ? 1 : 0) + ((2 * node + 2 < s_numNodes) ? 1 : 0);
+}
+
+IndexType
+heapParent(
+  const IndexType node
+)
+{
+  return (node == 0) ? Graph::Node::s_invalidIndex : (node - 1) / 2;
+}
+
+Graph::Node
+heapNode(
+  const IndexType node
+)
+{
+  return Graph::Node(node, heapParent(node), heapNumChildren(node), heapLevel(node));
+}
+
+unsigned long long
+heapSubtreeSize(
+  const IndexType node
+)
+{
+  return (node >= s_numNodes) ? 0 : 1 + heapSubtreeSize(2 * node + 1) + heapSubtreeSize(2 * node + 2);
+}
+
+/**
+ * @brief Numbers the heap in an Euler tour, which visits the left child
+ *        first, as the tree index does.
+ */
+void
+numberHeapTour(
+  const IndexType node,
+  unsigned long long& counter,
+  std::vector<unsigned long long>& entries,
+  std::vector<unsigned long long>& exits
+)
+{
+  entries[node] = counter++;
+  if (2 * node + 1 < s_numNodes) {
+    numberHeapTour(2 * node + 1, counter, entries, exits);
+  }
+  if (2 * node + 2 < s_numNodes) {
+    numberHeapTour(2 * node + 2, counter, entries, exits);
+  }
+  exits[node] = counter++;
+}
+
+/** Generate function of the children of a heap node **/
+class ChildrenGenerateFunction : public GenerateFunction {
+public:
+  bool
+  operator()(
+    const Graph&,
+    const Graph::Node& node,
+    std::back_insert_iterator<std::vector<Graph::Node> >& iteratorList,
+    bool& dependencyFlag
+  ) const
+  {
+    const IndexType index = node.index();
+    if (2 * index + 2 < s_numNodes) {
+      iteratorList = heapNode(2 * index + 2);
+    }
+    if (2 * index + 1 < s_numNodes) {
+      iteratorList = heapNode(2 * index + 1);
+    }
+    dependencyFlag = true;
+    return true;
+  }
+}; // class ChildrenGenerateFunction
+
+/** Children generate function which declares the upward accumulation **/
+class UpwardGenerateFunction : public ChildrenGenerateFunction {
+public:
+  Graph::AlgorithmChoice
+  type() const { return Graph::UpwardAccumulateSpecial; }
+}; // class UpwardGenerateFunction
+
+/** Generate function of the parent of a heap node **/
+class ParentGenerateFunction : public GenerateFunction {
+public:
+  bool
+  operator()(
+    const Graph&,
+    const Graph::Node& node,
+    std::back_insert_iterator<std::vector<Graph::Node> >& iteratorList,
+    bool& dependencyFlag
+  ) const
+  {
+    if (node.index() > 0) {
+      iteratorList = heapNode(heapParent(node.index()));
+    }
+    dependencyFlag = true;
+    return true;
+  }
+}; // class ParentGenerateFunction
+
+/** Parent generate function which declares the downward accumulation **/
+class DownwardGenerateFunction : public ParentGenerateFunction {
+public:
+  Graph::AlgorithmChoice
+  type() const { return Graph::DownwardAccumulateSpecial; }
+}; // class DownwardGenerateFunction
+
+class SumCombineFunction : public CombineFunction {
+public:
+  bool
+  operator()(
+    Graph::Node& node,
+    const Graph::Node& other
+  ) const
+  {
+    node.payload() += other.payload();
+    return true;
+  }
+}; // class SumCombineFunction
+
+/**
+ * @brief Checks the structure of a tree index of the heap against the heap.
+ */
+void
+checkTreeIndex(
+  const Graph& g,
+  const TreeIndex& tree
+)
+{
+  std::vector<unsigned long long> entries(s_numNodes);
+  std::vector<unsigned long long> exits(s_numNodes);
+  unsigned long long counter = 0;
+  numberHeapTour(0, counter, entries, exits);
+
+  const unsigned int maxLevel = heapLevel(s_numNodes - 1);
+  GRAPHWORKS_CHECK(tree.minLevel() == 0);
+  GRAPHWORKS_CHECK(tree.maxLevel() == maxLevel);
+
+  std::vector<unsigned int> numLevelNodes(maxLevel + 1, 0);
+  for (unsigned int i = 0; i < g.size(); ++i) {
+    const IndexType node = g.globalIndex(i);
+    GRAPHWORKS_CHECK(tree.level(i) == heapLevel(node));
+    GRAPHWORKS_CHECK(tree.parent(i) == heapParent(node));
+    GRAPHWORKS_CHECK(tree.isRoot(i) == (node == 0));
+    GRAPHWORKS_CHECK(tree.subtreeSize(i) == heapSubtreeSize(node));
+    GRAPHWORKS_CHECK(tree.entry(i) == entries[node]);
+    GRAPHWORKS_CHECK(tree.exit(i) == exits[node]);
+    GRAPHWORKS_CHECK(tree.numChildren(i) == heapNumChildren(node));
+    for (unsigned int c = 0; c < tree.numChildren(i); ++c) {
+      GRAPHWORKS_CHECK(tree.children(i)[c] == 2 * node + 1 + c);
+    }
+    // Every node is an ancestor of itself, and the ancestors of the last
+    // node are the nodes on its path to the root.
+    GRAPHWORKS_CHECK(tree.isAncestor(i, entries[node], exits[node]));
+    bool onPath = false;
+    for (IndexType n = s_numNodes - 1; n != Graph::Node::s_invalidIndex; n = heapParent(n)) {
+      onPath = onPath || (n == node);
+    }
+    GRAPHWORKS_CHECK(tree.isAncestor(i, entries[s_numNodes - 1], exits[s_numNodes - 1]) == onPath);
+    if (g.isLocal(0)) {
+      GRAPHWORKS_CHECK(tree.isAncestor(g.localIndex(0), entries[node], exits[node]));
+    }
+    ++numLevelNodes[heapLevel(node)];
+  }
+
+  for (unsigned int level = 0; level <= maxLevel; ++level) {
+    GRAPHWORKS_CHECK(tree.numLevelNodes(level) == numLevelNodes[level]);
+    for (unsigned int n = 0; n < tree.numLevelNodes(level); ++n) {
+      GRAPHWORKS_CHECK(heapLevel(g.globalIndex(tree.levelNodes(level)[n])) == level);
+      GRAPHWORKS_CHECK((n == 0) || (tree.levelNodes(level)[n - 1] < tree.levelNodes(level)[n]));
+    }
+  }
+  GRAPHWORKS_CHECK(tree.numLevelNodes(maxLevel + 1) == 0);
+}
+
+/**
+ * @brief Builds a binary heap whose nodes are split evenly between the
+ *        processors, checks the tree indices of its node parents and of the
+ *        same parents given explicitly, and accumulates over the tree in
+ *        both directions, detected and declared by the generate functions.
+ */
+void
+testHeap(
+  const MPICommunicator& mpiCommunicator
+)
+{
+  const unsigned int numProcs = mpiCommunicator.size();
+  const unsigned int myRank = mpiCommunicator.rank();
+  const IndexType first = (s_numNodes * myRank) / numProcs;
+  const IndexType last = (s_numNodes * (myRank + 1)) / numProcs;
+
+  std::vector<Graph::Node> nodes;
+  std::vector<IndexType> parents;
+  for (IndexType n = first; n < last; ++n) {
+    nodes.push_back(heapNode(n));
+    nodes.back().payload() = 1;
+    parents.push_back(heapParent(n));
+  }
+  Graph g(nodes, mpiCommunicator);
+
+  TreeIndex tree(g);
+  checkTreeIndex(g, tree);
+  TreeIndex givenTree(g, parents);
+  checkTreeIndex(g, givenTree);
+
+  // The sums of the children give the subtree sizes, and the sums of the
+  // parents give the depths.
+  GraphCompute graphCompute(mpiCommunicator);
+  SumCombineFunction combine;
+  ChildrenGenerateFunction children;
+  GRAPHWORKS_CHECK(graphCompute(g, children, combine));
+  GRAPHWORKS_CHECK(g.treeIndex() != 0);
+  for (unsigned int i = 0; i < g.size(); ++i) {
+    GRAPHWORKS_CHECK((g.begin() + i)->payload() == heapSubtreeSize(g.globalIndex(i)));
+  }
+
+  for (Graph::NodeIterator node = g.begin(); node != g.end(); ++node) {
+    node->payload() = 1;
+  }
+  ParentGenerateFunction parent;
+  GRAPHWORKS_CHECK(graphCompute(g, parent, combine));
+  for (unsigned int i = 0; i < g.size(); ++i) {
+    GRAPHWORKS_CHECK((g.begin() + i)->payload() == heapLevel(g.globalIndex(i)) + 1);
+  }
+
+  // The declared accumulations take their interaction sets from the tree.
+  for (Graph::NodeIterator node = g.begin(); node != g.end(); ++node) {
+    node->payload() = 1;
+  }
+  UpwardGenerateFunction upward;
+  GRAPHWORKS_CHECK(graphCompute(g, upward, combine));
+  for (unsigned int i = 0; i < g.size(); ++i) {
+    GRAPHWORKS_CHECK((g.begin() + i)->payload() == heapSubtreeSize(g.globalIndex(i)));
+  }
+
+  for (Graph::NodeIterator node = g.begin(); node != g.end(); ++node) {
+    node->payload() = 1;
+  }
+  DownwardGenerateFunction downward;
+  GRAPHWORKS_CHECK(graphCompute(g, downward, combine));
+  for (unsigned int i = 0; i < g.size(); ++i) {
+    GRAPHWORKS_CHECK((g.begin() + i)->payload() == heapLevel(g.globalIndex(i)) + 1);
+  }
+}
+
+} // namespace
+
+int
+main(
+  int argc,
+  char** argv
+)
+{
+  MPI_Init(&argc, &argv);
+  int status = 0;
+  {
+    MPICommunicator mpiCommunicator(MPI_COMM_WORLD);
+    testHeap(mpiCommunicator);
+    status = finishTest("TreeIndex", mpiCommunicator);
+  }
+  MPI_Finalize();
+  return status;
+}